@@ -15,6 +15,8 @@
  */
 
 #include "LogImp.h"
+#include "util/tc_lz4.h"
+#include "util/tc_gzip.h"
 
 GlobeInfo   g_globe;
 
@@ -418,16 +420,110 @@ void LogImp::loggerbyInfo(const LogInfo & info,const vector<std::string> & buffe
 {
     TC_DayLogger &dl = g_globe.getLogger(info,current->getIp());
 
-    //记录日志
+    //拼起来一次写入
+    string sPrefix = g_globe._bIpPrefix ? (current->getIp() + info.sSepar) : "";
+
+    size_t len = 0;
     for(size_t i = 0; i < buffer.size(); i++)
     {
-        if(g_globe._bIpPrefix)
-        {
-            dl.any() << current->getIp() << info.sSepar << buffer[i];
-        }
-        else
-        {
-            dl.any() << buffer[i];
-        }
+        len += sPrefix.length() + buffer[i].length();
     }
+
+    string s;
+    s.reserve(len);
+    for(size_t i = 0; i < buffer.size(); i++)
+    {
+        s += sPrefix;
+        s += buffer[i];
+    }
+
+    if(!s.empty())
+    {
+        dl.getRoll()->write(s.data(), s.length());
+    }
+}
+
+void LogImp::loggerbyBlock(const LogInfo & info,const LogBlock & block,tars::TarsCurrentPtr current)
+{
+    //解压后的长度限制, 避免异常的包占用过多内存
+    const static int MAX_RAW_LENGTH = 64 * 1024 * 1024;
+
+    if(block.rawLength < 0 || block.rawLength > MAX_RAW_LENGTH)
+    {
+        TLOGERROR("LogImp::loggerbyBlock invalid rawLength:" << block.rawLength << "|from:" << current->getIp() << endl);
+        return;
+    }
+
+    const char *src = block.data.empty() ? "" : &block.data[0];
+
+    string raw;
+    bool bSucc = false;
+    switch(block.compress)
+    {
+        case LOG_COMPRESS_NONE:
+            bSucc = ((int)block.data.size() == block.rawLength);
+            break;
+        case LOG_COMPRESS_LZ4:
+            raw.reserve(block.rawLength);
+            bSucc = TC_LZ4::uncompress(src, block.data.size(), block.rawLength, raw);
+            break;
+        case LOG_COMPRESS_GZIP:
+            //超过rawLength就停止, 不会按压缩比放大内存
+            bSucc = TC_GZip::uncompress(src, block.data.size(), block.rawLength, raw) && (int)raw.length() == block.rawLength;
+            break;
+        default:
+            break;
+    }
+
+    if(!bSucc)
+    {
+        TLOGERROR("LogImp::loggerbyBlock uncompress error, compress:" << block.compress << "|rawLength:" << block.rawLength
+            << "|size:" << block.data.size() << "|from:" << current->getIp() << endl);
+        return;
+    }
+
+    TC_DayLogger &dl = g_globe.getLogger(info,current->getIp());
+
+    string sPrefix = g_globe._bIpPrefix ? (current->getIp() + info.sSepar) : "";
+
+    if(block.compress == LOG_COMPRESS_NONE)
+    {
+        write(dl, src, block.data.size(), sPrefix);
+    }
+    else
+    {
+        write(dl, raw.data(), raw.length(), sPrefix);
+    }
+}
+
+void LogImp::write(TC_DayLogger &dl, const char *data, size_t len, const string &sPrefix)
+{
+    if(len == 0)
+    {
+        return;
+    }
+
+    if(sPrefix.empty())
+    {
+        dl.getRoll()->write(data, len);
+        return;
+    }
+
+    //块里面没有每条的边界, 按行加前缀
+    string s;
+    s.reserve(len + len / 32);
+
+    size_t pos = 0;
+    while(pos < len)
+    {
+        const char *p = (const char*)memchr(data + pos, '\n', len - pos);
+        size_t next = p ? (p - data + 1) : len;
+
+        s += sPrefix;
+        s.append(data + pos, next - pos);
+
+        pos = next;
+    }
+
+    dl.getRoll()->write(s.data(), s.length());
 }
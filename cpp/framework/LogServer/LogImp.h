@@ -214,7 +214,19 @@ public:
      */
     void loggerbyInfo(const LogInfo & info,const vector<std::string> & buffer,tars::TarsCurrentPtr current);
 
+    /**
+     * 解压后整块写到文件
+     * @param info
+     * @param block
+     *
+     */
+    void loggerbyBlock(const LogInfo & info,const LogBlock & block,tars::TarsCurrentPtr current);
+
 private:
+    /**
+     * 一次写到文件, sPrefix不为空时加到每行的前面
+     */
+    void write(TC_DayLogger &dl, const char *data, size_t len, const string &sPrefix);
 
 };
 
@@ -32,6 +32,7 @@ PropertyDbManager::PropertyDbManager()
     _reapSql           = g_pconf->getDomainMap("/tars/reapSql");
     _tbNamePre         = g_pconf->get("/tars/db<tbnamePre>","t_property_realtime_");
     _maxInsertCount    = TC_Common::strto<int>(g_pconf->get("/tars/reapSql<maxInsertCount>","1000"));
+    _bulkMode          = TC_MysqlBulk::toMode(g_pconf->get("/tars/reapSql<bulkMode>","insert"));
     _enableWeighted    = TC_Common::strto<bool>(g_pconf->get("/tars/<enWeighted>","0"));
 
     if (_sqlStatus == "")
@@ -82,6 +83,10 @@ PropertyDbManager::PropertyDbManager()
     {
         TC_DBConf tConf;
         tConf.loadFromMap(g_pconf->getDomainMap("/tars/multidb/" + vDb[i]));
+        if(_bulkMode == TC_MysqlBulk::BM_LOAD_DATA)
+        {
+            tConf._flag |= CLIENT_LOCAL_FILES;
+        }
         _sTbNamePre.push_back(g_pconf->get("/tars/multidb/" + vDb[i] + "<tbname>",
                                               "t_propert_0" + TC_Common::tostr(i) + "_"));
 
@@ -286,10 +291,8 @@ int PropertyDbManager::getGcd (int a, int b)
 ///////////////////////////////////////////////////////////
 int PropertyDbManager::insert2Db(const PropertyMsg &mPropMsg, const string &sDate, const string &sFlag, int iOldWriteNum, int &iNowWriteNum, const string &sTbNamePre, TC_Mysql *pMysql)
 {
-    int iCount = 0;
     int iHasWriteNum = iOldWriteNum;
-    ostringstream osSql;
-    string strValues;
+    int iHeadNum = 0;
 
     iNowWriteNum = 0;
 
@@ -298,6 +301,10 @@ int PropertyDbManager::insert2Db(const PropertyMsg &mPropMsg, const string &sDat
     {
         creatTable(strTbName,pMysql);
 
+        TC_MysqlBulk bulk(pMysql, _bulkMode, _maxInsertCount);
+
+        bulk.begin(strTbName, "f_date,f_tflag,master_name,master_ip,property_name,set_name,set_area,set_id,policy,value");
+
         for(map<PropHead,PropBody>::const_iterator it = mPropMsg.begin(); it != mPropMsg.end(); it++ )
         {
             if(_terminate)
@@ -305,6 +312,8 @@ int PropertyDbManager::insert2Db(const PropertyMsg &mPropMsg, const string &sDat
                 return -1;
             }
 
+            ++iHeadNum;
+
             if(iHasWriteNum > 0)
             {
                 --iHasWriteNum;
@@ -316,82 +325,67 @@ int PropertyDbManager::insert2Db(const PropertyMsg &mPropMsg, const string &sDat
             //组织sql语句
             for(size_t i = 0; i < body.vInfo.size(); i++)
             {
-                strValues = " ('";
-                strValues += sDate;
-                strValues += "','";
-                strValues += sFlag;
-                strValues += "','";
-                strValues += pMysql->escapeString(head.moduleName);
-                strValues += "','";
-                strValues += pMysql->escapeString(head.ip);
-                strValues += "','";
-                strValues += pMysql->escapeString(head.propertyName);
-                strValues += "','";
-                strValues += pMysql->escapeString(head.setName);
-                strValues += "','";
-                strValues += pMysql->escapeString(head.setArea);
-                strValues += "','";
-                strValues += pMysql->escapeString(head.setID);
-                strValues += "','";
-                strValues += pMysql->escapeString(body.vInfo[i].policy);
-                strValues += "','";
+                bulk.addStr(sDate);
+                bulk.addStr(sFlag);
+                bulk.addStr(head.moduleName);
+                bulk.addStr(head.ip);
+                bulk.addStr(head.propertyName);
+                bulk.addStr(head.setName);
+                bulk.addStr(head.setArea);
+                bulk.addStr(head.setID);
+                bulk.addStr(body.vInfo[i].policy);
 
                 //如果是平均值
                 if(body.vInfo[i].policy == "Avg")
                 {
-                    vector<string> sTmp = TC_Common::sepstr<string>(body.vInfo[i].value,"=");
-                    double avg = 0;
-                    if(2 == sTmp.size() && TC_Common::strto<long>(sTmp[1]) != 0)
+                    TC_StringView vt[2];
+                    size_t n = TC_Common::sepstr(body.vInfo[i].value, "=", vt, 2);
+
+                    double sum = 0;
+                    long cnt = 0;
+                    if(n > 0)
                     {
-                        avg = TC_Common::strto<double>(sTmp[0])/TC_Common::strto<long>(sTmp[1]);
+                        TC_Common::strto(vt[0], sum);
                     }
-                    else
+
+                    double avg = sum;
+                    if(2 == n && TC_Common::strto(vt[1], cnt) && cnt != 0)
                     {
-                        avg = TC_Common::strto<double>(sTmp[0]);
+                        avg = sum / cnt;
                     }
 
-                    
-                    strValues += pMysql->escapeString(TC_Common::tostr(avg));
-                    strValues += "') ";
+                    bulk.addStr(TC_Common::tostr(avg));
                 }
                 else
                 {
-                    strValues += pMysql->escapeString(body.vInfo[i].value);
-                    strValues += "') ";
+                    bulk.addStr(body.vInfo[i].value);
                 }
 
-                if ( iCount == 0 )
-                {
-                    osSql.str("");
-                    osSql << "insert ignore into " + strTbName + "  (f_date,f_tflag,master_name,master_ip,property_name,set_name,set_area,set_id,policy,value) values ";
-                    osSql << strValues;
-                }
-                else
+                //够行数或者语句长度时写入
+                size_t iFlushed = bulk.endRow();
+                if (iFlushed != 0)
                 {
-                    osSql<< "," + strValues;
+                    TLOGDEBUG("insert " << strTbName << " affected:" << iFlushed << endl);
+
+                    FDLOG("PropertyPool") << "propertypool ip:" << ServerConfig::LocalIp << "|insert " << strTbName << "|insert affected:" << iFlushed << "|mysql affected:" << pMysql->getAffectedRows() << endl;
                 }
-                iNowWriteNum++;
-                iCount ++;
             }
-            if ( iCount >= _maxInsertCount )
-            {
-                usleep(100);
-                pMysql->execute(osSql.str());    
 
-                TLOGDEBUG("insert " << strTbName << " affected:" << iCount  << endl);
-
-                FDLOG("PropertyPool") << "propertypool ip:" << ServerConfig::LocalIp << "|insert " << strTbName << "|insert affected:" << iCount << "|mysql affected:" << pMysql->getAffectedRows() << endl;
-
-                iCount = 0;
+            //这个head的数据都已经写入了, 重试时可以跳过
+            if (bulk.pending() == 0)
+            {
+                iNowWriteNum = iHeadNum;
             }
         }
 
+        size_t iCount = bulk.flush();
         if ( iCount != 0 )
         {
-            pMysql->execute(osSql.str());
             TLOGDEBUG("insert " << strTbName << " affected:" << iCount << endl);
             FDLOG("PropertyPool") << "statsec ip:" << ServerConfig::LocalIp << "|insert " << strTbName << "|insert affected:" << iCount << "|mysql affected:" << pMysql->getAffectedRows() << endl;
         }
+
+        iNowWriteNum = iHeadNum;
     }
     catch (TC_Mysql_Exception& ex)
     {
@@ -107,6 +107,7 @@ private:
     string              _sqlStatus;        //创建表t_ecstatus
     string              _tbNamePre;        //表前缀
     int                 _maxInsertCount;   //一次最大插入条数
+    TC_MysqlBulk::BulkMode _bulkMode;      //批量写入方式: 多行insert或者load data
     CutType             _cutType;          //分表类型
     int                    _tableInterval;
     map<string,string>  _reapSql;          //定时执行sql
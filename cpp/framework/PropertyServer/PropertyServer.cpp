@@ -293,15 +293,18 @@ void PropertyServer::getTimeInfo(time_t &tTime,string &sDate,string &sFlag)
 {
      //3G统计要求
     //loadIntev 单位为分钟 
-    string sTime,sHour,sMinute;
     time_t t    = TNOW;
     t           = (t/(_insertInterval*60))*_insertInterval*60;    //要求必须为Intev整数倍
     tTime       = t;
     t           = (t%3600 == 0?t-60:t);                                 //要求将9点写作0860  
-    sTime       = TC_Common::tm2str(t,"%Y%m%d%H%M");
-    sDate       = sTime.substr(0,8);
-    sHour       = sTime.substr(8,2);
-    sMinute     = sTime.substr(10,2);
-    sFlag       = sHour +  (sMinute=="59"?"60":sMinute);                //要求将9点写作0860     
+    char sTime[32];
+    TC_TimeProvider::tm2str(t, TC_TimeProvider::TF_MINUTE, sTime);     //"%Y%m%d%H%M", 不用每次localtime_r
+    sDate.assign(sTime, 8);
+    sFlag.assign(sTime + 8, 4);
+    if(sFlag[2] == '5' && sFlag[3] == '9')                //要求将9点写作0860
+    {
+        sFlag[2] = '6';
+        sFlag[3] = '0';
+    }
 }
 
@@ -15,6 +15,8 @@
  */
 
 #include "DbProxy.h"
+#include "RequestDecoder.h"
+#include "servant/StatReport.h"
 #include <time.h>
 
 ///////////////////////////////////////////////////////////
@@ -26,6 +28,8 @@ void selectLastMinTime(const string& sUid, int iThread , const string& tbname, c
 
 void query(int iThread, const TC_DBConf & conf, map<string,string>& mSqlPart, map<string, vector<Int64> > &result, string &sRes, QueryParam &queryParam);
 
+string formatValue(const vector<Int64> &value, const map<string,string>& mSqlPart);
+
 DbProxy::DbProxy()
 {
 }
@@ -84,6 +88,10 @@ int DbProxy::createRespData(const string& sUid, const map<string,string>& mSqlPa
             {
                 const vector<Int64> &number1 = it->second;
                 vector<Int64> &number2 = _it->second;
+                if (number2.size() < number1.size())
+                {
+                    number2.resize(number1.size(), 0);
+                }
                 // 相同key的值 求和,number1和number1的大小是一样的
                 for (size_t j=0; j<number1.size(); j++)
                 {
@@ -192,14 +200,7 @@ int DbProxy::createRespData(const string& sUid, const map<string,string>& mSqlPa
             {
                 ++iLineNum;
 
-                string valueBuffer = "";
-                vector<Int64>::iterator valueIt = _it->second.begin();
-                while(valueIt != _it->second.end()) // value is vector int, need transfer to string;
-                {
-                    valueBuffer += TC_Common::tostr(*valueIt);
-                    valueBuffer += ",";
-                    valueIt++;
-                }
+                string valueBuffer = formatValue(_it->second, mSqlPart);
 
                 sTemp += _it->first;
                 sTemp += ",";
@@ -211,14 +212,7 @@ int DbProxy::createRespData(const string& sUid, const map<string,string>& mSqlPa
         {
             ++iLineNum;
 
-            string valueBuffer = "";
-            vector<Int64>::iterator valueIt = _it->second.begin();
-            while(valueIt != _it->second.end()) // value is vector int, need transfer to string;
-            {
-                valueBuffer += TC_Common::tostr(*valueIt);
-                valueBuffer += ",";
-                valueIt++;
-            }
+            string valueBuffer = formatValue(_it->second, mSqlPart);
 
             sTemp += _it->first;
             sTemp += ",";
@@ -391,6 +385,116 @@ void DbProxy::queryData(map<string, string> &mSqlPart, string &sResult, bool bDb
     _queryParam._atomic = 0;
 }
 
+/**
+ * 查出高精度耗时分布(hist_count), 逐行按桶累加到每个key的值后面(从iSumNum开始)
+ * 没有hist_count列的旧表只打日志, 分位数为0
+ */
+void queryHist(TC_Mysql &tcMysql, const string &sTbName, const string &ignoreKey, const string &whereCond, const string &groupField,
+               const vector<string> &vGroupField, size_t iSumNum, map<string, vector<Int64> > &result)
+{
+    string selectCond = groupField;
+
+    string::size_type pos = selectCond.find("f_date");
+    if (pos != string::npos)
+    {
+        selectCond.replace(pos, 6, "DATE_FORMAT( f_date, '%Y%m%d') as f_date");
+    }
+
+    string sSql = "select " + (selectCond.empty() ? "" : selectCond + ",") + " hist_count from " + sTbName + " " + ignoreKey
+                + (whereCond.empty() ? " where " : whereCond + " and ") + " hist_count != '';";
+
+    try
+    {
+        tars::TC_Mysql::MysqlData res = tcMysql.queryRecord(sSql);
+
+        TLOGINFO("queryHist res.size:" << res.size() << "|sSql:" << sSql << endl);
+
+        TC_StringView vBucket[StatCounter::HIST_BUCKETS];
+
+        for(size_t iRow = 0; iRow < res.size(); iRow++)
+        {
+            string sKey = "";
+            for(size_t j = 0; j < vGroupField.size(); j++)
+            {
+                sKey += sKey.empty()?"":",";
+                sKey += res[iRow][vGroupField[j]];
+            }
+
+            vector<Int64>& data = result[sKey];
+            if (data.size() < iSumNum + StatCounter::HIST_BUCKETS)
+            {
+                data.resize(iSumNum + StatCounter::HIST_BUCKETS, 0);
+            }
+
+            //桶下标|调用量,...
+            const string &sHist = res[iRow]["hist_count"];
+            size_t n = TC_Common::sepstr(sHist, ",", vBucket, StatCounter::HIST_BUCKETS);
+            for(size_t j = 0; j < n && j < (size_t)StatCounter::HIST_BUCKETS; j++)
+            {
+                TC_StringView v[2];
+                int iIndex = 0;
+                Int64 iCount = 0;
+                if (TC_Common::sepstr(vBucket[j], "|", v, 2) == 2 && TC_Common::strto(v[0], iIndex) && TC_Common::strto(v[1], iCount)
+                    && iIndex >= 0 && iIndex < StatCounter::HIST_BUCKETS)
+                {
+                    data[iSumNum + iIndex] += iCount;
+                }
+            }
+        }
+    }
+    catch(TC_Mysql_Exception & ex)
+    {
+        TLOGERROR("queryHist " << sTbName << " exception:" << ex.what() << endl);
+    }
+}
+
+/**
+ * 一个key的查询结果转成字符串, 有分位数时按请求的指标顺序输出
+ */
+string formatValue(const vector<Int64> &value, const map<string,string>& mSqlPart)
+{
+    string valueBuffer = "";
+
+    map<string,string>::const_iterator it = mSqlPart.find("outputIndex");
+    if (it == mSqlPart.end())
+    {
+        for (size_t i = 0; i < value.size(); ++i)
+        {
+            valueBuffer += TC_Common::tostr(value[i]);
+            valueBuffer += ",";
+        }
+        return valueBuffer;
+    }
+
+    size_t iSumNum = TC_Common::sepstr<string>(mSqlPart.find("sumField")->second, ", ").size();
+
+    //没有分布数据的key(比如全是旧表的数据)补0
+    vector<Int64> hist(StatCounter::HIST_BUCKETS, 0);
+    if (value.size() >= iSumNum + StatCounter::HIST_BUCKETS)
+    {
+        hist.assign(value.begin() + iSumNum, value.begin() + iSumNum + StatCounter::HIST_BUCKETS);
+    }
+
+    size_t iSum = 0;
+    vector<string> vIndex = TC_Common::sepstr<string>(it->second, ",");
+    for (size_t i = 0; i < vIndex.size(); ++i)
+    {
+        double fPercent = 0;
+        if (RequestDecoder::parsePercentile(vIndex[i], fPercent))
+        {
+            valueBuffer += TC_Common::tostr(StatCounter::getPercentile(&hist[0], fPercent));
+        }
+        else
+        {
+            valueBuffer += TC_Common::tostr(iSum < value.size() ? value[iSum] : 0);
+            ++iSum;
+        }
+        valueBuffer += ",";
+    }
+
+    return valueBuffer;
+}
+
 void query(int iThread, const TC_DBConf & conf, map<string,string>& mSqlPart, map<string, vector<Int64> > &result, string &sRes, QueryParam &queryParam)
 {
     string sUid = mSqlPart.find("uid")->second;
@@ -465,6 +569,9 @@ void query(int iThread, const TC_DBConf & conf, map<string,string>& mSqlPart, ma
         vector<string> vGroupField = TC_Common::sepstr<string>(groupField, ", ");
         vector<string> vSumField = TC_Common::sepstr<string>(sumField, ", ");
 
+        //要算分位数时, 每个key的值后面跟着按桶展开的高精度耗时分布
+        bool bPercentile = (mSqlPart.find("outputIndex") != mSqlPart.end());
+
         TC_Mysql tcMysql;
 
         TC_DBConf tcDbConf = conf;
@@ -528,10 +635,20 @@ void query(int iThread, const TC_DBConf & conf, map<string,string>& mSqlPart, ma
                         {
                             vRes.push_back( TC_Common::strto<Int64>(res[iRow][vSumField[j]]));;
                         }
+
+                        if(bPercentile)
+                        {
+                            vRes.resize(vSumField.size() + StatCounter::HIST_BUCKETS, 0);
+                        }
                     }
                     TLOGINFO("query iDb:" << iThread <<" {"<< sKey << ":" << TC_Common::tostr(result[sKey]) << "}" << endl);
                 }
 
+                if(bPercentile)
+                {
+                    queryHist(tcMysql, sTbName, ignoreKey, whereCond, groupField, vGroupField, vSumField.size(), result);
+                }
+
                 TLOGINFO("query iDb :" << iThread << " day:" << day <<" tflag:" << tflag << endl);
             }
         }  //day
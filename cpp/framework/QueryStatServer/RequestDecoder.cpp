@@ -264,26 +264,63 @@ int RequestDecoder::composeSqlPartition()
     }
 
     string sumField = "";
+    string outputIndex = "";
+    bool bPercentile = false;
     vConditions.clear();
     iRet=generateVector(_req,"indexs",vConditions);
-    if (vConditions.empty())
-    {
-        sumField = " sum(succ_count) ";
-    }
-    else
+
+    vector<string>::iterator it = vConditions.begin();
+    while(it != vConditions.end())
     {
-        vector<string>::iterator it = vConditions.begin();
-        while(it != vConditions.end())
+        //p99,p999这样的分位数由hist_count算出, 不参与sum
+        double fPercent = 0;
+        if(parsePercentile(*it, fPercent))
+        {
+            bPercentile = true;
+        }
+        else
         {
             sumField += string((sumField.empty()?"":", ")) + " sum(" + *it + ")" ;
-             it++;
         }
+
+        outputIndex += (outputIndex.empty()?"":",") + *it;
+        it++;
+    }
+
+    if (sumField.empty())
+    {
+        sumField = " sum(succ_count) ";
     }
 
     _sql["sumField"]= sumField;
+
+    //有分位数时按请求的顺序输出
+    if (bPercentile)
+    {
+        _sql["outputIndex"] = outputIndex;
+    }
     return 0;
 }
 
+bool RequestDecoder::parsePercentile(const string& sIndex, double& fPercent)
+{
+    if (sIndex.length() < 2 || sIndex.length() > 10 || sIndex[0] != 'p' || !TC_Common::isdigit(sIndex.substr(1)))
+    {
+        return false;
+    }
+
+    //p50 => 0.5, p99 => 0.99, p999 => 0.999
+    double fBase = 1;
+    for (size_t i = 1; i < sIndex.length(); ++i)
+    {
+        fBase *= 10;
+    }
+
+    fPercent = TC_Common::strto<double>(sIndex.substr(1)) / fBase;
+
+    return fPercent > 0 && fPercent <= 1;
+}
+
 int RequestDecoder::parseCondition(const string& sCond, string& value)
 {
     string::size_type pos =0;
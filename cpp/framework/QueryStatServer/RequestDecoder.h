@@ -83,6 +83,14 @@ public:
 
     int  generateVector(Document &d ,const string s,std::vector<string> &v);
 
+    /**
+     * 分位数指标: p50, p99, p999..., 按高精度耗时分布(hist_count)计算, 单位微秒
+     * @param sIndex   指标名
+     * @param fPercent 输出, 0~1
+     * @return bool    是否分位数指标
+     */
+    static bool parsePercentile(const string& sIndex, double& fPercent);
+
 private:
     //待解析的json请求串
     string _input;
@@ -160,7 +160,7 @@ void ReapSSDThread::terminate()
 
 void ReapSSDThread::run()
 {
-    int iInsertDataNum = StatDbManager::getInstance()->getDbIpNum();
+    int iInsertDataNum = StatDbManager::getInstance()->getInsertDbThreadNum();
 
     for(int i = 0; i < iInsertDataNum; ++i)
     {
@@ -275,11 +275,7 @@ void ReapSSDThread::run()
                     }
                 }
 
-                for(int k = 0; k < g_app.getBuffNum(); ++k)
-                {
-                    StatHashMap *pHashMap = g_app.getHashMapBuff(iBufferIndex, k);
-                    pHashMap->clear();
-                }
+                g_app.getAggTable(iBufferIndex)->clear();
 
                 TLOGDEBUG("stat ip:" << ServerConfig::LocalIp << "|Buffer Index:" << iBufferIndex << "|ReapSSDThread::run insert record num:" << iTotalNum << "|tast patch finished." << endl);
                 FDLOG("CountStat") << "stat ip:" << ServerConfig::LocalIp << "|Buffer Index:" << iBufferIndex << "|ReapSSDThread::run insert record num:" << iTotalNum << "|tast patch finished." << endl;
@@ -368,59 +364,36 @@ void ReapSSDThread::getDataFromBuffer(int iIndex, vector<StatMsg*> &vAllStatMsg,
 
         bool bEnable = StatDbManager::getInstance()->IsEnableWeighted();
 
-        for(int k = 0; k < g_app.getBuffNum(); ++k)
-        {
-            if(_terminate)
-            {
-                break;
-            }
+        StatAggTable *pTable = g_app.getAggTable(iIndex);
 
-            StatHashMap *pHashMap = g_app.getHashMapBuff(iIndex, k);
+        FDLOG("CountStat") << "stat ip:" << ServerConfig::LocalIp << "|Buffer Index:" << iIndex << "|ReapSSDThread::getData load " << pTable->desc() << endl;
 
-            if(pHashMap->size() == 0)
+        StatMicMsgHead head;
+        StatMicMsgBody body;
+
+        for(size_t i = 0; i < pTable->capacity() && !_terminate; ++i)
+        {
+            if(!pTable->get(i, head, body))
             {
-                continue ;
+                continue;
             }
 
-            FDLOG("CountStat") << "stat ip:" << ServerConfig::LocalIp << "|Buffer Index:" << iIndex << "|ReapSSDThread::getData load hashmap k:" << k << endl;
-
-            HashMap::lock_iterator it = pHashMap->beginSetTime();
-            while ( it != pHashMap->end() )
+            if (dbNumber > 0)
             {
-                if(_terminate)
+                if(bEnable)//按权重入库
                 {
-                    break;
+                    dbSeq = getIndexWithWeighted(dbNumber,iGcd,iMaxW,vDbWeight);
+                    TLOGINFO("ReapSSDThread::getIndexWithWeighted |" << dbSeq << endl);
                 }
-
-                StatMicMsgHead head;
-                StatMicMsgBody body;
-                int ret = it->get( head, body );
-                if ( ret < 0 )
-                {
-                    ++it;
-                    continue;
-                }
-
-                if (dbNumber > 0)
+                else
                 {
-                    if(bEnable)//按权重入库
-                    {
-                        dbSeq = getIndexWithWeighted(dbNumber,iGcd,iMaxW,vDbWeight);
-                        TLOGINFO("ReapSSDThread::getIndexWithWeighted |" << dbSeq << endl);
-                    }
-                    else
-                    {
-                        dbSeq = iCount % dbNumber;
-                    }
-
-                    (*(vAllStatMsg[dbSeq]))[head] = body;
+                    dbSeq = iCount % dbNumber;
                 }
 
-                iCount++;
-
-                ++it;
+                (*(vAllStatMsg[dbSeq]))[head] = body;
             }
 
+            iCount++;
         }
 
         iTotalNum = iCount;
@@ -0,0 +1,596 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+
+#include "StatAggTable.h"
+#include "servant/StatReport.h"
+#include "servant/TarsLogger.h"
+#include "util/tc_common.h"
+#include <algorithm>
+
+#define STAT_AGG_MAGIC      "TARSAGG"
+#define STAT_AGG_VERSION    1
+
+struct StatAggTable::Head
+{
+    char                _magic[8];
+    uint32_t            _version;
+    uint32_t            _entrySize;
+    uint32_t            _histBuckets;
+    uint32_t            _capacity;
+    uint32_t            _stripeNum;
+    uint32_t            _strSlots;
+    uint32_t            _histBlocks;
+    uint32_t            _histUsed;      //已分配的耗时分布块
+    uint64_t            _strBytes;
+    uint64_t            _strUsed;       //字符串区已用字节
+    uint64_t            _strCount;      //字符串个数
+};
+
+struct StatAggTable::Entry
+{
+    uint32_t            _hash;          //0表示空槽
+    Key                 _key;
+    int32_t             _count;
+    int32_t             _timeoutCount;
+    int32_t             _execCount;
+    int32_t             _maxRspTime;
+    int32_t             _minRspTime;
+    uint32_t            _hist;          //耗时分布的块号+1, 0表示没有
+    int64_t             _totalRspTime;
+    int32_t             _intervalNum;
+    int32_t             _intervalPoint[MAX_INTERVAL];
+    int32_t             _intervalCount[MAX_INTERVAL];
+};
+
+namespace
+{
+    //字符串区的记录: [hash(4)][len(2)][bytes], 按4字节对齐
+    const size_t STR_HEAD_LEN   = 6;
+    //偏移0留给空串
+    const size_t STR_BEGIN      = 8;
+    const size_t HEAD_SIZE      = 4096;
+
+    inline uint32_t mix(uint32_t h)
+    {
+        h ^= h >> 16;
+        h *= 0x85ebca6b;
+        h ^= h >> 13;
+        h *= 0xc2b2ae35;
+        h ^= h >> 16;
+        return h;
+    }
+
+    inline uint32_t hashStr(const char *str, size_t len)
+    {
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < len; ++i)
+        {
+            h ^= (unsigned char)str[i];
+            h *= 16777619u;
+        }
+        return mix(h);
+    }
+
+    inline size_t floorPow2(size_t n)
+    {
+        size_t p = 1;
+        while (p * 2 <= n)
+        {
+            p *= 2;
+        }
+        return p;
+    }
+
+    inline size_t align8(size_t n)
+    {
+        return (n + 7) & ~(size_t)7;
+    }
+
+    struct StripeLess
+    {
+        uint32_t mask;
+
+        bool operator()(const StatAggTable::Record &a, const StatAggTable::Record &b) const
+        {
+            return (a.hash & mask) < (b.hash & mask);
+        }
+    };
+}
+
+StatAggTable::StatAggTable()
+: _head(NULL)
+, _entry(NULL)
+, _str(NULL)
+, _hist(NULL)
+, _strIndex(NULL)
+, _capacity(0)
+, _stripeNum(0)
+, _stripeSlots(0)
+, _strSlots(0)
+, _strBytes(0)
+, _histBlocks(0)
+, _stripe(NULL)
+{
+}
+
+StatAggTable::~StatAggTable()
+{
+    delete [] _stripe;
+}
+
+void StatAggTable::initLayout(size_t size, size_t stripes)
+{
+    //一半给记录区, 其余给字典和耗时分布
+    _capacity    = floorPow2(size / 2 / sizeof(Entry));
+    _stripeNum   = floorPow2(stripes > 0 ? stripes : 1);
+
+    while (_stripeNum > 1 && _capacity / _stripeNum < 64)
+    {
+        _stripeNum /= 2;
+    }
+
+    if (_capacity / _stripeNum < 64)
+    {
+        throw runtime_error("StatAggTable size too small:" + TC_Common::tostr(size));
+    }
+
+    _stripeSlots = _capacity / _stripeNum;
+    _strSlots    = _capacity;
+    _strBytes    = _capacity * 32;
+
+    //文件最后一个字节每次mmap时会被写0, 不用
+    size_t used  = HEAD_SIZE + _capacity * sizeof(Entry) + _strSlots * sizeof(uint32_t) + _strBytes;
+    size_t block = StatCounter::HIST_BUCKETS * sizeof(int);
+
+    _histBlocks  = size > used + 8 ? (size - used - 8) / block : 0;
+}
+
+void StatAggTable::init(const string &file, size_t size, size_t stripes)
+{
+    initLayout(size, stripes);
+
+    _mmap.mmap(file.c_str(), size);
+
+    char *p   = (char*)_mmap.getPointer();
+    _head     = (Head*)p;
+    p        += HEAD_SIZE;
+    _entry    = (Entry*)p;
+    p        += _capacity * sizeof(Entry);
+    _strIndex = (uint32_t*)p;
+    p        += _strSlots * sizeof(uint32_t);
+    _str      = p;
+    p        += _strBytes;
+    _hist     = (int*)align8((size_t)p);
+
+    delete [] _stripe;
+    _stripe = new Stripe[_stripeNum];
+
+    if (memcmp(_head->_magic, STAT_AGG_MAGIC, sizeof(_head->_magic)) == 0
+            && _head->_version == STAT_AGG_VERSION
+            && _head->_entrySize == sizeof(Entry)
+            && _head->_histBuckets == StatCounter::HIST_BUCKETS
+            && _head->_capacity == _capacity
+            && _head->_stripeNum == _stripeNum
+            && _head->_strSlots == _strSlots
+            && _head->_strBytes == _strBytes
+            && _head->_histBlocks == _histBlocks
+            && _head->_strUsed <= _strBytes
+            && _head->_histUsed <= _histBlocks)
+    {
+        //沿用上次的数据, 重新统计每段的记录数
+        for (size_t i = 0; i < _capacity; ++i)
+        {
+            if (_entry[i]._hash != 0)
+            {
+                ++_stripe[i / _stripeSlots].used;
+            }
+        }
+
+        TLOGDEBUG("StatAggTable::init reuse file:" << file << "|" << desc() << endl);
+        return;
+    }
+
+    TLOGDEBUG("StatAggTable::init new file:" << file << "|iscreate:" << _mmap.iscreate() << endl);
+
+    memset(_head, 0, HEAD_SIZE);
+    memcpy(_head->_magic, STAT_AGG_MAGIC, sizeof(_head->_magic));
+    _head->_version     = STAT_AGG_VERSION;
+    _head->_entrySize   = sizeof(Entry);
+    _head->_histBuckets = StatCounter::HIST_BUCKETS;
+    _head->_capacity    = _capacity;
+    _head->_stripeNum   = _stripeNum;
+    _head->_strSlots    = _strSlots;
+    _head->_strBytes    = _strBytes;
+    _head->_histBlocks  = _histBlocks;
+
+    reset();
+
+    TLOGDEBUG("StatAggTable::init " << desc() << endl);
+}
+
+void StatAggTable::reset()
+{
+    memset(_entry, 0, _capacity * sizeof(Entry));
+    memset(_strIndex, 0, _strSlots * sizeof(uint32_t));
+
+    _head->_strUsed  = STR_BEGIN;
+    _head->_strCount = 0;
+    _head->_histUsed = 0;
+
+    for (size_t i = 0; i < _stripeNum; ++i)
+    {
+        _stripe[i].used = 0;
+    }
+}
+
+void StatAggTable::clear()
+{
+    for (size_t i = 0; i < _stripeNum; ++i)
+    {
+        _stripe[i].lock.lock();
+    }
+
+    {
+        TC_LockT<TC_ThreadMutex> lock(_strLock);
+        reset();
+    }
+
+    for (size_t i = 0; i < _stripeNum; ++i)
+    {
+        _stripe[i].lock.unlock();
+    }
+}
+
+const char *StatAggTable::getStr(uint32_t id, size_t &len) const
+{
+    if (id == 0)
+    {
+        len = 0;
+        return "";
+    }
+
+    const char *p = _str + id;
+    len = *(const uint16_t*)(p + 4);
+    return p + STR_HEAD_LEN;
+}
+
+uint32_t StatAggTable::intern(const char *str, size_t len)
+{
+    if (len == 0)
+    {
+        return 0;
+    }
+
+    if (len > MAX_STR_LEN)
+    {
+        len = MAX_STR_LEN;
+    }
+
+    uint32_t h    = hashStr(str, len);
+    size_t   mask = _strSlots - 1;
+    size_t   pos  = h & mask;
+
+    //先不加锁找, 槽位是写完字符串之后才发布的
+    while (true)
+    {
+        uint32_t id = __atomic_load_n(&_strIndex[pos], __ATOMIC_ACQUIRE);
+        if (id == 0)
+        {
+            break;
+        }
+
+        const char *p = _str + id;
+        if (*(const uint32_t*)p == h && *(const uint16_t*)(p + 4) == len && memcmp(p + STR_HEAD_LEN, str, len) == 0)
+        {
+            return id;
+        }
+
+        pos = (pos + 1) & mask;
+    }
+
+    TC_LockT<TC_ThreadMutex> lock(_strLock);
+
+    //加锁期间可能被别的线程加进来了, 从空槽接着找
+    while (true)
+    {
+        uint32_t id = _strIndex[pos];
+        if (id == 0)
+        {
+            break;
+        }
+
+        const char *p = _str + id;
+        if (*(const uint32_t*)p == h && *(const uint16_t*)(p + 4) == len && memcmp(p + STR_HEAD_LEN, str, len) == 0)
+        {
+            return id;
+        }
+
+        pos = (pos + 1) & mask;
+    }
+
+    size_t need = (STR_HEAD_LEN + len + 3) & ~(size_t)3;
+    if (_head->_strCount >= _strSlots * 3 / 4 || _head->_strUsed + need > _strBytes)
+    {
+        return INVALID_ID;
+    }
+
+    uint32_t id = (uint32_t)_head->_strUsed;
+    char     *p = _str + id;
+
+    *(uint32_t*)p       = h;
+    *(uint16_t*)(p + 4) = (uint16_t)len;
+    memcpy(p + STR_HEAD_LEN, str, len);
+
+    _head->_strUsed += need;
+    ++_head->_strCount;
+
+    __atomic_store_n(&_strIndex[pos], id, __ATOMIC_RELEASE);
+
+    return id;
+}
+
+bool StatAggTable::makeRecord(const StatMicMsgHead &head, const StatMicMsgBody &body, const string &masterIp, const string &slaveIp, Record &record)
+{
+    Key &key = record.key;
+
+    string::size_type pos = head.masterName.find('@');
+    if (pos != string::npos)
+    {
+        key.masterName  = intern(head.masterName.c_str(), pos);
+        key.tarsVersion = intern(head.masterName.c_str() + pos + 1, head.masterName.length() - pos - 1);
+    }
+    else
+    {
+        key.masterName  = intern(head.masterName);
+        key.tarsVersion = intern(head.tarsVersion);
+    }
+
+    key.slaveName     = intern(head.slaveName);
+    key.interfaceName = intern(head.interfaceName);
+    key.masterIp      = intern(masterIp);
+    key.slaveIp       = intern(slaveIp);
+    key.slaveSetName  = intern(head.slaveSetName);
+    key.slaveSetArea  = intern(head.slaveSetArea);
+    key.slaveSetID    = intern(head.slaveSetID);
+    key.slavePort     = head.slavePort;
+    key.returnValue   = head.returnValue;
+    record.body       = &body;
+
+    return makeHash(record);
+}
+
+bool StatAggTable::makeHash(Record &record)
+{
+    const Key &key = record.key;
+    if (key.masterName == INVALID_ID || key.slaveName == INVALID_ID || key.interfaceName == INVALID_ID
+            || key.masterIp == INVALID_ID || key.slaveIp == INVALID_ID || key.slaveSetName == INVALID_ID
+            || key.slaveSetArea == INVALID_ID || key.slaveSetID == INVALID_ID || key.tarsVersion == INVALID_ID)
+    {
+        return false;
+    }
+
+    const uint32_t *p = (const uint32_t*)&key;
+
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < sizeof(Key) / sizeof(uint32_t); ++i)
+    {
+        h = (h ^ p[i]) * 16777619u;
+    }
+
+    h = mix(h);
+
+    record.hash = (h == 0 ? 1 : h);
+
+    return true;
+}
+
+void StatAggTable::mergeEntry(Entry &entry, const StatMicMsgBody &body)
+{
+    entry._count        += body.count;
+    entry._timeoutCount += body.timeoutCount;
+    entry._execCount    += body.execCount;
+    entry._totalRspTime += body.totalRspTime;
+
+    if (entry._maxRspTime < body.maxRspTime)
+    {
+        entry._maxRspTime = body.maxRspTime;
+    }
+    //非0最小值
+    if (entry._minRspTime == 0 || (entry._minRspTime > body.minRspTime && body.minRspTime != 0))
+    {
+        entry._minRspTime = body.minRspTime;
+    }
+
+    for (map<int, int>::const_iterator it = body.intervalCount.begin(); it != body.intervalCount.end(); ++it)
+    {
+        int i = 0;
+        while (i < entry._intervalNum && entry._intervalPoint[i] != it->first)
+        {
+            ++i;
+        }
+
+        if (i == entry._intervalNum)
+        {
+            if (i == MAX_INTERVAL)
+            {
+                continue;
+            }
+            entry._intervalPoint[i] = it->first;
+            entry._intervalCount[i] = 0;
+            ++entry._intervalNum;
+        }
+
+        entry._intervalCount[i] += it->second;
+    }
+
+    if (body.histCount.empty())
+    {
+        return;
+    }
+
+    if (entry._hist == 0)
+    {
+        //各段并发分配, 用原子操作; 分配完了就不保存分布
+        uint32_t block = 0;
+        do
+        {
+            block = _head->_histUsed;
+            if (block >= _histBlocks)
+            {
+                return;
+            }
+        }
+        while (!__sync_bool_compare_and_swap(&_head->_histUsed, block, block + 1));
+
+        entry._hist = block + 1;
+        memset(_hist + (size_t)block * StatCounter::HIST_BUCKETS, 0, StatCounter::HIST_BUCKETS * sizeof(int));
+    }
+
+    int *hist = _hist + (size_t)(entry._hist - 1) * StatCounter::HIST_BUCKETS;
+    for (map<int, int>::const_iterator it = body.histCount.begin(); it != body.histCount.end(); ++it)
+    {
+        if (it->first >= 0 && it->first < StatCounter::HIST_BUCKETS)
+        {
+            hist[it->first] += it->second;
+        }
+    }
+}
+
+size_t StatAggTable::merge(vector<Record> &records)
+{
+    StripeLess less;
+    less.mask = _stripeNum - 1;
+
+    std::sort(records.begin(), records.end(), less);
+
+    size_t dropped  = 0;
+    size_t slotMask = _stripeSlots - 1;
+    size_t limit    = _stripeSlots * 9 / 10;
+
+    size_t i = 0;
+    while (i < records.size())
+    {
+        size_t  s       = records[i].hash & less.mask;
+        Stripe  &stripe = _stripe[s];
+        Entry   *base   = _entry + s * _stripeSlots;
+
+        TC_LockT<TC_ThreadMutex> lock(stripe.lock);
+
+        for (; i < records.size() && (records[i].hash & less.mask) == s; ++i)
+        {
+            const Record &r = records[i];
+
+            size_t pos = (r.hash / _stripeNum) & slotMask;
+            while (base[pos]._hash != 0 && (base[pos]._hash != r.hash || memcmp(&base[pos]._key, &r.key, sizeof(Key)) != 0))
+            {
+                pos = (pos + 1) & slotMask;
+            }
+
+            Entry &entry = base[pos];
+            if (entry._hash == 0)
+            {
+                //新记录, 超过九成不再放
+                if (stripe.used >= limit)
+                {
+                    ++dropped;
+                    continue;
+                }
+
+                memset(&entry, 0, sizeof(Entry));
+                entry._hash = r.hash;
+                entry._key  = r.key;
+                ++stripe.used;
+            }
+
+            mergeEntry(entry, *r.body);
+        }
+    }
+
+    return dropped;
+}
+
+bool StatAggTable::get(size_t i, StatMicMsgHead &head, StatMicMsgBody &body) const
+{
+    const Entry &entry = _entry[i];
+    if (entry._hash == 0)
+    {
+        return false;
+    }
+
+    const Key &key = entry._key;
+    size_t    len  = 0;
+    const char *p  = NULL;
+
+    p = getStr(key.masterName, len);    head.masterName.assign(p, len);
+    p = getStr(key.slaveName, len);     head.slaveName.assign(p, len);
+    p = getStr(key.interfaceName, len); head.interfaceName.assign(p, len);
+    p = getStr(key.masterIp, len);      head.masterIp.assign(p, len);
+    p = getStr(key.slaveIp, len);       head.slaveIp.assign(p, len);
+    p = getStr(key.slaveSetName, len);  head.slaveSetName.assign(p, len);
+    p = getStr(key.slaveSetArea, len);  head.slaveSetArea.assign(p, len);
+    p = getStr(key.slaveSetID, len);    head.slaveSetID.assign(p, len);
+    p = getStr(key.tarsVersion, len);   head.tarsVersion.assign(p, len);
+    head.slavePort   = key.slavePort;
+    head.returnValue = key.returnValue;
+
+    body.count        = entry._count;
+    body.timeoutCount = entry._timeoutCount;
+    body.execCount    = entry._execCount;
+    body.totalRspTime = entry._totalRspTime;
+    body.maxRspTime   = entry._maxRspTime;
+    body.minRspTime   = entry._minRspTime;
+
+    body.intervalCount.clear();
+    for (int k = 0; k < entry._intervalNum; ++k)
+    {
+        body.intervalCount[entry._intervalPoint[k]] = entry._intervalCount[k];
+    }
+
+    body.histCount.clear();
+    if (entry._hist != 0)
+    {
+        const int *hist = _hist + (size_t)(entry._hist - 1) * StatCounter::HIST_BUCKETS;
+        for (int k = 0; k < StatCounter::HIST_BUCKETS; ++k)
+        {
+            if (hist[k] != 0)
+            {
+                body.histCount[k] = hist[k];
+            }
+        }
+    }
+
+    return true;
+}
+
+size_t StatAggTable::size() const
+{
+    size_t n = 0;
+    for (size_t i = 0; i < _stripeNum; ++i)
+    {
+        n += _stripe[i].used;
+    }
+    return n;
+}
+
+string StatAggTable::desc() const
+{
+    ostringstream os;
+    os << "capacity:" << _capacity << "|stripes:" << _stripeNum << "|size:" << size()
+       << "|strSlots:" << _strSlots << "|strCount:" << _head->_strCount
+       << "|strBytes:" << _strBytes << "|strUsed:" << _head->_strUsed
+       << "|histBlocks:" << _histBlocks << "|histUsed:" << _head->_histUsed;
+    return os.str();
+}
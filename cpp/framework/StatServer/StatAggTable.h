@@ -0,0 +1,187 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+
+#ifndef __STAT_AGG_TABLE_H_
+#define __STAT_AGG_TABLE_H_
+
+#include <ext/pool_allocator.h>
+#include "servant/StatF.h"
+#include "util/tc_mmap.h"
+#include "util/tc_thread_mutex.h"
+
+using namespace tars;
+
+typedef std::map<tars::StatMicMsgHead, tars::StatMicMsgBody, std::less<tars::StatMicMsgHead>, __gnu_cxx::__pool_alloc<std::pair<tars::StatMicMsgHead const, tars::StatMicMsgBody> > > StatMsg;
+
+/**
+ * 上报数据的聚合表, 放在mmap文件里, 进程重启后数据还在
+ *
+ * 文件分成四块:
+ * 1 字符串字典: 上报头里的字符串只存一份, 记录里只保存它的id(在字符串区的偏移),
+ *   查找不加锁, 新增字符串时加字典锁
+ * 2 记录区: 开放寻址的定长记录, 按hash分成若干段, 每段一把锁, 段内线性探测,
+ *   记录只增不删, 入库后整体clear
+ * 3 耗时分布区: 有histCount的记录第一次合并时分配一块
+ * 4 字符串索引: 字符串hash -> id, 同样开放寻址
+ *
+ * 合并时不再编解码, 一次reportMicMsg的所有记录按段排序后每段只加一次锁
+ */
+class StatAggTable
+{
+public:
+    enum
+    {
+        MAX_INTERVAL    = 16,           //每条记录最多保存的耗时区间个数
+        MAX_STR_LEN     = 0xFFFF,       //字符串最大长度, 超过的截断
+        INVALID_ID      = 0xFFFFFFFF    //字典满了
+    };
+
+    /**
+     * 上报头, 字符串都换成字典id, 没有填充字节, 可以直接memcmp
+     */
+    struct Key
+    {
+        uint32_t    masterName;
+        uint32_t    slaveName;
+        uint32_t    interfaceName;
+        uint32_t    masterIp;
+        uint32_t    slaveIp;
+        uint32_t    slaveSetName;
+        uint32_t    slaveSetArea;
+        uint32_t    slaveSetID;
+        uint32_t    tarsVersion;
+        int32_t     slavePort;
+        int32_t     returnValue;
+    };
+
+    /**
+     * 待合并的一条记录, hash由makeHash填
+     */
+    struct Record
+    {
+        Key                     key;
+        uint32_t                hash;
+        const StatMicMsgBody    *body;
+    };
+
+    StatAggTable();
+
+    ~StatAggTable();
+
+    /**
+     * 初始化, 文件已存在且格式一致时沿用里面的数据
+     * @param file      mmap文件
+     * @param size      文件大小
+     * @param stripes   段数(锁个数), 会调整成2的幂
+     */
+    void init(const string &file, size_t size, size_t stripes);
+
+    /**
+     * 字符串换成id, 空串是0
+     * @return uint32_t, 字典满了返回INVALID_ID
+     */
+    uint32_t intern(const char *str, size_t len);
+
+    uint32_t intern(const string &str) { return intern(str.c_str(), str.length()); }
+
+    /**
+     * 根据key计算record的hash
+     * @return bool, key里有INVALID_ID(字典满了)时返回false
+     */
+    static bool makeHash(Record &record);
+
+    /**
+     * 上报的一条统计转成待合并的记录: 字符串换成id并计算hash,
+     * masterName带"@版本"时拆出tarsVersion
+     * @param masterIp  入库的主调ip
+     * @param slaveIp   入库的被调ip
+     * @return bool, 字典满了返回false
+     */
+    bool makeRecord(const StatMicMsgHead &head, const StatMicMsgBody &body, const string &masterIp, const string &slaveIp, Record &record);
+
+    /**
+     * 批量合并, 会对records排序
+     * @return size_t, 因为表满了丢弃的记录数
+     */
+    size_t merge(vector<Record> &records);
+
+    /**
+     * 记录槽个数, 配合get遍历
+     */
+    size_t capacity() const { return _capacity; }
+
+    /**
+     * 第i个槽的数据, 遍历前要保证没有写入(双buffer中已切走的那个)
+     * @return bool, 空槽返回false
+     */
+    bool get(size_t i, StatMicMsgHead &head, StatMicMsgBody &body) const;
+
+    /**
+     * 记录数
+     */
+    size_t size() const;
+
+    /**
+     * 清空记录和字典
+     */
+    void clear();
+
+    /**
+     * 描述信息
+     */
+    string desc() const;
+
+protected:
+    struct Head;
+    struct Entry;
+
+    void initLayout(size_t size, size_t stripes);
+
+    void reset();
+
+    const char *getStr(uint32_t id, size_t &len) const;
+
+    void mergeEntry(Entry &entry, const StatMicMsgBody &body);
+
+    struct Stripe
+    {
+        Stripe() : used(0) {}
+
+        TC_ThreadMutex  lock;
+        size_t          used;
+        char            pad[64];    //避免相邻的锁在同一个cache line上
+    };
+
+protected:
+    TC_Mmap             _mmap;
+    Head                *_head;
+    Entry               *_entry;
+    char                *_str;
+    int                 *_hist;
+    uint32_t            *_strIndex;
+
+    size_t              _capacity;
+    size_t              _stripeNum;
+    size_t              _stripeSlots;
+    size_t              _strSlots;
+    size_t              _strBytes;
+    size_t              _histBlocks;
+
+    Stripe              *_stripe;
+    TC_ThreadMutex      _strLock;
+};
+
+#endif
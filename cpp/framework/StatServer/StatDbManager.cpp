@@ -17,25 +17,56 @@
 #include "StatDbManager.h"
 #include "util/tc_config.h"
 #include "StatServer.h"
-#include "StatHashMap.h"
+
+///////////////////////////////////////////////////////////
+namespace
+{
+    /**
+     * map拼成"key|value,key|value"
+     */
+    void joinCount(const map<int,int> &mCount, string &sOut)
+    {
+        sOut.clear();
+
+        char buf[32];
+        for (map<int,int>::const_iterator it = mCount.begin(); it != mCount.end(); ++it)
+        {
+            if (!sOut.empty())
+            {
+                sOut += ',';
+            }
+            sOut.append(buf, TC_Common::tochars(buf, it->first) - buf);
+            sOut += '|';
+            sOut.append(buf, TC_Common::tochars(buf, it->second) - buf);
+        }
+    }
+}
 
 ///////////////////////////////////////////////////////////
 StatDbManager::StatDbManager()
 : _terminate(false)
 , _lastDayTimeTable("")
+, _dbIpNum(0)
+, _oneDbHasThreadNum(1)
 {
     TLOGDEBUG("begin StatDbManager init" << endl);
 
     _sql               = (*g_pconf)["/tars<sql>"];
     _sqlStatus         = g_pconf->get("/tars<sqlStatus>", "");
+
     _tbNamePre         = g_pconf->get("/tars/db<tbnamePre>","t_stat_realtime_");
     _maxInsertCount    = TC_Common::strto<int>(g_pconf->get("/tars/reapSql<maxInsertCount>","1000"));
+    _bulkMode          = TC_MysqlBulk::toMode(g_pconf->get("/tars/reapSql<bulkMode>","insert"));
 
     //默认不使用权重
     _enableWeighted    = TC_Common::strto<bool>(g_pconf->get("/tars/<enWeighted>","0"));
 
     size_t iInsertDbThreaad = TC_Common::strto<int>(g_pconf->get("/tars/reapSql<insertDbThreadNum>","4"));
 
+    //同一个ip上的多个db可以并行写
+    size_t iInsertThreadByDB = TC_Common::strto<int>(g_pconf->get("/tars/reapSql<insertThreadByDB>","1"));
+    _oneDbHasThreadNum = (iInsertThreadByDB > 0 ? iInsertThreadByDB : 1);
+
     if (_sqlStatus == "")
     {
         _sqlStatus = "CREATE TABLE `t_ecstatus` ( "
@@ -78,6 +109,10 @@ StatDbManager::StatDbManager()
     {
         TC_DBConf tConf;
         tConf.loadFromMap(g_pconf->getDomainMap("/tars/multidb/" + vDb[i]));
+        if(_bulkMode == TC_MysqlBulk::BM_LOAD_DATA)
+        {
+            tConf._flag |= CLIENT_LOCAL_FILES;
+        }
 
         _vsTbNamePre.push_back(g_pconf->get("/tars/multidb/" + vDb[i] + "<tbname>", "t_stat_0" + TC_Common::tostr(i) + "_"));
 
@@ -124,7 +159,7 @@ StatDbManager::StatDbManager()
         _dbIpNum = iInsertDbThreaad;
     }
 
-    TLOGDEBUG("StatDbManager init insert DB threadnum:" << _dbIpNum  << endl);
+    TLOGDEBUG("StatDbManager init insert DB threadnum:" << _dbIpNum << "|insertThreadByDB:" << _oneDbHasThreadNum << "|bulkMode:" << _bulkMode << endl);
 
     //设置每个db ip使用写db的线程下标，即每个写db线程负责写哪些ip的db数据
     size_t iIndex = 0;
@@ -143,12 +178,16 @@ StatDbManager::StatDbManager()
     }
 
     //设置每个db实例使用写db的线程下标，即每个写db线程负责写哪些db实例的数据
+    //同一个ip的db轮流分给这个ip的_oneDbHasThreadNum个线程
+    map<string, size_t> mIpDbCount;
     for(size_t i = 0; i < vIp.size(); ++i)
     {
         map<string, size_t>::const_iterator iter = mIp.find(vIp[i]);
         if(iter != mIp.end())
         {
-            _mDbToIp.insert(map<size_t, size_t>::value_type(i, iter->second));
+            size_t &iDbCount = mIpDbCount[vIp[i]];
+            _mDbToIp.insert(map<size_t, size_t>::value_type(i, iter->second * _oneDbHasThreadNum + iDbCount % _oneDbHasThreadNum));
+            ++iDbCount;
         }
         else
         {
@@ -284,20 +323,28 @@ int StatDbManager::genRandOrder()
 ///////////////////////////////////////////////////////////
 int StatDbManager::insert2Db(const StatMsg &statmsg, const string &sDate, const string &sFlag, const string &sTbNamePre, TC_Mysql *pMysql)
 {
-    int iCount  = 0;
-    string sSql;
-    string strValues;
-
     string sTbName  = (sTbNamePre != "" ? sTbNamePre : _tbNamePre);
     sTbName += TC_Common::replace(sDate, "-", "");
     sTbName += sFlag.substr(0,_eCutType * 2);
 
     try
     {
-        string sEscapeString = pMysql->escapeString(ServerConfig::LocalIp);
-
         creatTable(sTbName,pMysql);
 
+        TC_MysqlBulk bulk(pMysql, _bulkMode, _maxInsertCount);
+
+        const bool bHist = hasHistColumn(sTbName, pMysql);
+
+        string sColumns = "source_id,f_date,f_tflag,master_name,slave_name,interface_name,tars_version,master_ip,slave_ip,slave_port,return_value, succ_count,timeout_count,exce_count,total_time,interv_count,ave_time,maxrsp_time, minrsp_time";
+        if (bHist)
+        {
+            sColumns += ",hist_count";
+        }
+
+        bulk.begin(sTbName, sColumns);
+
+        string sCount;
+
         for (StatMsg::const_iterator it = statmsg.begin(); it != statmsg.end(); it++ )
         {
             if(_terminate)
@@ -308,21 +355,6 @@ int StatDbManager::insert2Db(const StatMsg &statmsg, const string &sDate, const
             const StatMicMsgHead& head      = it->first;
             const StatMicMsgBody& body      = it->second;
 
-            string strIntervCount;
-            int iTemp = 0;
-            for (map<int,int>::const_iterator it = body.intervalCount.begin();it != body.intervalCount.end();it++)
-            {
-                if (iTemp != 0)
-                {
-                    strIntervCount += ",";
-                }
-                strIntervCount = strIntervCount;
-                strIntervCount += TC_Common::tostr(it->first);
-                strIntervCount += "|";
-                strIntervCount += TC_Common::tostr(it->second);
-                iTemp++;
-            }
-
             int iAveTime = 0;
             if ( body.count != 0 )
             {
@@ -330,74 +362,50 @@ int StatDbManager::insert2Db(const StatMsg &statmsg, const string &sDate, const
                 iAveTime == 0?iAveTime=1:iAveTime=iAveTime;
             }
 
-            //组织sql语句
-            strValues = " ('";
-            strValues += sEscapeString;
-            strValues += "','";
-            strValues += sDate;
-            strValues += "','";
-            strValues += sFlag;
-            strValues += "','";
-            strValues += pMysql->escapeString(head.masterName);
-            strValues += "','";
-            strValues += pMysql->escapeString(head.slaveName);
-            strValues += "','";
-            strValues += pMysql->escapeString(head.interfaceName);
-            strValues += "','";
-            strValues += pMysql->escapeString(head.tarsVersion);
-            strValues += "','";
-            strValues += pMysql->escapeString(head.masterIp);
-            strValues += "','";
-            strValues += pMysql->escapeString(head.slaveIp);
-            strValues += "',";
-            strValues += TC_Common::tostr<tars::Int32>( head.slavePort);
-            strValues += ",";
-            strValues += TC_Common::tostr<tars::Int32>( head.returnValue );
-            strValues += ",";
-            strValues += TC_Common::tostr<tars::Int32>(body.count);
-            strValues += ",";
-            strValues += TC_Common::tostr<tars::Int32>(body.timeoutCount);
-            strValues += ",";
-            strValues += TC_Common::tostr<tars::Int32>(body.execCount);
-            strValues += ",";
-            strValues += TC_Common::tostr<tars::Int64>(body.totalRspTime);
-            strValues += ",'";
-            strValues += strIntervCount;
-            strValues += "',";
-            strValues += TC_Common::tostr<tars::Int32>(iAveTime);
-            strValues += ",";
-            strValues += TC_Common::tostr<tars::Int32>(body.maxRspTime);
-            strValues += ",";
-            strValues += TC_Common::tostr<tars::Int32>(body.minRspTime ) + ") ";
-
-            if( iCount == 0 )
+            //字段直接写进批量缓冲区
+            bulk.addStr(ServerConfig::LocalIp);
+            bulk.addStr(sDate);
+            bulk.addStr(sFlag);
+            bulk.addStr(head.masterName);
+            bulk.addStr(head.slaveName);
+            bulk.addStr(head.interfaceName);
+            bulk.addStr(head.tarsVersion);
+            bulk.addStr(head.masterIp);
+            bulk.addStr(head.slaveIp);
+            bulk.addInt(head.slavePort);
+            bulk.addInt(head.returnValue);
+            bulk.addInt(body.count);
+            bulk.addInt(body.timeoutCount);
+            bulk.addInt(body.execCount);
+            bulk.addInt(body.totalRspTime);
+
+            joinCount(body.intervalCount, sCount);
+            bulk.addStr(sCount);
+
+            bulk.addInt(iAveTime);
+            bulk.addInt(body.maxRspTime);
+            bulk.addInt(body.minRspTime);
+
+            //格式和interv_count一样: 桶下标|调用量,...
+            if (bHist)
             {
-                sSql = "insert ignore into ";
-                sSql += sTbName;
-                sSql += " (source_id,f_date,f_tflag,master_name,slave_name,interface_name,tars_version,master_ip,slave_ip,slave_port,return_value, succ_count,timeout_count,exce_count,total_time,interv_count,ave_time,maxrsp_time, minrsp_time) values ";
-                sSql += strValues;
-            }
-            else
-            {
-                sSql += ",";
-                sSql += strValues;
+                joinCount(body.histCount, sCount);
+                bulk.addStr(sCount);
             }
 
-            iCount ++;
-            if ( iCount >= _maxInsertCount )
+            //够行数或者语句长度时写入
+            size_t iFlushed = bulk.endRow();
+            if (iFlushed != 0)
             {
-                usleep(100);
-                pMysql->execute(sSql);
-                TLOGDEBUG("insert " << sTbName << " affected:" << iCount  << endl);
+                TLOGDEBUG("insert " << sTbName << " affected:" << iFlushed << endl);
 
-                FDLOG("CountStat") << "stat ip:" << ServerConfig::LocalIp << "|insert " << sTbName << "|insert affected:" << iCount << "|mysql affected:" << pMysql->getAffectedRows() << endl;
-                iCount = 0;
+                FDLOG("CountStat") << "stat ip:" << ServerConfig::LocalIp << "|insert " << sTbName << "|insert affected:" << iFlushed << "|mysql affected:" << pMysql->getAffectedRows() << endl;
             }
         }
 
+        size_t iCount = bulk.flush();
         if ( iCount != 0 )
         {
-            pMysql->execute(sSql);
             TLOGDEBUG("insert " << sTbName << " affected:" << iCount << endl);
             FDLOG("CountStat") << "stat ip:" << ServerConfig::LocalIp << "|insert " << sTbName << "|insert affected:" << iCount << "|mysql affected:" << pMysql->getAffectedRows() << endl;
         }
@@ -469,6 +477,50 @@ bool StatDbManager::IsdbTableExist(const string& sTbName,TC_Mysql *pMysql)
     }
 }
 ///////////////////////////////////////////////////////////
+bool StatDbManager::hasHistColumn(const string& sTbName,TC_Mysql *pMysql)
+{
+    pair<TC_Mysql*, string> key(pMysql, sTbName);
+
+    {
+        TC_LockT<TC_ThreadMutex> lock(*this);
+
+        map<pair<TC_Mysql*, string>, bool>::const_iterator it = _histColumn.find(key);
+        if (it != _histColumn.end())
+        {
+            return it->second;
+        }
+    }
+
+    bool bHist = false;
+
+    try
+    {
+        TC_Mysql::MysqlData tRecord = pMysql->queryRecord("show columns from " + sTbName + " like 'hist_count'");
+
+        bHist = (tRecord.size() > 0);
+
+        TLOGDEBUG("StatDbManager::hasHistColumn " << sTbName << "|" << bHist << endl);
+    }
+    catch (TC_Mysql_Exception& ex)
+    {
+        //查询失败不缓存, 下次再查
+        TLOGERROR("StatDbManager::hasHistColumn exception: " << ex.what() << endl);
+        return false;
+    }
+
+    TC_LockT<TC_ThreadMutex> lock(*this);
+
+    //每个库每小时一张表, 定期清掉旧的
+    if (_histColumn.size() > 1024)
+    {
+        _histColumn.clear();
+    }
+
+    _histColumn[key] = bHist;
+
+    return bHist;
+}
+///////////////////////////////////////////////////////////
 int StatDbManager::creatTb(const string &sTbName,TC_Mysql *pMysql)
 {
     try
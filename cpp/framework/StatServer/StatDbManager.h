@@ -26,7 +26,7 @@
 #include "servant/TarsLogger.h"
 #include "jmem/jmem_hashmap.h"
 #include "servant/StatF.h"
-#include "StatHashMap.h"
+#include "StatAggTable.h"
 
 using namespace tars;
 
@@ -82,10 +82,20 @@ public:
 
     bool IsdbTableExist(const string& sTbName,TC_Mysql *pMysql);
 
+    /**
+     * 表里是否有hist_count列(高精度耗时分布), 按实际的表查询并缓存,
+     * 升级前建好的表和建表语句里没有该列的表都不写
+     * @param sTbName
+     * @param pMysql
+     */
+    bool hasHistColumn(const string& sTbName,TC_Mysql *pMysql);
+
     size_t getDbToIpIndex(size_t iIndex);
 
     size_t getDbIpNum() { return _dbIpNum; }
 
+    size_t getInsertDbThreadNum() { return _dbIpNum * _oneDbHasThreadNum; }
+
     string getIpAndPort(size_t iDbIndex);
 
     map<string, vector<size_t> >& getIpHasDbInfo() { return _mIpHasDbInfo; }
@@ -110,12 +120,18 @@ private:
     //创建表t_ecstatus
     string              _sqlStatus;
 
+    //各个库的表里是否有hist_count列(高精度耗时分布)
+    map<pair<TC_Mysql*, string>, bool> _histColumn;
+
     //表前缀
     string              _tbNamePre;
 
     //一次最大插入条数
     int                 _maxInsertCount;
 
+    //批量写入方式: 多行insert或者load data
+    TC_MysqlBulk::BulkMode _bulkMode;
+
     //分表类型
     CutType             _eCutType;
 
@@ -138,6 +154,9 @@ private:
     //db的ip个数
     size_t                _dbIpNum;
 
+    //每个db ip的写db线程数
+    size_t                _oneDbHasThreadNum;
+
     //设置每个db实例使用写db的线程下标，即每个写db线程负责写哪些db实例的数据
     map<size_t, size_t> _mDbToIp;
 
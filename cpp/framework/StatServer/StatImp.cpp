@@ -93,56 +93,63 @@ int StatImp::reportMicMsg( const map<tars::StatMicMsgHead, tars::StatMicMsgBody>
 {
     TLOGINFO("report---------------------------------access size:" << statmsg.size() << "|bFromClient:" <<bFromClient << endl);
 
+    StatAggTable *pTable = getAggTable();
+
+    const string &sIp = current->getIp();
+    map<string, string> &mVirtualMasterIp = g_app.getVirtualMasterIp();
+
+    //如果不是info等级的日志级别，就别往里走了
+    bool bLog = LOG->IsNeedLog(TarsRollLogger::INFO_LOG);
+
+    size_t iDropped = 0;
+
+    _records.clear();
+
     for ( map<StatMicMsgHead, StatMicMsgBody>::const_iterator it = statmsg.begin(); it != statmsg.end(); it++ )
     {
-        StatMicMsgHead head = it->first;
+        const StatMicMsgHead &head = it->first;
         const StatMicMsgBody &body = it->second;
 
-        if(bFromClient)
-        {
-            head.masterIp   = current->getIp();  //以前是自己获取主调ip,现在从proxy直接
-
-            head.slaveName  = getSlaveName(head.slaveName);
-        }
-        else
+        if(bLog)
         {
-            head.slaveIp = current->getIp();//现在从proxy直接
+            ostringstream os;
+            head.displaySimple(os);
+            body.displaySimple(os);
+            TLOGINFO(os.str() << (body.count == 0 && body.execCount == 0 && body.timeoutCount == 0 ? "|zero" : "") << endl);
         }
 
-        string sMasterName      = head.masterName;
-        string::size_type pos   =  sMasterName.find("@");
-        if (pos != string::npos)
+        //三个数据都为0时不入库
+        if(body.count == 0 && body.execCount == 0 && body.timeoutCount == 0)
         {
-            head.masterName   = sMasterName.substr(0, pos);
-            head.tarsVersion   = sMasterName.substr(pos+1);
+            continue;
         }
 
-        map<string, string>::iterator it_vip;
-        it_vip =  g_app.getVirtualMasterIp().find(getSlaveName(head.slaveName));
-        if( it_vip != g_app.getVirtualMasterIp().end())
-        {
-            head.masterIp    = it_vip->second; //按 slaveName来匹配，填入假的主调ip，减小入库数据量
-        }
+        //以前是自己获取主调ip,现在从proxy直接
+        const string *pMasterIp   = bFromClient ? &sIp : &head.masterIp;
+        const string &sSlaveIp    = bFromClient ? head.slaveIp : sIp;
 
-        //如果不是info等级的日志级别，就别往里走了
-        ostringstream os;
-        if(LOG->IsNeedLog(TarsRollLogger::INFO_LOG))
+        map<string, string>::const_iterator it_vip = mVirtualMasterIp.find(getSlaveName(head.slaveName));
+        if( it_vip != mVirtualMasterIp.end())
         {
-            os.str("");
-            head.displaySimple(os);
-            body.displaySimple(os);
+            pMasterIp = &it_vip->second; //按 slaveName来匹配，填入假的主调ip，减小入库数据量
         }
 
-        //三个数据都为0时不入库
-        if(body.count == 0 && body.execCount == 0 && body.timeoutCount == 0)
+        StatAggTable::Record record;
+        if(!pTable->makeRecord(head, body, *pMasterIp, sSlaveIp, record))
         {
-            TLOGINFO(os.str()<<"|zero"<<endl);
+            ++iDropped;
             continue;
         }
 
-        int iAddHash        = addHashMap(head,body);
+        _records.push_back(record);
+    }
+
+    iDropped += pTable->merge(_records);
 
-        TLOGINFO(os.str()<<"|"<<iAddHash<<endl);
+    if(iDropped > 0)
+    {
+        TLOGERROR("StatImp::reportMicMsg hashmap will full|dropped:" << iDropped << "|" << pTable->desc() << endl);
+        FDLOG("HashMap")<<"StatImp::reportMicMsg hashmap will full|dropped:" << iDropped << "|" << pTable->desc() << endl;
     }
 
     return 0;
@@ -167,7 +174,7 @@ int StatImp::reportSampleMsg(const vector<StatSampleMsg> &msg,tars::TarsCurrentP
 
 ///////////////////////////////////////////////////////////
 //
-int StatImp::addHashMap(const StatMicMsgHead &head, const StatMicMsgBody &body )
+StatAggTable *StatImp::getAggTable()
 {
     size_t iIndex = _threadIndex;
 
@@ -182,38 +189,11 @@ int StatImp::addHashMap(const StatMicMsgHead &head, const StatMicMsgBody &body )
 
     iBufferIndex = g_app.getSelectBufferIndex();
 
-    string sKey = head.slaveName;
-    sKey += head.masterName;
-    sKey += head.interfaceName;
-    sKey += head.masterIp;
-    sKey += head.slaveIp;
-
-    int iHashKey = _hashf(sKey) % g_app.getBuffNum();
-
-    StatHashMap *pHashMap = g_app.getHashMapBuff(iBufferIndex, iHashKey);
-    
-    //////////////////////////////////////////////////////////////////////////////////////
-
-    float rate =  (pHashMap->getMapHead()._iUsedChunk) * 1.0/pHashMap->allBlockChunkCount();
-
-    if(rate >0.9)
-    {
-        TLOGERROR("StatImp::addHashMap hashmap will full|_iMemSize:" << pHashMap->getMapHead()._iMemSize << endl);
-        FDLOG("HashMap")<<"StatImp::addHashMap hashmap will full|_iMemSize:" << pHashMap->getMapHead()._iMemSize << endl;
-        return -1;
-    }
-
-    int iRet = pHashMap->add(head, body);
-    if(iRet != 0)
-    {
-        TLOGDEBUG("StatImp::addHashMap set g_hashmap recourd erro|" << iRet << endl);
-        return iRet;
-    }
-    return iRet;
+    return g_app.getAggTable(iBufferIndex);
 }
 
 ///////////////////////////////////////////////////////////
-string StatImp::getSlaveName(const string& sSlaveName)
+const string& StatImp::getSlaveName(const string& sSlaveName)
 {
     return  sSlaveName;
 }
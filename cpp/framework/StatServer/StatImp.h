@@ -28,7 +28,7 @@
 #include "servant/TarsLogger.h"
 #include "jmem/jmem_hashmap.h"
 #include "servant/StatF.h"
-#include "StatHashMap.h"
+#include "StatAggTable.h"
 
 using namespace tars;
 
@@ -67,8 +67,7 @@ public:
      *
      */
     StatImp()
-    : _hashf(tars::hash<string>())
-    , _threadIndex(0)
+    : _threadIndex(0)
     {
     };
 
@@ -104,20 +103,23 @@ public:
      */
     virtual int reportSampleMsg(const vector<StatSampleMsg> &msg,tars::TarsCurrentPtr current );
 
-    typedef TC_Functor<size_t, TL::TLMaker<const string &>::Result> hash_functor;
-
 protected:
 
-    int addHashMap(const StatMicMsgHead &head, const StatMicMsgBody &body);
+    /**
+     * 刷新本线程的访问时间, 取当前写入的聚合表
+     */
+    StatAggTable *getAggTable();
 
 private:
     void dump2file();
 
-    string getSlaveName(const string& sSlaveName);
+    const string& getSlaveName(const string& sSlaveName);
 
 private:
-    hash_functor                    _hashf;
     size_t                            _threadIndex;
+
+    //每次reportMicMsg复用, 避免重复分配
+    vector<StatAggTable::Record>    _records;
 };
 
 #endif
@@ -53,7 +53,7 @@ void StatServer::initialize()
 
         TLOGDEBUG("StatServer::initialize iHandleNum:" << iHandleNum<< endl);
 
-        initHashMap();
+        initAggTable();
 
         string s("");
         _iSelectBuffer = getSelectBufferFromFlag(s);
@@ -167,25 +167,16 @@ bool StatServer::cmdSetRandOrder(const string& command, const string& params, st
     return true;
 }
 
-void StatServer::initHashMap()
+void StatServer::initAggTable()
 {
-    TLOGDEBUG("StatServer::initHashMap begin" << endl);
+    TLOGDEBUG("StatServer::initAggTable begin" << endl);
 
-    int iHashMapNum      = TC_Common::strto<int>(g_pconf->get("/tars/hashmap<hashmapnum>","1"));
+    //原来每个buffer按hashmapnum分成多个hashmap, 现在合成一个表, 总大小不变
+    int iHashMapNum     = TC_Common::strto<int>(g_pconf->get("/tars/hashmap<hashmapnum>","1"));
+    size_t iSize        = TC_Common::toSize(g_pconf->get("/tars/hashmap<size>"), 1024*1024*256);
+    size_t iStripes     = TC_Common::strto<size_t>(g_pconf->get("/tars/hashmap<stripes>","64"));
 
-    _iBuffNum = iHashMapNum;
-
-    _hashmap = new StatHashMap *[2];
-
-    for(int k = 0; k < 2; ++k)
-    {
-        _hashmap[k] = new StatHashMap[iHashMapNum]();
-    }
-
-    int iMinBlock       = TC_Common::strto<int>(g_pconf->get("/tars/hashmap<minBlock>","128"));
-    int iMaxBlock       = TC_Common::strto<int>(g_pconf->get("/tars/hashmap<maxBlock>","256"));
-    float iFactor       = TC_Common::strto<float>(g_pconf->get("/tars/hashmap<factor>","2"));
-    int iSize           = TC_Common::toSize(g_pconf->get("/tars/hashmap<size>"), 1024*1024*256);
+    iSize *= (iHashMapNum > 0 ? iHashMapNum : 1);
 
     _sClonePath         = ServerConfig::DataPath + "/" + g_pconf->get("/tars/hashmap<clonePatch>","clone");
 
@@ -195,99 +186,33 @@ void StatServer::initHashMap()
         exit(0);
     }
 
-    TLOGDEBUG("StatServer::initHashMap init multi hashmap begin..." << endl);
-
-    char a[26];
-    int iChar = 0;
-    for(int n = 0; n < 26; n++)
-    {
-        a[n] = 'a' + n;
-    }
-
     for(int i = 0; i < 2; ++i)
     {
-        for(int k = 0; k < iHashMapNum; ++k)
-        {
-            string sFileConf("/tars/hashmap<file");
-            string sFileDefault("hashmap");
+        string sFileConf("/tars/hashmap<aggfile");
+        string sFileDefault("statagg");
 
-            sFileConf += TC_Common::tostr(i);
-            sFileConf += TC_Common::tostr(k);
-            sFileConf += ">";
+        sFileConf += TC_Common::tostr(i);
+        sFileConf += ">";
 
-            sFileDefault += TC_Common::tostr(i);
-            sFileDefault += TC_Common::tostr(k);
-            sFileDefault += ".txt";
+        sFileDefault += TC_Common::tostr(i);
+        sFileDefault += ".dat";
 
-            string sHashMapFile = ServerConfig::DataPath + "/" + g_pconf->get(sFileConf, sFileDefault);
+        string sAggFile = ServerConfig::DataPath + "/" + g_pconf->get(sFileConf, sFileDefault);
 
-            string sPath        = TC_File::extractFilePath(sHashMapFile);
-            
-            if(!TC_File::makeDirRecursive(sPath))
-            {
-                TLOGERROR("cannot create hashmap file " << sPath << endl);
-                exit(0);
-            }
+        string sPath    = TC_File::extractFilePath(sAggFile);
 
-            try
-            {
-                TLOGINFO("initDataBlockSize size: " << iMinBlock << ", " << iMaxBlock << ", " << iFactor << endl);
-
-                _hashmap[i][k].initDataBlockSize(iMinBlock,iMaxBlock,iFactor);
-
-                if(TC_File::isFileExist(sHashMapFile))
-                {
-                    iSize = TC_File::getFileSize(sHashMapFile);
-                }
-                else
-                {
-                    int fd = open(sHashMapFile.c_str(), O_CREAT|O_EXCL|O_RDWR, 0666);
-                    if(fd == -1)
-                    {
-                        if(errno != EEXIST)
-                        {
-                            throw TC_Exception("open1 file '" + sHashMapFile + "' error", errno);
-                        }
-                        else
-                        {
-                            fd = open(sHashMapFile.c_str(), O_CREAT|O_RDWR, 0666);
-                            if(fd == -1)
-                            {
-                                throw TC_Exception("open2 file '" + sHashMapFile + "' error", errno);
-                            }
-                        }
-                    }
-
-                    lseek(fd, iSize-1, SEEK_SET);
-                    write(fd,"\0",1);
-                    if(fd != -1)
-                    {
-                       close(fd); 
-                    }
-                }
-
-                key_t key = ftok(sHashMapFile.c_str(), a[iChar%26]);
-
-                iChar++;
-
-                TLOGDEBUG("init hash mem，shm key: 0x" << hex << key << dec << endl);
-
-                //_hashmap[i][k].initStore( sHashMapFile.c_str(), iSize );
-                _hashmap[i][k].initStore(key, iSize);
-                _hashmap[i][k].setAutoErase(false);
-
-                TLOGINFO("\n" <<  _hashmap[i][k].desc() << endl);
-            }
-            catch(TC_HashMap_Exception &e)
-            {
-               TC_File::removeFile(sHashMapFile,false);
-               throw runtime_error(e.what());
-            }
-            
+        if(!TC_File::makeDirRecursive(sPath))
+        {
+            TLOGERROR("cannot create hashmap file " << sPath << endl);
+            exit(0);
         }
+
+        _aggTable[i].init(sAggFile, iSize, iStripes);
+
+        TLOGINFO("StatServer::initAggTable file:" << sAggFile << "|" << _aggTable[i].desc() << endl);
     }
 
-    TLOGDEBUG("StatServer::initHashMap init multi hashmap end..." << endl);
+    TLOGDEBUG("StatServer::initAggTable end..." << endl);
 }
 
 void StatServer::destroyApp()
@@ -298,28 +223,24 @@ void StatServer::destroyApp()
         _pReapSSDThread = NULL;
     }
 
-    for(int i = 0; i < 2; ++i)
-    {
-        delete [] _hashmap[i];
-    }
-
-    delete [] _hashmap;
-
     TLOGDEBUG("StatServer::destroyApp ok" << endl);
 }
 
 void StatServer::getTimeInfo(time_t &tTime,string &sDate,string &sFlag)
 {
-    string sTime,sHour,sMinute;
     time_t t    = TC_TimeProvider::getInstance()->getNow();
     t           = (t/(_iInsertInterval*60))*_iInsertInterval*60; //要求必须为loadIntev整数倍
     tTime       = t;
     t           = (t%3600 == 0?t-60:t);                           //要求将9点写作0860
-    sTime       = TC_Common::tm2str(t,"%Y%m%d%H%M");
-    sDate       = sTime.substr(0,8);
-    sHour       = sTime.substr(8,2);
-    sMinute     = sTime.substr(10,2);
-    sFlag       = sHour +  (sMinute=="59"?"60":sMinute);    //要求将9点写作0860
+    char sTime[32];
+    TC_TimeProvider::tm2str(t, TC_TimeProvider::TF_MINUTE, sTime);     //"%Y%m%d%H%M", 不用每次localtime_r
+    sDate.assign(sTime, 8);
+    sFlag.assign(sTime + 8, 4);
+    if(sFlag[2] == '5' && sFlag[3] == '9')    //要求将9点写作0860
+    {
+        sFlag[2] = '6';
+        sFlag[3] = '0';
+    }
 }
 
 
@@ -19,7 +19,7 @@
 
 #include "servant/Application.h"
 #include "servant/StatF.h"
-#include "StatHashMap.h"
+#include "StatAggTable.h"
 #include "ReapSSDThread.h"
 
 using namespace tars;
@@ -62,12 +62,10 @@ public:
 
     void setSelectBufferIndex(int iIndex) { _iSelectBuffer = iIndex; }
 
-    StatHashMap * getHashMapBuff(int iIndex, int iBuffer) { return &(_hashmap[iIndex][iBuffer]); }
-
-    int getBuffNum() { return _iBuffNum; }
+    StatAggTable * getAggTable(int iIndex) { return &(_aggTable[iIndex]); }
 
 private:
-    void initHashMap();
+    void initAggTable();
 
 private:
 
@@ -90,9 +88,7 @@ private:
 
     int _iSelectBuffer;
 
-    StatHashMap **_hashmap;
-
-    int _iBuffNum;
+    StatAggTable _aggTable[2];
 };
 
 extern TC_Config* g_pconf;
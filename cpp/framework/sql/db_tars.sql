@@ -330,7 +330,7 @@ CREATE TABLE `t_profile_template` (
 
 LOCK TABLES `t_profile_template` WRITE;
 /*!40000 ALTER TABLE `t_profile_template` DISABLE KEYS */;
-INSERT INTO `t_profile_template` VALUES (353,'tars.default','tars.default','<tars>\n    <application>\n    #是否启用SET分组\n    enableset=${enableset}\n    #SET分组的全名.(mtt.s.1)\n    setdivision=${setdivision}\n    <client>\n        #地址\n        locator =${locator}\n        #同步调用超时时间,缺省3s(毫秒)\n        sync-invoke-timeout = 3000\n        #异步超时时间,缺省5s(毫秒)\n        async-invoke-timeout =5000\n        #重新获取服务列表时间间隔(毫秒)\n        refresh-endpoint-interval = 60000\n        #模块间调用服务[可选]\n        stat            = tars.tarsstat.StatObj\n        #属性上报服务[可选]\n        property                    = tars.tarsproperty.PropertyObj\n        #上报间隔时间,默认60s(毫秒)\n        report-interval            = 60000\n        #stat采样比1:n 例如sample-rate为1000时 采样比为千分之一\n         sample-rate = 100000\n        #1分钟内stat最大采样条数\n         max-sample-count = 50\n\n        #网络异步回调线程个数\n        asyncthread      = ${asyncthread}\n        #模块名称\n        modulename      = ${modulename}\n    </client>\n        \n    #定义所有绑定的IP\n    <server>\n        #应用名称\n        app      = ${app}\n        #服务名称\n        server  = ${server}\n        #本地ip\n       localip  = ${localip}\n\n        #本地管理套接字[可选]\n        local  = ${local}\n        #服务的数据目录,可执行文件,配置文件等\n        basepath = ${basepath}\n        #\n        datapath = ${datapath}\n        #日志路径\n        logpath  = ${logpath}\n        #日志大小\n        logsize = 10M\n        #日志数量\n        #   lognum = 10\n        #配置中心的地址[可选]\n        config  = tars.tarsconfig.ConfigObj\n        #信息中心的地址[可选]\n        notify  = tars.tarsnotify.NotifyObj\n        #远程LogServer[可选]\n        log = tars.tarslog.LogObj\n        #关闭服务时等待时间\n         deactivating-timeout = 3000\n        #滚动日志等级默认值\n   logLevel=DEBUG\n    </server>          \n    </application>\n    </tars>','2016-09-22 17:36:01','admin'),(354,'tars.tarspatch','tars.default','<tars>\n    <application>\n    <server>\n        log    = tars.tarslog.LogObj\n        logLevel = DEBUG\n    </server>          \n    </application>\n\n    directory=/usr/local/app/patchs/tars\n    uploadDirectory=/usr/local/app/patchs/tars.upload\n    size=1M\n</tars>','2015-08-07 22:06:46','admin'),(355,'tars.tarsconfig','tars.default','<tars>\n    <application>\n    <server>\n        log    = tars.tarslog.LogObj\n        logLevel = DEBUG\n    </server>          \n    </application>\n    <db>\n        charset=utf8\n        dbhost=db.tars.com\n  dbname=db_tars\n        dbpass=tars2015\n dbport=3306\n dbuser=tars\n\n    </db>\n</tars>','2015-08-07 22:05:24','admin'),(356,'tars.tarsnotify','tars.default','<tars>\n    <application>\n    <server>\n        log    = tars.tarslog.LogObj\n        logLevel = DEBUG\n    </server>          \n    </application>\n\n    <hash> \n min_block=50 \n max_block=200 \n factor=1.5 \n  file_path=./notify \n file_size=50000000 \n  max_page_num=30 \n max_page_size=20 \n </hash> \n <db>\n        charset=utf8\n        dbhost=db.tars.com\n        dbname=db_tars\n        dbpass=tars2015\n        dbport=3306\n        dbuser=tars\n        dbname=db_tars\n\n    </db>\n\n    sql=CREATE TABLE `${TABLE}` (   `id` int(11) NOT NULL AUTO_INCREMENT,  `application` varchar(128) DEFAULT \'\',  `server_name` varchar(128) DEFAULT NULL, `container_name` varchar(128) DEFAULT \'\' , `node_name` varchar(128) NOT NULL DEFAULT \'\',  `set_name` varchar(16) DEFAULT NULL,  `set_area` varchar(16) DEFAULT NULL,  `set_group` varchar(16) DEFAULT NULL,  `server_id` varchar(100) DEFAULT NULL,  `thread_id` varchar(20) DEFAULT NULL,  `command` varchar(50) DEFAULT NULL,  `result` text,  `notifytime` datetime DEFAULT NULL,  PRIMARY KEY (`id`),  KEY `index_name` (`server_name`),  KEY `servernoticetime_i_1` (`notifytime`),  KEY `indx_1_server_id` (`server_id`),  KEY `query_index` (`application`,`server_name`,`node_name`,`set_name`,`set_area`,`set_group`) ) ENGINE\\=InnoDB DEFAULT CHARSET\\=utf8\n</tars>','2016-09-26 15:21:52','admin'),(359,'tars.tarsstat','tars.default','<tars>\n       sql= CREATE TABLE `${TABLE}`( `stattime` timestamp NOT NULL default CURRENT_TIMESTAMP,`f_date` date NOT NULL default \'1970-01-01\', `f_tflag` varchar(8) NOT NULL default \'\',`source_id` varchar(15) NOT NULL default \'\',`master_name` varchar(128) NOT NULL default \'\',`slave_name` varchar(128) NOT NULL default \'\',`interface_name` varchar(128) NOT NULL default \'\',`tars_version` varchar(16) NOT NULL default \'\',`master_ip` varchar(15) NOT NULL default \'\',`slave_ip` varchar(21) NOT NULL default \'\',`slave_port` int(10) NOT NULL default 0,`return_value` int(11) NOT NULL default 0,`succ_count` int(10) unsigned default NULL,`timeout_count` int(10) unsigned default NULL,`exce_count` int(10) unsigned default NULL,`interv_count` varchar(128) default NULL,`total_time` bigint(20) unsigned default NULL,`ave_time` int(10) unsigned default NULL,`maxrsp_time` int(10) unsigned default NULL,`minrsp_time` int(10) unsigned default NULL,PRIMARY KEY (`source_id`,`f_date`,`f_tflag`,`master_name`,`slave_name`,`interface_name`,`master_ip`,`slave_ip`,`slave_port`,`return_value`,`tars_version`),KEY `IDX_TIME` (`stattime`),KEY `IDC_MASTER` (`master_name`),KEY `IDX_INTERFACENAME` (`interface_name`),KEY `IDX_FLAGSLAVE` (`f_tflag`,`slave_name`), KEY `IDX_SLAVEIP` (`slave_ip`),KEY `IDX_SLAVE` (`slave_name`),KEY `IDX_RETVALUE` (`return_value`),KEY `IDX_MASTER_IP` (`master_ip`),KEY `IDX_F_DATE` (`f_date`)) ENGINE\\=InnoDB DEFAULT CHARSET\\=utf8\n  enWeighted=1\n        \n  <masteripGroup>\n   tars.tarsstat;1.1.1.1\n </masteripGroup>\n  <hashmap>\n   masterfile=hashmap_master.txt\n   slavefile=hashmap_slave.txt\n   insertInterval=5\n    enableStatCount=0\n   size=8M\n                countsize=1M\n </hashmap>\n  <reapSql>\n   interval=5\n    insertDbThreadNum=4\n </reapSql>\n        <multidb>\n   <db1>\n     dbhost=db.tars.com\n      dbname=tars_stat\n      tbname=tars_stat_\n     dbuser=tars\n     dbpass=tars2015\n     dbport=3306\n     charset=utf8\n    </db1>\n  </multidb>\n  \n</tars>','2016-09-26 17:25:45','admin'),(365,'tars.tarsjava.default','tars.default','<tars>\n <application>\n   enableset=${enableset}\n    setdivision=${setdivision}\n    <client>\n      locator=${locator}\n      sync-invoke-timeout=20000\n     async-invoke-timeout=20000\n      refresh-endpoint-interval=60000\n     stat=tars.tarsstat.StatObj\n      property=tars.tarsproperty.PropertyObj\n      report-interval=60000\n     modulename=${modulename}\n      sample-rate=100000\n      max-sample-count=50\n   </client>\n   <server>\n      app=${app}\n      server=${server}\n      localip=${localip}\n      local=${local}\n      basepath=${basepath}\n      datapath=${datapath}\n      logpath=${logpath}\n      loglevel=DEBUG\n      logsize=15M\n     log=tars.tarslog.LogObj\n     config=tars.tarsconfig.ConfigObj\n      notify=tars.tarsnotify.NotifyObj\n      mainclass=com.qq.tars.server.startup.Main\n     classpath=${basepath}/conf:${basepath}/WEB-INF/classes:${basepath}/WEB-INF/lib\n      jvmparams=-Dcom.sun.management.jmxremote.ssl\\=false -Dcom.sun.management.jmxremote.authenticate\\=false -Xms2000m -Xmx2000m -Xmn1000m -Xss1000k -XX:PermSize\\=128M -XX:+UseConcMarkSweepGC -XX:CMSInitiatingOccupancyFraction\\=60 -XX:+PrintGCApplicationStoppedTime -XX:+PrintGCDateStamps -XX:+CMSParallelRemarkEnabled -XX:+CMSScavengeBeforeRemark -XX:+UseCMSCompactAtFullCollection -XX:CMSFullGCsBeforeCompaction\\=0 -verbosegc -XX:+PrintGCDetails -XX:ErrorFile\\=${logpath}/${app}/${server}/jvm_error.log\n      sessiontimeout=120000\n     sessioncheckinterval=60000\n      tcpnodelay=true\n     udpbuffersize=8192\n      charsetname=UTF-8\n     backupfiles=conf\n    </server>\n </application>\n</tars>','2016-10-13 17:22:07','admin'),(358,'tars.tarsnode','tars.default','<tars>\n    <application>\n      enableset=n \n      setdivision=NULL\n        <client>\n            modulename=tars.tarsnode\n           locator=${locator}\n            #缺省3s(毫秒)\n            sync-invoke-timeout = 6000\n            asyncthread=3\n        </client>\n        <server>\n            app=tars\n            server=tarsnode\n            localip=${localip}\n            local = tcp -h 127.0.0.1 -p 19385 -t 10000\n            basepath=/usr/local/app/tars/tarsnode/data\n            datapath=/usr/local/app/tars/tarsnode/data\n            logpath=  /usr/local/app/tars/app_log\n            logLevel=DEBUG\n            #配置绑定端口\n            <NodeAdapter>\n                    #监听IP地址\n                    endpoint    = tcp -h ${localip} -p 19385 -t 60000\n                    #允许的IP地址\n                    allow      =\n                    #最大连接数\n                    maxconns    = 1024\n                    #当前线程个数\n                    threads    = 5\n                    #流量限制\n                    queuecap    = 10000\n                    #队列超时时间\n                    queuetimeout= 4000\n                    #处理对象\n                    servant    = tars.tarsnode.NodeObj\n            </NodeAdapter>\n\n            <ServerAdapter>\n                    #监听IP地址\n                    endpoint    = tcp -h  ${localip} -p 19386 -t 60000\n                    #允许的IP地址\n                    allow      =\n                    #最大连接数\n                    maxconns    = 1024\n                    #当前线程个数\n                    threads    = 5\n                    #流量限制\n                    queuecap    = 10000\n                    #队列超时时间\n                    queuetimeout= 4000\n                    #处理对象\n                    servant    = tars.tarsnode.ServerObj\n            </ServerAdapter>\n        </server>\n    </application>\n\n    <node>\n        registryObj = ${registryObj}\n        <keepalive>              \n            #业务心跳超时时间(s) \n            heartTimeout    = 60\n            \n            #监控server状态间隔时间(s) \n            monitorInterval = 2 \n            \n            #跟主控/本地cache同步服务状态间隔时间(s) \n            synStatInterval = 300\n        </keepalive> \n        \n        <hashmap>\n            file            =serversCache.dat\n            minBlock        =500\n            maxBlock        =500\n            factor          =1\n            size            =10M\n        </hashmap>\n    </node>\n</tars>','2015-08-07 22:04:39','admin'),(360,'tars.tarsproperty','tars.default','<tars>\n  sql=CREATE TABLE `${TABLE}` (`stattime` timestamp NOT NULL default CURRENT_TIMESTAMP,`f_date` date NOT NULL default \'1970-01-01\', `f_tflag` varchar(8) NOT NULL default \'\',`master_name` varchar(128) NOT NULL default \'\',`master_ip` varchar(16) default NULL,`property_name` varchar(100) default NULL,`set_name` varchar(15) NOT NULL default \'\',`set_area` varchar(15) NOT NULL default \'\',`set_id` varchar(15) NOT NULL default \'\',`policy` varchar(20) default NULL,`value` varchar(255) default NULL, KEY (`f_date`,`f_tflag`,`master_name`,`master_ip`,`property_name`,`policy`),KEY `IDX_MASTER_NAME` (`master_name`),KEY `IDX_MASTER_IP` (`master_ip`),KEY `IDX_TIME` (`stattime`)) ENGINE=Innodb\n\n <db>\n    charset\n   dbhost=db.tars.com\n    dbname=tars\n   dbport=3306\n   dbuser=tars\n   dbpass=tars2015\n </db>\n <multidb>\n   <db1>\n     dbhost=db.tars.com\n      dbname=tars_property\n      tbname=tars_property_\n     dbuser=tars\n     dbpass=tars2015\n     dbport=3306\n     charset=utf8\n    </db1>\n    <db2>\n     dbhost=db.tars.com\n      dbname=tars_property\n      tbname=tars_property_\n     dbuser=tars\n     dbpass=tars2015\n     dbport=3306\n     charset=utf8\n    </db2>\n  </multidb>\n  <hashmap>\n   factor=1.5\n    file=hashmap.txt\n    insertInterval=5\n    maxBlock=200\n    minBlock=100\n    size=10M\n  </hashmap>\n  <reapSql>\n   Interval=10\n   sql=insert ignore into t_master_property select  master_name, property_name, policy from ${TABLE}  group by  master_name, property_name, policy;\n  </reapSql>\n</tars>','2015-08-25 12:15:52','admin'),(362,'tars.tarslog','tars.default','<tars>\n     <application>\n          <server>\n               logLevel=ERROR\n              </server>\n     </application>\n     <log>\n          logpath=/usr/local/app/tars/remote_app_log\n          logthread=10         \n          <format>\n               hour=xx\n          </format>\n     </log>\n</tars>','2016-10-13 17:31:36','admin'),(366,'tars.tarsquerystat','tars.default','<tars>\n<countdb>\n<db1>\n      dbhost=db.tars.com\n      dbname=tars_stat\n      tbname=tars_stat_\n     dbuser=tars\n     dbpass=tars2015\n     dbport=3306\n     charset=utf8\n    </db1>\n</countdb>\n</tars>','2017-01-04 17:13:40',NULL),(367,'tars.tarsqueryproperty','tars.default','<tars>\n<countdb>\n<db1>\n     dbhost=db.tars.com\n      dbname=tars_property\n      tbname=tars_property_\n     dbuser=tars\n     dbpass=tars2015\n     dbport=3306\n     charset=utf8\n    </db1>\n</countdb>\n</tars>','2017-01-04 17:14:01',NULL);
+INSERT INTO `t_profile_template` VALUES (353,'tars.default','tars.default','<tars>\n    <application>\n    #是否启用SET分组\n    enableset=${enableset}\n    #SET分组的全名.(mtt.s.1)\n    setdivision=${setdivision}\n    <client>\n        #地址\n        locator =${locator}\n        #同步调用超时时间,缺省3s(毫秒)\n        sync-invoke-timeout = 3000\n        #异步超时时间,缺省5s(毫秒)\n        async-invoke-timeout =5000\n        #重新获取服务列表时间间隔(毫秒)\n        refresh-endpoint-interval = 60000\n        #模块间调用服务[可选]\n        stat            = tars.tarsstat.StatObj\n        #属性上报服务[可选]\n        property                    = tars.tarsproperty.PropertyObj\n        #上报间隔时间,默认60s(毫秒)\n        report-interval            = 60000\n        #stat采样比1:n 例如sample-rate为1000时 采样比为千分之一\n         sample-rate = 100000\n        #1分钟内stat最大采样条数\n         max-sample-count = 50\n\n        #网络异步回调线程个数\n        asyncthread      = ${asyncthread}\n        #模块名称\n        modulename      = ${modulename}\n    </client>\n        \n    #定义所有绑定的IP\n    <server>\n        #应用名称\n        app      = ${app}\n        #服务名称\n        server  = ${server}\n        #本地ip\n       localip  = ${localip}\n\n        #本地管理套接字[可选]\n        local  = ${local}\n        #服务的数据目录,可执行文件,配置文件等\n        basepath = ${basepath}\n        #\n        datapath = ${datapath}\n        #日志路径\n        logpath  = ${logpath}\n        #日志大小\n        logsize = 10M\n        #日志数量\n        #   lognum = 10\n        #配置中心的地址[可选]\n        config  = tars.tarsconfig.ConfigObj\n        #信息中心的地址[可选]\n        notify  = tars.tarsnotify.NotifyObj\n        #远程LogServer[可选]\n        log = tars.tarslog.LogObj\n        #关闭服务时等待时间\n         deactivating-timeout = 3000\n        #滚动日志等级默认值\n   logLevel=DEBUG\n    </server>          \n    </application>\n    </tars>','2016-09-22 17:36:01','admin'),(354,'tars.tarspatch','tars.default','<tars>\n    <application>\n    <server>\n        log    = tars.tarslog.LogObj\n        logLevel = DEBUG\n    </server>          \n    </application>\n\n    directory=/usr/local/app/patchs/tars\n    uploadDirectory=/usr/local/app/patchs/tars.upload\n    size=1M\n</tars>','2015-08-07 22:06:46','admin'),(355,'tars.tarsconfig','tars.default','<tars>\n    <application>\n    <server>\n        log    = tars.tarslog.LogObj\n        logLevel = DEBUG\n    </server>          \n    </application>\n    <db>\n        charset=utf8\n        dbhost=db.tars.com\n  dbname=db_tars\n        dbpass=tars2015\n dbport=3306\n dbuser=tars\n\n    </db>\n</tars>','2015-08-07 22:05:24','admin'),(356,'tars.tarsnotify','tars.default','<tars>\n    <application>\n    <server>\n        log    = tars.tarslog.LogObj\n        logLevel = DEBUG\n    </server>          \n    </application>\n\n    <hash> \n min_block=50 \n max_block=200 \n factor=1.5 \n  file_path=./notify \n file_size=50000000 \n  max_page_num=30 \n max_page_size=20 \n </hash> \n <db>\n        charset=utf8\n        dbhost=db.tars.com\n        dbname=db_tars\n        dbpass=tars2015\n        dbport=3306\n        dbuser=tars\n        dbname=db_tars\n\n    </db>\n\n    sql=CREATE TABLE `${TABLE}` (   `id` int(11) NOT NULL AUTO_INCREMENT,  `application` varchar(128) DEFAULT \'\',  `server_name` varchar(128) DEFAULT NULL, `container_name` varchar(128) DEFAULT \'\' , `node_name` varchar(128) NOT NULL DEFAULT \'\',  `set_name` varchar(16) DEFAULT NULL,  `set_area` varchar(16) DEFAULT NULL,  `set_group` varchar(16) DEFAULT NULL,  `server_id` varchar(100) DEFAULT NULL,  `thread_id` varchar(20) DEFAULT NULL,  `command` varchar(50) DEFAULT NULL,  `result` text,  `notifytime` datetime DEFAULT NULL,  PRIMARY KEY (`id`),  KEY `index_name` (`server_name`),  KEY `servernoticetime_i_1` (`notifytime`),  KEY `indx_1_server_id` (`server_id`),  KEY `query_index` (`application`,`server_name`,`node_name`,`set_name`,`set_area`,`set_group`) ) ENGINE\\=InnoDB DEFAULT CHARSET\\=utf8\n</tars>','2016-09-26 15:21:52','admin'),(359,'tars.tarsstat','tars.default','<tars>\n       sql= CREATE TABLE `${TABLE}`( `stattime` timestamp NOT NULL default CURRENT_TIMESTAMP,`f_date` date NOT NULL default \'1970-01-01\', `f_tflag` varchar(8) NOT NULL default \'\',`source_id` varchar(15) NOT NULL default \'\',`master_name` varchar(128) NOT NULL default \'\',`slave_name` varchar(128) NOT NULL default \'\',`interface_name` varchar(128) NOT NULL default \'\',`tars_version` varchar(16) NOT NULL default \'\',`master_ip` varchar(15) NOT NULL default \'\',`slave_ip` varchar(21) NOT NULL default \'\',`slave_port` int(10) NOT NULL default 0,`return_value` int(11) NOT NULL default 0,`succ_count` int(10) unsigned default NULL,`timeout_count` int(10) unsigned default NULL,`exce_count` int(10) unsigned default NULL,`interv_count` varchar(128) default NULL,`total_time` bigint(20) unsigned default NULL,`ave_time` int(10) unsigned default NULL,`maxrsp_time` int(10) unsigned default NULL,`minrsp_time` int(10) unsigned default NULL,`hist_count` text default NULL,PRIMARY KEY (`source_id`,`f_date`,`f_tflag`,`master_name`,`slave_name`,`interface_name`,`master_ip`,`slave_ip`,`slave_port`,`return_value`,`tars_version`),KEY `IDX_TIME` (`stattime`),KEY `IDC_MASTER` (`master_name`),KEY `IDX_INTERFACENAME` (`interface_name`),KEY `IDX_FLAGSLAVE` (`f_tflag`,`slave_name`), KEY `IDX_SLAVEIP` (`slave_ip`),KEY `IDX_SLAVE` (`slave_name`),KEY `IDX_RETVALUE` (`return_value`),KEY `IDX_MASTER_IP` (`master_ip`),KEY `IDX_F_DATE` (`f_date`)) ENGINE\\=InnoDB DEFAULT CHARSET\\=utf8\n  enWeighted=1\n        \n  <masteripGroup>\n   tars.tarsstat;1.1.1.1\n </masteripGroup>\n  <hashmap>\n   masterfile=hashmap_master.txt\n   slavefile=hashmap_slave.txt\n   insertInterval=5\n    enableStatCount=0\n   size=8M\n                countsize=1M\n </hashmap>\n  <reapSql>\n   interval=5\n    insertDbThreadNum=4\n </reapSql>\n        <multidb>\n   <db1>\n     dbhost=db.tars.com\n      dbname=tars_stat\n      tbname=tars_stat_\n     dbuser=tars\n     dbpass=tars2015\n     dbport=3306\n     charset=utf8\n    </db1>\n  </multidb>\n  \n</tars>','2016-09-26 17:25:45','admin'),(365,'tars.tarsjava.default','tars.default','<tars>\n <application>\n   enableset=${enableset}\n    setdivision=${setdivision}\n    <client>\n      locator=${locator}\n      sync-invoke-timeout=20000\n     async-invoke-timeout=20000\n      refresh-endpoint-interval=60000\n     stat=tars.tarsstat.StatObj\n      property=tars.tarsproperty.PropertyObj\n      report-interval=60000\n     modulename=${modulename}\n      sample-rate=100000\n      max-sample-count=50\n   </client>\n   <server>\n      app=${app}\n      server=${server}\n      localip=${localip}\n      local=${local}\n      basepath=${basepath}\n      datapath=${datapath}\n      logpath=${logpath}\n      loglevel=DEBUG\n      logsize=15M\n     log=tars.tarslog.LogObj\n     config=tars.tarsconfig.ConfigObj\n      notify=tars.tarsnotify.NotifyObj\n      mainclass=com.qq.tars.server.startup.Main\n     classpath=${basepath}/conf:${basepath}/WEB-INF/classes:${basepath}/WEB-INF/lib\n      jvmparams=-Dcom.sun.management.jmxremote.ssl\\=false -Dcom.sun.management.jmxremote.authenticate\\=false -Xms2000m -Xmx2000m -Xmn1000m -Xss1000k -XX:PermSize\\=128M -XX:+UseConcMarkSweepGC -XX:CMSInitiatingOccupancyFraction\\=60 -XX:+PrintGCApplicationStoppedTime -XX:+PrintGCDateStamps -XX:+CMSParallelRemarkEnabled -XX:+CMSScavengeBeforeRemark -XX:+UseCMSCompactAtFullCollection -XX:CMSFullGCsBeforeCompaction\\=0 -verbosegc -XX:+PrintGCDetails -XX:ErrorFile\\=${logpath}/${app}/${server}/jvm_error.log\n      sessiontimeout=120000\n     sessioncheckinterval=60000\n      tcpnodelay=true\n     udpbuffersize=8192\n      charsetname=UTF-8\n     backupfiles=conf\n    </server>\n </application>\n</tars>','2016-10-13 17:22:07','admin'),(358,'tars.tarsnode','tars.default','<tars>\n    <application>\n      enableset=n \n      setdivision=NULL\n        <client>\n            modulename=tars.tarsnode\n           locator=${locator}\n            #缺省3s(毫秒)\n            sync-invoke-timeout = 6000\n            asyncthread=3\n        </client>\n        <server>\n            app=tars\n            server=tarsnode\n            localip=${localip}\n            local = tcp -h 127.0.0.1 -p 19385 -t 10000\n            basepath=/usr/local/app/tars/tarsnode/data\n            datapath=/usr/local/app/tars/tarsnode/data\n            logpath=  /usr/local/app/tars/app_log\n            logLevel=DEBUG\n            #配置绑定端口\n            <NodeAdapter>\n                    #监听IP地址\n                    endpoint    = tcp -h ${localip} -p 19385 -t 60000\n                    #允许的IP地址\n                    allow      =\n                    #最大连接数\n                    maxconns    = 1024\n                    #当前线程个数\n                    threads    = 5\n                    #流量限制\n                    queuecap    = 10000\n                    #队列超时时间\n                    queuetimeout= 4000\n                    #处理对象\n                    servant    = tars.tarsnode.NodeObj\n            </NodeAdapter>\n\n            <ServerAdapter>\n                    #监听IP地址\n                    endpoint    = tcp -h  ${localip} -p 19386 -t 60000\n                    #允许的IP地址\n                    allow      =\n                    #最大连接数\n                    maxconns    = 1024\n                    #当前线程个数\n                    threads    = 5\n                    #流量限制\n                    queuecap    = 10000\n                    #队列超时时间\n                    queuetimeout= 4000\n                    #处理对象\n                    servant    = tars.tarsnode.ServerObj\n            </ServerAdapter>\n        </server>\n    </application>\n\n    <node>\n        registryObj = ${registryObj}\n        <keepalive>              \n            #业务心跳超时时间(s) \n            heartTimeout    = 60\n            \n            #监控server状态间隔时间(s) \n            monitorInterval = 2 \n            \n            #跟主控/本地cache同步服务状态间隔时间(s) \n            synStatInterval = 300\n        </keepalive> \n        \n        <hashmap>\n            file            =serversCache.dat\n            minBlock        =500\n            maxBlock        =500\n            factor          =1\n            size            =10M\n        </hashmap>\n    </node>\n</tars>','2015-08-07 22:04:39','admin'),(360,'tars.tarsproperty','tars.default','<tars>\n  sql=CREATE TABLE `${TABLE}` (`stattime` timestamp NOT NULL default CURRENT_TIMESTAMP,`f_date` date NOT NULL default \'1970-01-01\', `f_tflag` varchar(8) NOT NULL default \'\',`master_name` varchar(128) NOT NULL default \'\',`master_ip` varchar(16) default NULL,`property_name` varchar(100) default NULL,`set_name` varchar(15) NOT NULL default \'\',`set_area` varchar(15) NOT NULL default \'\',`set_id` varchar(15) NOT NULL default \'\',`policy` varchar(20) default NULL,`value` varchar(255) default NULL, KEY (`f_date`,`f_tflag`,`master_name`,`master_ip`,`property_name`,`policy`),KEY `IDX_MASTER_NAME` (`master_name`),KEY `IDX_MASTER_IP` (`master_ip`),KEY `IDX_TIME` (`stattime`)) ENGINE=Innodb\n\n <db>\n    charset\n   dbhost=db.tars.com\n    dbname=tars\n   dbport=3306\n   dbuser=tars\n   dbpass=tars2015\n </db>\n <multidb>\n   <db1>\n     dbhost=db.tars.com\n      dbname=tars_property\n      tbname=tars_property_\n     dbuser=tars\n     dbpass=tars2015\n     dbport=3306\n     charset=utf8\n    </db1>\n    <db2>\n     dbhost=db.tars.com\n      dbname=tars_property\n      tbname=tars_property_\n     dbuser=tars\n     dbpass=tars2015\n     dbport=3306\n     charset=utf8\n    </db2>\n  </multidb>\n  <hashmap>\n   factor=1.5\n    file=hashmap.txt\n    insertInterval=5\n    maxBlock=200\n    minBlock=100\n    size=10M\n  </hashmap>\n  <reapSql>\n   Interval=10\n   sql=insert ignore into t_master_property select  master_name, property_name, policy from ${TABLE}  group by  master_name, property_name, policy;\n  </reapSql>\n</tars>','2015-08-25 12:15:52','admin'),(362,'tars.tarslog','tars.default','<tars>\n     <application>\n          <server>\n               logLevel=ERROR\n              </server>\n     </application>\n     <log>\n          logpath=/usr/local/app/tars/remote_app_log\n          logthread=10         \n          <format>\n               hour=xx\n          </format>\n     </log>\n</tars>','2016-10-13 17:31:36','admin'),(366,'tars.tarsquerystat','tars.default','<tars>\n<countdb>\n<db1>\n      dbhost=db.tars.com\n      dbname=tars_stat\n      tbname=tars_stat_\n     dbuser=tars\n     dbpass=tars2015\n     dbport=3306\n     charset=utf8\n    </db1>\n</countdb>\n</tars>','2017-01-04 17:13:40',NULL),(367,'tars.tarsqueryproperty','tars.default','<tars>\n<countdb>\n<db1>\n     dbhost=db.tars.com\n      dbname=tars_property\n      tbname=tars_property_\n     dbuser=tars\n     dbpass=tars2015\n     dbport=3306\n     charset=utf8\n    </db1>\n</countdb>\n</tars>','2017-01-04 17:14:01',NULL);
 /*!40000 ALTER TABLE `t_profile_template` ENABLE KEYS */;
 UNLOCK TABLES;
 
@@ -24,17 +24,27 @@
 #include "tup/tup.h"
 #include "servant/StatF.h"
 #include "servant/StatReport.h"
+#include <cmath>
 
 
 namespace tars
 {
 
+/**
+ * 平均响应时间衰减的时间常数(微秒)
+ */
+static const double LATENCY_DECAY_US = 10000000.0;
+
+/**
+ * 还没有响应时间, 但已经有在途请求的节点的负载, 避免新节点一下子涌入大量请求
+ */
+static const double LATENCY_PENALTY = 1e12;
+
 AdapterProxy::AdapterProxy(ObjectProxy * pObjectProxy,const EndpointInfo &ep,Communicator* pCom)
 : _communicator(pCom)
 , _objectProxy(pObjectProxy)
 , _endpoint(ep)
-, _trans(NULL)
-, _timeoutQueue(NULL)
+, _nextConn(0)
 , _activeStateInReg(true)
 , _activeStatus(true)
 , _totalInvoke(0)
@@ -49,16 +59,33 @@ AdapterProxy::AdapterProxy(ObjectProxy * pObjectProxy,const EndpointInfo &ep,Com
 , _staticWeight(0)
 , _timeoutLogFlag(false)
 , _noSendQueueLimit(1000)
+, _sendBatch(false)
+, _sendBatchNum(1)
+, _sendBatchBytes(0)
+, _pendingInvoke(false)
+, _pendingNum(0)
+, _pendingBytes(0)
+, _latency(0)
+, _latencyTime(0)
 , _maxSampleCount(1000)
 , _sampleRate(0)
 {
-    _timeoutQueue = new TC_TimeoutQueueNew<ReqMessage*>();
-
-    assert(_timeoutQueue != NULL);
+    size_t iConnNum = 1;
 
     if(pObjectProxy->getCommunicatorEpoll())
     {
         _noSendQueueLimit = pObjectProxy->getCommunicatorEpoll()->getNoSendQueueLimit();
+
+        //udp和ssl不批量发送
+        _sendBatch        = (pObjectProxy->getCommunicatorEpoll()->isSendBatch() && ep.type() == EndpointInfo::TCP);
+        _sendBatchNum     = pObjectProxy->getCommunicatorEpoll()->getSendBatchNum();
+        _sendBatchBytes   = pObjectProxy->getCommunicatorEpoll()->getSendBatchBytes();
+
+        //udp只用一个连接
+        if(ep.type() != EndpointInfo::UDP)
+        {
+            iConnNum = pObjectProxy->getCommunicatorEpoll()->getConnNum();
+        }
     }
 
     if(_communicator)
@@ -66,13 +93,28 @@ AdapterProxy::AdapterProxy(ObjectProxy * pObjectProxy,const EndpointInfo &ep,Com
         _timeoutLogFlag = _communicator->getTimeoutLogFlag();
     }
 
-    if (ep.type() == EndpointInfo::UDP)
-    {
-        _trans = new UdpTransceiver(this, ep);
-    }
-    else
+    _conns.resize(iConnNum);
+
+    for(size_t i = 0; i < _conns.size(); ++i)
     {
-        _trans = new TcpTransceiver(this, ep);
+        ConnInfo & conn = _conns[i];
+
+        if (ep.type() == EndpointInfo::UDP)
+        {
+            conn.trans = new UdpTransceiver(this, ep);
+        }
+        else
+        {
+            conn.trans = new TcpTransceiver(this, ep);
+        }
+
+        conn.trans->setConnIndex(i);
+
+        conn.timeoutQueue  = new TC_TimeoutQueueNew<ReqMessage*>();
+        conn.connTimeout   = false;
+        conn.connExc       = false;
+        conn.connExcCnt    = 0;
+        conn.nextRetryTime = 0;
     }
 
     //初始化stat的head信息
@@ -81,16 +123,13 @@ AdapterProxy::AdapterProxy(ObjectProxy * pObjectProxy,const EndpointInfo &ep,Com
 
 AdapterProxy::~AdapterProxy()
 {
-    if(_trans)
+    for(size_t i = 0; i < _conns.size(); ++i)
     {
-        delete _trans;
-        _trans = NULL;
-    }
+        delete _conns[i].trans;
+        _conns[i].trans = NULL;
 
-    if(_timeoutQueue)
-    {
-        delete _timeoutQueue;
-        _timeoutQueue = NULL;
+        delete _conns[i].timeoutQueue;
+        _conns[i].timeoutQueue = NULL;
     }
 }
 
@@ -142,14 +181,55 @@ void AdapterProxy::initStatHead()
     _statHead.returnValue  = 0;
 }
 
+AdapterProxy::ConnInfo & AdapterProxy::selectConn()
+{
+    size_t iNum = _conns.size();
+
+    if(iNum == 1)
+    {
+        return _conns[0];
+    }
+
+    //从上次的下一个开始找, 在途请求一样多时轮流使用
+    size_t iStart = _nextConn++ % iNum;
+
+    ConnInfo * best = NULL;
+
+    for(size_t i = 0; i < iNum; ++i)
+    {
+        ConnInfo & conn = _conns[(iStart + i) % iNum];
+
+        //异常或者没有连接的不选
+        if(conn.connExc || !(conn.trans->hasConnected() || conn.trans->isConnecting()))
+        {
+            continue;
+        }
+
+        if(best == NULL || conn.timeoutQueue->size() < best->timeoutQueue->size())
+        {
+            best = &conn;
+        }
+    }
+
+    //都不可用, 先放到未发送链表里, 连接建立后再发送
+    if(best == NULL)
+    {
+        best = &_conns[iStart];
+    }
+
+    return *best;
+}
+
 int AdapterProxy::invoke(ReqMessage * msg)
 {
-    assert(_trans != NULL);
+    ConnInfo & conn = selectConn();
+
+    TC_TimeoutQueueNew<ReqMessage*> * timeoutQueue = conn.timeoutQueue;
 
-    TLOGINFO("[TARS][AdapterProxy::invoke objname:" << _objectProxy->name() << ",desc:" << _endpoint.desc() << endl);
+    TLOGINFO("[TARS][AdapterProxy::invoke objname:" << _objectProxy->name() << ",desc:" << _endpoint.desc() << ",conn:" << conn.trans->getConnIndex() << endl);
 
     //未发链表有长度限制
-    if(_timeoutQueue->getSendListSize() >= _noSendQueueLimit)
+    if(timeoutQueue->getSendListSize() >= _noSendQueueLimit)
     {
         TLOGERROR("[TARS][AdapterProxy::invoke fail,ReqInfoQueue.size > " << _noSendQueueLimit << ",objname:" << _objectProxy->name() <<",desc:"<< _endpoint.desc() << endl);
         msg->eStatus = ReqMessage::REQ_EXC;
@@ -166,10 +246,53 @@ int AdapterProxy::invoke(ReqMessage * msg)
         msg->request.iRequestId = _objectProxy->generateId();
     }
 
-    _objectProxy->getProxyProtocol().requestFunc(msg->request,msg->sReqData);
+    if(msg->iReqIdPos > 0)
+    {
+        ProxyProtocol::tarsRequestPatchId(msg->sReqData, msg->iReqIdPos, msg->request.iRequestId);
+    }
+    else
+    {
+        _objectProxy->getProxyProtocol().requestFunc(msg->request,msg->sReqData);
+    }
+
+    //批量发送: 先放入未发送链表, 本轮事件处理完或者攒够一批再一起发送
+    if(_sendBatch)
+    {
+        TLOGINFO("[TARS][AdapterProxy::invoke push (batch) " << _objectProxy->name() << ", " << _endpoint.desc() << ",id " << msg->request.iRequestId <<endl);
+
+        size_t iSize = msg->sReqData.size();
+
+        bool bFlag = timeoutQueue->push(msg,msg->request.iRequestId, msg->request.iTimeout+msg->iBeginTime, false);
+        if(!bFlag)
+        {
+            TLOGERROR("[TARS][AdapterProxy::invoke fail3 : insert timeout queue fail,queue size:" << timeoutQueue->size() << "," <<_objectProxy->name() << ", " << _endpoint.desc() <<endl);
+
+            msg->eStatus = ReqMessage::REQ_EXC;
+
+            finishInvoke(msg);
+
+            return 0;
+        }
+
+        ++_pendingNum;
+        _pendingBytes += iSize;
+
+        if(_pendingNum >= _sendBatchNum || _pendingBytes >= _sendBatchBytes)
+        {
+            doInvoke();
+        }
+        else if(!_pendingInvoke)
+        {
+            _pendingInvoke = true;
+
+            _objectProxy->getCommunicatorEpoll()->addPendingInvoke(this);
+        }
+
+        return 0;
+    }
 
     //交给连接发送数据,连接连上,buffer不为空,直接发送数据成功
-    if(_timeoutQueue->sendListEmpty() && _trans->sendRequest(msg->sReqData.c_str(),msg->sReqData.size()) != Transceiver::eRetError)
+    if(timeoutQueue->sendListEmpty() && conn.trans->sendRequest(msg->sReqData.c_str(),msg->sReqData.size()) != Transceiver::eRetError)
     {
         TLOGINFO("[TARS][AdapterProxy::invoke push (send) objname:" << _objectProxy->name() << ",desc:" << _endpoint.desc() << ",id:" << msg->request.iRequestId << endl);
 
@@ -182,10 +305,10 @@ int AdapterProxy::invoke(ReqMessage * msg)
             return 0;
         }
 
-        bool bFlag = _timeoutQueue->push(msg, msg->request.iRequestId, msg->request.iTimeout + msg->iBeginTime);
+        bool bFlag = timeoutQueue->push(msg, msg->request.iRequestId, msg->request.iTimeout + msg->iBeginTime);
         if(!bFlag)
         {
-            TLOGERROR("[TARS][AdapterProxy::invoke fail1 : insert timeout queue fail,queue size:" << _timeoutQueue->size() << ",objname" <<_objectProxy->name() << ",desc" << _endpoint.desc() <<endl);
+            TLOGERROR("[TARS][AdapterProxy::invoke fail1 : insert timeout queue fail,queue size:" << timeoutQueue->size() << ",objname" <<_objectProxy->name() << ",desc" << _endpoint.desc() <<endl);
             msg->eStatus = ReqMessage::REQ_EXC;
 
             finishInvoke(msg);
@@ -196,10 +319,10 @@ int AdapterProxy::invoke(ReqMessage * msg)
         TLOGINFO("[TARS][AdapterProxy::invoke push (no send) " << _objectProxy->name() << ", " << _endpoint.desc() << ",id " << msg->request.iRequestId <<endl);
 
         //请求发送失败了
-        bool bFlag = _timeoutQueue->push(msg,msg->request.iRequestId, msg->request.iTimeout+msg->iBeginTime, false);
+        bool bFlag = timeoutQueue->push(msg,msg->request.iRequestId, msg->request.iTimeout+msg->iBeginTime, false);
         if(!bFlag)
         {
-            TLOGERROR("[TARS][AdapterProxy::invoke fail2 : insert timeout queue fail,queue size:" << _timeoutQueue->size() << "," <<_objectProxy->name() << ", " << _endpoint.desc() <<endl);
+            TLOGERROR("[TARS][AdapterProxy::invoke fail2 : insert timeout queue fail,queue size:" << timeoutQueue->size() << "," <<_objectProxy->name() << ", " << _endpoint.desc() <<endl);
             
             msg->eStatus = ReqMessage::REQ_EXC;
 
@@ -210,20 +333,106 @@ int AdapterProxy::invoke(ReqMessage * msg)
     return 0;
 }
 
+void AdapterProxy::doPendingInvoke()
+{
+    _pendingInvoke = false;
+
+    doInvoke();
+}
+
+void AdapterProxy::doInvokeBatch(ConnInfo & conn)
+{
+    vector<ReqMessage*> vMsg;
+    vector<iovec> vecs;
+
+    while(!conn.timeoutQueue->sendListEmpty())
+    {
+        conn.timeoutQueue->getSend(vMsg, _sendBatchNum);
+
+        vecs.clear();
+
+        size_t iBytes = 0;
+        for(size_t i = 0; i < vMsg.size(); ++i)
+        {
+            //至少发一个
+            if(i > 0 && iBytes + vMsg[i]->sReqData.size() > _sendBatchBytes)
+            {
+                break;
+            }
+
+            iovec ivc;
+            ivc.iov_base = const_cast<char*>(vMsg[i]->sReqData.data());
+            ivc.iov_len  = vMsg[i]->sReqData.size();
+            iBytes += ivc.iov_len;
+
+            vecs.push_back(ivc);
+        }
+
+        size_t iNum = 0;
+
+        int iRet = conn.trans->sendRequest(vecs, iNum);
+
+        TLOGINFO("[TARS][AdapterProxy::doInvokeBatch sendRequest objname:" << _objectProxy->name() << ",desc" << _endpoint.desc() << ",num " << vecs.size() << ",sent " << iNum << ",ret" << iRet << endl);
+
+        //发送完成(包括写入buffer的)，要从队列里面清掉
+        for(size_t i = 0; i < iNum; ++i)
+        {
+            ReqMessage * msg = vMsg[i];
+
+            conn.timeoutQueue->popSend(msg->eType == ReqMessage::ONE_WAY);
+            if(msg->eType == ReqMessage::ONE_WAY)
+            {
+                delete msg;
+            }
+        }
+
+        //发送失败或者发送buffer已经满了 要返回
+        if(iRet != Transceiver::eRetOk)
+        {
+            return;
+        }
+    }
+}
+
 void AdapterProxy::doInvoke()
 {
-    if(_timeoutQueue->sendListEmpty())
+    if(_sendBatch)
+    {
+        _pendingNum   = 0;
+        _pendingBytes = 0;
+    }
+
+    for(size_t i = 0; i < _conns.size(); ++i)
+    {
+        doInvoke(_conns[i]);
+    }
+}
+
+void AdapterProxy::doInvoke(Transceiver * trans)
+{
+    doInvoke(_conns[trans->getConnIndex()]);
+}
+
+void AdapterProxy::doInvoke(ConnInfo & conn)
+{
+    if(_sendBatch)
+    {
+        doInvokeBatch(conn);
+        return;
+    }
+
+    if(conn.timeoutQueue->sendListEmpty())
     {
         return ;
     }
 
-    while(!_timeoutQueue->sendListEmpty())
+    while(!conn.timeoutQueue->sendListEmpty())
     {
         ReqMessage * msg = NULL;
 
-        _timeoutQueue->getSend(msg);
+        conn.timeoutQueue->getSend(msg);
 
-        int iRet = _trans->sendRequest(msg->sReqData.c_str(), msg->sReqData.size());
+        int iRet = conn.trans->sendRequest(msg->sReqData.c_str(), msg->sReqData.size());
 
         TLOGINFO("[TARS][AdapterProxy::doInvoke sendRequest objname:" << _objectProxy->name() << ",desc" << _endpoint.desc() << ",id " << msg->request.iRequestId << ",ret" << iRet << endl);
 
@@ -238,7 +447,7 @@ void AdapterProxy::doInvoke()
         //...
 
         //发送完成，要从队列里面清掉
-        _timeoutQueue->popSend(msg->eType == ReqMessage::ONE_WAY);
+        conn.timeoutQueue->popSend(msg->eType == ReqMessage::ONE_WAY);
         if(msg->eType == ReqMessage::ONE_WAY)
         {
             delete msg;
@@ -358,6 +567,34 @@ void AdapterProxy::finishInvoke(bool bFail)
 }
 
 
+void AdapterProxy::checkConn(ConnInfo & conn, time_t now, bool bForceConnect)
+{
+    //连接没有建立或者连接无效, 重新建立连接
+    if(conn.trans->isValid())
+    {
+        return;
+    }
+
+    //异常的连接按重试间隔重连
+    if(!bForceConnect && conn.connExc && now < conn.nextRetryTime)
+    {
+        return;
+    }
+
+    conn.nextRetryTime = now + _objectProxy->checkTimeoutInfo().tryTimeInterval;
+
+    try
+    {
+        conn.trans->reconnect();
+    }
+    catch(exception &ex)
+    {
+        conn.trans->close();
+
+        TLOGERROR("[TARS][AdapterProxy::checkActive connect ex:" << ex.what() << endl);
+    }
+}
+
 bool AdapterProxy::checkActive(bool bForceConnect)
 {
     time_t now = TNOW;
@@ -371,7 +608,10 @@ bool AdapterProxy::checkActive(bool bForceConnect)
           << ",_connExcCnt:"<<_connExcCnt
           << ",total:" << _totalInvoke << endl);
 
-    _trans->checkTimeout();
+    for(size_t i = 0; i < _conns.size(); ++i)
+    {
+        _conns[i].trans->checkTimeout();
+    }
 
     //强制重试
     if(bForceConnect)
@@ -379,78 +619,67 @@ bool AdapterProxy::checkActive(bool bForceConnect)
         //强制重试  肯定是无效结点
         assert(!_activeStatus);
 
-        //有效的连接
-        if(_trans->isConnecting() || _trans->hasConnected())
+        _nextRetryTime = now + _objectProxy->checkTimeoutInfo().tryTimeInterval;
+    }
+    else
+    {
+        //失效且没有到下次重试时间, 直接返回不可用
+        if((!_activeStatus) && (now < _nextRetryTime) )
         {
-            return true;
+            TLOGINFO("[TARS][AdapterProxy::checkActive,not reach retry time ,objname:" << _objectProxy->name() << ",desc:" << _endpoint.desc()  <<endl);
+            return false;
         }
 
-        _nextRetryTime = now + _objectProxy->checkTimeoutInfo().tryTimeInterval;
-
-        //连接没有建立或者连接无效, 重新建立连接
-        if(!_trans->isValid())
+        if(!_activeStatus)
         {
-
-            try
-            {
-                _trans->reconnect();
-            }
-            catch(exception &ex)
-            {
-                _activeStatus = false;
-
-                _trans->close();
-
-                TLOGERROR("[TARS][AdapterProxy::checkActive connect ex:" << ex.what() << endl);
-            }
+            _nextRetryTime = now + _objectProxy->checkTimeoutInfo().tryTimeInterval;
         }
-
-        return (_trans->hasConnected() || _trans->isConnecting());
     }
 
-    //失效且没有到下次重试时间, 直接返回不可用
-    if((!_activeStatus) && (now < _nextRetryTime) )
-    {
-        TLOGINFO("[TARS][AdapterProxy::checkActive,not reach retry time ,objname:" << _objectProxy->name() << ",desc:" << _endpoint.desc()  <<endl);
-        return false;
-    }
+    bool bActive = false;
 
-    if(!_activeStatus)
+    for(size_t i = 0; i < _conns.size(); ++i)
     {
-        _nextRetryTime = now + _objectProxy->checkTimeoutInfo().tryTimeInterval;
-    }
+        ConnInfo & conn = _conns[i];
 
-    //连接没有建立或者连接无效, 重新建立连接
-    if(!_trans->isValid())
-    {
-        try
+        //强制重试时, 有有效的连接就不再重连
+        if(bForceConnect && (conn.trans->isConnecting() || conn.trans->hasConnected()))
         {
-            _trans->reconnect();
+            bActive = true;
+            continue;
         }
-        catch(exception &ex)
-        {
-            _activeStatus = false;
 
-            _trans->close();
+        checkConn(conn, now, bForceConnect);
 
-            TLOGERROR("[TARS][AdapterProxy::checkActive connect ex:" << ex.what() << endl);
-        }
+        bActive = bActive || conn.trans->hasConnected() || conn.trans->isConnecting();
+    }
+
+    //一个连接都建立不起来
+    if(!bActive)
+    {
+        _activeStatus = false;
     }
 
-    return (_trans->hasConnected() || _trans->isConnecting());
+    return bActive;
 }
 
 
-void AdapterProxy::setConTimeout(bool bConTimeout)
+void AdapterProxy::setConTimeout(Transceiver * trans, bool bConTimeout)
 {
-    if(bConTimeout != _connTimeout)
+    ConnInfo & conn = _conns[trans->getConnIndex()];
+
+    if(bConTimeout != conn.connTimeout)
     {
-        TLOGERROR("[TARS][AdapterProxy::setConTimeout desc:"<< _endpoint.desc() << " connect timeout status is:" << bConTimeout << endl);
-        _connTimeout = bConTimeout;
-        if(_connTimeout)
+        TLOGERROR("[TARS][AdapterProxy::setConTimeout desc:"<< _endpoint.desc() << ",conn:" << trans->getConnIndex() << " connect timeout status is:" << bConTimeout << endl);
+
+        conn.connTimeout = bConTimeout;
+
+        if(conn.connTimeout)
         {
-            setInactive();
+            conn.trans->close();
         }
+
+        updateConnState();
     }
 }
 
@@ -459,6 +688,39 @@ int AdapterProxy::getConTimeout()
     return _objectProxy->getConTimeout(); 
 }
 
+void AdapterProxy::updateConnState()
+{
+    bool bConnTimeout   = true;
+    bool bConnExc       = true;
+    uint32_t iConnExcCnt = _conns[0].connExcCnt;
+
+    for(size_t i = 0; i < _conns.size(); ++i)
+    {
+        bConnTimeout = bConnTimeout && _conns[i].connTimeout;
+        bConnExc     = bConnExc && _conns[i].connExc;
+
+        if(_conns[i].connExcCnt < iConnExcCnt)
+        {
+            iConnExcCnt = _conns[i].connExcCnt;
+        }
+    }
+
+    _connExcCnt = iConnExcCnt;
+
+    //所有连接都超时或者异常才屏蔽结点
+    if((bConnTimeout && !_connTimeout) || (bConnExc && !_connExc))
+    {
+        setInactive();
+    }
+    else if(_connExc && !bConnExc)
+    {
+        TLOGERROR("[TARS][AdapterProxy::addConnExc desc:"<< _endpoint.desc() << ",connect exception status is false!(connect ok)"<<endl);
+    }
+
+    _connTimeout = bConnTimeout;
+    _connExc     = bConnExc;
+}
+
 //屏蔽结点
 void AdapterProxy::setInactive()
 {
@@ -466,35 +728,38 @@ void AdapterProxy::setInactive()
 
     _nextRetryTime = TNOW + _objectProxy->checkTimeoutInfo().tryTimeInterval;
 
-    _trans->close();
+    for(size_t i = 0; i < _conns.size(); ++i)
+    {
+        _conns[i].trans->close();
+    }
 
     TLOGINFO("[TARS][AdapterProxy::setInactive objname:" << _objectProxy->name() << ",desc:" << _endpoint.desc() << ",inactive" << endl);
 }
 
-void AdapterProxy::finishInvoke(ResponsePacket & rsp)
+void AdapterProxy::finishInvoke(Transceiver * trans, ResponsePacket & rsp)
 {
     TLOGINFO("[TARS][AdapterProxy::finishInvoke(ResponsePacket) objname:" << _objectProxy->name() << ",desc:" << _endpoint.desc() 
         << ",id:" << rsp.iRequestId << endl);
 
-    if (_trans->getAuthState() != AUTH_SUCC)
+    if (trans->getAuthState() != AUTH_SUCC)
     {
         std::string ret(rsp.sBuffer.begin(), rsp.sBuffer.end());
         tars::AUTH_STATE tmp = AUTH_SUCC;
         tars::stoe(ret, tmp);
         int newstate = tmp;
 
-        TLOGINFO("[TARS]AdapterProxy::finishInvoke from state " << _trans->getAuthState() << " to " << newstate << endl);
-        _trans->setAuthState(newstate);
+        TLOGINFO("[TARS]AdapterProxy::finishInvoke from state " << trans->getAuthState() << " to " << newstate << endl);
+        trans->setAuthState(newstate);
 
         if (newstate == AUTH_SUCC)
         {
             // flush old buffered msg when auth is not complete
-            doInvoke();
+            doInvoke(trans);
         }
         else
         {
             TLOGERROR("newstate is " << newstate << ", error close!\n");
-            _trans->close();
+            trans->close();
         }
 
         return;
@@ -525,7 +790,7 @@ void AdapterProxy::finishInvoke(ResponsePacket & rsp)
     else
     {
         //这里的队列中的发送链表中的数据可能已经在timeout的时候删除了
-        bool retErase = _timeoutQueue->erase(rsp.iRequestId, msg);
+        bool retErase = _conns[trans->getConnIndex()].timeoutQueue->erase(rsp.iRequestId, msg);
 
         //找不到此请求id信息
         if (!retErase)
@@ -569,6 +834,9 @@ void AdapterProxy::finishInvoke(ReqMessage * msg)
     if(msg->eStatus != ReqMessage::REQ_EXC && !msg->bPush)
     {
         finishInvoke(msg->response.iRet != TARSSERVERSUCCESS);
+
+        //超时的按超时时间算, 慢节点很快就会少分到请求
+        updateLatency(msg->iEndUs, (double)(msg->iEndUs >= msg->iBeginUs ? msg->iEndUs - msg->iBeginUs : 0));
     }
 
     //同步调用，唤醒ServantProxy线程
@@ -651,32 +919,90 @@ void AdapterProxy::doTimeout()
 {
     TLOGINFO("[TARS][AdapterProxy::doTimeout objname:" << _objectProxy->name() << ",desc:" << _endpoint.desc() << endl);
 
-    ReqMessage * msg;
-    while(_timeoutQueue->timeout(msg))
+    for(size_t i = 0; i < _conns.size(); ++i)
     {
-        TLOGINFO("[TARS][AdapterProxy::doTimeout objname:" << _objectProxy->name() << ",desc:" << _endpoint.desc() << ",id " << msg->request.iRequestId << endl);
+        ConnInfo & conn = _conns[i];
 
-        assert(msg->eStatus == ReqMessage::REQ_REQ);
+        ReqMessage * msg;
+        while(conn.timeoutQueue->timeout(msg))
+        {
+            TLOGINFO("[TARS][AdapterProxy::doTimeout objname:" << _objectProxy->name() << ",desc:" << _endpoint.desc() << ",id " << msg->request.iRequestId << endl);
 
-        msg->eStatus = ReqMessage::REQ_TIME;
+            assert(msg->eStatus == ReqMessage::REQ_REQ);
 
-        //有可能是单向调用超时了
-        if(msg->eType == ReqMessage::ONE_WAY)
-        {
-            delete msg;
-            msg = NULL;
-            continue;
-        }
+            msg->eStatus = ReqMessage::REQ_TIME;
 
-        //如果是异步调用超时
-        if(msg->eType == ReqMessage::ASYNC_CALL)
-        {
-            //_connExcCnt大于0说明是网络连接异常引起的超时
-            msg->response.iRet = (_connExcCnt > 0 ? TARSPROXYCONNECTERR : TARSASYNCCALLTIMEOUT);
+            //有可能是单向调用超时了
+            if(msg->eType == ReqMessage::ONE_WAY)
+            {
+                delete msg;
+                msg = NULL;
+                continue;
+            }
+
+            //如果是异步调用超时
+            if(msg->eType == ReqMessage::ASYNC_CALL)
+            {
+                //connExcCnt大于0说明是网络连接异常引起的超时
+                msg->response.iRet = (conn.connExcCnt > 0 ? TARSPROXYCONNECTERR : TARSASYNCCALLTIMEOUT);
+            }
+
+            finishInvoke(msg);
         }
+    }
+}
 
-        finishInvoke(msg);
+size_t AdapterProxy::getInflight() const
+{
+    size_t iNum = 0;
+
+    for(size_t i = 0; i < _conns.size(); ++i)
+    {
+        iNum += _conns[i].timeoutQueue->size();
+    }
+
+    return iNum;
+}
+
+void AdapterProxy::updateLatency(int64_t iNowUs, double dRttUs)
+{
+    //时间往回走(比上次更新早)时不衰减, 也不改上次更新的时间
+    int64_t iDelta = iNowUs - _latencyTime;
+    if(iDelta < 0)
+    {
+        iDelta = 0;
+    }
+    else
+    {
+        _latencyTime = iNowUs;
+    }
+
+    //比平均值大的直接取当前值, 对变慢反应快; 变快时慢慢衰减下来
+    if(dRttUs > _latency)
+    {
+        _latency = dRttUs;
     }
+    else
+    {
+        double w = exp(-(double)iDelta / LATENCY_DECAY_US);
+
+        _latency = _latency * w + dRttUs * (1 - w);
+    }
+}
+
+double AdapterProxy::getLatencyLoad(int64_t iNowUs)
+{
+    //没有请求的这段时间也要衰减, 让慢节点有机会恢复
+    updateLatency(iNowUs, 0);
+
+    size_t iInflight = getInflight();
+
+    if(_latency <= 0 && iInflight > 0)
+    {
+        return LATENCY_PENALTY + iInflight;
+    }
+
+    return _latency * (iInflight + 1);
 }
 
 void AdapterProxy::sample(ReqMessage * msg)
@@ -719,129 +1045,75 @@ void AdapterProxy::stat(ReqMessage * msg)
         return ;
     }
 
-    StatMicMsgBody body;
-    int64_t sptime = 0;
+    int eResult     = StatReport::STAT_EXCE;
+    int64_t sptime  = 0;
+    int64_t sptimeUs= 0;
 
-    msg->iEndTime = TNOWMS;
+    int64_t endUs   = TNOWUS;
+
+    msg->iEndUs   = endUs;
+    msg->iEndTime = endUs / 1000;
 
-    //包体信息.
     if(msg->eStatus == ReqMessage::REQ_RSP && TARSSERVERSUCCESS == msg->response.iRet)
     {
-        body.count = 1;
-        sptime = (msg->iEndTime >= msg->iBeginTime) ? (msg->iEndTime - msg->iBeginTime) : 10000;
-
-        body.totalRspTime = body.minRspTime = body.maxRspTime = sptime;
+        eResult = StatReport::STAT_SUCC;
+        sptime  = (msg->iEndTime >= msg->iBeginTime) ? (msg->iEndTime - msg->iBeginTime) : 10000;
+        sptimeUs= (endUs >= msg->iBeginUs) ? (endUs - msg->iBeginUs) : sptime * 1000;
     }
     else if(msg->eStatus == ReqMessage::REQ_TIME)
     {
-        body.timeoutCount = 1;
-    }
-    else
-    {
-        body.execCount = 1;
+        eResult = StatReport::STAT_TIMEOUT;
     }
 
-    map<string,StatMicMsgBody>::iterator it = _statBody.find(msg->request.sFuncName);
-    if(it != _statBody.end())
+    //每个接口的上报头只生成一次, 计数由StatReport线程定时取走
+    map<string, StatCounterPtr>::iterator it = _statCounter.find(msg->request.sFuncName);
+    if(it == _statCounter.end())
     {
-        merge(body,it->second);
-    }
-    else
-    {
-        _communicator->getStatReport()->getIntervCount(body.maxRspTime, body);
-        _statBody[msg->request.sFuncName] = body;
+        StatMicMsgHead head = _statHead;
+        head.interfaceName  = msg->request.sFuncName;
+
+        it = _statCounter.insert(make_pair(msg->request.sFuncName, _communicator->getStatReport()->getStatCounter(head, true))).first;
     }
 
+    it->second->report(eResult, (int)sptime, sptimeUs);
+
     if(LOG->IsNeedLog(TarsRollLogger::INFO_LOG))
     {
         ostringstream os;
         os.str("");
-        _statHead.displaySimple(os);
-        os << "  ";
-        _statBody[msg->request.sFuncName].displaySimple(os);
-        TLOGINFO("[TARS][AdapterProxy::stat(ReqMessage) display:" << os.str() << endl);
-    }
-}
-
-void AdapterProxy::merge(const StatMicMsgBody& inBody,StatMicMsgBody& outBody/*out*/)
-{
-    outBody.count                += inBody.count;
-    outBody.timeoutCount         += inBody.timeoutCount;
-    outBody.execCount            += inBody.execCount;
-    outBody.totalRspTime         += inBody.totalRspTime;
-
-    if (outBody.maxRspTime < inBody.maxRspTime )
-    {
-        outBody.maxRspTime = inBody.maxRspTime;
+        it->second->getHead().displaySimple(os);
+        TLOGINFO("[TARS][AdapterProxy::stat(ReqMessage) display:" << os.str() << ",result:" << eResult << ",sptime:" << sptime << endl);
     }
-
-    //非0最小值
-    if (outBody.minRspTime == 0 ||(outBody.minRspTime > inBody.minRspTime && inBody.minRspTime != 0))
-    {
-        outBody.minRspTime = inBody.minRspTime;
-    }
-
-    _communicator->getStatReport()->getIntervCount(inBody.maxRspTime, outBody);
 }
 
-void AdapterProxy::doStat(map<StatMicMsgHead, StatMicMsgBody> & mStatMicMsg)
+void AdapterProxy::addConnExc(Transceiver * trans, bool bExc)
 {
-    TLOGINFO("[TARS][AdapterProxy::doStat objname:" << _objectProxy->name() << ",desc:" << _endpoint.desc() << endl);
+    ConnInfo & conn = _conns[trans->getConnIndex()];
 
-    map<string,StatMicMsgBody>::iterator iter = _statBody.begin();
-
-    for(; iter != _statBody.end(); ++iter)
+    if(bExc)
     {
-        _statHead.interfaceName = iter->first;
-        //有数据就放到map里面
-        if(iter->second.count != 0 || iter->second.timeoutCount != 0 || iter->second.execCount != 0)
+        if(!conn.connExc && conn.connExcCnt++ >= _objectProxy->checkTimeoutInfo().maxConnectExc)
         {
-            //判断是否已经有相同的数据了，需要汇总
-            StatReport::MapStatMicMsg::iterator it = mStatMicMsg.find(_statHead);
-            if(it != mStatMicMsg.end())
-            {
-                merge(iter->second,it->second);
-            }
-            else
-            {
-                mStatMicMsg[_statHead] = iter->second;
-            }
-        }
-    }
+            TLOGERROR("[TARS][AdapterProxy::addConnExc desc:"<< _endpoint.desc() << ",conn:" << trans->getConnIndex() << ",connect exception status is true! (connect error)"<<endl);
 
-    //清空数据
-    _statBody.clear();
-}
+            conn.connExc       = true;
+            conn.nextRetryTime = TNOW + _objectProxy->checkTimeoutInfo().tryTimeInterval;
 
-void AdapterProxy::addConnExc(bool bExc)
-{
-    if(bExc)
-    {
-        if(!_connExc && _connExcCnt++ >= _objectProxy->checkTimeoutInfo().maxConnectExc)
-        {
-            if(!_connExc)
-            {
-                TLOGERROR("[TARS][AdapterProxy::addConnExc desc:"<< _endpoint.desc() << ",connect exception status is true! (connect error)"<<endl);
-            }
-            setInactive();
-            _connExc = true;
+            conn.trans->close();
         }
     }
     else
     {
-        if(_connExc)
-        {
-            TLOGERROR("[TARS][AdapterProxy::addConnExc desc:"<< _endpoint.desc() << ",connect exception status is false!(connect ok)"<<endl);
-        }
-
-         _connExc = false;
-        _connExcCnt = 0;
+        conn.connExc    = false;
+        conn.connExcCnt = 0;
 
         if(!_activeStatus)
         {
             _activeStatus = true;
         }
     }
+
+    updateConnState();
 }
 
 }
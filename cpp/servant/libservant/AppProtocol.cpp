@@ -28,21 +28,74 @@ int AppProtocol::parseAdmin(string &in, string &out)
     return parse(in, out);
 }
 
+int AppProtocol::parseAdminSlice(const char *data, size_t len, size_t &pos, size_t &end)
+{
+    return parseSlice(data, len, pos, end);
+}
+
+/**
+ * 每个线程复用一个请求编码缓冲区, 用完超过64K的释放掉, 避免长期占用
+ */
+static pthread_once_t   g_encodeOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t    g_encodeKey;
+
+static void destroyEncodeBuffer(void *p)
+{
+    delete (TarsOutputStream<BufferWriter>*)p;
+}
+
+static void createEncodeKey()
+{
+    pthread_key_create(&g_encodeKey, destroyEncodeBuffer);
+}
+
 void ProxyProtocol::tarsRequest(const RequestPacket& request, string& buff)
 {
-    TarsOutputStream<BufferWriter> os;
+    pthread_once(&g_encodeOnce, createEncodeKey);
+
+    TarsOutputStream<BufferWriter> *os = (TarsOutputStream<BufferWriter>*)pthread_getspecific(g_encodeKey);
+    if(os == NULL)
+    {
+        os = new TarsOutputStream<BufferWriter>();
+        pthread_setspecific(g_encodeKey, os);
+    }
+
+    os->reset();
+
+    //先占住包头, 编码完再回填长度
+    tars::Int32 iHeaderLen = 0;
+
+    os->writeBuf(&iHeaderLen, sizeof(tars::Int32));
+
+    request.writeTo(*os);
 
-    request.writeTo(os);
+    iHeaderLen = htonl(os->getLength());
+
+    memcpy(os->_buf, &iHeaderLen, sizeof(tars::Int32));
+
+    buff.assign(os->getBuffer(), os->getLength());
+
+    if(os->_buf_len > 65536)
+    {
+        delete os;
+        pthread_setspecific(g_encodeKey, NULL);
+    }
+}
+size_t ProxyProtocol::tarsRequestPrepare(RequestPacket& request, string& buff)
+{
+    //用超出Short范围的值占位, 保证requestid按Int32编码, 回填时长度不变
+    request.iRequestId = 0x7fffffff;
 
-    tars::Int32 iHeaderLen = htonl(sizeof(tars::Int32) + os.getLength());
+    tarsRequest(request, buff);
 
-    buff.clear();
+    //跳过requestid前面的字段, 再跳过1字节的头
+    TarsInputStream<BufferReader> is;
 
-    buff.reserve(sizeof(tars::Int32) + os.getLength());
+    is.setBuffer(buff.c_str() + sizeof(tars::Int32), buff.size() - sizeof(tars::Int32));
 
-    buff.append((const char*)&iHeaderLen, sizeof(tars::Int32));
+    is.skipToTag(4);
 
-    buff.append(os.getBuffer(), os.getLength());
+    return sizeof(tars::Int32) + is._cur + 1;
 }
 ////////////////////////////////////////////////////////////////////////////////////
 }
@@ -191,6 +191,12 @@ bool Application::cmdViewStatus(const string& command, const string& params, str
 
     outAllAdapter(os);
 
+    os << OUT_LINE << "\n" << outfill("[cache alloc]:") << endl;
+
+    os << TC_CacheAlloc::stat();
+
+    os << OUT_LINE << endl;
+
     result = os.str();
 
     return true;
@@ -766,6 +772,28 @@ TC_EpollServer::BindAdapter::EOrder Application::parseOrder(const string &s)
      exit(0);
 }
 
+int Application::parseHandleSchedule(const string &s)
+{
+    string sched = TC_Common::lower(TC_Common::trim(s));
+
+    if(sched == "queue")
+    {
+        return TC_EpollServer::HANDLE_SCHED_QUEUE;
+    }
+    if(sched == "roundrobin")
+    {
+        return TC_EpollServer::HANDLE_SCHED_ROUNDROBIN;
+    }
+    if(sched == "affinity")
+    {
+        return TC_EpollServer::HANDLE_SCHED_AFFINITY;
+    }
+
+    cout << OUT_LINE << "\nwarning:invalid handlesched '" << s << "', use queue." << endl;
+
+    return TC_EpollServer::HANDLE_SCHED_QUEUE;
+}
+
 void Application::initializeClient()
 {
     cout << "\n" << OUT_LINE_LONG << endl;
@@ -845,6 +873,17 @@ void Application::addServantProtocol(const string& servant, const TC_EpollServer
     getEpollServer()->getBindAdapter(adapterName)->setProtocol(protocol);
 }
 
+void Application::addServantSliceProtocol(const string& servant, const TC_EpollServer::slice_protocol_functor& protocol)
+{
+    string adapterName = ServantHelperManager::getInstance()->getServantAdapter(servant);
+
+    if (adapterName == "")
+    {
+        throw runtime_error("[TARS]addServantSliceProtocol fail, no found adapter for servant:" + servant);
+    }
+    getEpollServer()->getBindAdapter(adapterName)->setSliceProtocol(protocol);
+}
+
 void Application::initializeServer()
 {
     cout << OUT_LINE << "\n" << outfill("[server config]:") << endl;
@@ -939,9 +978,26 @@ void Application::initializeServer()
     cout << OUT_LINE << "\n" << outfill("[set file cache ]") << "OK" << endl;
     AppCache::getInstance()->setCacheInfo(ServerConfig::DataPath+ServerConfig::ServerName+".tarsdat",0);
 
+    ///////////////////////////////////////////////////////////////////////////////////////////////////
+    //异步写日志时每个线程在每个日志文件上的缓冲区大小(0表示不用)
+    //满时的策略: sync(当前线程直接写文件, 默认)/block(等待)/drop(丢弃并计数, 要显式配置)
+    size_t logRingSize = TC_Common::strto<size_t>(_conf.get("/tars/application/server<logringsize>", "65536"));
+    string logOverflow = TC_Common::lower(_conf.get("/tars/application/server<logoverflow>", "sync"));
+    int iOverflow = TC_LoggerRoll::OVERFLOW_SYNC;
+    if (logOverflow == "drop")
+    {
+        iOverflow = TC_LoggerRoll::OVERFLOW_DROP;
+    }
+    else if (logOverflow == "block")
+    {
+        iOverflow = TC_LoggerRoll::OVERFLOW_BLOCK;
+    }
+    TC_LoggerRoll::setDefaultRing(logRingSize, iOverflow);
+
     ///////////////////////////////////////////////////////////////////////////////////////////////////
     //初始化本地Log
     cout << OUT_LINE << "\n" << outfill("[set roll logger] ") << "OK" << endl;
+    TarsRollLogger::getInstance()->logger()->getRoll()->setRing(logRingSize, iOverflow);
     TarsRollLogger::getInstance()->setLogInfo(ServerConfig::Application, ServerConfig::ServerName, ServerConfig::LogPath, ServerConfig::LogSize, ServerConfig::LogNum, _communicator, ServerConfig::Log);
     _epollServer->setLocalLogger(TarsRollLogger::getInstance()->logger());
 
@@ -963,6 +1019,20 @@ void Application::initializeServer()
     //初始化到LogServer代理
     cout << OUT_LINE << "\n" << outfill("[set time logger] ") << "OK" << endl;
     bool bLogStatReport = (_conf.get("/tars/application/server<logstatreport>", "0") == "1") ? true : false;
+    //远程日志的压缩方式: lz4(缺省)/gzip/none, LogServer不支持时自动改成none
+    string logCompress = TC_Common::lower(_conf.get("/tars/application/server<logcompress>", "lz4"));
+    if (logCompress == "none")
+    {
+        TarsTimeLogger::getInstance()->setCompress(LOG_COMPRESS_NONE);
+    }
+    else if (logCompress == "gzip")
+    {
+        TarsTimeLogger::getInstance()->setCompress(LOG_COMPRESS_GZIP);
+    }
+    else
+    {
+        TarsTimeLogger::getInstance()->setCompress(LOG_COMPRESS_LZ4);
+    }
     TarsTimeLogger::getInstance()->setLogInfo(_communicator, ServerConfig::Log, ServerConfig::Application, ServerConfig::ServerName, ServerConfig::LogPath, setDivision(), bLogStatReport);
 
     ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1004,7 +1074,7 @@ void Application::initializeServer()
 
         lsPtr->setProtocolName("tars");
 
-        lsPtr->setProtocol(AppProtocol::parse);
+        lsPtr->setSliceProtocol(AppProtocol::parseSlice);
 
         lsPtr->setHandleGroupName("AdminAdapter");
 
@@ -1093,6 +1163,9 @@ void Application::bindAdapter(vector<TC_EpollServer::BindAdapterPtr>& adapters)
 
     map<string, ServantHandle*> servantHandles;
 
+    //handle组 -> (第一个adapter, 分发方式)
+    map<string, pair<string, int> > handleScheds;
+
     if (_conf.getDomainVector("/tars/application/server", adapterName))
     {
         for (size_t i = 0; i < adapterName.size(); i++)
@@ -1138,15 +1211,35 @@ void Application::bindAdapter(vector<TC_EpollServer::BindAdapterPtr>& adapters)
 
             if (bindAdapter->isTarsProtocol())
             {
-                bindAdapter->setProtocol(AppProtocol::parse);
+                bindAdapter->setSliceProtocol(AppProtocol::parseSlice);
             }
 
             bindAdapter->setHandleGroupName(_conf.get(sLastPath + "<handlegroup>", adapterName[i]));
 
             bindAdapter->setHandleNum(TC_Common::strto<int>(_conf.get(sLastPath + "<threads>", "0")));
 
+            //handle组分发请求的方式: queue(共用队列, 缺省)/roundrobin/affinity
+            bindAdapter->setHandleSchedule(parseHandleSchedule(_conf.get(sLastPath + "<handlesched>", "queue")));
+
+            //同一个handle组用第一个adapter的分发方式
+            map<string, pair<string, int> >::iterator itSched = handleScheds.find(bindAdapter->getHandleGroupName());
+            if(itSched == handleScheds.end())
+            {
+                handleScheds[bindAdapter->getHandleGroupName()] = make_pair(adapterName[i], bindAdapter->getHandleSchedule());
+            }
+            else if(itSched->second.second != bindAdapter->getHandleSchedule())
+            {
+                cout << OUT_LINE << "\nwarning:handlesched of " << adapterName[i] << " conflicts with " << itSched->second.first
+                     << " in handlegroup " << itSched->first << ", use " << itSched->second.first << "'s." << endl;
+
+                bindAdapter->setHandleSchedule(itSched->second.second);
+            }
+
             bindAdapter->setBackPacketBuffLimit(iBackPacketBuffLimit);
 
+            //每个网络线程各自监听(SO_REUSEPORT), 缺省为单线程accept
+            bindAdapter->setReusePort(_conf.get(sLastPath + "<reuseport>", "0") == "1");
+
             _epollServer->bind(bindAdapter);
 
             adapters.push_back(bindAdapter);
@@ -1202,6 +1295,8 @@ void Application::outAdapter(ostream &os, const string &v, TC_EpollServer::BindA
     os << outfill("protocol")         << lsPtr->getProtocolName() << endl;
     os << outfill("handlegroup")      << lsPtr->getHandleGroupName() << endl;
     os << outfill("handlethread")     << lsPtr->getHandleNum() << endl;
+    os << outfill("reuseport")        << lsPtr->isReusePort() << endl;
+    os << outfill("handlesched")      << lsPtr->getHandleSchedule() << endl;
 }
 //////////////////////////////////////////////////////////////////////////////////////////////////
 }
@@ -212,6 +212,9 @@ int Communicator::reloadProperty(string & sResult)
         propertyPrx = stringToProxy<PropertyFPrx>(propertyObj);
     }
 
+    //微秒级的高精度耗时分布, 需要StatServer和统计表支持
+    _statReport->setHistogram(TC_Common::strto<bool>(getProperty("stat-histogram", "0")));
+
     string sSetDivision = ClientConfig::SetOpen?ClientConfig::SetDivision:"";
     _statReport->setReportInfo(statPrx, propertyPrx, ClientConfig::ModuleName, ClientConfig::LocalIp, sSetDivision, iReportInterval, iSampleRate, iMaxSampleCount, iMaxReportSize, iReportTimeout);
 
@@ -251,7 +254,7 @@ void Communicator::initialize()
     }
 
     //stat总是有对象, 保证getStat返回的对象总是有效
-    _statReport = new StatReport(_clientThreadNum);
+    _statReport = new StatReport();
 
     for(size_t i = 0; i < _clientThreadNum; ++i)
     {
@@ -295,6 +298,9 @@ void Communicator::initialize()
         propertyPrx = stringToProxy<PropertyFPrx>(propertyObj);
     }
 
+    //微秒级的高精度耗时分布, 需要StatServer和统计表支持
+    _statReport->setHistogram(TC_Common::strto<bool>(getProperty("stat-histogram", "0")));
+
     string sSetDivision = ClientConfig::SetOpen?ClientConfig::SetDivision:"";
     _statReport->setReportInfo(statPrx, propertyPrx, ClientConfig::ModuleName, ClientConfig::LocalIp, sSetDivision, iReportInterval, iSampleRate, iMaxSampleCount, iMaxReportSize, iReportTimeout);
 }
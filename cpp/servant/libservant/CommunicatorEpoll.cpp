@@ -18,6 +18,7 @@
 #include "servant/Communicator.h"
 #include "servant/TarsLogger.h"
 #include "servant/StatReport.h"
+#include "servant/AdapterProxy.h"
 
 using namespace std;
 
@@ -35,6 +36,11 @@ CommunicatorEpoll::CommunicatorEpoll(Communicator * pCommunicator,size_t netThre
 , _netThreadSeq(netThreadSeq)
 , _reportAsyncQueue(NULL)
 , _noSendQueueLimit(1000)
+, _sendBatch(false)
+, _sendBatchNum(64)
+, _sendBatchBytes(64 * 1024)
+, _callerEncode(false)
+, _connNum(1)
 , _waitTimeout(100)
 , _timeoutCheckInterval(100)
 {
@@ -66,6 +72,41 @@ CommunicatorEpoll::CommunicatorEpoll(Communicator * pCommunicator,size_t netThre
         _noSendQueueLimit = 1000;
     }
 
+    //批量发送: 一轮事件处理中同一个节点的请求一次writev发送
+    _sendBatch = (pCommunicator->getProperty("sendbatch", "0") == "1");
+
+    //一次最多发送的请求个数, 不超过IOV_MAX
+    _sendBatchNum = TC_Common::strto<size_t>(pCommunicator->getProperty("sendbatchnum", "64"));
+    if(_sendBatchNum < 1)
+    {
+        _sendBatchNum = 1;
+    }
+    if(_sendBatchNum > 1024)
+    {
+        _sendBatchNum = 1024;
+    }
+
+    //一次最多发送的字节数
+    _sendBatchBytes = TC_Common::strto<size_t>(pCommunicator->getProperty("sendbatchbytes", "65536"));
+    if(_sendBatchBytes < 1024)
+    {
+        _sendBatchBytes = 1024;
+    }
+
+    //tars协议的请求在调用线程中编码, 网络线程只回填requestid
+    _callerEncode = (pCommunicator->getProperty("callerencode", "0") == "1");
+
+    //每个节点的连接个数(只对tcp有效), 请求发给在途请求最少的连接
+    _connNum = TC_Common::strto<size_t>(pCommunicator->getProperty("connnum", "1"));
+    if(_connNum < 1)
+    {
+        _connNum = 1;
+    }
+    if(_connNum > 64)
+    {
+        _connNum = 64;
+    }
+
     //异步队列的大小
     size_t iAsyncQueueCap = TC_Common::strto<size_t>(pCommunicator->getProperty("asyncqueuecap", "10000"));
     if(iAsyncQueueCap < 10000)
@@ -197,7 +238,7 @@ void CommunicatorEpoll::handleInputImp(Transceiver * pTransceiver)
         if (::getsockopt(pTransceiver->fd(), SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&iVal), &iLen) == -1 || iVal)
         {
             pTransceiver->close();
-            pTransceiver->getAdapterProxy()->addConnExc(true);
+            pTransceiver->getAdapterProxy()->addConnExc(pTransceiver, true);
             TLOGERROR("[TARS][CommunicatorEpoll::handleInputImp] connect error "
                     << pTransceiver->getAdapterProxy()->endpoint().desc()
                     << "," << pTransceiver->getAdapterProxy()->getObjProxy()->name()
@@ -215,7 +256,7 @@ void CommunicatorEpoll::handleInputImp(Transceiver * pTransceiver)
         list<ResponsePacket>::iterator it = done.begin();
         for (; it != done.end(); ++it)
         {
-            pTransceiver->getAdapterProxy()->finishInvoke(*it);
+            pTransceiver->getAdapterProxy()->finishInvoke(pTransceiver, *it);
         }
     }
 }
@@ -230,7 +271,7 @@ void CommunicatorEpoll::handleOutputImp(Transceiver * pTransceiver)
         if (::getsockopt(pTransceiver->fd(), SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&iVal), &iLen) == -1 || iVal)
         {
             pTransceiver->close();
-            pTransceiver->getAdapterProxy()->addConnExc(true);
+            pTransceiver->getAdapterProxy()->addConnExc(pTransceiver, true);
             TLOGERROR("[TARS][CommunicatorEpoll::handleOutputImp] connect error "
                     << pTransceiver->getAdapterProxy()->endpoint().desc()
                     << "," << pTransceiver->getAdapterProxy()->getObjProxy()->name()
@@ -371,6 +412,33 @@ void CommunicatorEpoll::handle(FDInfo * pFDInfo, uint32_t events)
     }
 }
 
+void CommunicatorEpoll::addPendingInvoke(AdapterProxy * adapterProxy)
+{
+    _pendingInvoke.push_back(adapterProxy);
+}
+
+void CommunicatorEpoll::doPendingInvoke()
+{
+    //发送过程中可能有新的节点加入
+    for(size_t i = 0; i < _pendingInvoke.size(); ++i)
+    {
+        try
+        {
+            _pendingInvoke[i]->doPendingInvoke();
+        }
+        catch(exception & e)
+        {
+            TLOGERROR("[TARS]CommunicatorEpoll::doPendingInvoke exp:"<<e.what()<<" ,line:"<<__LINE__<<endl);
+        }
+        catch(...)
+        {
+            TLOGERROR("[TARS]CommunicatorEpoll::doPendingInvoke|"<<__LINE__<<endl);
+        }
+    }
+
+    _pendingInvoke.clear();
+}
+
 void CommunicatorEpoll::doTimeout()
 {
     int64_t iNow = TNOWMS;
@@ -413,23 +481,7 @@ void CommunicatorEpoll::doStat()
         _reportAsyncQueue->report(n);
     }
 
-    StatReport::MapStatMicMsg mStatMicMsg;
-
-    for(size_t i = 0;i < _objectProxyFactory->getObjNum(); ++i)
-    {
-        const vector<AdapterProxy*> & vAdapterProxy = _objectProxyFactory->getObjectProxy(i)->getAdapters();
-        for(size_t iAdapter = 0;iAdapter < vAdapterProxy.size(); ++iAdapter)
-        {
-            vAdapterProxy[iAdapter]->doStat(mStatMicMsg);
-        }
-    }
-
-    //有数据才上报
-    if(mStatMicMsg.size() > 0)
-    {
-        StatReport::MapStatMicMsg* pmStatMicMsg = new StatReport::MapStatMicMsg(mStatMicMsg);
-        _communicator->getStatReport()->report(_netThreadSeq,pmStatMicMsg);
-    }
+    //模块间调用统计在AdapterProxy::stat中直接计入StatCounter, 由StatReport线程取走
 }
 
 void CommunicatorEpoll::pushAsyncThreadQueue(ReqMessage * msg)
@@ -479,6 +531,9 @@ void CommunicatorEpoll::run()
                 handle((FDInfo*)data, ev.events);
             }
 
+            //发送本轮积攒的请求
+            doPendingInvoke();
+
             //处理超时请求
             doTimeout();
 
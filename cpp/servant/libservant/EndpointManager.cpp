@@ -291,6 +291,10 @@ void QueryEpBase::setEndpoints(const string & sEndpoints, set<EndpointInfo> & se
         {
             _weightType = E_STATIC_WEIGHT;
         }
+        else if(iWeightType == 2)
+        {
+            _weightType = E_LATENCY;
+        }
         else
         {
             _weightType = E_LOOP;
@@ -502,6 +506,10 @@ void QueryEpBase::doEndpoints(const vector<tars::EndpointF>& activeEp, const vec
         {
             _weightType = E_STATIC_WEIGHT;
         }
+        else if(iWeightType == 2)
+        {
+            _weightType = E_LATENCY;
+        }
         else
         {
             _weightType = E_LOOP;
@@ -776,6 +784,11 @@ bool EndpointManager::selectAdapterProxy(ReqMessage * msg,AdapterProxy * & pAdap
 
         pAdapterProxy = getWeightedProxy(bStaticWeighted);
     }
+    else if(_weightType == E_LATENCY)
+    {
+        //按响应时间选择
+        pAdapterProxy = getLatencyProxy();
+    }
     else
     {
         //普通轮询模式
@@ -830,6 +843,50 @@ AdapterProxy * EndpointManager::getNextValidProxy()
     return NULL;
 }
 
+AdapterProxy * EndpointManager::getLatencyProxy()
+{
+    size_t iNum = _activeProxys.size();
+
+    if (iNum < 2)
+    {
+        return getNextValidProxy();
+    }
+
+    //随机取两个不同的结点
+    size_t i = (uint32_t)rand() % iNum;
+    size_t j = (uint32_t)rand() % (iNum - 1);
+    if (j >= i)
+    {
+        ++j;
+    }
+
+    AdapterProxy * first  = _activeProxys[i];
+    AdapterProxy * second = _activeProxys[j];
+
+    bool bFirst  = first->checkActive();
+    bool bSecond = second->checkActive();
+
+    if (bFirst && bSecond)
+    {
+        int64_t iNow = TNOWUS;
+
+        return (first->getLatencyLoad(iNow) <= second->getLatencyLoad(iNow)) ? first : second;
+    }
+
+    if (bFirst)
+    {
+        return first;
+    }
+
+    if (bSecond)
+    {
+        return second;
+    }
+
+    //两个都不可用, 按轮询的方式找
+    return getNextValidProxy();
+}
+
 AdapterProxy* EndpointManager::getHashProxy(int64_t hashCode, bool bConsistentHash)
 {
     if(_weightType == E_STATIC_WEIGHT)
@@ -16,30 +16,97 @@
 
 #include "servant/PropertyReport.h"
 #include "util/tc_common.h"
+#include <new>
+#include <stdlib.h>
 
 namespace tars
 {
 
+/**
+ * 计数只需要原子性, 不需要和其他内存操作保序
+ */
+#if defined(__ATOMIC_RELAXED)
+#define TARS_PROP_ADD(p, v)         __atomic_fetch_add(p, v, __ATOMIC_RELAXED)
+#define TARS_PROP_TAKE(p, v)        __atomic_exchange_n(p, v, __ATOMIC_RELAXED)
+#else
+#define TARS_PROP_ADD(p, v)         __sync_fetch_and_add(p, v)
+#define TARS_PROP_TAKE(p, v)        __sync_lock_test_and_set(p, v)
+#endif
+
+//max没有数据时的值, StatReport::reportPropMsg据此判断是否上报
+#define TARS_PROP_MAX_NONE          (-9999999)
+
+static volatile int     g_propSlotSeq = 0;
+static __thread int     t_propSlot    = -1;
+
+size_t PropertyReport::getSlot()
+{
+    if(t_propSlot < 0)
+    {
+        t_propSlot = __sync_fetch_and_add(&g_propSlotSeq, 1) % MAX_SLOT;
+    }
+
+    return t_propSlot;
+}
+
+void *PropertyReport::operator new(size_t size)
+{
+    void *p = NULL;
+
+    if(posix_memalign(&p, 64, size) != 0)
+    {
+        throw std::bad_alloc();
+    }
+
+    return p;
+}
+
+void PropertyReport::operator delete(void *p)
+{
+    free(p);
+}
+
+void PropertyReport::sum::set(int o)
+{
+    TARS_PROP_ADD(&_cell[getSlot()].d, o);
+}
+
 string PropertyReport::sum::get()
 {
-    string s = TC_Common::tostr(_d);
+    int d = 0;
+    for(size_t i = 0; i < (size_t)MAX_SLOT; ++i)
+    {
+        d += TARS_PROP_TAKE(&_cell[i].d, 0);
+    }
 
-    clear();
+    return TC_Common::tostr(d);
+}
 
-    return s;
+void PropertyReport::avg::set(int o)
+{
+    //和加在高32位(按32位回绕, 和原来int求和一致), 个数加在低32位
+    TARS_PROP_ADD(&_cell[getSlot()].v, ((uint64_t)(uint32_t)o << 32) + 1);
 }
 
 string PropertyReport::avg::get()
 {
-    if(_count == 0)
+    //和与个数一次取走, 不会把一条上报拆到两个周期
+    int sum   = 0;
+    int count = 0;
+    for(size_t i = 0; i < (size_t)MAX_SLOT; ++i)
     {
-        return "0";
+        uint64_t v = TARS_PROP_TAKE(&_cell[i].v, (uint64_t)0);
+
+        count += (int)(uint32_t)v;
+        sum   += (int)(uint32_t)(v >> 32);
     }
-    string s = TC_Common::tostr(static_cast<double>(_sum)/_count);
 
-    clear();
+    if(count == 0)
+    {
+        return "0";
+    }
 
-    return s;
+    return TC_Common::tostr(static_cast<double>(sum)/count);
 }
 
 PropertyReport::distr::distr(const vector<int>& range)
@@ -50,7 +117,18 @@ PropertyReport::distr::distr(const vector<int>& range)
 
     _range.erase(unique(_range.begin(), _range.end()),_range.end());
 
-    _result.resize(_range.size());
+    //每个槽占整数条cache line
+    size_t n = 64 / sizeof(size_t);
+
+    _stride = (_range.size() + n - 1) / n * n;
+
+    _result.resize(_stride * MAX_SLOT + n);
+}
+
+size_t *PropertyReport::distr::slots()
+{
+    //vector的内存不保证按cache line对齐, 策略对象按值拷贝后地址也会变, 每次按当前地址取整
+    return (size_t *)(((uintptr_t)&_result[0] + 63) & ~(uintptr_t)63);
 }
 
 void PropertyReport::distr::set(int o)
@@ -61,7 +139,7 @@ void PropertyReport::distr::set(int o)
     {
         size_t n = it - _range.begin();
 
-        ++_result[n];
+        TARS_PROP_ADD(&slots()[getSlot() * _stride + n], (size_t)1);
     }
 }
 
@@ -71,53 +149,99 @@ string PropertyReport::distr::get()
 
     for(unsigned i = 0; i < _range.size(); ++i)
     {
+        size_t result = 0;
+        for(size_t j = 0; j < (size_t)MAX_SLOT; ++j)
+        {
+            result += TARS_PROP_TAKE(&slots()[j * _stride + i], (size_t)0);
+        }
+
         if (i != 0)
         {
             s += ",";
         }
-        s = s + TC_Common::tostr(_range[i]) + "|" + TC_Common::tostr(_result[i]);
-    }
-    for(unsigned i = 0; i < _result.size(); ++i)
-    {
-        _result[i] = 0;
+        s = s + TC_Common::tostr(_range[i]) + "|" + TC_Common::tostr(result);
     }
     return s;
 }
 
-string PropertyReport::max::get()
+PropertyReport::max::max()
 {
-    string s = TC_Common::tostr(_d);
-
-    clear();
+    memset(_cell, 0, sizeof(_cell));
 
-    return s;
+    for(size_t i = 0; i < (size_t)MAX_SLOT; ++i)
+    {
+        _cell[i].d = TARS_PROP_MAX_NONE;
+    }
 }
 
-string PropertyReport::min::get()
+void PropertyReport::max::set(int o)
 {
-    string s = TC_Common::tostr(_d);
+    Cell& cell = _cell[getSlot()];
 
-    clear();
+    int old = cell.d;
+    while(o > old && !__sync_bool_compare_and_swap(&cell.d, old, o))
+    {
+        old = cell.d;
+    }
+}
 
-    return s;
+string PropertyReport::max::get()
+{
+    //取走后置0, 和原来的clear一致
+    int d = TARS_PROP_MAX_NONE;
+    for(size_t i = 0; i < (size_t)MAX_SLOT; ++i)
+    {
+        int v = TARS_PROP_TAKE(&_cell[i].d, 0);
+        if(v > d)
+        {
+            d = v;
+        }
+    }
+
+    return TC_Common::tostr(d);
 }
 
 void PropertyReport::min::set(int o)
 {
+    Cell& cell = _cell[getSlot()];
+
     //非0最小值
-    if(_d == 0 ||(_d > o && o != 0))
+    int old = cell.d;
+    while(o != 0 && (old == 0 || o < old) && !__sync_bool_compare_and_swap(&cell.d, old, o))
     {
-         _d = o;
+        old = cell.d;
     }
 }
 
-string PropertyReport::count::get()
+string PropertyReport::min::get()
 {
-    string s = TC_Common::tostr(_d);
+    int d = 0;
+    for(size_t i = 0; i < (size_t)MAX_SLOT; ++i)
+    {
+        int v = TARS_PROP_TAKE(&_cell[i].d, 0);
+        if(d == 0 || (v != 0 && v < d))
+        {
+            d = v;
+        }
+    }
 
-    clear();
+    return TC_Common::tostr(d);
+}
 
-    return s;
+void PropertyReport::count::set(int o)
+{
+    TARS_PROP_ADD(&_cell[getSlot()].d, 1);
+}
+
+string PropertyReport::count::get()
+{
+    int d = 0;
+    for(size_t i = 0; i < (size_t)MAX_SLOT; ++i)
+    {
+        d += TARS_PROP_TAKE(&_cell[i].d, 0);
+    }
+
+    return TC_Common::tostr(d);
 }
 ///////////////////////////////////////////////
 }
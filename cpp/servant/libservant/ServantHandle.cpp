@@ -60,6 +60,45 @@ ServantHandle::~ServantHandle()
         delete _coroSched;
         _coroSched = NULL;
     }
+
+    for(size_t i = 0; i < _freeArenas.size(); ++i)
+    {
+        delete _freeArenas[i];
+    }
+    _freeArenas.clear();
+}
+
+TC_Arena *ServantHandle::allocArena()
+{
+    {
+        TC_LockT<TC_ThreadMutex> lock(_arenaMutex);
+
+        if(!_freeArenas.empty())
+        {
+            TC_Arena *arena = _freeArenas.back();
+            _freeArenas.pop_back();
+            return arena;
+        }
+    }
+
+    return new TC_Arena();
+}
+
+void ServantHandle::releaseArena(TC_Arena *arena)
+{
+    arena->reset();
+
+    {
+        TC_LockT<TC_ThreadMutex> lock(_arenaMutex);
+
+        if(_freeArenas.size() < MAX_FREE_ARENA)
+        {
+            _freeArenas.push_back(arena);
+            return;
+        }
+    }
+
+    delete arena;
 }
 
 void ServantHandle::run()
@@ -108,10 +147,25 @@ void ServantHandle::run()
 void ServantHandle::handleRequest()
 {
     bool bYield = false;
+
+    const bool bLocalQueue = (_handleGroup->schedule != TC_EpollServer::HANDLE_SCHED_QUEUE);
+
     while (!getEpollServer()->isTerminate())
     {
         bool bServerReqEmpty = false;
 
+        if (bLocalQueue)
+        {
+            if(_coroSched->getResponseCoroSize() > 0)
+            {
+                bServerReqEmpty = (allAdapterIsEmpty() && allFilterIsEmpty());
+            }
+            else
+            {
+                waitForRecvData(3000);
+            }
+        }
+        else
         {
             TC_ThreadLock::Lock lock(_handleGroup->monitor);
 
@@ -161,7 +215,7 @@ void ServantHandle::handleRequest()
                 {
                     --iLoop;
 
-                    if(adapter->waitForRecvQueue(recv, 0))
+                    if(bLocalQueue ? popRecvData(recv) : adapter->waitForRecvQueue(recv, 0))
                     {
                         bYield = true;
 
@@ -175,7 +229,10 @@ void ServantHandle::handleRequest()
 
                         int64_t now = TNOWMS;
 
-                        stRecvData.adapter = adapter;
+                        if (!bLocalQueue)
+                        {
+                            stRecvData.adapter = adapter;
+                        }
 
                         //数据已超载 overload
                         if (stRecvData.isOverload)
@@ -192,7 +249,7 @@ void ServantHandle::handleRequest()
                             recv = NULL;
                         }
                         //数据在队列中已经超时了
-                        else if ( (now - stRecvData.recvTimeStamp) > (int64_t)adapter->getQueueTimeout())
+                        else if ( (now - stRecvData.recvTimeStamp) > (int64_t)stRecvData.adapter->getQueueTimeout())
                         {
                             handleTimeout(stRecvData);
                             delete recv;
@@ -242,6 +299,12 @@ void ServantHandle::handleRequest()
 
                 getEpollServer()->error("[Handle::handleImp] unknown error");
             }
+
+            //非共用队列模式下请求都在handle自己的队列中, 不用按adapter取
+            if (bLocalQueue)
+            {
+                break;
+            }
         }
 
         if(!bYield)
@@ -643,17 +706,23 @@ void ServantHandle::processSample(const TarsCurrentPtr &current)
         if(iter != requestStatus.end())
         {
             //statu 里面的内容为 "id|depth|width"形式.合在一起以便节省编解码
-            vector<string> v = TC_Common::sepstr<string>(iter->second,"|");
+            //每个采样请求都要解析, 不分配临时的vector<string>
+            TC_StringView v[3];
 
-            if(v.size() > 2)
+            if(TC_Common::sepstr(iter->second, "|", v, 3) > 2)
             {
-                sptd->_sampleKey._unid      = v[0];
+                sptd->_sampleKey._unid      = v[0].str();
+
+                int depth = 0;
+                TC_Common::strto(v[1], depth);
 
                 //深度+1
-                sptd->_sampleKey._depth     = TC_Common::strto<int>(v[1])+1;
+                sptd->_sampleKey._depth     = depth + 1;
 
-                sptd->_sampleKey._parentWidth = TC_Common::strto<int>(v[2]);
+                int width = 0;
+                TC_Common::strto(v[2], width);
 
+                sptd->_sampleKey._parentWidth = width;
             }
         }
     }
@@ -670,12 +739,13 @@ bool ServantHandle::processDye(const TarsCurrentPtr &current, string& dyeingKey)
     }
 
     //当前请求已经被染色, 需要打印染色日志
-    map<string, string>::const_iterator dyeingIt = current->getRequestStatus().find(ServantProxy::STATUS_DYED_KEY);
-
     if (IS_MSG_TYPE(current->getMessageType(), tars::TARSMESSAGETYPEDYED))
     {
         TLOGINFO("[TARS] servant got a dyeing request, message_type set" << current->getMessageType() << endl);
 
+        //status按需解码, 只有染色请求才查
+        map<string, string>::const_iterator dyeingIt = current->getRequestStatus().find(ServantProxy::STATUS_DYED_KEY);
+
         if (dyeingIt != current->getRequestStatus().end())
         {
             TLOGINFO("[TARS] servant got a dyeing request, dyeing key:" << dyeingIt->second << endl);
@@ -238,6 +238,8 @@ string ServantProxy::STATUS_SETNAME_VALUE = "STATUS_SETNAME_VALUE";
 
 string ServantProxy::TARS_MASTER_KEY       = "TARS_MASTER_KEY";
 
+string ServantProxy::STATUS_PACKED_KEY     = "STATUS_PACKED_KEY";
+
 
 ServantProxy::ServantProxy(Communicator * pCommunicator, ObjectProxy ** ppObjectProxy, size_t iClientThreadNum)
 : _communicator(pCommunicator)
@@ -248,6 +250,7 @@ ServantProxy::ServantProxy(Communicator * pCommunicator, ObjectProxy ** ppObject
 , _id(0)
 , _endpointInfo(NULL)
 , _masterFlag(false)
+, _packed(false)
 , _queueSize(1000)
 , _minTimeout(100)
 {
@@ -540,7 +543,8 @@ void ServantProxy::invoke(ReqMessage * msg, bool bCoroAsync)
     selectNetThreadInfo(pSptd,pObjProxy,pReqQ);
 
     //调用发起时间
-    msg->iBeginTime   = TNOWMS;
+    msg->iBeginUs     = TNOWUS;
+    msg->iBeginTime   = msg->iBeginUs / 1000;
     msg->pObjectProxy = pObjProxy;
 
     //如果是按set规则调用
@@ -604,6 +608,12 @@ void ServantProxy::invoke(ReqMessage * msg, bool bCoroAsync)
         }
     }
 
+    //tars协议的请求在调用线程中编码好, 网络线程只回填requestid
+    if(!msg->bFromRpc && !pObjProxy->hasSetProtocol() && pObjProxy->getCommunicatorEpoll()->isCallerEncode())
+    {
+        msg->iReqIdPos = ProxyProtocol::tarsRequestPrepare(msg->request, msg->sReqData);
+    }
+
     //通知网络线程
     bool bEmpty = false;
     bool bSync  = (msg->eType == ReqMessage::SYNC_CALL);
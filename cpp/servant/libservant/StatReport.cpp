@@ -20,12 +20,302 @@
 #include "servant/TarsLogger.h"
 #include "servant/Communicator.h"
 #include <iostream>
+#include <new>
+#include <stdlib.h>
 
 namespace tars
 {
+
+/**
+ * 统计计数只需要原子性, 不需要和其他内存操作保序
+ */
+#if defined(__ATOMIC_RELAXED)
+#define TARS_STAT_ADD(p, v)     __atomic_fetch_add(p, v, __ATOMIC_RELAXED)
+#define TARS_STAT_TAKE(p)       __atomic_exchange_n(p, 0, __ATOMIC_RELAXED)
+#else
+#define TARS_STAT_ADD(p, v)     __sync_fetch_and_add(p, v)
+#define TARS_STAT_TAKE(p)       __sync_lock_test_and_set(p, 0)
+#endif
+
+static volatile int     g_statSlotSeq = 0;
+static __thread int     t_statSlot    = -1;
+
+StatCounter::StatCounter(const StatMicMsgHead& head, bool bFromClient, const vector<int>& timePoint, bool bHist)
+: _head(head)
+, _fromClient(bFromClient)
+, _hist(bHist)
+, _timePointNum(0)
+{
+    memset(_timePoint, 0, sizeof(_timePoint));
+    memset(_slot, 0, sizeof(_slot));
+
+    for(size_t i = 0; i < timePoint.size() && i < (size_t)MAX_INTERV; ++i)
+    {
+        _timePoint[_timePointNum++] = timePoint[i];
+    }
+}
+
+StatCounter::~StatCounter()
+{
+    for(size_t i = 0; i < (size_t)MAX_SLOT; ++i)
+    {
+        delete[] _slot[i].histCount;
+    }
+}
+
+void *StatCounter::operator new(size_t size)
+{
+    void *p = NULL;
+    if(posix_memalign(&p, 64, size) != 0)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void StatCounter::operator delete(void *p)
+{
+    free(p);
+}
+
+void StatCounter::report(int eResult, int iSptime, int64_t iSptimeUs)
+{
+    if(t_statSlot < 0)
+    {
+        t_statSlot = __sync_fetch_and_add(&g_statSlotSeq, 1) % MAX_SLOT;
+    }
+
+    Slot& slot = _slot[t_statSlot];
+
+    //失败的调用耗时按0计入分布, 和原来的统计保持一致
+    int time = 0;
+
+    if(eResult == StatReport::STAT_SUCC)
+    {
+        time = iSptime;
+
+        TARS_STAT_ADD(&slot.count, 1);
+        TARS_STAT_ADD(&slot.totalRspTime, (int64_t)iSptime);
+
+        int old = slot.maxRspTime;
+        while(iSptime > old && !__sync_bool_compare_and_swap(&slot.maxRspTime, old, iSptime))
+        {
+            old = slot.maxRspTime;
+        }
+
+        //非0最小值
+        old = slot.minRspTime;
+        while(iSptime != 0 && (old == 0 || iSptime < old) && !__sync_bool_compare_and_swap(&slot.minRspTime, old, iSptime))
+        {
+            old = slot.minRspTime;
+        }
+
+        if(_hist)
+        {
+            int *histCount = slot.histCount;
+            if(histCount == NULL)
+            {
+                //同一个槽可能有多个线程, 只有一个能装上
+                histCount = new int[HIST_BUCKETS];
+                memset(histCount, 0, sizeof(int) * HIST_BUCKETS);
+
+                if(!__sync_bool_compare_and_swap(&slot.histCount, (int*)NULL, histCount))
+                {
+                    delete[] histCount;
+                    histCount = slot.histCount;
+                }
+            }
+
+            TARS_STAT_ADD(&histCount[getHistIndex(iSptimeUs >= 0 ? iSptimeUs : (int64_t)iSptime * 1000)], 1);
+        }
+    }
+    else if(eResult == StatReport::STAT_TIMEOUT)
+    {
+        TARS_STAT_ADD(&slot.timeoutCount, 1);
+    }
+    else
+    {
+        TARS_STAT_ADD(&slot.execCount, 1);
+    }
+
+    for(size_t i = 0; i < _timePointNum; ++i)
+    {
+        if(time < _timePoint[i])
+        {
+            TARS_STAT_ADD(&slot.intervalCount[i], 1);
+            break;
+        }
+    }
+}
+
+bool StatCounter::get(StatMicMsgBody& body)
+{
+    body = StatMicMsgBody();
+
+    int intervalCount[MAX_INTERV] = {0};
+
+    vector<int> histCount;
+
+    for(size_t i = 0; i < (size_t)MAX_SLOT; ++i)
+    {
+        Slot& slot = _slot[i];
+
+        body.count          += TARS_STAT_TAKE(&slot.count);
+        body.timeoutCount   += TARS_STAT_TAKE(&slot.timeoutCount);
+        body.execCount      += TARS_STAT_TAKE(&slot.execCount);
+        body.totalRspTime   += TARS_STAT_TAKE(&slot.totalRspTime);
+
+        int maxRspTime = TARS_STAT_TAKE(&slot.maxRspTime);
+        if(body.maxRspTime < maxRspTime)
+        {
+            body.maxRspTime = maxRspTime;
+        }
+
+        int minRspTime = TARS_STAT_TAKE(&slot.minRspTime);
+        if(body.minRspTime == 0 || (minRspTime != 0 && minRspTime < body.minRspTime))
+        {
+            body.minRspTime = minRspTime;
+        }
+
+        for(size_t j = 0; j < _timePointNum; ++j)
+        {
+            intervalCount[j] += TARS_STAT_TAKE(&slot.intervalCount[j]);
+        }
+
+        //分配后不会释放, 直接读指针即可
+        if(slot.histCount != NULL)
+        {
+            histCount.resize(HIST_BUCKETS);
+
+            for(size_t j = 0; j < (size_t)HIST_BUCKETS; ++j)
+            {
+                if(slot.histCount[j] != 0)
+                {
+                    histCount[j] += TARS_STAT_TAKE(&slot.histCount[j]);
+                }
+            }
+        }
+    }
+
+    if(body.count == 0 && body.timeoutCount == 0 && body.execCount == 0)
+    {
+        return false;
+    }
+
+    for(size_t j = 0; j < _timePointNum; ++j)
+    {
+        body.intervalCount[_timePoint[j]] = intervalCount[j];
+    }
+
+    for(size_t j = 0; j < histCount.size(); ++j)
+    {
+        if(histCount[j] != 0)
+        {
+            body.histCount.insert(make_pair((int)j, histCount[j]));
+        }
+    }
+
+    return true;
+}
+
+int64_t StatCounter::getPercentile(const int64_t *histCount, double fPercent)
+{
+    int64_t total = 0;
+    for(size_t i = 0; i < (size_t)HIST_BUCKETS; ++i)
+    {
+        total += histCount[i];
+    }
+
+    if(total == 0)
+    {
+        return 0;
+    }
+
+    //第rank个调用所在的桶, 取桶的上界
+    int64_t rank = (int64_t)(fPercent * total + 0.5);
+    if(rank < 1)
+    {
+        rank = 1;
+    }
+
+    int64_t count = 0;
+    for(size_t i = 0; i < (size_t)HIST_BUCKETS; ++i)
+    {
+        count += histCount[i];
+        if(count >= rank)
+        {
+            return getHistValue(i);
+        }
+    }
+
+    return getHistValue(HIST_BUCKETS - 1);
+}
+
+/**
+ * report(string...)的线程缓存, 每个上报周期清空一次, 不再使用的统计项才能被删掉
+ */
+struct StatCounterCache
+{
+    StatCounterCache() : epoch(0) {}
+
+    map<string, StatCounterPtr> counters;
+    size_t                      epoch;
+    string                      key;
+};
+
+static const size_t         MAX_STAT_CACHE   = 10000;
+static volatile size_t      g_statEpoch      = 0;
+static __thread StatCounterCache * t_statCache = NULL;
+
+static pthread_once_t       g_statCacheOnce  = PTHREAD_ONCE_INIT;
+static pthread_key_t        g_statCacheKey;
+
+static void statCacheExit(void *p)
+{
+    delete (StatCounterCache*)p;
+}
+
+static void statCacheKeyInit()
+{
+    pthread_key_create(&g_statCacheKey, statCacheExit);
+}
+
+static StatCounterCache* getStatCache()
+{
+    if(t_statCache == NULL)
+    {
+        pthread_once(&g_statCacheOnce, statCacheKeyInit);
+
+        t_statCache = new StatCounterCache();
+
+        pthread_setspecific(g_statCacheKey, t_statCache);
+    }
+
+    if(t_statCache->epoch != g_statEpoch || t_statCache->counters.size() > MAX_STAT_CACHE)
+    {
+        t_statCache->counters.clear();
+        t_statCache->epoch = g_statEpoch;
+    }
+
+    return t_statCache;
+}
+
+static inline void appendKey(string& key, const string& s)
+{
+    key.append(s);
+    key.push_back('\0');
+}
+
+static inline void appendKey(string& key, int64_t v)
+{
+    char buf[32];
+    key.append(buf, TC_Common::tochars(buf, v) - buf);
+    key.push_back('\0');
+}
+
 //////////////////////////////////////////////////////////////////
 //
-StatReport::StatReport(size_t iEpollNum)
+StatReport::StatReport()
 : _time(0)
 , _reportInterval(60000)
 , _reportTimeout(5000)
@@ -33,13 +323,11 @@ StatReport::StatReport(size_t iEpollNum)
 , _terminate(false)
 , _sampleRate(1)
 , _maxSampleCount(500)
-, _epollNum(iEpollNum)
+, _hist(false)
 , _retValueNumLimit(10)
 {
-    for(size_t i = 0 ; i < _epollNum; i++)
-    {
-        _statMsg.push_back(new stat_queue(MAX_STAT_QUEUE_SIZE));
-    }
+    static volatile size_t s_id = 0;
+    _id = __sync_add_and_fetch(&s_id, 1);
 }
 
 StatReport::~StatReport()
@@ -61,19 +349,6 @@ void StatReport::terminate()
     notifyAll();
 }
 
-void StatReport::report(size_t iSeq,MapStatMicMsg * pmStatMicMsg)
-{
-    assert(iSeq < _epollNum);
-    bool bFlag = _statMsg[iSeq]->push_back(pmStatMicMsg);
-    if(!bFlag)
-    {
-        delete pmStatMicMsg;
-        pmStatMicMsg = NULL;
-
-        TLOGERROR("[TARS][StatReport::report] queue full." << endl);
-    }
-}
-
 void StatReport::setReportInfo(const StatFPrx& statPrx,
                        const PropertyFPrx& propertyPrx,
                        const string& strModuleName,
@@ -195,15 +470,10 @@ void  StatReport::resetStatInterv()
 
 string StatReport::trimAndLimitStr(const string& str, uint32_t limitlen)
 {
-    static const string strTime = "\r\t";
+    //每次上报都会调用, 先截取再拷贝
+    TC_StringView ret = TC_Common::trimView(str, "\r\t");
 
-    string ret = TC_Common::trim(str, strTime);
-
-    if (ret.length() > limitlen)
-    {
-        ret.resize(limitlen);
-    }
-    return ret;
+    return string(ret.data(), ret.length() > limitlen ? limitlen : ret.length());
 }
 
 bool StatReport::divison2SetInfo(const string& str, vector<string>& vtSetInfo)
@@ -231,24 +501,37 @@ string StatReport::getServerName(string sModuleName)
     return  sModuleName;
 }
 
-void StatReport::report(const string& strModuleName,
+StatCounter* StatReport::getCachedCounter(const string& strModuleName,
                       const string& setdivision,
                       const string& strInterfaceName,
                       const string& strModuleIp,
                       uint16_t iPort,
-                      StatResult eResult,
-                      int iSptime,
                       int iReturnValue,
                       bool bFromClient)
 {
+    StatCounterCache *cache = getStatCache();
+
+    string& key = cache->key;
+    key.clear();
+    appendKey(key, (int64_t)_id);
+    appendKey(key, bFromClient ? 1 : 0);
+    appendKey(key, strModuleName);
+    appendKey(key, setdivision);
+    appendKey(key, strInterfaceName);
+    appendKey(key, strModuleIp);
+    appendKey(key, iPort);
+    appendKey(key, iReturnValue);
+
+    map<string, StatCounterPtr>::iterator itCache = cache->counters.find(key);
+    if(itCache != cache->counters.end())
+    {
+        return itCache->second.get();
+    }
+
     //包头信息,trim&substr 防止超长导致udp包发送失败
     //masterIp为空服务端自己获取。
 
     StatMicMsgHead head;
-    StatMicMsgBody body;
-    string sMaterServerName = "";
-    string sSlaveServerName = "";
-    string appName = "";// 由setdivision生成
 
     if(bFromClient)
     {
@@ -309,40 +592,61 @@ void StatReport::report(const string& strModuleName,
     head.interfaceName  = trimAndLimitStr(strInterfaceName, MAX_MASTER_NAME_LEN);
     head.slavePort      = iPort;
     head.returnValue    = iReturnValue;
-    
-    //包体信息.
-    if(eResult == STAT_SUCC)
-    {
-        body.count = 1;
 
-        body.totalRspTime = body.minRspTime = body.maxRspTime = iSptime;
-    }
-    else if(eResult == STAT_TIMEOUT)
-    {
-        body.timeoutCount = 1;
-    }
-    else
-    {
-        body.execCount = 1;
-    }
-    submit(head, body, bFromClient);
+    StatCounterPtr counter = getStatCounter(head, bFromClient);
+
+    cache->counters[key] = counter;
+
+    return counter.get();
 }
 
-void StatReport::report(const string& strMasterName,
+void StatReport::report(const string& strModuleName,
+                      const string& setdivision,
+                      const string& strInterfaceName,
+                      const string& strModuleIp,
+                      uint16_t iPort,
+                      StatResult eResult,
+                      int iSptime,
+                      int iReturnValue,
+                      bool bFromClient,
+                      int64_t iSptimeUs)
+{
+    //上报头按调用信息缓存在线程里, 这里只更新计数
+    getCachedCounter(strModuleName, setdivision, strInterfaceName, strModuleIp, iPort, iReturnValue, bFromClient)->report(eResult, iSptime, iSptimeUs);
+}
+
+StatCounter* StatReport::getCachedCounter(const string& strMasterName,
                         const string& strMasterIp,
                         const string& strSlaveName,
                         const string& strSlaveIp,
                         uint16_t iSlavePort,
                         const string& strInterfaceName,
-                        StatResult eResult,
-                        int  iSptime,
                         int  iReturnValue)
 {
+    StatCounterCache *cache = getStatCache();
+
+    string& key = cache->key;
+    key.clear();
+    appendKey(key, (int64_t)_id);
+    appendKey(key, 2);
+    appendKey(key, strMasterName);
+    appendKey(key, strMasterIp);
+    appendKey(key, strSlaveName);
+    appendKey(key, strSlaveIp);
+    appendKey(key, iSlavePort);
+    appendKey(key, strInterfaceName);
+    appendKey(key, iReturnValue);
+
+    map<string, StatCounterPtr>::iterator itCache = cache->counters.find(key);
+    if(itCache != cache->counters.end())
+    {
+        return itCache->second.get();
+    }
+
     //包头信息,trim&substr 防止超长导致udp包发送失败
     //masterIp为空服务端自己获取。
 
     StatMicMsgHead head;
-    StatMicMsgBody body;
 
     head.masterName     = trimAndLimitStr(strMasterName + "@" + ClientConfig::TarsVersion, MAX_MASTER_NAME_LEN);
     head.masterIp       = trimAndLimitStr(strMasterIp,      MAX_MASTER_IP_LEN);
@@ -352,23 +656,112 @@ void StatReport::report(const string& strMasterName,
     head.slavePort      = iSlavePort;
     head.returnValue    = iReturnValue;
 
-    //包体信息.
-    if(eResult == STAT_SUCC)
+    StatCounterPtr counter = getStatCounter(head, true);
+
+    cache->counters[key] = counter;
+
+    return counter.get();
+}
+
+void StatReport::report(const string& strMasterName,
+                        const string& strMasterIp,
+                        const string& strSlaveName,
+                        const string& strSlaveIp,
+                        uint16_t iSlavePort,
+                        const string& strInterfaceName,
+                        StatResult eResult,
+                        int  iSptime,
+                        int  iReturnValue,
+                        int64_t iSptimeUs)
+{
+    getCachedCounter(strMasterName, strMasterIp, strSlaveName, strSlaveIp, iSlavePort, strInterfaceName, iReturnValue)->report(eResult, iSptime, iSptimeUs);
+}
+
+StatCounterPtr StatReport::getStatCounter(const StatMicMsgHead& head, bool bFromClient)
+{
+    Lock lock(*this);
+
+    map<StatMicMsgHead, StatCounterPtr>& counters = bFromClient ? _statCounterClient : _statCounterServer;
+
+    map<StatMicMsgHead, StatCounterPtr>::iterator it = counters.find(head);
+    if(it != counters.end())
+    {
+        return it->second;
+    }
+
+    StatCounterPtr counter = new StatCounter(head, bFromClient, _timePoint, _hist);
+
+    counters[head] = counter;
+
+    return counter;
+}
+
+void StatReport::collectStatCounter()
+{
+    Lock lock(*this);
+
+    for(int i = 0; i < 2; ++i)
     {
-        body.count = 1;
+        map<StatMicMsgHead, StatCounterPtr>& counters = (i == 0) ? _statCounterClient : _statCounterServer;
+        MapStatMicMsg& msg = (i == 0) ? _statMicMsgClient : _statMicMsgServer;
 
-        body.totalRspTime = body.minRspTime = body.maxRspTime = iSptime;
+        map<StatMicMsgHead, StatCounterPtr>::iterator it = counters.begin();
+        while(it != counters.end())
+        {
+            StatMicMsgBody body;
+            if(it->second->get(body))
+            {
+                MapStatMicMsg::iterator itMsg = msg.find(it->first);
+                if(itMsg != msg.end())
+                {
+                    mergeBody(body, itMsg->second);
+                }
+                else
+                {
+                    msg[it->first] = body;
+                }
+                ++it;
+            }
+            else if(it->second->getRef() == 1)
+            {
+                //没有数据, 也没有调用方缓存
+                counters.erase(it++);
+            }
+            else
+            {
+                ++it;
+            }
+        }
     }
-    else if(eResult == STAT_TIMEOUT)
+}
+
+void StatReport::mergeBody(const StatMicMsgBody& inBody, StatMicMsgBody& outBody)
+{
+    outBody.count           += inBody.count;
+    outBody.timeoutCount    += inBody.timeoutCount;
+    outBody.execCount       += inBody.execCount;
+    outBody.totalRspTime    += inBody.totalRspTime;
+
+    if ( outBody.maxRspTime < inBody.maxRspTime )
     {
-        body.timeoutCount = 1;
+        outBody.maxRspTime = inBody.maxRspTime;
     }
-    else
+
+    //非0最小值
+    if ( outBody.minRspTime == 0 ||(outBody.minRspTime > inBody.minRspTime && inBody.minRspTime != 0))
     {
-        body.execCount = 1;
+        outBody.minRspTime = inBody.minRspTime;
     }
 
-    submit(head, body, true);
+    for(map<int, int>::const_iterator it = inBody.intervalCount.begin(); it != inBody.intervalCount.end(); ++it)
+    {
+        outBody.intervalCount[it->first] += it->second;
+    }
+
+    for(map<int, int>::const_iterator it = inBody.histCount.begin(); it != inBody.histCount.end(); ++it)
+    {
+        outBody.histCount[it->first] += it->second;
+    }
 }
 
 string StatReport::sampleUnid()
@@ -386,37 +779,6 @@ string StatReport::sampleUnid()
     return TC_Common::bin2str(string(s,14));
 }
 
-void StatReport::submit( StatMicMsgHead& head, StatMicMsgBody& body,bool bFromClient )
-{
-    Lock lock(*this);
-
-    MapStatMicMsg& msg = (bFromClient == true)?_statMicMsgClient:_statMicMsgServer;
-    MapStatMicMsg::iterator it = msg.find( head );
-    if ( it != msg.end() )
-    {
-        StatMicMsgBody& stBody      = it->second;
-        stBody.count                += body.count;
-        stBody.timeoutCount         += body.timeoutCount;
-        stBody.execCount            += body.execCount;
-        stBody.totalRspTime         += body.totalRspTime;
-        if ( stBody.maxRspTime < body.maxRspTime )
-        {
-            stBody.maxRspTime = body.maxRspTime;
-        }
-        //非0最小值
-        if ( stBody.minRspTime == 0 ||(stBody.minRspTime > body.minRspTime && body.minRspTime != 0))
-        {
-            stBody.minRspTime = body.minRspTime;
-        }
-        getIntervCount(body.maxRspTime, stBody);
-    }
-    else
-    {
-        getIntervCount(body.maxRspTime, body);
-        msg[head] = body;
-    }
-}
-
 void StatReport::doSample(const string& strSlaveName,
                       const string& strInterfaceName,
                       const string& strSlaveIp,
@@ -446,6 +808,14 @@ int StatReport::reportMicMsg(MapStatMicMsg& msg,bool bFromClient)
            const StatMicMsgHead &head = it->first;
            int iTemLen = STAT_PROTOCOL_LEN +head.masterName.length() + head.slaveName.length() + head.interfaceName.length()
                + head.slaveSetName.length() + head.slaveSetArea.length() + head.slaveSetID.length();
+
+           //高精度分布的桶数不固定, 按实际编码长度算
+           if(!it->second.histCount.empty())
+           {
+               TarsOutputStream<BufferWriter> os;
+               os.write(it->second.histCount, 7);
+               iTemLen += os.getLength();
+           }
            iLen = iLen + iTemLen;
            if(iLen > _maxReportSize) //不能超过udp 1472
            {
@@ -694,54 +1064,6 @@ int StatReport::reportSampleMsg()
     return -1;
 }
 
-void StatReport::addMicMsg(MapStatMicMsg & old,MapStatMicMsg & add)
-{
-    MapStatMicMsg::iterator iter;
-    MapStatMicMsg::iterator iterOld;
-    iter = add.begin();
-    for(;iter != add.end();++iter)
-    {
-        iterOld = old.find(iter->first);
-        if(iterOld == old.end())
-        {
-            //直接insert
-            old.insert(make_pair(iter->first,iter->second));
-        }
-        else
-        {
-            //合并
-            iterOld->second.count += iter->second.count;
-            iterOld->second.timeoutCount += iter->second.timeoutCount;
-            iterOld->second.execCount += iter->second.execCount;
-
-            map<int,int>::iterator iterOldInt,iterInt;
-            map<int,int> & mCount = iter->second.intervalCount;
-            map<int,int> & mCountOld = iterOld->second.intervalCount;
-            iterInt = mCount.begin();
-            for(;iterInt != mCount.end();++iterInt)
-            {
-                iterOldInt = mCountOld.find(iterInt->first);
-                if(iterOldInt == mCountOld.end())
-                {
-                    mCountOld.insert(make_pair(iterInt->first,iterInt->second));
-                }
-                else
-                {
-                    iterOldInt->second += iterInt->second;
-                }
-            }
-
-            iterOld->second.totalRspTime += iter->second.totalRspTime;
-
-            if(iterOld->second.maxRspTime < iter->second.maxRspTime)
-                iterOld->second.maxRspTime = iter->second.maxRspTime;
-
-            if(iterOld->second.minRspTime > iter->second.minRspTime)
-                iterOld->second.minRspTime = iter->second.minRspTime;
-        }
-    }
-}
-
 void StatReport::run()
 {
     while(!_terminate)
@@ -752,37 +1074,14 @@ void StatReport::run()
 
             if(tNow - _time > _reportInterval/1000)
             {
-                reportMicMsg(_statMicMsgClient, true);
-
-                reportMicMsg(_statMicMsgServer, false);
+                collectStatCounter();
 
-                MapStatMicMsg mStatMsg;
+                //各线程缓存的统计项在下次调用时清空
+                __sync_fetch_and_add(&g_statEpoch, 1);
 
-                for(size_t i = 0; i < _epollNum; ++i)
-                {
-                    MapStatMicMsg * pStatMsg;
-                    while(_statMsg[i]->pop_front(pStatMsg))
-                    {
-                        addMicMsg(mStatMsg,*pStatMsg);
-                        delete pStatMsg;
-                    }
-                }
-#if 0
-
-                ostringstream os;
-                MapStatMicMsg::iterator iter;
-                iter = mStatMsg.begin();
-                for(;iter != mStatMsg.end();++iter)
-                {
-                    iter->first.display(os);
-                    os<<endl;
-                    iter->second.display(os);
-                    os<<endl<<endl;
-                }
+                reportMicMsg(_statMicMsgClient, true);
 
-                TLOGDEBUG("StatReport::run() msg:"<<os.str()<<endl);
-#endif
-                reportMicMsg(mStatMsg, true);
+                reportMicMsg(_statMicMsgServer, false);
 
                 reportPropMsg();
 
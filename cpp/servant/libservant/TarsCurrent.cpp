@@ -31,8 +31,14 @@ TarsCurrent::TarsCurrent(ServantHandle *pServantHandle)
 , _ip("NULL")
 , _port(0)
 , _fd(-1)
+, _requestData(NULL)
+, _requestLen(0)
+, _lazyPos(0)
+, _bufferCopied(true)
+, _arena(NULL)
 , _response(true)
 , _begintime(0)
+, _beginUs(0)
 , _ret(0)
 , _reportStat(true)
 , _closeType(-1)
@@ -58,6 +64,11 @@ TarsCurrent::~TarsCurrent()
             reportToStat("not_tars_client");
         }
     }
+
+    if (_arena)
+    {
+        _servantHandle->releaseArena(_arena);
+    }
 }
 
 string TarsCurrent::getIp() const
@@ -87,15 +98,26 @@ short TarsCurrent::getRequestVersion() const
 
 map<string, string>& TarsCurrent::getContext()
 {
+    decodeLazy();
+
     return _request.context;
 }
 
 const map<string, string>& TarsCurrent::getRequestStatus() const
 {
+    decodeLazy();
+
     return _request.status;
 }
 
-string TarsCurrent::getFuncName() const
+bool TarsCurrent::isPackedAccepted() const
+{
+    const map<string, string> &status = getRequestStatus();
+
+    return status.find(ServantProxy::STATUS_PACKED_KEY) != status.end();
+}
+
+const string &TarsCurrent::getFuncName() const
 {
     return _request.sFuncName;
 }
@@ -131,14 +153,58 @@ void TarsCurrent::setReportStat(bool bReport)
 
 const vector<char>& TarsCurrent::getRequestBuffer() const
 {
+    //兼容接口, 第一次访问时才拷贝
+    if (!_bufferCopied)
+    {
+        TC_LockT<TC_ThreadMutex> lock(_lazyMutex);
+
+        if (!_bufferCopied)
+        {
+            _request.sBuffer.assign(_requestData, _requestData + _requestLen);
+
+            __sync_synchronize();
+
+            _bufferCopied = true;
+        }
+    }
     return _request.sBuffer;
 }
 
+const char *TarsCurrent::getRequestData() const
+{
+    return _requestData;
+}
+
+size_t TarsCurrent::getRequestLength() const
+{
+    return _requestLen;
+}
+
+TC_Arena *TarsCurrent::getArena()
+{
+    if (_arena == NULL && _servantHandle != NULL)
+    {
+        _arena = _servantHandle->allocArena();
+    }
+    return _arena;
+}
+
 bool TarsCurrent::isResponse() const
 {
     return _response;
 }
 
+void TarsCurrent::setResponse(bool value)
+{
+    _response = value;
+
+    //异步回包, current会交给其他线程, 在这里(业务线程)把按需的数据都准备好
+    if (!value)
+    {
+        releaseRecvSlice();
+    }
+}
+
 void TarsCurrent::setCloseType(int type)
 {
     _closeType = type;
@@ -171,19 +237,27 @@ void TarsCurrent::initialize(const TC_EpollServer::tagRecvData &stRecvData, int6
 
     _begintime   = beginTime;
 
+    _beginUs     = (beginTime == stRecvData.recvTimeStamp) ? stRecvData.recvTimeUs : beginTime * 1000;
+
     _request.sServantName = ServantHelperManager::getInstance()->getAdapterServant(stRecvData.adapter->getName());
 
     if (_bindAdapter->isTarsProtocol())
     {
-        initialize(stRecvData.buffer);
+        if (!stRecvData.slice.empty())
+        {
+            initialize(stRecvData.slice);
+        }
+        else
+        {
+            initialize(stRecvData.data(), stRecvData.length());
+        }
     }
     else
     {
-        _request.sBuffer.reserve(stRecvData.buffer.length());
+        _request.sBuffer.assign(stRecvData.data(), stRecvData.data() + stRecvData.length());
 
-        _request.sBuffer.resize(stRecvData.buffer.length());
-
-        ::memcpy(&_request.sBuffer[0], stRecvData.buffer.c_str(), stRecvData.buffer.length());
+        _requestData = _request.sBuffer.empty() ? NULL : &_request.sBuffer[0];
+        _requestLen  = _request.sBuffer.size();
     }
 }
 
@@ -201,16 +275,132 @@ void TarsCurrent::initializeClose(const TC_EpollServer::tagRecvData &stRecvData)
 
     _request.sServantName = ServantHelperManager::getInstance()->getAdapterServant(stRecvData.adapter->getName());
 
-    _begintime = TNOWMS;
+    _beginUs   = TNOWUS;
+
+    _begintime = _beginUs / 1000;
 }
 
 void TarsCurrent::initialize(const string &sRecvBuffer)
+{
+    initialize(sRecvBuffer.c_str(), sRecvBuffer.length());
+}
+
+void TarsCurrent::initialize(const char *data, size_t len)
 {
     TarsInputStream<BufferReader> is;
 
-    is.setBuffer(sRecvBuffer.c_str(), sRecvBuffer.length());
+    is.setBuffer(data, len);
 
     _request.readFrom(is);
+
+    _requestData = _request.sBuffer.empty() ? NULL : &_request.sBuffer[0];
+    _requestLen  = _request.sBuffer.size();
+    _lazyPos     = 0;
+}
+
+void TarsCurrent::initialize(const TC_SharedSlice &slice)
+{
+    TarsInputStream<BufferReader> is;
+
+    is.setBuffer(slice.data, slice.len);
+
+    is.read(_request.iVersion, 1, true);
+    is.read(_request.cPacketType, 2, true);
+    is.read(_request.iMessageType, 3, true);
+    is.read(_request.iRequestId, 4, true);
+    is.read(_request.sServantName, 5, true);
+    is.read(_request.sFuncName, 6, true);
+
+    //sBuffer只记下位置, 不是SimpleList(其他语言的客户端)按原来的方式全部解码
+    uint8_t headType = 0;
+    size_t  n        = 0;
+
+    if (!is.skipToTag(7))
+    {
+        throw TarsDecodeRequireNotExist("require field not exist, tag: 7");
+    }
+
+    TarsPeekFromHeadNoTag(is, headType, n);
+
+    if (headType != TarsHeadeSimpleList)
+    {
+        initialize(slice.data, slice.len);
+        return;
+    }
+
+    TarsReadHeadSkip(is, n);
+
+    readFromHeadNoTag(is, headType);
+    if (headType != TarsHeadeChar)
+    {
+        char s[64];
+        snprintf(s, sizeof(s), "type mismatch, tag: 7, type: %d", headType);
+        throw TarsDecodeMismatch(s);
+    }
+
+    UInt32 size = 0;
+    is.read(size, 0);
+
+    if (size > is._buf_len - is._cur)
+    {
+        char s[64];
+        snprintf(s, sizeof(s), "invalid size, tag: 7, size: %u", size);
+        throw TarsDecodeInvalidValue(s);
+    }
+
+    _requestData = size > 0 ? is._buf + is._cur : NULL;
+    _requestLen  = size;
+
+    is.skip(size);
+
+    is.read(_request.iTimeout, 8, true);
+
+    _bufferCopied = (size == 0);
+    _lazyPos      = is._cur;
+    _recvSlice    = slice;
+}
+
+void TarsCurrent::decodeLazy() const
+{
+    if (_lazyPos == 0)
+    {
+        return;
+    }
+
+    TC_LockT<TC_ThreadMutex> lock(_lazyMutex);
+
+    if (_lazyPos == 0)
+    {
+        return;
+    }
+
+    TarsInputStream<BufferReader> is;
+
+    is.setBuffer(_recvSlice.data + _lazyPos, _recvSlice.len - _lazyPos);
+
+    is.read(_request.context, 9, true);
+    is.read(_request.status, 10, true);
+
+    //解码完才置0, 其他线程看到0时map已经填好
+    __sync_synchronize();
+
+    _lazyPos = 0;
+}
+
+void TarsCurrent::releaseRecvSlice()
+{
+    if (_recvSlice.empty())
+    {
+        return;
+    }
+
+    decodeLazy();
+
+    getRequestBuffer();
+
+    _requestData = _request.sBuffer.empty() ? NULL : &_request.sBuffer[0];
+
+    _recvSlice = TC_SharedSlice();
 }
 
 void TarsCurrent::sendResponse(const char* buff, uint32_t len)
@@ -230,27 +420,35 @@ void TarsCurrent::sendResponse(int iRet, const vector<char>& buffer, const map<s
 
     TarsOutputStream<BufferWriter> os;
 
-    if (_request.iVersion != TUPVERSION)
-    {
-        ResponsePacket response;
+    //先占住4字节的包长, 编码完再填, 不用再拼一次包
+    tars::Int32 iHeaderLen = 0;
 
-        response.iRequestId     = _request.iRequestId;
-        response.iMessageType   = _request.iMessageType;
-        response.cPacketType    = TARSNORMAL;
-        response.iVersion       = TARSVERSION;
-        response.status         = status;
-        response.sBuffer        = buffer;
-        response.sResultDesc    = sResultDesc;
-        response.context        = _responseContext;
-        response.iRet           = iRet;
+    os.writeBuf(&iHeaderLen, sizeof(tars::Int32));
 
+    if (_request.iVersion != TUPVERSION)
+    {
         TLOGINFO("[TARS]TarsCurrent::sendResponse :"
-                   << response.iMessageType << "|"
+                   << _request.iMessageType << "|"
                    << _request.sServantName << "|"
                    << _request.sFuncName << "|"
-                   << response.iRequestId << endl);
-
-        response.writeTo(os);
+                   << _request.iRequestId << endl);
+
+        //按ResponsePacket::writeTo的顺序直接编码, 不把buffer拷贝到ResponsePacket::sBuffer
+        os.write(TARSVERSION, 1);
+        os.write(TARSNORMAL, 2);
+        os.write(_request.iRequestId, 3);
+        os.write(_request.iMessageType, 4);
+        os.write(iRet, 5);
+        os.write(buffer, 6);
+        os.write(status, 7);
+        if (!sResultDesc.empty())
+        {
+            os.write(sResultDesc, 8);
+        }
+        if (!_responseContext.empty())
+        {
+            os.write(_responseContext, 9);
+        }
     }
     else
     {
@@ -294,15 +492,16 @@ void TarsCurrent::sendResponse(int iRet, const vector<char>& buffer, const map<s
         response.writeTo(os);
     }
 
-    tars::Int32 iHeaderLen = htonl(sizeof(tars::Int32) + os.getLength());
-
-    string s = "";
+    iHeaderLen = htonl(os.getLength());
 
-    s.append((const char*)&iHeaderLen, sizeof(tars::Int32));
+    memcpy(os._buf, &iHeaderLen, sizeof(tars::Int32));
 
-    s.append(os.getBuffer(), os.getLength());
+    //编码好的内存直接交给网络线程发送
+    size_t len              = os.getLength();
+    size_t capacity         = os._buf_len;
+    TC_SharedBlockPtr block = new TC_SharedBlock(os.detach(), capacity);
 
-    _servantHandle->sendResponse(_uid, s, _ip, _port, _fd);
+    _servantHandle->sendResponse(_uid, TC_SharedSlice(block, block->Data(), len), _ip, _port, _fd);
 }
 
 void TarsCurrent::close()
@@ -329,11 +528,11 @@ void TarsCurrent::reportToStat(const string& sObj)
 
     if(stat && stat->getStatPrx())
     {
-        int64_t endtime = TNOWMS;
-        int sptime = endtime - _begintime;
+        int64_t endUs   = TNOWUS;
+        int sptime      = endUs / 1000 - _begintime;
 
         //被调上报自己的set信息，set信息在setReportInfo设置
-        stat->report(sObj, "" , _request.sFuncName, _ip, 0, (StatReport::StatResult)_ret, sptime, 0, false);
+        stat->report(sObj, "" , _request.sFuncName, _ip, 0, (StatReport::StatResult)_ret, sptime, 0, false, endUs - _beginUs);
     }
 }
 
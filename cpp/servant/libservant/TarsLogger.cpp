@@ -17,12 +17,15 @@
 #include "servant/TarsLogger.h"
 #include "servant/Communicator.h"
 #include "servant/Application.h"
+#include "util/tc_lz4.h"
+#include "util/tc_gzip.h"
 
 namespace tars
 {
 
 int RollWriteT::_dyeingThread = 0;
 int TimeWriteT::_dyeing = 0;
+volatile bool RemoteTimeWriteT::_blockUnsupported = false;
 
 /////////////////////////////////////////////////////////////////////////////////////
 
@@ -198,8 +201,6 @@ void RemoteTimeWriteT::setTimeWriteT(TimeWriteT *pTimeWrite)
 
 void RemoteTimeWriteT::operator()(ostream &of, const deque<pair<int, string> > &buffer)
 {
-    const static uint32_t len = 2000;
-
     //写远程日志
     if(_timeWrite->_logPrx && !buffer.empty())
     {
@@ -210,49 +211,52 @@ void RemoteTimeWriteT::operator()(ostream &of, const deque<pair<int, string> > &
             return;
         }
 
-        vector<string> v;
-        v.reserve(len);
-
-        deque<pair<int, string> >::const_iterator it = buffer.begin();
-        while(it != buffer.end())
+        if(_timeWrite->_compress != LOG_COMPRESS_NONE && !_blockUnsupported)
         {
-            v.push_back(it->second);
+            sync2remoteBlock(buffer);
+        }
+        else
+        {
+            sync2remoteLines(buffer.begin(), buffer.end());
+        }
+    }
+}
 
-            ++it;
+void RemoteTimeWriteT::sync2remoteLines(deque<pair<int, string> >::const_iterator begin, deque<pair<int, string> >::const_iterator end)
+{
+    const static uint32_t len = 2000;
 
-            //每次最多同步len条
-            if(v.size() >= len)
-            {
-                sync2remote(v);
-                v.clear();
-                v.reserve(len);
-            }
-        }
+    vector<string> v;
+    v.reserve(len);
+
+    deque<pair<int, string> >::const_iterator it = begin;
+    while(it != end)
+    {
+        v.push_back(it->second);
+
+        ++it;
 
-        if(v.size() > 0)
+        //每次最多同步len条
+        if(v.size() >= len)
         {
             sync2remote(v);
+            v.clear();
+            v.reserve(len);
         }
     }
+
+    if(v.size() > 0)
+    {
+        sync2remote(v);
+    }
 }
 
 void RemoteTimeWriteT::sync2remote(const vector<string> &v)
 {
     try
     {
-        //此处传递set信息到远程logserver
         LogInfo stInfo;
-        stInfo.appname           = _timeWrite->_app;
-        stInfo.servername        = _timeWrite->_server;
-        stInfo.sFilename         = _timeWrite->_file;
-        stInfo.sFormat           = _timeWrite->_format;
-        stInfo.setdivision       = _timeWrite->_setDivision;
-        stInfo.bHasSufix         = _timeWrite->_hasSufix;
-        stInfo.bHasAppNamePrefix = _timeWrite->_hasAppNamePrefix;
-        stInfo.sConcatStr        = _timeWrite->_concatStr;
-        stInfo.bHasSquareBracket = _timeWrite->_hasSquareBracket;
-        stInfo.sSepar            = _timeWrite->_separ;
-        stInfo.sLogType          = _timeWrite->_logType;
+        getLogInfo(stInfo);
 
         _timeWrite->_logPrx->loggerbyInfo(stInfo,v);
 
@@ -272,6 +276,125 @@ void RemoteTimeWriteT::sync2remote(const vector<string> &v)
     }
 }
 
+void RemoteTimeWriteT::getLogInfo(LogInfo &stInfo)
+{
+    //此处传递set信息到远程logserver
+    stInfo.appname           = _timeWrite->_app;
+    stInfo.servername        = _timeWrite->_server;
+    stInfo.sFilename         = _timeWrite->_file;
+    stInfo.sFormat           = _timeWrite->_format;
+    stInfo.setdivision       = _timeWrite->_setDivision;
+    stInfo.bHasSufix         = _timeWrite->_hasSufix;
+    stInfo.bHasAppNamePrefix = _timeWrite->_hasAppNamePrefix;
+    stInfo.sConcatStr        = _timeWrite->_concatStr;
+    stInfo.bHasSquareBracket = _timeWrite->_hasSquareBracket;
+    stInfo.sSepar            = _timeWrite->_separ;
+    stInfo.sLogType          = _timeWrite->_logType;
+}
+
+void RemoteTimeWriteT::sync2remoteBlock(const deque<pair<int, string> > &buffer)
+{
+    //每块压缩前最多1M
+    const static size_t blockSize = 1024 * 1024;
+
+    string raw;
+    raw.reserve(blockSize);
+
+    deque<pair<int, string> >::const_iterator begin = buffer.begin();
+    deque<pair<int, string> >::const_iterator it    = buffer.begin();
+    while(it != buffer.end())
+    {
+        raw += it->second;
+
+        ++it;
+
+        if(raw.length() >= blockSize)
+        {
+            sendBlock(raw, begin, it);
+            raw.clear();
+            begin = it;
+        }
+    }
+
+    if(begin != buffer.end())
+    {
+        sendBlock(raw, begin, buffer.end());
+    }
+}
+
+void RemoteTimeWriteT::sendBlock(const string &raw, deque<pair<int, string> >::const_iterator begin, deque<pair<int, string> >::const_iterator end)
+{
+    //LogServer不支持时改回按条发送
+    if(_timeWrite->_compress == LOG_COMPRESS_NONE || _blockUnsupported)
+    {
+        sync2remoteLines(begin, end);
+        return;
+    }
+
+    LogBlock block;
+    block.compress  = _timeWrite->_compress;
+    block.rawLength = raw.length();
+    block.lines     = end - begin;
+
+    bool bSucc = false;
+    if(block.compress == LOG_COMPRESS_LZ4)
+    {
+        string c;
+        bSucc = TC_LZ4::compress(raw.data(), raw.length(), c);
+        block.data.assign(c.begin(), c.end());
+    }
+    else if(block.compress == LOG_COMPRESS_GZIP)
+    {
+        bSucc = TC_GZip::compress(raw.data(), raw.length(), block.data);
+    }
+
+    //压缩失败或者没有变小, 直接发原始内容
+    if(!bSucc || block.data.size() >= raw.length())
+    {
+        block.compress = LOG_COMPRESS_NONE;
+        block.data.assign(raw.begin(), raw.end());
+    }
+
+    try
+    {
+        LogInfo stInfo;
+        getLogInfo(stInfo);
+
+        _timeWrite->_logPrx->loggerbyBlock(stInfo, block);
+
+        if (_timeWrite->_reportSuccPtr)
+        {
+            _timeWrite->_reportSuccPtr->report(block.lines);
+        }
+    }
+    catch(TarsServerNoFuncException &ex)
+    {
+        TLOGERROR("[TARS] remote log server not support loggerbyBlock, all remote logs of this process send by lines:" << ex.what() << endl);
+
+        //所有远程日志都发到同一个LogServer, 其他日志文件也不再尝试
+        _blockUnsupported = true;
+
+        sync2remoteLines(begin, end);
+    }
+    catch(exception &ex)
+    {
+        TLOGERROR("[TARS] write block to remote log server error:" << ex.what() << ": buffer size:" << block.lines << endl);
+
+        vector<string> v;
+        v.reserve(block.lines);
+        for(deque<pair<int, string> >::const_iterator it = begin; it != end; ++it)
+        {
+            v.push_back(it->second);
+        }
+        _timeWrite->writeError(v);
+
+        if (_timeWrite->_reportFailPtr)
+        {
+            _timeWrite->_reportFailPtr->report(block.lines);
+        }
+    }
+}
+
 void RemoteTimeWriteT::sync2remoteDyeing(const vector<string> &v)
 {
     try
@@ -295,7 +418,7 @@ TimeWriteT::~TimeWriteT()
 }
 
 TimeWriteT::TimeWriteT() : _remoteTimeLogger(NULL), _local(true), _remote(true), _dyeingTimeLogger(NULL),_setDivision(""),
-    _hasSufix(true),_hasAppNamePrefix(true),_concatStr("_"),_separ("|"),_hasSquareBracket(false),_logType("")
+    _hasSufix(true),_hasAppNamePrefix(true),_concatStr("_"),_separ("|"),_hasSquareBracket(false),_logType(""),_compress(LOG_COMPRESS_NONE)
 {
 }
 
@@ -466,7 +589,7 @@ void TimeWriteT::writeError(const deque<pair<int, string> > &buffer)
 
 /////////////////////////////////////////////////////////////////////////////////////
 
-TarsTimeLogger::TarsTimeLogger() : _defaultLogger(NULL),_hasSufix(true),_hasAppNamePrefix(true),_concatStr("_"),_separ("|"),_hasSquareBracket(false),_local(true),_remote(true)
+TarsTimeLogger::TarsTimeLogger() : _defaultLogger(NULL),_hasSufix(true),_hasAppNamePrefix(true),_concatStr("_"),_separ("|"),_hasSquareBracket(false),_local(true),_remote(true),_logStatReport(false),_compress(LOG_COMPRESS_LZ4)
 {
 }
 
@@ -512,6 +635,7 @@ void TarsTimeLogger::initTimeLogger(TimeLogger *pTimeLogger, const string &sFile
     pTimeLogger->getWriteT().enableSqareWrapper(_hasSquareBracket);
     pTimeLogger->getWriteT().enableLocal(_local);
     pTimeLogger->getWriteT().enableRemote(_remote);
+    pTimeLogger->getWriteT().setCompress(_compress);
 
     string sLogType = "";
     if(logTypePtr)
@@ -558,6 +682,7 @@ void TarsTimeLogger::initTimeLogger(TimeLogger *pTimeLogger,const string &sApp,
     pTimeLogger->getWriteT().enableSqareWrapper(_hasSquareBracket);
     pTimeLogger->getWriteT().enableLocal(_local);
     pTimeLogger->getWriteT().enableRemote(_remote);
+    pTimeLogger->getWriteT().setCompress(_compress);
     string sLogType = "";
     if(logTypePtr)
     {
@@ -28,6 +28,7 @@ namespace tars
 ///////////////////////////////////////////////////////////////////////
 Transceiver::Transceiver(AdapterProxy * pAdapterProxy,const EndpointInfo &ep)
 : _adapterProxy(pAdapterProxy)
+, _connIndex(0)
 , _ep(ep)
 , _fd(-1)
 , _connStatus(eUnconnected)
@@ -53,7 +54,7 @@ void Transceiver::checkTimeout()
     {
         //链接超时
         TLOGERROR("[TARS][Transceiver::checkTimeout ep:"<<_adapterProxy->endpoint().desc()<<" , connect timeout]"<<endl);
-        _adapterProxy->setConTimeout(true);
+        _adapterProxy->setConTimeout(this, true);
         close();
     }
 }
@@ -142,8 +143,8 @@ void Transceiver::connect()
 void Transceiver::setConnected()
 {
     _connStatus = eConnected;
-    _adapterProxy->setConTimeout(false);
-    _adapterProxy->addConnExc(false);
+    _adapterProxy->setConTimeout(this, false);
+    _adapterProxy->addConnExc(this, false);
 
     _onConnect();
 }
@@ -196,7 +197,7 @@ void Transceiver::_doAuthReq()
     if (_adapterProxy->endpoint().authType() == AUTH_TYPENONE)
     {
         _authState = AUTH_SUCC;
-        _adapterProxy->doInvoke();
+        _adapterProxy->doInvoke(this);
     }
     else
     {
@@ -305,7 +306,7 @@ int Transceiver::doRequest()
     }
 
     //取adapter里面积攒的数据
-    _adapterProxy->doInvoke();
+    _adapterProxy->doInvoke(this);
 
     //object里面应该是空的
     assert(_adapterProxy->getObjProxy()->timeoutQSize()  == 0);
@@ -373,6 +374,87 @@ int Transceiver::sendRequest(const char * pData, size_t iSize, bool forceSend)
     return eRetOk;
 }
 
+int Transceiver::sendRequest(const vector<iovec> &vecs, size_t &iNum)
+{
+    iNum = 0;
+
+    if(vecs.empty())
+    {
+        return eRetOk;
+    }
+
+    if(_connStatus != eConnected)
+    {
+        return eRetError;
+    }
+
+    if (_authState != AUTH_SUCC)
+    {
+        TLOGINFO("[TARS][Transceiver::sendRequest temporary failed because need auth for " << _adapterProxy->getObjProxy()->name() << endl);
+        return eRetError; // 需要鉴权但还没通过，不能发送非认证消息
+    }
+
+    //buf不为空,直接返回失败
+    //等buffer可写了,epoll会通知写时间
+    if(!_sendBuffer.IsEmpty())
+    {
+        return eRetError;
+    }
+
+    int iRet = this->writev(&vecs[0], vecs.size());
+
+    //失败，直接返回
+    if(iRet < 0)
+    {
+        return eRetError;
+    }
+
+    size_t iSent = iRet;
+
+    for(; iNum < vecs.size() && iSent >= vecs[iNum].iov_len; ++iNum)
+    {
+        iSent -= vecs[iNum].iov_len;
+    }
+
+    if(iNum == vecs.size())
+    {
+        return eRetOk;
+    }
+
+    //发送了一部分的请求, 剩下的写buffer, 后面的请求等epoll通知再发
+    if(iSent > 0)
+    {
+        _sendBuffer.PushData((const char*)vecs[iNum].iov_base + iSent, vecs[iNum].iov_len - iSent);
+        ++iNum;
+    }
+
+    return eRetFull;
+}
+
+int Transceiver::writev(const struct iovec* vecs, int32_t count)
+{
+    int iTotal = 0;
+
+    for(int32_t i = 0; i < count; ++i)
+    {
+        int iRet = this->send(vecs[i].iov_base, vecs[i].iov_len, 0);
+
+        if(iRet < 0)
+        {
+            return (iTotal > 0) ? iTotal : iRet;
+        }
+
+        iTotal += iRet;
+
+        if(iRet < (int)vecs[i].iov_len)
+        {
+            break;
+        }
+    }
+
+    return iTotal;
+}
+
 //////////////////////////////////////////////////////////
 TcpTransceiver::TcpTransceiver(AdapterProxy * pAdapterProxy, const EndpointInfo &ep)
 : Transceiver(pAdapterProxy, ep)
@@ -522,6 +604,33 @@ int TcpTransceiver::send(const void* buf, uint32_t len, uint32_t flag)
     return iRet;
 }
 
+int TcpTransceiver::writev(const struct iovec* vecs, int32_t count)
+{
+    //只有是连接状态才能收发数据
+    if(_connStatus != eConnected)
+    {
+        return -1;
+    }
+
+    int iRet = ::writev(_fd, vecs, count);
+
+    if (iRet < 0 && errno != EAGAIN)
+    {
+        TLOGINFO("[TARS][tcp writev objname:" << _adapterProxy->getObjProxy()->name() 
+            << ",fd:" << _fd << ",desc:" << _ep.desc() 
+            << ",fail! errno:" << errno << "," << strerror(errno) << ",close]" << endl);
+
+        close();
+
+        return iRet;
+    }
+
+    TLOGINFO("[TARS][tcp writev," << _adapterProxy->getObjProxy()->name() << ",fd:" << _fd 
+        << ",desc:" << _ep.desc() << ",count:" << count << ",len:" << iRet << "]" << endl);
+
+    return iRet;
+}
+
 int TcpTransceiver::readv(const struct iovec* vecs, int32_t vcnt)
 {
     //只有是连接状态才能收发数据
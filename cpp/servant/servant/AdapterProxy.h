@@ -55,14 +55,26 @@ public:
 
     /**
      * 发送请求
-     * 发送挤压的数据
+     * 发送所有连接上挤压的数据
      */
     void doInvoke();
 
+    /**
+     * 发送某个连接上挤压的数据
+     */
+    void doInvoke(Transceiver * trans);
+
+    /**
+     * 发送本轮事件处理中积攒的请求(批量发送模式)
+     */
+    void doPendingInvoke();
+
     /**
      * server端的响应包返回
+     * @param trans 收到响应的连接
+     * @param rsp
      */
-    void finishInvoke(ResponsePacket &rsp);
+    void finishInvoke(Transceiver * trans, ResponsePacket &rsp);
 
     /**
      * 端口是否有效,当连接全部失效时返回false
@@ -72,20 +84,15 @@ public:
     bool checkActive(bool bForceConnect = false);
 
     /**
-     * 记录连接是否异常
+     * 记录连接是否异常, 所有连接都异常时节点才算连接异常
      */
-    void addConnExc(bool bExc);
+    void addConnExc(Transceiver * trans, bool bExc);
 
     /**
      * 处理超时
      */
     void doTimeout();
 
-    /**
-     * 处理stat
-     */
-    void doStat(map<StatMicMsgHead, StatMicMsgBody> & mStatMicMsg);
-
     /**
      * 处理采样
      */
@@ -108,14 +115,14 @@ public:
     int getConTimeout();
 
     /**
-     * 连接是否超时
+     * 连接是否超时, 所有连接都超时才算
      */
     inline bool isConnTimeout() { return _connTimeout; }
 
     /**
      * 设置连接是否超时
      */
-    void   setConTimeout(bool bConTimeout);
+    void   setConTimeout(Transceiver * trans, bool bConTimeout);
 
     /**
      * 连接是否异常
@@ -123,7 +130,7 @@ public:
     inline bool isConnExc() { return _connExc; }
 
     /**
-     * 连接异常的次数
+     * 连接异常的次数(各连接连续异常次数的最小值)
      */
     inline int ConnExcCnt() const { return _connExcCnt; }
 
@@ -137,12 +144,20 @@ public:
      */
     inline void setActiveInReg(bool bActive) { _activeStateInReg = bActive; }
 
+    /**
+     * 连接个数
+     *
+     * @return size_t
+     */
+    inline size_t getConnNum() const { return _conns.size(); }
+
     /**
      * 获取连接
      *
+     * @param i 第几个连接
      * @return Transceiver*
      */
-    inline Transceiver* trans() { return _trans; }
+    inline Transceiver* trans(size_t i = 0) { return _conns[i].trans; }
 
     /**
      * 设置节点的静态权重值
@@ -154,6 +169,25 @@ public:
      */
     inline int getWeight() { return _staticWeight; }
 
+    /**
+     * 在途请求数(包括还没有发送的)
+     */
+    size_t getInflight() const;
+
+    /**
+     * 按响应时间选择节点时的负载: 平均响应时间*(在途请求数+1)
+     * @param iNowUs 当前时间(微秒)
+     */
+    double getLatencyLoad(int64_t iNowUs);
+
+    /**
+     * 更新平均响应时间, 指数衰减: 距离上次更新越久, 旧值的权重越小;
+     * 比平均值大的样本直接生效. 收到响应时调用, 也可以直接喂样本(测试)
+     * @param iNowUs 当前时间(微秒)
+     * @param dRttUs 本次响应时间(微秒), 同机房的调用常常不到1毫秒, 按毫秒算分不出快慢
+     */
+    void updateLatency(int64_t iNowUs, double dRttUs);
+
 private:
 
     /**
@@ -162,6 +196,43 @@ private:
     void setInactive();
 
 private:
+    /**
+     * 到节点的一个连接, 每个连接有自己的超时队列(在途请求和未发送链表)和异常状态
+     */
+    struct ConnInfo
+    {
+        Transceiver*                       trans;
+        TC_TimeoutQueueNew<ReqMessage*>*   timeoutQueue;
+        bool                               connTimeout;
+        bool                               connExc;
+        uint32_t                           connExcCnt;
+        time_t                             nextRetryTime;
+    };
+
+    /**
+     * 选择在途请求最少的可用连接
+     */
+    ConnInfo & selectConn();
+
+    /**
+     * 发送一个连接上积压的数据
+     */
+    void doInvoke(ConnInfo & conn);
+
+    /**
+     * 批量发送积压的数据, 每批一次writev
+     */
+    void doInvokeBatch(ConnInfo & conn);
+
+    /**
+     * 检查连接, 无效的重新建立
+     */
+    void checkConn(ConnInfo & conn, time_t now, bool bForceConnect);
+
+    /**
+     * 按各连接的状态汇总节点的连接超时/异常状态
+     */
+    void updateConnState();
 
     /**
      * 请求的响应处理
@@ -183,11 +254,6 @@ private:
      */
     void stat(ReqMessage * msg);
 
-    /**
-     * 模块间调用信息的合并
-     */
-    void merge(const StatMicMsgBody& inBody, StatMicMsgBody& outBody);
-
     /**
      * 获取被调名
      */
@@ -211,14 +277,14 @@ private:
     EndpointInfo                           _endpoint;
 
     /*
-     * 收发包处理
+     * 到节点的连接
      */
-    Transceiver*                           _trans;
+    vector<ConnInfo>                       _conns;
 
     /*
-     * 超时队列
+     * 在途请求相同时轮流选择连接
      */
-    TC_TimeoutQueueNew<ReqMessage*>*       _timeoutQueue;
+    size_t                                 _nextConn;
 
     /*
      * 节点在主控的存活状态
@@ -290,15 +356,55 @@ private:
      */
     size_t                                   _noSendQueueLimit;
 
+    /*
+     * 是否批量发送(只有tcp)
+     */
+    bool                                   _sendBatch;
+
+    /*
+     * 批量发送一次最多的请求个数
+     */
+    size_t                                 _sendBatchNum;
+
+    /*
+     * 批量发送一次最多的字节数
+     */
+    size_t                                 _sendBatchBytes;
+
+    /*
+     * 是否已经在网络线程的待发送节点中
+     */
+    bool                                   _pendingInvoke;
+
+    /*
+     * 上次发送后积攒的请求个数
+     */
+    size_t                                 _pendingNum;
+
+    /*
+     * 上次发送后积攒的字节数
+     */
+    size_t                                 _pendingBytes;
+
+    /*
+     * 平均响应时间(微秒)
+     */
+    double                                 _latency;
+
+    /*
+     * 平均响应时间上次更新的时间(微秒)
+     */
+    int64_t                                _latencyTime;
+
     /*
      * 模块间调用统计信息的head信息
      */
     StatMicMsgHead                           _statHead;
 
     /*
-     * 模块间调用统计信息的body信息
+     * 模块间调用统计项, 按接口名
      */
-    map<string,StatMicMsgBody>               _statBody;
+    map<string,StatCounterPtr>               _statCounter;
 
     /*
      * 最大采样次数
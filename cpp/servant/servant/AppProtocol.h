@@ -94,6 +94,51 @@ public:
         return TC_EpollServer::PACKET_FULL;
     }
 
+    /**
+     * 零拷贝解析协议, 不拷贝也不修改接收缓冲区
+     * @param data, 目前的buffer
+     * @param len, buffer的长度
+     * @param pos, 包体在buffer中的起始偏移
+     * @param end, 包在buffer中的结束偏移
+     *
+     * @return int, 0表示没有接收完全, 1表示收到一个完整包
+     */
+    static int parseSlice(const char *data, size_t len, size_t &pos, size_t &end)
+    {
+        return parseLenSlice<10000000>(data, len, pos, end);
+    }
+
+    template<tars::Int32 iMaxLength>
+    static int parseLenSlice(const char *data, size_t len, size_t &pos, size_t &end)
+    {
+        if(len < sizeof(tars::Int32))
+        {
+            return TC_EpollServer::PACKET_LESS;
+        }
+
+        tars::Int32 iHeaderLen;
+
+        memcpy(&iHeaderLen, data, sizeof(tars::Int32));
+
+        iHeaderLen = ntohl(iHeaderLen);
+
+        if(iHeaderLen < tars::Int32(sizeof(tars::Int32))|| iHeaderLen > iMaxLength)
+        {
+            return TC_EpollServer::PACKET_ERR;
+        }
+
+        if(len < (size_t)iHeaderLen)
+        {
+            return TC_EpollServer::PACKET_LESS;
+        }
+
+        pos = sizeof(tars::Int32);
+
+        end = iHeaderLen;
+
+        return TC_EpollServer::PACKET_FULL;
+    }
+
     /**
      * 解析协议
      * @param in, 目前的buffer
@@ -103,6 +148,17 @@ public:
      */
     static int parseAdmin(string &in, string &out);
 
+    /**
+     * 零拷贝解析管理协议
+     * @param data, 目前的buffer
+     * @param len, buffer的长度
+     * @param pos, 包体在buffer中的起始偏移
+     * @param end, 包在buffer中的结束偏移
+     *
+     * @return int, 0表示没有接收完全, 1表示收到一个完整包
+     */
+    static int parseAdminSlice(const char *data, size_t len, size_t &pos, size_t &end);
+
     /**
      *
      * @param T
@@ -145,6 +201,51 @@ public:
 
         return TC_EpollServer::PACKET_FULL;
     }
+
+    /**
+     * parseStream的零拷贝版本
+     * @param T
+     * @param offset
+     * @param netorder
+     * @param data
+     * @param len
+     * @param pos
+     * @param end
+     * @return int
+     */
+    template<size_t offset, typename T, bool netorder>
+    static int parseStreamSlice(const char *data, size_t len, size_t &pos, size_t &end)
+    {
+        if(len < offset + sizeof(T))
+        {
+            return TC_EpollServer::PACKET_LESS;
+        }
+
+        T iHeaderLen = 0;
+
+        ::memcpy(&iHeaderLen, data + offset, sizeof(T));
+
+        if (netorder)
+        {
+            iHeaderLen = net2host<T>(iHeaderLen);
+        }
+
+        if (iHeaderLen < (T)(offset + sizeof(T)) || (uint32_t)iHeaderLen > 100000000)
+        {
+            return TC_EpollServer::PACKET_ERR;
+        }
+
+        if (len < (uint32_t)iHeaderLen)
+        {
+            return TC_EpollServer::PACKET_LESS;
+        }
+
+        pos = 0;
+
+        end = iHeaderLen;
+
+        return TC_EpollServer::PACKET_FULL;
+    }
 };
 
 typedef TC_Functor<void, TL::TLMaker<const RequestPacket&, string&>::Result> request_protocol;
@@ -385,6 +486,27 @@ public:
      */
     static void tarsRequest(const RequestPacket& request, string& buff);
 
+    /**
+     * tars请求包预编码, 在调用线程中完整编码, requestid固定按4字节编码占位
+     * @param request
+     * @param buff
+     * @return size_t, requestid的值在buff中的偏移
+     */
+    static size_t tarsRequestPrepare(RequestPacket& request, string& buff);
+
+    /**
+     * 回填预编码请求包的requestid
+     * @param buff
+     * @param pos  tarsRequestPrepare返回的偏移
+     * @param iRequestId
+     */
+    static void tarsRequestPatchId(string& buff, size_t pos, tars::Int32 iRequestId)
+    {
+        iRequestId = htonl(iRequestId);
+
+        memcpy(&buff[pos], &iRequestId, sizeof(tars::Int32));
+    }
+
     /**
      * tars响应包解析
      * @param recvBuffer
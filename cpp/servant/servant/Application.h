@@ -342,6 +342,14 @@ protected:
      */
     void addServantProtocol(const string& servant, const TC_EpollServer::protocol_functor& protocol);
 
+    /**
+     * 非tars协议server，设置Servant的零拷贝协议解析器, 
+     * 收到的包直接引用网络接收缓冲区
+     * @param protocol
+     * @param servant
+     */
+    void addServantSliceProtocol(const string& servant, const TC_EpollServer::slice_protocol_functor& protocol);
+
 protected:
     /**
      * 读取基本信息
@@ -387,6 +395,11 @@ protected:
      */
     TC_EpollServer::BindAdapter::EOrder parseOrder(const string &s);
 
+    /**
+     * 解析handle组分发请求的方式
+     */
+    int parseHandleSchedule(const string &s);
+
     /**
      * 绑定server配置的Adapter和对象
      */
@@ -30,6 +30,7 @@ namespace tars
 class Communicator;
 class ObjectProxy;
 class ObjectProxyFactory;
+class AdapterProxy;
 class StatReport;
 class PropertyReport;
 
@@ -149,6 +150,51 @@ public:
         return _noSendQueueLimit;
     }
 
+    /*
+     * 是否批量发送: 一轮事件处理中同一个节点的请求攒起来一次writev
+     */
+    inline bool isSendBatch()
+    {
+        return _sendBatch;
+    }
+
+    /*
+     * 批量发送时一次最多发送的请求个数
+     */
+    inline size_t getSendBatchNum()
+    {
+        return _sendBatchNum;
+    }
+
+    /*
+     * 批量发送时一次最多发送的字节数
+     */
+    inline size_t getSendBatchBytes()
+    {
+        return _sendBatchBytes;
+    }
+
+    /*
+     * 是否在调用线程中编码请求包
+     */
+    inline bool isCallerEncode()
+    {
+        return _callerEncode;
+    }
+
+    /*
+     * 每个节点的连接个数
+     */
+    inline size_t getConnNum()
+    {
+        return _connNum;
+    }
+
+    /*
+     * 节点有请求等待本轮事件处理完再发送
+     */
+    void addPendingInvoke(AdapterProxy * adapterProxy);
+
     /*
      * 判断是否是第一个网络线程 主控写缓存的时候用到
      */
@@ -241,6 +287,11 @@ protected:
      */
     void doStat();
 
+    /**
+     * 发送本轮积攒的请求
+     */
+    void doPendingInvoke();
+
 protected:
     /*
      * 通信器
@@ -312,6 +363,36 @@ protected:
      */
     size_t                 _noSendQueueLimit;
 
+    /*
+     * 是否批量发送
+     */
+    bool                   _sendBatch;
+
+    /*
+     * 批量发送一次最多的请求个数
+     */
+    size_t                 _sendBatchNum;
+
+    /*
+     * 批量发送一次最多的字节数
+     */
+    size_t                 _sendBatchBytes;
+
+    /*
+     * 是否在调用线程中编码请求包
+     */
+    bool                   _callerEncode;
+
+    /*
+     * 每个节点的连接个数
+     */
+    size_t                 _connNum;
+
+    /*
+     * 本轮有请求等待发送的节点
+     */
+    vector<AdapterProxy*>  _pendingInvoke;
+
     /*
      * epoll wait的超时时间
      */
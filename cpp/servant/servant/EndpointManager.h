@@ -44,6 +44,7 @@ enum  EndpointWeightType
 {
     E_LOOP          = 0,
     E_STATIC_WEIGHT = 1,
+    E_LATENCY       = 2,
 };
 
 ////////////////////////////////////////////////////////////////////////
@@ -404,6 +405,11 @@ private:
      */
     AdapterProxy* getWeightedProxy(bool bStaticWeighted);
 
+    /*
+     * 按响应时间选取一个结点: 随机取两个, 选负载(平均响应时间*(在途请求数+1))小的
+     */
+    AdapterProxy* getLatencyProxy();
+
     /*
      * 根据后端服务的权重值选取一个结点
      */
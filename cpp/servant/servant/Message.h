@@ -21,6 +21,7 @@
 #include "util/tc_autoptr.h"
 #include "util/tc_monitor.h"
 #include "util/tc_loop_queue.h"
+#include "util/tc_cache_alloc.h"
 #include "servant/CoroutineScheduler.h"
 
 namespace tars
@@ -150,6 +151,11 @@ struct SampleKey
  */
 struct ReqMonitor : public TC_ThreadLock
 {
+    /*
+     * 从线程缓存中分配
+     */
+    static void * operator new(size_t size) { return TC_CacheAlloc::allocate(size); }
+    static void operator delete(void * p, size_t size) { TC_CacheAlloc::deallocate(p, size); }
 };
 
 /////////////////////////////////////////////////////////////////////////
@@ -193,6 +199,8 @@ struct ReqMessage : public TC_HandleBase
     , bMonitorFin(false)
     , iBeginTime(0)
     , iEndTime(0)
+    , iBeginUs(0)
+    , iEndUs(0)
     , bHash(false)
     , bConHash(false)
     , iHashCode(0)
@@ -202,6 +210,7 @@ struct ReqMessage : public TC_HandleBase
     , bCoroFlag(false)
     , sched(NULL)
     , iCoroId(0)
+    , iReqIdPos(0)
     {
     }
 
@@ -217,6 +226,13 @@ struct ReqMessage : public TC_HandleBase
         }
     }
 
+    /*
+     * 从线程缓存中分配, 调用线程分配、网络线程或者回调线程释放,
+     * 稳定状态下不再向系统申请
+     */
+    static void * operator new(size_t size) { return TC_CacheAlloc::allocate(size); }
+    static void operator delete(void * p, size_t size) { TC_CacheAlloc::deallocate(p, size); }
+
     /*
      * 初始化
      */
@@ -236,6 +252,8 @@ struct ReqMessage : public TC_HandleBase
 
         iBeginTime     = 0;
         iEndTime       = 0;
+        iBeginUs       = 0;
+        iEndUs         = 0;
         bHash          = false;
         bConHash       = false;
         iHashCode      = 0;
@@ -248,6 +266,8 @@ struct ReqMessage : public TC_HandleBase
         bCoroFlag      = false;
         sched          = NULL;
         iCoroId        = 0;
+
+        iReqIdPos      = 0;
     }
 
 
@@ -270,6 +290,8 @@ struct ReqMessage : public TC_HandleBase
 
     int64_t                     iBeginTime;     //请求时间
     int64_t                     iEndTime;       //完成时间
+    int64_t                     iBeginUs;       //请求时间(微秒), 统计耗时分布用
+    int64_t                     iEndUs;         //完成时间(微秒), 按响应时间选择节点用
 
     bool                        bHash;          //是否hash调用
     bool                        bConHash;       //是否一致性hash调用
@@ -286,6 +308,8 @@ struct ReqMessage : public TC_HandleBase
     CoroutineScheduler*            sched;          //协程调度器
     uint32_t                    iCoroId;        //协程的id
 
+    size_t                      iReqIdPos;      //调用线程已经编码好sReqData时, requestid在其中的偏移; 0表示由网络线程编码
+
     SampleKey                   sampleKey;      //采样信息
 
 };
@@ -145,6 +145,14 @@ public:
         return _communicatorEpoll;
     }
 
+    /**
+     * 获取结点路由管理类
+     */
+    inline EndpointManager * getEndpointManager()
+    {
+        return _endpointManger;
+    }
+
     /**
      * 获取object名称
      * @return const string&
@@ -154,6 +162,14 @@ public:
         return _name;
     }
 
+    /**
+     * 是否设置过proxy的协议函数, 没有设置过的是tars协议
+     */
+    bool hasSetProtocol() const
+    {
+        return _hasSetProtocol;
+    }
+
     /**
      * 判断此obj是否走按set规则调用流程，如果是直连方式，即使服务端是启用set的，也不认为是按set规则调用的
      */
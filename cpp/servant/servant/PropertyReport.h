@@ -23,6 +23,8 @@
 
 #include <vector>
 #include <string>
+#include <string.h>
+#include <stdint.h>
 
 using namespace std;
 
@@ -48,6 +50,42 @@ public:
     std::string getMasterName() { return _sMasterName; }
     
 public:
+    enum
+    {
+        MAX_SLOT    = 16        //计数的槽数, 线程按序号取模, 同StatCounter
+    };
+
+    /**
+     * 当前线程使用的槽
+     */
+    static size_t getSlot();
+
+    /**
+     * 一个槽占一条cache line, 避免不同线程的槽互相干扰
+     */
+    struct Cell
+    {
+        int     d;
+    } __attribute__((aligned(64)));
+
+    /**
+     * avg的槽, 和与个数放在一个64位整数里, 一次原子操作同时取走
+     */
+    struct AvgCell
+    {
+        uint64_t v;             //高32位:和, 低32位:个数
+    } __attribute__((aligned(64)));
+
+    /**
+     * 策略对象里的槽按cache line对齐, 属性对象也要按cache line分配
+     */
+    static void *operator new(size_t size);
+    static void operator delete(void *p);
+
+public:
+    /**
+     * 以下策略都按线程分槽原子累加, report不加锁, get时取出各槽合并并清零
+     */
 
     /**
      * 求和
@@ -55,14 +93,12 @@ public:
     class sum
     {
     public:
-        sum() :_d(0)                { }
+        sum()                       { memset(_cell, 0, sizeof(_cell)); }
         string get();
         string desc()               { return "Sum"; }
-        void   set(int o)           { _d += o; }
-    protected:
-        void   clear()              { _d  = 0; }
+        void   set(int o);
     private:
-        int   _d;
+        Cell  _cell[MAX_SLOT];
     };
 
     /**
@@ -71,15 +107,12 @@ public:
     class avg
     {
     public:
-        avg():_sum(0), _count(0)    { }
+        avg()                       { memset(_cell, 0, sizeof(_cell)); }
         string desc()               { return "Avg"; }
         string get();
-        void   set(int o)           { _sum += o;++_count; }
-    protected:
-        void   clear()                { _sum = 0; _count = 0; }
+        void   set(int o);
     private:
-        int _sum;
-        int _count;
+        AvgCell _cell[MAX_SLOT];
     };
 
     /**
@@ -88,16 +121,17 @@ public:
     class distr
     {
     public:
-        distr(){};
+        distr() : _stride(0)        { }
         distr(const vector<int>& range);
         string desc()               { return "Distr"; }
         void   set(int o);
         string get();
-    protected:
-        void clear()                { _result.clear();}
+    private:
+        size_t *slots();            //_result中按cache line对齐的起始位置
     private:
         vector<int>     _range;
-        vector<size_t>  _result;
+        size_t          _stride;    //每个槽的计数个数, 按cache line对齐
+        vector<size_t>  _result;    //MAX_SLOT * _stride, 多留一条cache line用于对齐
     };
 
     /**
@@ -106,14 +140,12 @@ public:
     class max
     {
     public:
-        max() : _d(-9999999)        { }
+        max();
         string desc()               { return "Max"; }
         string get();
-        void   set(int o)           { _d < o?_d = o:1; }
-    protected:
-        void   clear()              { _d = 0; }
+        void   set(int o);
     private:
-        int   _d;
+        Cell  _cell[MAX_SLOT];
     };
 
     /**
@@ -122,14 +154,12 @@ public:
     class min
     {
     public:
-        min():_d(0)                 { }
+        min()                       { memset(_cell, 0, sizeof(_cell)); }
         string desc()               { return "Min"; }
         string get();
         void   set(int o);
-    protected:
-        void   clear()              { _d = 0; }
     private:
-        int   _d;
+        Cell  _cell[MAX_SLOT];      //0表示没有
     };
 
     /**
@@ -138,14 +168,12 @@ public:
     class count
     {
     public:
-        count():_d(0)               { }
+        count()                     { memset(_cell, 0, sizeof(_cell)); }
         string desc()               { return "Count"; }
         string get();
-        void   set(int o)           { _d++; }
-    protected:
-        void   clear()              { _d = 0; }
+        void   set(int o);
     private:
-        int   _d;
+        Cell  _cell[MAX_SLOT];
     };
 
 public:
@@ -186,7 +214,7 @@ public:
      * 构造函数
      * @param p1
      */
-    PropertyReportImp(Param1 p1)
+    PropertyReportImp(const Param1& p1)
     {
         TL::field<0>(_propertyReportData) = p1;
     }
@@ -196,7 +224,7 @@ public:
      * @param p1
      * @param p2
      */
-    PropertyReportImp(Param1 p1, Param2 p2)
+    PropertyReportImp(const Param1& p1, const Param2& p2)
     {
         TL::field<0>(_propertyReportData) = p1;
         TL::field<1>(_propertyReportData) = p2;
@@ -208,7 +236,7 @@ public:
      * @param p2
      * @param p3
      */
-    PropertyReportImp(Param1 p1, Param2 p2, Param3 p3)
+    PropertyReportImp(const Param1& p1, const Param2& p2, const Param3& p3)
     {
         TL::field<0>(_propertyReportData) = p1;
         TL::field<1>(_propertyReportData) = p2;
@@ -222,7 +250,7 @@ public:
      * @param p3
      * @param p4
      */
-    PropertyReportImp(Param1 p1, Param2 p2, Param3 p3, Param4 p4)
+    PropertyReportImp(const Param1& p1, const Param2& p2, const Param3& p3, const Param4& p4)
     {
         TL::field<0>(_propertyReportData) = p1;
         TL::field<1>(_propertyReportData) = p2;
@@ -238,7 +266,7 @@ public:
      * @param p4
      * @param p5
      */
-    PropertyReportImp(Param1 p1, Param2 p2, Param3 p3, Param4 p4, Param5 p5)
+    PropertyReportImp(const Param1& p1, const Param2& p2, const Param3& p3, const Param4& p4, const Param5& p5)
     {
         TL::field<0>(_propertyReportData) = p1;
         TL::field<1>(_propertyReportData) = p2;
@@ -256,7 +284,7 @@ public:
      * @param p5
      * @param p6
      */
-    PropertyReportImp(Param1 p1, Param2 p2, Param3 p3, Param4 p4, Param5 p5, Param6 p6)
+    PropertyReportImp(const Param1& p1, const Param2& p2, const Param3& p3, const Param4& p4, const Param5& p5, const Param6& p6)
     {
         TL::field<0>(_propertyReportData) = p1;
         TL::field<1>(_propertyReportData) = p2;
@@ -276,7 +304,7 @@ public:
      * @param p6
      * @param p7
      */
-    PropertyReportImp(Param1 p1, Param2 p2, Param3 p3, Param4 p4, Param5 p5, Param6 p6, Param7 p7)
+    PropertyReportImp(const Param1& p1, const Param2& p2, const Param3& p3, const Param4& p4, const Param5& p5, const Param6& p6, const Param7& p7)
     {
         TL::field<0>(_propertyReportData) = p1;
         TL::field<1>(_propertyReportData) = p2;
@@ -298,7 +326,7 @@ public:
      * @param p7
      * @param p8
      */
-    PropertyReportImp(Param1 p1, Param2 p2, Param3 p3, Param4 p4, Param5 p5, Param6 p6, Param7 p7, Param8 p8)
+    PropertyReportImp(const Param1& p1, const Param2& p2, const Param3& p3, const Param4& p4, const Param5& p5, const Param6& p6, const Param7& p7, const Param8& p8)
     {
         TL::field<0>(_propertyReportData) = p1;
         TL::field<1>(_propertyReportData) = p2;
@@ -322,7 +350,7 @@ public:
      * @param p8
      * @param p9
      */
-    PropertyReportImp(Param1 p1, Param2 p2, Param3 p3, Param4 p4, Param5 p5, Param6 p6, Param7 p7, Param8 p8, Param9 p9)
+    PropertyReportImp(const Param1& p1, const Param2& p2, const Param3& p3, const Param4& p4, const Param5& p5, const Param6& p6, const Param7& p7, const Param8& p8, const Param9& p9)
     {
         TL::field<0>(_propertyReportData) = p1;
         TL::field<1>(_propertyReportData) = p2;
@@ -348,7 +376,7 @@ public:
      * @param p9
      * @param p10
      */
-    PropertyReportImp(Param1 p1, Param2 p2, Param3 p3, Param4 p4, Param5 p5, Param6 p6, Param7 p7, Param8 p8, Param9 p9, Param10 p10)
+    PropertyReportImp(const Param1& p1, const Param2& p2, const Param3& p3, const Param4& p4, const Param5& p5, const Param6& p6, const Param7& p7, const Param8& p8, const Param9& p9, const Param10& p10)
     {
         TL::field<0>(_propertyReportData) = p1;
         TL::field<1>(_propertyReportData) = p2;
@@ -368,12 +396,12 @@ public:
     */
     virtual void report(int iValue)
     {
-        TC_LockT<TC_ThreadMutex> lock(*this);
+        //各策略自己保证线程安全, 不加锁
         report(iValue, TL::Int2Type<TL::Length<TList>::value-1>());
     }
 
     /**
-     * 获取属性信息
+     * 获取属性信息(取出后清零)
      *
      * @return vector<pair<string, string>>
      */
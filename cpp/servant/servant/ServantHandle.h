@@ -21,8 +21,10 @@
 #include <string>
 #include <memory>
 #include <deque>
+#include <vector>
 #include "util/tc_monitor.h"
 #include "util/tc_epoll_server.h"
+#include "util/tc_arena.h"
 #include "servant/Servant.h"
 #include "servant/StatReport.h"
 #include <ucontext.h>
@@ -43,6 +45,7 @@ public:
     enum
     {
         HEART_BEAT_INTERVAL = 10, /**心跳间隔时间**/
+        MAX_FREE_ARENA      = 64  /**缓存的空闲arena个数**/
     };
 
     /**
@@ -65,6 +68,19 @@ public:
      */
     CoroutineScheduler* getCoroSched() { return _coroSched; }
 
+    /**
+     * 取一个请求级的内存池, 优先复用空闲的
+     * TarsCurrent可能在其他线程(异步回包)析构, 所以加锁
+     * @return TC_Arena*
+     */
+    TC_Arena *allocArena();
+
+    /**
+     * 归还内存池, reset后放回空闲列表, 超过MAX_FREE_ARENA个直接释放
+     * @param arena
+     */
+    void releaseArena(TC_Arena *arena);
+
 protected:
 
     /**
@@ -194,6 +210,13 @@ protected:
      * 协程调度器
      */
     CoroutineScheduler     *_coroSched;
+
+    /**
+     * 空闲的请求级内存池
+     */
+    TC_ThreadMutex          _arenaMutex;
+
+    vector<TC_Arena*>       _freeArenas;
 };
 
 typedef TC_AutoPtr<ServantHandle> ServantHandlePtr;
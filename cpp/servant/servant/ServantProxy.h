@@ -349,6 +349,8 @@ public:
 
     static string TARS_MASTER_KEY; //透传主调名称信息
 
+    static string STATUS_PACKED_KEY; //调用方接受packed编码的数值列表
+
     /**
      * 缺省的同步调用超时时间
      * 超时后不保证消息不会被服务端处理
@@ -447,6 +449,20 @@ public:
      */
     void tars_connect_timeout(int conTimeout);
 
+    /**
+     * 请求中的数值列表是否用packed编码(tars2cpp --packed生成的接口有效)
+     * 对端的服务端代码也需要用--packed生成才能解码, 所以默认关闭, 由调用方确认后打开;
+     * 响应是否packed由服务端根据请求里的STATUS_PACKED_KEY决定, 和这里无关
+     * @param bPacked
+     */
+    void tars_packed(bool bPacked) { _packed = bPacked; }
+
+    /**
+     * 请求是否用packed编码
+     * @return bool
+     */
+    bool tars_packed() const { return _packed; }
+
     /**
      * 获取所属的Object名称
      * @return string
@@ -649,6 +665,11 @@ private:
      */
     bool                    _masterFlag;
 
+    /**
+     * 请求是否用packed编码
+     */
+    bool                    _packed;
+
     /**
      *每个业务线程与每个客户端网络线程之间通信的请求队列大小
      */
@@ -61,6 +61,134 @@ struct StatSampleMsgHead
     }
 };
 
+/////////////////////////////////////////////////////////////////////////
+/**
+ * 预先生成好上报头的模块间调用统计项.
+ *
+ * 上报头只在创建时生成一次, 每次调用只用原子操作更新计数和耗时分布,
+ * 计数按线程分到不同的槽里避免多个线程争用同一个cache line;
+ * StatReport线程上报时才取出合并成StatMicMsgBody.
+ */
+class StatCounter : public TC_HandleBase
+{
+public:
+    enum
+    {
+        MAX_SLOT        = 16,       //计数的槽数, 线程按序号取模
+        MAX_INTERV      = 16,       //耗时分布的最大描点数
+        HIST_SUB_BITS   = 5,        //高精度分布每个2的幂区间分16个桶, 相对误差不超过1/16
+        HIST_BUCKETS    = 448       //最大到2^31微秒, 更大的计入最后一个桶
+    };
+
+    /**
+     * 构造
+     * @param head        上报头
+     * @param bFromClient 主调上报
+     * @param timePoint   耗时分布的描点(已排序), 超过MAX_INTERV的忽略
+     * @param bHist       是否统计微秒级的高精度耗时分布(StatMicMsgBody::histCount)
+     */
+    StatCounter(const StatMicMsgHead& head, bool bFromClient, const vector<int>& timePoint, bool bHist = false);
+
+    ~StatCounter();
+
+    /**
+     * 按cache line对齐分配, 普通的new不保证Slot的aligned(64)
+     */
+    static void *operator new(size_t size);
+
+    static void operator delete(void *p);
+
+    /**
+     * 一次调用
+     * @param eResult   成功0, 超时1, 异常2(StatReport::StatResult)
+     * @param iSptime   耗时(毫秒)
+     * @param iSptimeUs 耗时(微秒), 小于0时按iSptime计入高精度分布
+     */
+    void report(int eResult, int iSptime, int64_t iSptimeUs = -1);
+
+    /**
+     * 微秒耗时对应的高精度分布桶下标
+     * @param us
+     * @return int 0 ~ HIST_BUCKETS-1
+     */
+    static int getHistIndex(int64_t us)
+    {
+        if(us < (1 << HIST_SUB_BITS))
+        {
+            return us < 0 ? 0 : (int)us;
+        }
+
+        int shift = 63 - __builtin_clzll((uint64_t)us) - (HIST_SUB_BITS - 1);
+        int index = shift * (1 << (HIST_SUB_BITS - 1)) + (int)(us >> shift);
+
+        return index < HIST_BUCKETS ? index : HIST_BUCKETS - 1;
+    }
+
+    /**
+     * 高精度分布桶的上界(桶内最大的微秒值), 算分位数用
+     * @param index
+     * @return int64_t
+     */
+    static int64_t getHistValue(int index)
+    {
+        if(index < (1 << HIST_SUB_BITS))
+        {
+            return index < 0 ? 0 : index;
+        }
+
+        int shift = index / (1 << (HIST_SUB_BITS - 1)) - 1;
+        int64_t m = index % (1 << (HIST_SUB_BITS - 1)) + (1 << (HIST_SUB_BITS - 1));
+
+        return ((m + 1) << shift) - 1;
+    }
+
+    /**
+     * 按高精度分布求分位数
+     * @param histCount 按桶下标展开的调用量, HIST_BUCKETS个
+     * @param fPercent  0~1, 比如0.99
+     * @return int64_t  微秒, 没有数据返回0
+     */
+    static int64_t getPercentile(const int64_t *histCount, double fPercent);
+
+    /**
+     * 取出计数并清零
+     * @param body 输出
+     * @return 有数据返回true
+     */
+    bool get(StatMicMsgBody& body);
+
+    const StatMicMsgHead& getHead() const { return _head; }
+
+    bool isFromClient() const { return _fromClient; }
+
+protected:
+    struct Slot
+    {
+        int64_t     totalRspTime;
+        int         count;
+        int         timeoutCount;
+        int         execCount;
+        int         maxRspTime;
+        int         minRspTime;     //0表示没有
+        int         intervalCount[MAX_INTERV];
+        int         *histCount;     //第一次用到时才分配, HIST_BUCKETS个
+    } __attribute__((aligned(64)));
+
+    StatMicMsgHead  _head;
+
+    bool            _fromClient;
+
+    bool            _hist;
+
+    int             _timePoint[MAX_INTERV];
+
+    size_t          _timePointNum;
+
+    Slot            _slot[MAX_SLOT];
+};
+
+typedef TC_AutoPtr<StatCounter> StatCounterPtr;
+
 /////////////////////////////////////////////////////////////////////////
 /**
  * 状态上报类, 上报的信息包括:
@@ -73,7 +201,6 @@ public:
     typedef  map<StatMicMsgHead, StatMicMsgBody>        MapStatMicMsg;
     typedef  map<StatPropMsgHead, StatPropMsgBody>      MapStatPropMsg;
     typedef  multimap<StatSampleMsgHead,StatSampleMsg>  MMapStatSampleMsg;
-    typedef  TC_LoopQueue<MapStatMicMsg*>                 stat_queue;
 
     const static int MAX_MASTER_NAME_LEN   = 127;
     const static int MAX_MASTER_IP_LEN     = 20;
@@ -81,7 +208,6 @@ public:
     const static int MIN_REPORT_SIZE       = 500;     //上报的最小大小限制
     const static int STAT_PROTOCOL_LEN     = 100;     //一次stat mic上报纯协议部分占用大小，用来控制udp大小防止超MTU
     const static int PROPERTY_PROTOCOL_LEN = 50;      //一次property上纯报协议部分占用大小，用来控制udp大小防止超MTU
-    const static int MAX_STAT_QUEUE_SIZE   = 10000;   //上报队列缓存大小限制
     
     enum StatResult
     {
@@ -93,7 +219,7 @@ public:
     /**
      * 构造函数
      */
-    StatReport(size_t iEpollNum=0);
+    StatReport();
 
     /**
      * 析够函数
@@ -135,7 +261,7 @@ public:
      * @param iSptime,耗时
      * @param iReturnValue,返回值
      * @param bFromClient,从客户端采集 false从服务端采集
-     * @param sContainer, 设置上报的容器名
+     * @param iSptimeUs,耗时(微秒), 开启高精度分布时使用, 小于0时按iSptime计
      * 。
      */
     void report(const string& strModuleName,
@@ -146,7 +272,8 @@ public:
                 StatResult eResult,
                 int  iSptime,
                 int  iReturnValue = 0,
-                bool bFromClient = true);
+                bool bFromClient = true,
+                int64_t iSptimeUs = -1);
 
      /**
      * 设置模块间调用数据
@@ -159,6 +286,7 @@ public:
      * @param eResult           成功STAT_SUCC，超时 STAT_TIMEOUT，异常STAT_EXC.
      * @param iSptime           耗时(单位毫秒)
      * @param iReturnValue      返回值
+     * @param iSptimeUs         耗时(单位微秒), 小于0时按iSptime计
      */
     void report(const string& strMasterName,
                 const string& strMasterIp,
@@ -168,7 +296,8 @@ public:
                 const string& strInterfaceName,
                 StatResult eResult,
                 int  iSptime,
-                int  iReturnValue = 0);
+                int  iReturnValue = 0,
+                int64_t iSptimeUs = -1);
 
     /**
      * 根据名字获取属性上报对象
@@ -195,7 +324,7 @@ public:
      * @return PropertyReportPtr
      */
     template<typename T1>
-    PropertyReportPtr createPropertyReport(const string& strProperty, T1 t1)
+    PropertyReportPtr createPropertyReport(const string& strProperty, const T1& t1)
     {
         Lock lock(*this);
 
@@ -220,7 +349,7 @@ public:
      * @return PropertyReportPtr
      */
     template<typename T1, typename T2>
-    PropertyReportPtr createPropertyReport(const string& strProperty, T1 t1, T2 t2)
+    PropertyReportPtr createPropertyReport(const string& strProperty, const T1& t1, const T2& t2)
     {
         Lock lock(*this);
 
@@ -245,7 +374,7 @@ public:
      * @return PropertyReportPtr
      */
     template<typename T1, typename T2, typename T3>
-    PropertyReportPtr createPropertyReport(const string& strProperty, T1 t1, T2 t2, T3 t3)
+    PropertyReportPtr createPropertyReport(const string& strProperty, const T1& t1, const T2& t2, const T3& t3)
     {
         Lock lock(*this);
 
@@ -271,7 +400,7 @@ public:
      * @return PropertyReportPtr
      */
     template<typename T1, typename T2, typename T3, typename T4>
-    PropertyReportPtr createPropertyReport(const string& strProperty, T1 t1, T2 t2, T3 t3, T4 t4)
+    PropertyReportPtr createPropertyReport(const string& strProperty, const T1& t1, const T2& t2, const T3& t3, const T4& t4)
     {
         Lock lock(*this);
 
@@ -298,7 +427,7 @@ public:
      * @return PropertyReportPtr
      */
     template<typename T1, typename T2, typename T3, typename T4, typename T5>
-    PropertyReportPtr createPropertyReport(const string& strProperty, T1 t1, T2 t2, T3 t3, T4 t4, T5 t5)
+    PropertyReportPtr createPropertyReport(const string& strProperty, const T1& t1, const T2& t2, const T3& t3, const T4& t4, const T5& t5)
     {
         Lock lock(*this);
 
@@ -326,7 +455,7 @@ public:
      * @return PropertyReportPtr
      */
     template<typename T1, typename T2, typename T3, typename T4, typename T5, typename T6>
-    PropertyReportPtr createPropertyReport(const string& strProperty, T1 t1, T2 t2, T3 t3, T4 t4, T5 t5, T6 t6)
+    PropertyReportPtr createPropertyReport(const string& strProperty, const T1& t1, const T2& t2, const T3& t3, const T4& t4, const T5& t5, const T6& t6)
     {
         Lock lock(*this);
 
@@ -355,7 +484,7 @@ public:
      * @return PropertyReportPtr
      */
     template<typename T1, typename T2, typename T3, typename T4, typename T5, typename T6, typename T7>
-    PropertyReportPtr createPropertyReport(const string& strProperty, T1 t1, T2 t2, T3 t3, T4 t4, T5 t5, T6 t6, T7 t7)
+    PropertyReportPtr createPropertyReport(const string& strProperty, const T1& t1, const T2& t2, const T3& t3, const T4& t4, const T5& t5, const T6& t6, const T7& t7)
     {
         Lock lock(*this);
 
@@ -385,7 +514,7 @@ public:
      * @return PropertyReportPtr
      */
     template<typename T1, typename T2, typename T3, typename T4, typename T5, typename T6, typename T7, typename T8>
-    PropertyReportPtr createPropertyReport(const string& strProperty, T1 t1, T2 t2, T3 t3, T4 t4, T5 t5, T6 t6, T7 t7, T8 t8)
+    PropertyReportPtr createPropertyReport(const string& strProperty, const T1& t1, const T2& t2, const T3& t3, const T4& t4, const T5& t5, const T6& t6, const T7& t7, const T8& t8)
     {
         Lock lock(*this);
 
@@ -416,7 +545,7 @@ public:
      * @return PropertyReportPtr
      */
     template<typename T1, typename T2, typename T3, typename T4, typename T5, typename T6, typename T7, typename T8, typename T9>
-    PropertyReportPtr createPropertyReport(const string& strProperty, T1 t1, T2 t2, T3 t3, T4 t4, T5 t5, T6 t6, T7 t7, T8 t8, T9 t9)
+    PropertyReportPtr createPropertyReport(const string& strProperty, const T1& t1, const T2& t2, const T3& t3, const T4& t4, const T5& t5, const T6& t6, const T7& t7, const T8& t8, const T9& t9)
     {
         Lock lock(*this);
 
@@ -449,7 +578,7 @@ public:
      * @return PropertyReportPtr
      */
     template<typename T1, typename T2, typename T3, typename T4, typename T5, typename T6, typename T7, typename T8, typename T9, typename T10>
-    PropertyReportPtr createPropertyReport(const string& strProperty, T1 t1, T2 t2, T3 t3, T4 t4, T5 t5, T6 t6, T7 t7, T8 t8, T9 t9, T10 t10)
+    PropertyReportPtr createPropertyReport(const string& strProperty, const T1& t1, const T2& t2, const T3& t3, const T4& t4, const T5& t5, const T6& t6, const T7& t7, const T8& t8, const T9& t9, const T10& t10)
     {
         Lock lock(*this);
 
@@ -467,7 +596,21 @@ public:
 
 
 public:
-    void report(size_t iSeq,MapStatMicMsg * pmStatMicMsg);
+    /**
+     * 获取(没有则生成)上报头对应的统计项, 调用方缓存起来, 每次调用只需要StatCounter::report
+     * @param head        上报头
+     * @param bFromClient 主调上报
+     *
+     * @return StatCounterPtr
+     */
+    StatCounterPtr getStatCounter(const StatMicMsgHead& head, bool bFromClient);
+
+    /**
+     * 是否上报微秒级的高精度耗时分布(StatMicMsgBody::histCount), 默认不上报.
+     * 只对之后生成的统计项生效, 需要在发起调用前设置
+     * @param bEnable
+     */
+    void setHistogram(bool bEnable) { _hist = bEnable; }
 
 public:
 
@@ -540,15 +683,6 @@ public:
 
 private:
 
-    /**
-     *
-     * @param head
-     * @param body
-     * @param msg
-     * @param bFromClient
-     */
-    void submit(StatMicMsgHead& head, StatMicMsgBody& body, bool bFromClient);
-
     /**
      * 上报模块间调用信息  Mic = module interval call
      * @param msg
@@ -574,9 +708,35 @@ private:
      */
     int reportSampleMsg();
 
+    /**
+     * 取出所有StatCounter的计数合并到_statMicMsgClient/_statMicMsgServer,
+     * 没有数据且只有这里引用的统计项删掉
+     */
+    void collectStatCounter();
 
-    //合并两个MicMsg
-    void addMicMsg(MapStatMicMsg & old,MapStatMicMsg & add);
+    /**
+     * report(string...)用的线程缓存, 没有则生成上报头并获取统计项
+     */
+    StatCounter* getCachedCounter(const string& strModuleName,
+                                  const string& setdivision,
+                                  const string& strInterfaceName,
+                                  const string& strModuleIp,
+                                  uint16_t iPort,
+                                  int  iReturnValue,
+                                  bool bFromClient);
+
+    StatCounter* getCachedCounter(const string& strMasterName,
+                                  const string& strMasterIp,
+                                  const string& strSlaveName,
+                                  const string& strSlaveIp,
+                                  uint16_t iSlavePort,
+                                  const string& strInterfaceName,
+                                  int  iReturnValue);
+
+    /**
+     * 合并一条统计
+     */
+    static void mergeBody(const StatMicMsgBody& inBody, StatMicMsgBody& outBody);
 
 private:
     time_t              _time;
@@ -617,10 +777,24 @@ private:
 
     map<string, PropertyReportPtr>          _statPropMsg;
 
-private:
+    /**
+     * 预先生成的统计项
+     */
+    map<StatMicMsgHead, StatCounterPtr>     _statCounterClient;
 
-    size_t _epollNum;
-    vector<stat_queue*>   _statMsg;
+    map<StatMicMsgHead, StatCounterPtr>     _statCounterServer;
+
+    /**
+     * 区分不同的StatReport对象(线程缓存的key)
+     */
+    size_t                                  _id;
+
+    /**
+     * 是否统计高精度耗时分布
+     */
+    bool                                    _hist;
+
+private:
 
     size_t                _retValueNumLimit;    
 
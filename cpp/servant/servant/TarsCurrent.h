@@ -18,6 +18,7 @@
 #define __TARS_CURRENT_H_
 
 #include "util/tc_epoll_server.h"
+#include "util/tc_arena.h"
 #include "tup/RequestF.h"
 #include "servant/BaseF.h"
 
@@ -90,8 +91,10 @@ public:
 
     /**
      * 设置是否自动回响应包
+     * 设置为false(异步回包)时, 请求数据和context/status都拷贝出来, 不再引用接收缓冲区,
+     * 要在把current交给其他线程之前调用
      */
-    void setResponse(bool value) { _response = value; }
+    void setResponse(bool value);
 
     /**
      * 设置返回的context(仅TARS协议有效)
@@ -125,6 +128,25 @@ public:
      */
     const vector<char> &getRequestBuffer() const;
 
+    /**
+     * 获取请求buffer的数据, 不拷贝(TARS协议时引用接收缓冲区)
+     * @return const char*
+     */
+    const char *getRequestData() const;
+
+    /**
+     * 获取请求buffer的长度
+     * @return size_t
+     */
+    size_t getRequestLength() const;
+
+    /**
+     * 获取请求级的内存池, 第一次调用时从ServantHandle的池中取,
+     * TarsCurrent析构时归还; tars2cpp --arena生成的代码用它解码请求参数
+     * @return TC_Arena*, 没有ServantHandle时为NULL
+     */
+    TC_Arena *getArena();
+
     /**
      * 获取服务Servant名称
      * @return string
@@ -139,22 +161,28 @@ public:
     short getRequestVersion() const;
 
     /**
-     * 扩展map(仅TARS协议有效)
+     * 扩展map(仅TARS协议有效), 第一次访问时才解码
      * @return map<string,string>&
      */
     map<string, string>& getContext();
 
     /**
-     * 获取保存状态信息，比如染色等(仅TARS协议有效)
+     * 获取保存状态信息，比如染色等(仅TARS协议有效), 第一次访问时才解码
      * @return map<string,string>&
      */
     const map<string, string>& getRequestStatus() const;
 
+    /**
+     * 调用方是否接受packed编码的数值列表(仅TARS协议有效)
+     * @return bool
+     */
+    bool isPackedAccepted() const;
+
     /**
      * 函数名称(仅TARS协议有效)
-     * @return string
+     * @return const string&
      */
-    string getFuncName() const;
+    const string &getFuncName() const;
 
     /**
      * 请求ID(仅TARS协议有效)
@@ -232,6 +260,31 @@ protected:
      */
     void initialize(const string &sRecvBuffer);
 
+    /**
+     * 初始化
+     * @param data
+     * @param len
+     */
+    void initialize(const char *data, size_t len);
+
+    /**
+     * 初始化, 只解码头部的字段, sBuffer引用接收缓冲区,
+     * context/status第一次访问时再解码
+     * @param slice
+     */
+    void initialize(const TC_SharedSlice &slice);
+
+    /**
+     * 解码context/status, 多个线程同时访问时只解码一次
+     */
+    void decodeLazy() const;
+
+    /**
+     * 把请求数据和context/status拷贝出来, 不再引用接收缓冲区;
+     * 在业务线程(setResponse(false))中调用, 这时current还没有交给其他线程
+     */
+    void releaseRecvSlice();
+
     /**
      * 服务端上报状态，针对单向调用及TUP调用(仅对TARS协议有效)
      */
@@ -269,9 +322,46 @@ protected:
     int                        _fd;
 
     /**
-     * 客户端请求包
+     * 客户端请求包, TARS协议时sBuffer/context/status按需解码,
+     * const接口中也会填充
+     */
+    mutable RequestPacket    _request;
+
+    /**
+     * 引用的接收缓冲区, 业务处理期间请求数据直接指向其中;
+     * 处理完后如果current还被持有, 由releaseRecvSlice()释放
+     */
+    TC_SharedSlice          _recvSlice;
+
+    /**
+     * 请求buffer的位置
+     */
+    const char *            _requestData;
+
+    /**
+     * 请求buffer的长度
+     */
+    size_t                  _requestLen;
+
+    /**
+     * context/status在_recvSlice中的位置, 0表示已经解码
+     */
+    mutable volatile size_t _lazyPos;
+
+    /**
+     * sBuffer是否已经有请求数据
+     */
+    mutable volatile bool   _bufferCopied;
+
+    /**
+     * 按需解码/拷贝的锁, current交给其他线程后可能同时访问
      */
-    RequestPacket            _request;
+    mutable TC_ThreadMutex  _lazyMutex;
+
+    /**
+     * 请求级的内存池, 按需从ServantHandle取
+     */
+    TC_Arena *              _arena;
 
     /**
      * 响应
@@ -283,6 +373,11 @@ protected:
      */
     int64_t                _begintime;
 
+    /**
+     * 收到请求时间(微秒)
+     */
+    int64_t                _beginUs;
+
     /**
      * 接口处理的返回值
      */
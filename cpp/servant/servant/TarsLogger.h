@@ -241,6 +241,26 @@ protected:
      */
     void sync2remote(const vector<string> &buffer);
 
+    /**
+     * 按条同步到远程, 每次最多2000条
+     */
+    void sync2remoteLines(deque<pair<int, string> >::const_iterator begin, deque<pair<int, string> >::const_iterator end);
+
+    /**
+     * 按块压缩后同步到远程, LogServer不支持时改回sync2remoteLines
+     */
+    void sync2remoteBlock(const deque<pair<int, string> > &buffer);
+
+    /**
+     * 压缩[begin, end)的日志, 发送一块
+     */
+    void sendBlock(const string &raw, deque<pair<int, string> >::const_iterator begin, deque<pair<int, string> >::const_iterator end);
+
+    /**
+     * 远程日志的信息
+     */
+    void getLogInfo(LogInfo &stInfo);
+
     /**
      * 染色日志同步到远程
      */
@@ -252,6 +272,10 @@ protected:
      */
     TimeWriteT          *_timeWrite;
 
+    /**
+     * LogServer不支持按块发送, 本进程所有远程日志都改回按条发送
+     */
+    static volatile bool _blockUnsupported;
 };
 
 ////////////////////////////////////////////////////////////////////////////
@@ -346,6 +370,12 @@ public:
      */
     void setFormat(const string &sFormat)   { _format = sFormat;}
 
+    /**
+     * 设置远程日志的压缩方式(LogCompress), 不是LOG_COMPRESS_NONE时按块压缩后发送
+     * @param iCompress
+     */
+    void setCompress(int iCompress)         { _compress = iCompress;}
+
     /**
      * 具体调用
      * @param of
@@ -495,6 +525,11 @@ protected:
      * 对于远程日志，上报同步到logser的失败量，默认不上报
      */
      PropertyReportPtr   _reportFailPtr;
+
+     /*
+     * 远程日志的压缩方式, LogServer不支持时见RemoteTimeWriteT::_blockUnsupported
+     */
+     int                 _compress;
 }; 
 
 ////////////////////////////////////////////////////////////////////////////
@@ -648,6 +683,12 @@ public:
      * @param bEnable
      */
     void enableRemoteLog(bool bEnable) {_remote = bEnable;}
+
+    /**
+     * @brief 远程日志的压缩方式(LogCompress),影响之后创建的日志文件
+     * @param iCompress
+     */
+    void setCompress(int iCompress) {_compress = iCompress;}
 protected:
 
     /**
@@ -746,6 +787,11 @@ protected:
     * 服务日志上报logser是否上报成功数量
     */
     bool                     _logStatReport;
+
+    /*
+    * 远程日志的压缩方式
+    */
+    int                      _compress;
 };
 
 /**
@@ -855,6 +901,23 @@ protected:
 #define TLOGWARN(msg...)    LOGMSG(TarsRollLogger::WARN_LOG,msg)
 #define TLOGERROR(msg...)   LOGMSG(TarsRollLogger::ERROR_LOG,msg)
 
+/**
+ * @brief 按级别循环日志, 只记录参数的值, 格式化推迟到写日志线程
+ *
+ * @fmt 格式串, 其中的{}依次替换成后面的参数, 结尾自动换行; 默认拷贝进记录,
+ *      用TC_LOGFMT("...")包起来的字符串常量只记地址
+ *
+ * @用法:
+ *       框架宏方式:     TLOGINFOF("I have {} apples from {}", vApple.size(), sFrom);
+ *       不拷贝格式串:   TLOGINFOF(TC_LOGFMT("I have {} apples"), vApple.size());
+ */
+#define LOGMSGF(level,fmt,args...) do{ if(LOG->IsNeedLog(level)) (LOG->logf(level,fmt),##args);}while(0)
+
+#define TLOGINFOF(fmt,args...)    LOGMSGF(TarsRollLogger::INFO_LOG,fmt,##args)
+#define TLOGDEBUGF(fmt,args...)   LOGMSGF(TarsRollLogger::DEBUG_LOG,fmt,##args)
+#define TLOGWARNF(fmt,args...)    LOGMSGF(TarsRollLogger::WARN_LOG,fmt,##args)
+#define TLOGERRORF(fmt,args...)   LOGMSGF(TarsRollLogger::ERROR_LOG,fmt,##args)
+
 /**
  * 按天日志
  */
@@ -862,6 +925,12 @@ protected:
 #define FDLOG(x)        (TarsTimeLogger::getInstance()->logger(x)->any())
 #define FFDLOG(x,y,z)   (TarsTimeLogger::getInstance()->logger(x,y,z)->any())
 
+/**
+ * 按天日志, 格式化推迟到写日志线程, 用法同TLOGINFOF
+ */
+#define DLOGF(fmt,args...)      do{ (TarsTimeLogger::getInstance()->logger()->anyf(fmt),##args);}while(0)
+#define FDLOGF(x,fmt,args...)   do{ (TarsTimeLogger::getInstance()->logger(x)->anyf(fmt),##args);}while(0)
+
 /**
  *  按天日志局部使能开关，针对单个日志文件进行使能，请在所有按天日志输出前调用
  */
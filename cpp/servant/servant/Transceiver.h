@@ -23,6 +23,8 @@
 #include "servant/Auth.h"
 #include "util/tc_buffer.h"
 #include <list>
+#include <vector>
+#include <sys/uio.h>
 
 using namespace std;
 
@@ -116,6 +118,15 @@ public:
      */
     int sendRequest(const char * pData,size_t iSize, bool forceSend = false);
 
+    /*
+     * 批量发送请求, 只调用一次writev
+     * 最后一个只发送了一部分的请求, 剩下的写入buffer, 返回eRetFull
+     * @param vecs 每个请求一个iovec
+     * @param iNum [out] 已经发送(包括写入buffer)的请求个数
+     * @return int
+     */
+    int sendRequest(const vector<iovec> &vecs, size_t &iNum);
+
     /*
      * 处理请求，判断Send BufferCache是否有完整的包
      * @return int
@@ -138,6 +149,14 @@ public:
      */
     virtual int send(const void* buf, uint32_t len, uint32_t flag) = 0;
 
+    /*
+     * 网络批量发送接口, 缺省逐个调用send
+     * @param vecs
+     * @param count
+     * @return int
+     */
+    virtual int writev(const struct iovec* vecs, int32_t count);
+
     /*
      * 网络接收接口
      * @param buf
@@ -181,6 +200,22 @@ public:
         return _adapterProxy;
     }
 
+    /*
+     * 在adapter中是第几个连接
+     */
+    size_t getConnIndex() const
+    {
+        return _connIndex;
+    }
+
+    /*
+     * 设置在adapter中是第几个连接
+     */
+    void setConnIndex(size_t index)
+    {
+        _connIndex = index;
+    }
+
     /*
      * 判断是否已经连接到服务端
      */
@@ -236,6 +271,11 @@ protected:
      */
     AdapterProxy *           _adapterProxy;
 
+    /*
+     * 在adapter中是第几个连接
+     */
+    size_t                   _connIndex;
+
     /*
      * 连接的节点信息
      */
@@ -324,6 +364,15 @@ public:
      * @return int
      */
     int readv(const struct iovec*, int32_t count);
+
+    /**
+     * TCP 批量发送实现
+     * @param iovec
+     * @param count
+     *
+     * @return int
+     */
+    virtual int writev(const struct iovec* vecs, int32_t count);
     /**
      * 处理返回，判断接收是否有完整的包
      * @param done
@@ -397,6 +397,44 @@ namespace tars
         TarsNotEnoughBuff(const std::string & s) : TarsProtoException(s) {}
     };
 
+//////////////////////////////////////////////////////////////////
+    /**
+     * packed编码的数值列表: SimpleList头 + 元素类型头(tag 0) + 元素个数 + 定长网络序数组
+     * 只有下面这些元素类型可以packed, Char的SimpleList是原有格式
+     */
+    template<typename T> struct TarsPackedHead;
+    template<> struct TarsPackedHead<Short>  { enum { type = TarsHeadeShort }; };
+    template<> struct TarsPackedHead<Int32>  { enum { type = TarsHeadeInt32 }; };
+    template<> struct TarsPackedHead<Int64>  { enum { type = TarsHeadeInt64 }; };
+    template<> struct TarsPackedHead<Float>  { enum { type = TarsHeadeFloat }; };
+    template<> struct TarsPackedHead<Double> { enum { type = TarsHeadeDouble }; };
+
+    /**
+     * packed数组的元素类型能否读到T的数组里, 和逐个元素读取时允许的扩展一致:
+     * short -> int/long, int -> long, float -> double
+     */
+    template<typename T> inline bool tarsPackedWiden(uint8_t type) { return false; }
+    template<> inline bool tarsPackedWiden<Int32>(uint8_t type)  { return type == TarsHeadeShort; }
+    template<> inline bool tarsPackedWiden<Int64>(uint8_t type)  { return type == TarsHeadeShort || type == TarsHeadeInt32; }
+    template<> inline bool tarsPackedWiden<Double>(uint8_t type) { return type == TarsHeadeFloat; }
+
+    /**
+     * SimpleList中元素类型对应的宽度, 不支持的类型返回0
+     */
+    inline size_t tarsPackedWidth(uint8_t type)
+    {
+        switch (type)
+        {
+        case TarsHeadeChar:     return sizeof(Char);
+        case TarsHeadeShort:    return sizeof(Short);
+        case TarsHeadeInt32:    return sizeof(Int32);
+        case TarsHeadeInt64:    return sizeof(Int64);
+        case TarsHeadeFloat:    return sizeof(Float);
+        case TarsHeadeDouble:   return sizeof(Double);
+        default:                return 0;
+        }
+    }
+
 //////////////////////////////////////////////////////////////////
     namespace
     {
@@ -777,6 +815,15 @@ namespace tars
             std::swap(_len, buf._len);
             std::swap(_reverse, buf._reverse);
         }
+        /// 交出缓冲区(new[]分配, 由调用者delete[]), 之后写入器为空
+        char * detach()
+        {
+            char * p = _buf;
+            _buf = NULL;
+            _len = 0;
+            _buf_len = 0;
+            return p;
+        }
     };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -963,15 +1010,16 @@ namespace tars
                 {
                     uint8_t headType = 0, headTag = 0;
                     readFromHead(*this, headType, headTag);
-                    if (tars_unlikely(headType != TarsHeadeChar))
+                    size_t width = tarsPackedWidth(headType);
+                    if (tars_unlikely(width == 0))
                     {
                         char s[64];
                         snprintf(s, sizeof(s), "skipField with invalid type, type value: %d, %d, %d.", type, headType, headTag);
                         throw TarsDecodeMismatch(s);
                     }
-                    Int32 size = 0;
+                    UInt32 size = 0;
                     read(size, 0);
-                    TarsReadHeadSkip(*this, size);
+                    TarsReadHeadSkip(*this, (size_t)size * width);
                 }
                 break;
             case TarsHeadeStructBegin:
@@ -1590,6 +1638,138 @@ namespace tars
             }
         }
 
+        /// 数值列表, 逐个元素编码和packed编码都可以读
+        template<typename Alloc>
+        void read(std::vector<Short, Alloc>& v, uint8_t tag, bool isRequire = true)
+        {
+            readNumList(v, tag, isRequire);
+        }
+
+        template<typename Alloc>
+        void read(std::vector<Int32, Alloc>& v, uint8_t tag, bool isRequire = true)
+        {
+            readNumList(v, tag, isRequire);
+        }
+
+        template<typename Alloc>
+        void read(std::vector<Int64, Alloc>& v, uint8_t tag, bool isRequire = true)
+        {
+            readNumList(v, tag, isRequire);
+        }
+
+        template<typename Alloc>
+        void read(std::vector<Float, Alloc>& v, uint8_t tag, bool isRequire = true)
+        {
+            readNumList(v, tag, isRequire);
+        }
+
+        template<typename Alloc>
+        void read(std::vector<Double, Alloc>& v, uint8_t tag, bool isRequire = true)
+        {
+            readNumList(v, tag, isRequire);
+        }
+
+        template<typename T, typename Alloc>
+        void readNumList(std::vector<T, Alloc>& v, uint8_t tag, bool isRequire)
+        {
+            uint8_t headType = 0, headTag = 0;
+            bool skipFlag = false;
+            TarsSkipToTag(skipFlag, tag, headType, headTag);
+            if (tars_likely(skipFlag))
+            {
+                switch(headType)
+                {
+                case TarsHeadeSimpleList:
+                    {
+                        uint8_t hheadType, hheadTag;
+                        readFromHead(*this, hheadType, hheadTag);
+                        if (tars_unlikely(hheadType != TarsPackedHead<T>::type))
+                        {
+                            if (tars_unlikely(!tarsPackedWiden<T>(hheadType)))
+                            {
+                                char s[128];
+                                snprintf(s, sizeof(s), "type mismatch, tag: %d, type: %d, %d, %d", tag, headType, hheadType, hheadTag);
+                                throw TarsDecodeMismatch(s);
+                            }
+
+                            switch (hheadType)
+                            {
+                            case TarsHeadeShort:    readPackedAs<Short>(v, tag);    break;
+                            case TarsHeadeInt32:    readPackedAs<Int32>(v, tag);    break;
+                            default:                readPackedAs<Float>(v, tag);    break;
+                            }
+                            break;
+                        }
+                        UInt32 size = 0;
+                        read(size, 0);
+                        if (tars_unlikely((size_t)size * sizeof(T) > this->_buf_len - this->_cur))
+                        {
+                            char s[128];
+                            snprintf(s, sizeof(s), "invalid size, tag: %d, type: %d, %d, size: %d", tag, headType, hheadType, size);
+                            throw TarsDecodeInvalidValue(s);
+                        }
+                        v.resize(size);
+                        if (size > 0)
+                        {
+                            tars_packed_copy<T>((char *)&v[0], this->_buf + this->_cur, size);
+                            TarsReadHeadSkip(*this, (size_t)size * sizeof(T));
+                        }
+                    }
+                    break;
+                case TarsHeadeList:
+                    {
+                        UInt32 size = 0;
+                        read(size, 0);
+                        if (tars_unlikely(size > this->size()))
+                        {
+                            char s[128];
+                            snprintf(s, sizeof(s), "invalid size, tag: %d, type: %d, size: %d", tag, headType, size);
+                            throw TarsDecodeInvalidValue(s);
+                        }
+                        v.reserve(size);
+                        v.resize(size);
+                        for (UInt32 i = 0; i < size; ++i)
+                            read(v[i], 0);
+                    }
+                    break;
+                default:
+                    {
+                        char s[64];
+                        snprintf(s, sizeof(s), "read 'vector' type mismatch, tag: %d, get type: %d.", tag, headType);
+                        throw TarsDecodeMismatch(s);
+                    }
+                }
+            }
+            else if (tars_unlikely(isRequire))
+            {
+                char s[64];
+                snprintf(s, sizeof(s), "require field not exist, tag: %d, headTag: %d", tag, headTag);
+                throw TarsDecodeRequireNotExist(s);
+            }
+        }
+
+        /// packed数组的元素比T窄, 逐个转换
+        template<typename From, typename T, typename Alloc>
+        void readPackedAs(std::vector<T, Alloc>& v, uint8_t tag)
+        {
+            UInt32 size = 0;
+            read(size, 0);
+            if (tars_unlikely((size_t)size * sizeof(From) > this->_buf_len - this->_cur))
+            {
+                char s[128];
+                snprintf(s, sizeof(s), "invalid size, tag: %d, type: %d, size: %d", tag, TarsHeadeSimpleList, size);
+                throw TarsDecodeInvalidValue(s);
+            }
+            v.resize(size);
+            for (UInt32 i = 0; i < size; ++i)
+            {
+                From n;
+                tars_packed_copy<From>((char *)&n, this->_buf + this->_cur + (size_t)i * sizeof(From), 1);
+                v[i] = n;
+            }
+            TarsReadHeadSkip(*this, (size_t)size * sizeof(From));
+        }
+
         /// 读取结构数组
         template<typename T>
         void read(T* v, const UInt32 len, UInt32 & readLen, uint8_t tag, bool isRequire = true)
@@ -1672,6 +1852,16 @@ namespace tars
     class TarsOutputStream : public WriterT
     {
     public:
+        TarsOutputStream() : _packed(false) {}
+
+        /**
+         * 数值列表(short/int/long/float/double)是否用packed编码,
+         * packed编码只有新版本的TarsInputStream才能解, 需要和对端协商后才能打开
+         */
+        void setPacked(bool bPacked) { _packed = bPacked; }
+
+        bool isPacked() const { return _packed; }
+
         void writeUnknown(const std::string& s)
         {
             this->writeBuf(s.data(), s.size());
@@ -1888,6 +2078,71 @@ namespace tars
             TarsWriteTypeBuf(*this, &v[0], v.size());
         }
 
+        /// 数值列表, setPacked(true)时用packed编码
+        template<typename Alloc>
+        void write(const std::vector<Short, Alloc>& v, uint8_t tag)
+        {
+            writeNumList(v, tag);
+        }
+
+        template<typename Alloc>
+        void write(const std::vector<Int32, Alloc>& v, uint8_t tag)
+        {
+            writeNumList(v, tag);
+        }
+
+        template<typename Alloc>
+        void write(const std::vector<Int64, Alloc>& v, uint8_t tag)
+        {
+            writeNumList(v, tag);
+        }
+
+        template<typename Alloc>
+        void write(const std::vector<Float, Alloc>& v, uint8_t tag)
+        {
+            writeNumList(v, tag);
+        }
+
+        template<typename Alloc>
+        void write(const std::vector<Double, Alloc>& v, uint8_t tag)
+        {
+            writeNumList(v, tag);
+        }
+
+        template<typename T, typename Alloc>
+        void writeNumList(const std::vector<T, Alloc>& v, uint8_t tag)
+        {
+            if (!_packed)
+            {
+                TarsWriteToHead(*this, TarsHeadeList, tag);
+                Int32 n = v.size();
+                write(n, 0);
+                typedef typename std::vector<T, Alloc>::const_iterator IT;
+                for (IT i = v.begin(); i != v.end(); ++i)
+                    write(*i, 0);
+                return;
+            }
+
+            writePacked(v, tag);
+        }
+
+        /// packed编码, 不管setPacked
+        template<typename T, typename Alloc>
+        void writePacked(const std::vector<T, Alloc>& v, uint8_t tag)
+        {
+            TarsWriteToHead(*this, TarsHeadeSimpleList, tag);
+            TarsWriteToHead(*this, (uint8_t)TarsPackedHead<T>::type, 0);
+            Int32 n = v.size();
+            write(n, 0);
+            if (n > 0)
+            {
+                size_t len = v.size() * sizeof(T);
+                TarsReserveBuf(*this, (*this)._len + len);
+                tars_packed_copy<T>((*this)._buf + (*this)._len, (const char *)&v[0], v.size());
+                (*this)._len += len;
+            }
+        }
+
         template<typename T>
         void write(const T& v, uint8_t tag, typename detail::disable_if<detail::is_convertible<T*, TarsStructBase*>, void ***>::type dummy = 0)
         {
@@ -1908,6 +2163,8 @@ namespace tars
             h.writeTo(*this);
             */
         }
+    protected:
+        bool _packed;
     };
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 }
@@ -135,6 +135,48 @@ inline Double tars_ntohd(Double x)
 #   endif
 #endif
 
+/**
+ * packed编码的数值列表整体转换字节序(网络序<->主机序, 两个方向相同)
+ * 每个元素按无符号整数做一次bswap, 循环体里没有分支,
+ * 编译器可以向量化成SIMD的字节重排指令(x86的pshufb, arm的rev)
+ */
+namespace detail
+{
+    template<size_t N> struct packed_uint;
+    template<> struct packed_uint<2>
+    {
+        typedef uint16_t type;
+        static type swap(type x) { return (type)((x << 8) | (x >> 8)); }
+    };
+    template<> struct packed_uint<4>
+    {
+        typedef uint32_t type;
+        static type swap(type x) { return __builtin_bswap32(x); }
+    };
+    template<> struct packed_uint<8>
+    {
+        typedef uint64_t type;
+        static type swap(type x) { return __builtin_bswap64(x); }
+    };
+}
+
+template<typename T>
+inline void tars_packed_copy(char *dst, const char *src, size_t n)
+{
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+    typedef detail::packed_uint<sizeof(T)> P;
+    for (size_t i = 0; i < n; ++i)
+    {
+        typename P::type x;
+        memcpy(&x, src + i * sizeof(T), sizeof(T));
+        x = P::swap(x);
+        memcpy(dst + i * sizeof(T), &x, sizeof(T));
+    }
+#else
+    memcpy(dst, src, n * sizeof(T));
+#endif
+}
+
 //type2name
 template<typename T> struct TarsClass    { static std::string name() { return T::className(); } };
 template<> struct TarsClass<tars::Bool>   { static std::string name() { return "bool"; } };
@@ -148,8 +190,8 @@ template<> struct TarsClass<tars::UInt8>  { static std::string name() { return "
 template<> struct TarsClass<tars::UInt16> { static std::string name() { return "int32"; } };
 template<> struct TarsClass<tars::UInt32> { static std::string name() { return "int64"; } };
 template<> struct TarsClass<std::string> { static std::string name() { return "string"; } };
-template<typename T> struct TarsClass<std::vector<T> > { static std::string name() { return std::string("list<") + TarsClass<T>::name() + ">"; } };
-template<typename T, typename U> struct TarsClass<std::map<T, U> > { static std::string name() { return std::string("map<") + TarsClass<T>::name() + "," + TarsClass<U>::name() + ">"; } };
+template<typename T, typename Alloc> struct TarsClass<std::vector<T, Alloc> > { static std::string name() { return std::string("list<") + TarsClass<T>::name() + ">"; } };
+template<typename T, typename U, typename Cmp, typename Alloc> struct TarsClass<std::map<T, U, Cmp, Alloc> > { static std::string name() { return std::string("map<") + TarsClass<T>::name() + "," + TarsClass<U>::name() + ">"; } };
 
 namespace detail
 {
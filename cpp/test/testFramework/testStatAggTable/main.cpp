@@ -0,0 +1,617 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+
+#include <iostream>
+#include <cassert>
+#include <sys/ipc.h>
+#include "StatAggTable.h"
+#include "servant/StatReport.h"
+#include "jmem/jmem_hashmap.h"
+#include "util/tc_common.h"
+#include "util/tc_file.h"
+
+using namespace std;
+using namespace tars;
+
+static const size_t TABLE_SIZE = 16 * 1024 * 1024;
+
+/**
+ * 原来StatHashMap::add的合并规则, 作为期望值
+ */
+void mergeBody(StatMicMsgBody &stBody, const StatMicMsgBody &body)
+{
+    stBody.count        += body.count;
+    stBody.execCount    += body.execCount;
+    stBody.timeoutCount += body.timeoutCount;
+
+    for (map<int, int>::const_iterator it = body.intervalCount.begin(); it != body.intervalCount.end(); it++)
+    {
+        stBody.intervalCount[it->first] += it->second;
+    }
+
+    for (map<int, int>::const_iterator it = body.histCount.begin(); it != body.histCount.end(); it++)
+    {
+        stBody.histCount[it->first] += it->second;
+    }
+
+    stBody.totalRspTime += body.totalRspTime;
+    if (stBody.maxRspTime < body.maxRspTime)
+    {
+        stBody.maxRspTime = body.maxRspTime;
+    }
+    //非0最小值
+    if (stBody.minRspTime == 0 || (stBody.minRspTime > body.minRspTime && body.minRspTime != 0))
+    {
+        stBody.minRspTime = body.minRspTime;
+    }
+}
+
+/**
+ * 第i个上报头, 共keys种
+ */
+void makeMsg(int i, int keys, StatMicMsgHead &head, StatMicMsgBody &body)
+{
+    int k = i % keys;
+
+    head = StatMicMsgHead();
+    head.masterName    = "TestApp.Client" + TC_Common::tostr(k % 50);
+    head.slaveName     = "TestApp.HelloServer" + TC_Common::tostr(k % 20);
+    head.interfaceName = "testHello" + TC_Common::tostr(k / 1000);
+    head.masterIp      = "10.0." + TC_Common::tostr(k % 7) + ".1";
+    head.slaveIp       = "10.1." + TC_Common::tostr(k % 13) + ".1";
+    head.slavePort     = 10000 + k % 3;
+    head.returnValue   = k % 2;
+    head.tarsVersion   = "1.1.0";
+
+    body = StatMicMsgBody();
+    body.count         = i % 5 + 1;
+    body.timeoutCount  = i % 3;
+    body.execCount     = i % 2;
+    body.totalRspTime  = (int64_t)i * 3;
+    body.maxRspTime    = i % 1000;
+    body.minRspTime    = i % 17;
+    body.intervalCount[100] = i % 7;
+    body.intervalCount[200] = 1;
+    if (i % 4 == 0)
+    {
+        body.histCount[i % StatCounter::HIST_BUCKETS] = 2;
+    }
+}
+
+/**
+ * 用StatImp::reportMicMsg的makeRecord生成一批记录
+ */
+size_t makeRecords(StatAggTable &table, const vector<pair<StatMicMsgHead, StatMicMsgBody> > &msg, vector<StatAggTable::Record> &records)
+{
+    size_t invalid = 0;
+
+    records.clear();
+    for (size_t i = 0; i < msg.size(); ++i)
+    {
+        const StatMicMsgHead &head = msg[i].first;
+
+        StatAggTable::Record record;
+        if (!table.makeRecord(head, msg[i].second, head.masterIp, head.slaveIp, record))
+        {
+            ++invalid;
+            continue;
+        }
+
+        records.push_back(record);
+    }
+
+    return invalid;
+}
+
+void dumpTable(const StatAggTable &table, map<StatMicMsgHead, StatMicMsgBody> &data)
+{
+    data.clear();
+    for (size_t i = 0; i < table.capacity(); ++i)
+    {
+        StatMicMsgHead head;
+        StatMicMsgBody body;
+        if (table.get(i, head, body))
+        {
+            assert(data.find(head) == data.end());
+            data[head] = body;
+        }
+    }
+    assert(data.size() == table.size());
+}
+
+void testIntern()
+{
+    StatAggTable table;
+    table.init("stat_agg_test.dat", TABLE_SIZE, 16);
+    table.clear();
+
+    assert(table.intern("") == 0);
+    assert(table.intern("a", 0) == 0);
+
+    uint32_t a = table.intern("TestApp.HelloServer");
+    uint32_t b = table.intern("TestApp.HelloServer2");
+    assert(a != 0 && b != 0 && a != b);
+    assert(table.intern(string("TestApp.HelloServer")) == a);
+    assert(table.intern("TestApp.HelloServer2xxx", 20) == b);
+
+    //超长的截断
+    string sLong(StatAggTable::MAX_STR_LEN + 100, 'x');
+    assert(table.intern(sLong) == table.intern(sLong.c_str(), StatAggTable::MAX_STR_LEN));
+
+    //clear后字典也清空, 重新分配
+    table.clear();
+    assert(table.intern("TestApp.HelloServer2") == a);
+
+    cout << "testIntern ok" << endl;
+}
+
+/**
+ * 主调名带版本时拆开, 入库的ip用参数指定的
+ */
+void testMakeRecord()
+{
+    StatAggTable table;
+    table.init("stat_agg_test.dat", TABLE_SIZE, 16);
+    table.clear();
+
+    StatMicMsgHead head;
+    StatMicMsgBody body;
+    makeMsg(1, 100, head, body);
+    head.masterName = "TestApp.Client1@2.1.0";
+
+    vector<StatAggTable::Record> records(1);
+    assert(table.makeRecord(head, body, "192.168.0.1", "192.168.0.2", records[0]));
+    assert(records[0].body == &body);
+    assert(table.merge(records) == 0);
+
+    map<StatMicMsgHead, StatMicMsgBody> data;
+    dumpTable(table, data);
+    assert(data.size() == 1);
+
+    const StatMicMsgHead &out = data.begin()->first;
+    assert(out.masterName == "TestApp.Client1" && out.tarsVersion == "2.1.0");
+    assert(out.masterIp == "192.168.0.1" && out.slaveIp == "192.168.0.2");
+    assert(out.slaveName == head.slaveName && out.interfaceName == head.interfaceName);
+    assert(out.slavePort == head.slavePort && out.returnValue == head.returnValue);
+    assert(data.begin()->second.count == body.count);
+
+    //没有版本的用head里的tarsVersion, 和上面是不同的key
+    head.masterName = "TestApp.Client1";
+    assert(table.makeRecord(head, body, "192.168.0.1", "192.168.0.2", records[0]));
+    assert(table.merge(records) == 0);
+    assert(table.size() == 2);
+
+    cout << "testMakeRecord ok" << endl;
+}
+
+struct MergeArg
+{
+    StatAggTable    *table;
+    int             begin;
+    int             count;
+    int             keys;
+    size_t          dropped;
+};
+
+void *mergeThread(void *p)
+{
+    MergeArg *arg = (MergeArg*)p;
+
+    vector<pair<StatMicMsgHead, StatMicMsgBody> > msg;
+    vector<StatAggTable::Record> records;
+
+    arg->dropped = 0;
+    for (int i = arg->begin; i < arg->begin + arg->count; )
+    {
+        msg.clear();
+        for (int j = 0; j < 100 && i < arg->begin + arg->count; ++j, ++i)
+        {
+            msg.push_back(make_pair(StatMicMsgHead(), StatMicMsgBody()));
+            makeMsg(i, arg->keys, msg.back().first, msg.back().second);
+        }
+
+        assert(makeRecords(*arg->table, msg, records) == 0);
+        arg->dropped += arg->table->merge(records);
+    }
+
+    return NULL;
+}
+
+/**
+ * 多线程合并的结果和逐条按原规则合并的一致
+ */
+void testMerge()
+{
+    StatAggTable table;
+    table.init("stat_agg_test.dat", TABLE_SIZE, 16);
+    table.clear();
+
+    int threads = 8;
+    int count   = 20000;
+    int keys    = 3000;
+
+    vector<pthread_t> ids(threads);
+    vector<MergeArg> args(threads);
+    for (int i = 0; i < threads; ++i)
+    {
+        MergeArg arg = {&table, i * count, count, keys, 0};
+        args[i] = arg;
+        pthread_create(&ids[i], NULL, mergeThread, &args[i]);
+    }
+    for (int i = 0; i < threads; ++i)
+    {
+        pthread_join(ids[i], NULL);
+        assert(args[i].dropped == 0);
+    }
+
+    map<StatMicMsgHead, StatMicMsgBody> expect;
+    for (int i = 0; i < threads * count; ++i)
+    {
+        StatMicMsgHead head;
+        StatMicMsgBody body;
+        makeMsg(i, keys, head, body);
+        mergeBody(expect[head], body);
+    }
+
+    map<StatMicMsgHead, StatMicMsgBody> data;
+    dumpTable(table, data);
+    assert(data == expect);
+
+    table.clear();
+    assert(table.size() == 0);
+    dumpTable(table, data);
+    assert(data.empty());
+
+    cout << "testMerge ok" << endl;
+}
+
+/**
+ * 表满(每段超过九成)后新记录被丢弃并计数, 已有记录照常合并
+ */
+void testDrop()
+{
+    StatAggTable table;
+    table.init("stat_agg_test_small.dat", 1024 * 1024, 4);
+    table.clear();
+
+    int keys = (int)table.capacity() * 2;
+
+    vector<pair<StatMicMsgHead, StatMicMsgBody> > msg(1);
+    vector<StatAggTable::Record> records;
+
+    size_t dropped = 0;
+    for (int i = 0; i < keys; ++i)
+    {
+        makeMsg(i, keys, msg[0].first, msg[0].second);
+        dropped += makeRecords(table, msg, records);
+        dropped += table.merge(records);
+    }
+
+    assert(dropped > 0);
+    assert(table.size() + dropped == (size_t)keys);
+    assert(table.size() <= table.capacity() * 9 / 10);
+
+    //已经在表里的记录还能合并
+    map<StatMicMsgHead, StatMicMsgBody> before;
+    dumpTable(table, before);
+
+    const StatMicMsgHead &head = before.begin()->first;
+    StatMicMsgBody body;
+    body.count = 10;
+    msg[0] = make_pair(head, body);
+    assert(makeRecords(table, msg, records) == 0);
+    assert(table.merge(records) == 0);
+
+    map<StatMicMsgHead, StatMicMsgBody> after;
+    dumpTable(table, after);
+    assert(after.size() == before.size());
+    assert(after[head].count == before[head].count + 10);
+
+    cout << "testDrop ok|" << table.desc() << endl;
+}
+
+struct SwapArg
+{
+    StatAggTable    *table;
+    volatile int    *select;
+    volatile int    inUse;     //正在写的表, -1表示没有在写
+    int             count;
+    int             keys;
+};
+
+void *swapThread(void *p)
+{
+    SwapArg *arg = (SwapArg*)p;
+
+    vector<pair<StatMicMsgHead, StatMicMsgBody> > msg(10);
+    vector<StatAggTable::Record> records;
+
+    for (int i = 0; i < arg->count; i += 10)
+    {
+        for (int j = 0; j < 10; ++j)
+        {
+            makeMsg(i + j, arg->keys, msg[j].first, msg[j].second);
+        }
+
+        //相当于StatImp::getAggTable记录本线程正在用哪个buffer
+        arg->inUse = *arg->select;
+        __sync_synchronize();
+
+        StatAggTable &table = arg->table[arg->inUse];
+        assert(makeRecords(table, msg, records) == 0);
+        assert(table.merge(records) == 0);
+
+        __sync_synchronize();
+        arg->inUse = -1;
+    }
+
+    return NULL;
+}
+
+/**
+ * 双buffer: 写线程按选择的下标写入, 切换后等所有写线程离开旧表(StatServer用bufferInterval保证),
+ * 收割旧表再clear, 所有上报都不丢
+ */
+void testDoubleBuffer()
+{
+    StatAggTable table[2];
+    table[0].init("stat_agg_test0.dat", TABLE_SIZE, 16);
+    table[1].init("stat_agg_test1.dat", TABLE_SIZE, 16);
+    table[0].clear();
+    table[1].clear();
+
+    volatile int select = 0;
+
+    int threads = 4;
+    int count   = 50000;
+    int keys    = 500;
+
+    vector<pthread_t> ids(threads);
+    vector<SwapArg> args(threads);
+    for (int i = 0; i < threads; ++i)
+    {
+        SwapArg arg = {table, &select, -1, count, keys};
+        args[i] = arg;
+        pthread_create(&ids[i], NULL, swapThread, &args[i]);
+    }
+
+    int64_t total = 0;
+    for (int round = 0; round < 20; ++round)
+    {
+        usleep(2000);
+
+        int old = select;
+        select  = 1 - old;
+        __sync_synchronize();
+
+        for (int i = 0; i < threads; ++i)
+        {
+            while (args[i].inUse == old)
+            {
+                usleep(100);
+            }
+        }
+
+        map<StatMicMsgHead, StatMicMsgBody> data;
+        dumpTable(table[old], data);
+        for (map<StatMicMsgHead, StatMicMsgBody>::iterator it = data.begin(); it != data.end(); ++it)
+        {
+            total += it->second.count;
+        }
+        table[old].clear();
+    }
+
+    for (int i = 0; i < threads; ++i)
+    {
+        pthread_join(ids[i], NULL);
+    }
+
+    for (int k = 0; k < 2; ++k)
+    {
+        map<StatMicMsgHead, StatMicMsgBody> data;
+        dumpTable(table[k], data);
+        for (map<StatMicMsgHead, StatMicMsgBody>::iterator it = data.begin(); it != data.end(); ++it)
+        {
+            total += it->second.count;
+        }
+    }
+
+    int64_t expect = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        expect += i % 5 + 1;
+    }
+
+    assert(total == expect * threads);
+
+    cout << "testDoubleBuffer ok" << endl;
+}
+
+/**
+ * 进程重启: 重新mmap同一个文件, 数据和字典都还在; 布局变化时重新初始化
+ */
+void testRestart()
+{
+    map<StatMicMsgHead, StatMicMsgBody> before;
+
+    {
+        StatAggTable table;
+        table.init("stat_agg_test.dat", TABLE_SIZE, 16);
+        table.clear();
+
+        MergeArg arg = {&table, 0, 10000, 1000, 0};
+        mergeThread(&arg);
+
+        dumpTable(table, before);
+        assert(before.size() == 1000);
+    }
+
+    {
+        StatAggTable table;
+        table.init("stat_agg_test.dat", TABLE_SIZE, 16);
+
+        map<StatMicMsgHead, StatMicMsgBody> after;
+        dumpTable(table, after);
+        assert(after == before);
+
+        //字典沿用, 同一个字符串还是同一个id, 继续合并到原记录上
+        MergeArg arg = {&table, 0, 10000, 1000, 0};
+        mergeThread(&arg);
+        dumpTable(table, after);
+        assert(after.size() == before.size());
+        assert(after.begin()->second.count == before.begin()->second.count * 2);
+    }
+
+    {
+        //段数不同, 布局不一致, 重新初始化
+        StatAggTable table;
+        table.init("stat_agg_test.dat", TABLE_SIZE, 8);
+        assert(table.size() == 0);
+    }
+
+    cout << "testRestart ok" << endl;
+}
+
+/**
+ * 原来的存储: TarsHashMap放在SysV共享内存里, 每条记录编码上报头, 加锁, 解码旧值, 合并, 再编码写回
+ */
+typedef TarsHashMap<StatMicMsgHead, StatMicMsgBody, ThreadLockPolicy, ShmStorePolicy> HashMap;
+
+class StatHashMap : public HashMap
+{
+public:
+    int add(const StatMicMsgHead &head, const StatMicMsgBody &body)
+    {
+        StatMicMsgBody stBody;
+        int ret = TC_HashMap::RT_OK;
+        TarsOutputStream<BufferWriter> osk;
+        head.writeTo(osk);
+        string sk(osk.getBuffer(), osk.getLength());
+        string sv;
+        time_t t = 0;
+
+        TC_LockT<ThreadLockPolicy::Mutex> lock(ThreadLockPolicy::mutex());
+        ret = this->_t.get(sk, sv, t);
+        if (ret < 0)
+        {
+            return -1;
+        }
+
+        if (ret == TC_HashMap::RT_OK)
+        {
+            TarsInputStream<BufferReader> is;
+            is.setBuffer(sv.c_str(), sv.length());
+            stBody.readFrom(is);
+        }
+
+        mergeBody(stBody, body);
+
+        TarsOutputStream<BufferWriter> osv;
+        stBody.writeTo(osv);
+        string stemp(osv.getBuffer(), osv.getLength());
+        vector<TC_HashMap::BlockData> vtData;
+
+        return this->_t.set(sk, stemp, true, vtData);
+    }
+};
+
+void bench(int count)
+{
+    int keys  = 5000;
+    int batch = 500;
+
+    vector<pair<StatMicMsgHead, StatMicMsgBody> > msg;
+    for (int i = 0; i < batch * 10; ++i)
+    {
+        msg.push_back(make_pair(StatMicMsgHead(), StatMicMsgBody()));
+        makeMsg(i, keys, msg.back().first, msg.back().second);
+    }
+
+    TC_File::save2file("stat_agg_bench.shm", "");
+    key_t key = ftok("stat_agg_bench.shm", 'a');
+
+    StatHashMap hashmap;
+    hashmap.initDataBlockSize(128, 256, 2);
+    hashmap.initStore(key, 64 * 1024 * 1024);
+    hashmap.setAutoErase(false);
+
+    int64_t t = TC_Common::now2us();
+    for (int i = 0; i < count; ++i)
+    {
+        const pair<StatMicMsgHead, StatMicMsgBody> &m = msg[i % msg.size()];
+        hashmap.add(m.first, m.second);
+    }
+    int64_t t1 = TC_Common::now2us() - t;
+
+    hashmap.release();
+
+    StatAggTable table;
+    table.init("stat_agg_bench.dat", 64 * 1024 * 1024, 64);
+    table.clear();
+
+    vector<pair<StatMicMsgHead, StatMicMsgBody> > one;
+    vector<StatAggTable::Record> records;
+
+    //和reportMicMsg一样一次处理一批
+    t = TC_Common::now2us();
+    for (int i = 0; i < count; i += batch)
+    {
+        size_t begin = i % msg.size();
+        one.assign(msg.begin() + begin, msg.begin() + begin + batch);
+        makeRecords(table, one, records);
+        table.merge(records);
+    }
+    int64_t t2 = TC_Common::now2us() - t;
+
+    cout << "StatHashMap:" << (double)t1 * 1000 / count << "ns/record"
+         << " StatAggTable:" << (double)t2 * 1000 / count << "ns/record"
+         << " x" << (double)t1 / (t2 > 0 ? t2 : 1) << endl;
+
+    TC_File::removeFile("stat_agg_bench.shm", false);
+    TC_File::removeFile("stat_agg_bench.dat", false);
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        testIntern();
+
+        testMakeRecord();
+
+        testMerge();
+
+        testDrop();
+
+        testDoubleBuffer();
+
+        testRestart();
+
+        bench(argc > 1 ? TC_Common::strto<int>(argv[1]) : 500000);
+    }
+    catch(exception &ex)
+    {
+        cout << ex.what() << endl;
+        return -1;
+    }
+
+    TC_File::removeFile("stat_agg_test.dat", false);
+    TC_File::removeFile("stat_agg_test_small.dat", false);
+    TC_File::removeFile("stat_agg_test0.dat", false);
+    TC_File::removeFile("stat_agg_test1.dat", false);
+
+    return 0;
+}
@@ -0,0 +1,413 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+
+#include <iostream>
+#include <cassert>
+#include <map>
+#include <set>
+#include <arpa/inet.h>
+#include "servant/Communicator.h"
+#include "servant/CommunicatorEpoll.h"
+#include "servant/ObjectProxy.h"
+#include "servant/EndpointManager.h"
+#include "servant/AdapterProxy.h"
+#include "servant/AppProtocol.h"
+#include "util/tc_epoll_server.h"
+#include "util/tc_thread.h"
+#include "util/tc_common.h"
+
+using namespace std;
+using namespace tars;
+
+/**
+ * 进程内起几个TARS协议的服务端口, 客户端用Communicator调用,
+ * 检查按响应时间选择节点(-v 2)的结果, 以及一个节点多个连接(connnum)时的选择和重连
+ *
+ * 按响应时间选择的用例不靠服务端的处理耗时: 直接给AdapterProxy喂响应时间样本,
+ * 统计EndpointManager选中各节点的次数, 结果是确定的
+ */
+
+#define BASE_PORT   19970
+#define PORT_NUM    3
+
+//多连接用例单独用一个端口
+#define CONN_PORT   (BASE_PORT + PORT_NUM)
+#define CONN_NUM    4
+
+//响应时间的衰减周期(微秒), 同AdapterProxy.cpp
+#define DECAY_US    10000000LL
+
+//多连接用例: 服务端看到的连接uid->fd
+static TC_ThreadMutex       g_connMutex;
+static map<unsigned int, int> g_conns;
+
+class TestHandle : public TC_EpollServer::Handle
+{
+protected:
+    virtual void handle(const TC_EpollServer::tagRecvData &stRecvData)
+    {
+        TarsInputStream<BufferReader> is;
+        is.setBuffer(stRecvData.data(), stRecvData.length());
+
+        RequestPacket req;
+        req.readFrom(is);
+
+        if (stRecvData.adapter->getEndpoint().getPort() == CONN_PORT)
+        {
+            TC_LockT<TC_ThreadMutex> lock(g_connMutex);
+
+            g_conns[stRecvData.uid] = stRecvData.fd;
+        }
+
+        ResponsePacket rsp;
+        rsp.iVersion    = TARSVERSION;
+        rsp.cPacketType = TARSNORMAL;
+        rsp.iRequestId  = req.iRequestId;
+        rsp.iRet        = TARSSERVERSUCCESS;
+
+        TarsOutputStream<BufferWriter> os;
+        rsp.writeTo(os);
+
+        tars::Int32 iHeaderLen = htonl(sizeof(tars::Int32) + os.getLength());
+
+        string s((const char *)&iHeaderLen, sizeof(tars::Int32));
+        s.append(os.getBuffer(), os.getLength());
+
+        sendResponse(stRecvData.uid, s, stRecvData.ip, stRecvData.port, stRecvData.fd);
+    }
+};
+
+class ServerThread : public TC_Thread
+{
+public:
+    ServerThread(TC_EpollServer *server) : _server(server)
+    {
+    }
+
+protected:
+    virtual void run()
+    {
+        _server->waitForShutdown();
+    }
+
+    TC_EpollServer *_server;
+};
+
+static void addAdapter(TC_EpollServerPtr &server, int idx)
+{
+    TC_EpollServer::BindAdapterPtr lsPtr = new TC_EpollServer::BindAdapter(server.get());
+
+    string name = "Adapter" + TC_Common::tostr(idx);
+
+    lsPtr->setName(name);
+    lsPtr->setEndpoint("tcp -h 127.0.0.1 -p " + TC_Common::tostr(BASE_PORT + idx) + " -t 60000");
+    lsPtr->setProtocol(AppProtocol::parse);
+    lsPtr->setHandleGroupName(name);
+    lsPtr->setHandleNum(1);
+    lsPtr->setHandle<TestHandle>();
+
+    server->bind(lsPtr);
+}
+
+static void call(ServantPrx &prx, int count)
+{
+    map<string, string> context;
+    map<string, string> status;
+
+    for (int i = 0; i < count; ++i)
+    {
+        ResponsePacket rsp;
+        prx->tars_invoke(TARSNORMAL, "test", vector<char>(), context, status, rsp);
+        assert(rsp.iRet == TARSSERVERSUCCESS);
+    }
+}
+
+/**
+ * 按响应时间选择的节点, 先调用几次把到各节点的连接都建立起来,
+ * 之后只在测试线程里选择节点, 没有在途请求
+ */
+class LatencyNodes
+{
+public:
+    LatencyNodes(Communicator &comm, int num) : _clockUs(TNOWUS)
+    {
+        string obj = "Test.AdapterProxy.LatencyObj@";
+        for (int i = 0; i < num; ++i)
+        {
+            obj += (i == 0 ? "" : ":") + string("tcp -h 127.0.0.1 -p ") + TC_Common::tostr(BASE_PORT + i) + " -t 60000 -v 2";
+        }
+
+        comm.setProperty("netthread", "1");
+
+        ServantPrx prx = comm.stringToProxy<ServantPrx>(obj);
+
+        call(prx, num * 10);
+
+        ObjectProxy *pObjectProxy = comm.getCommunicatorEpoll(0)->getObjectProxy(obj);
+
+        _manager = pObjectProxy->getEndpointManager();
+
+        //按端口排序, 下标和端口对应
+        _adapters.resize(num);
+        const vector<AdapterProxy*> &vAdapters = pObjectProxy->getAdapters();
+        for (size_t i = 0; i < vAdapters.size(); ++i)
+        {
+            _adapters[vAdapters[i]->endpoint().port() - BASE_PORT] = vAdapters[i];
+        }
+    }
+
+    /**
+     * 把节点的响应时间直接设成dRttUs: 样本时间取在很远的将来, 之前的值完全衰减掉;
+     * 选择节点时用的当前时间比它早, 不再衰减
+     */
+    void setLatency(int idx, double dRttUs)
+    {
+        _clockUs += 1000 * DECAY_US;
+
+        _adapters[idx]->updateLatency(_clockUs, dRttUs);
+    }
+
+    /**
+     * 喂一个iDelayUs之后的样本, 按衰减规则更新
+     */
+    void sample(int idx, int64_t iDelayUs, double dRttUs)
+    {
+        _clockUs += iDelayUs;
+
+        _adapters[idx]->updateLatency(_clockUs, dRttUs);
+    }
+
+    /**
+     * 选择count次, 返回选中各节点的次数
+     */
+    vector<int> select(int count)
+    {
+        vector<int> vCount(_adapters.size(), 0);
+
+        for (int i = 0; i < count; ++i)
+        {
+            ReqMessage msg;
+            AdapterProxy *pAdapterProxy = NULL;
+
+            _manager->selectAdapterProxy(&msg, pAdapterProxy);
+            assert(pAdapterProxy != NULL);
+
+            vCount[pAdapterProxy->endpoint().port() - BASE_PORT]++;
+        }
+
+        return vCount;
+    }
+
+protected:
+    int64_t                 _clockUs;
+    EndpointManager *       _manager;
+    vector<AdapterProxy*>   _adapters;
+};
+
+static string tostr(const vector<int> &v)
+{
+    return TC_Common::tostr(v.begin(), v.end(), " ");
+}
+
+/**
+ * 两个节点都不到1毫秒, 按微秒计时也要分出快慢: 两个节点时每次都比较两个, 全部给快的
+ */
+void testSubMillisecond()
+{
+    //Communicator析构时会terminate, 不要再显式调用(重复join)
+    Communicator comm;
+
+    LatencyNodes nodes(comm, 2);
+
+    nodes.setLatency(0, 100);
+    nodes.setLatency(1, 500);
+
+    vector<int> v = nodes.select(1000);
+
+    cout << "testSubMillisecond " << tostr(v) << endl;
+
+    assert(v[0] == 1000 && v[1] == 0);
+
+    cout << "testSubMillisecond ok" << endl;
+}
+
+/**
+ * 三个节点时随机取两个比较, 最慢的永远选不中, 最快的只要被取到就选中
+ */
+void testPowerOfTwo()
+{
+    Communicator comm;
+
+    LatencyNodes nodes(comm, 3);
+
+    nodes.setLatency(0, 100);
+    nodes.setLatency(1, 500);
+    nodes.setLatency(2, 900);
+
+    vector<int> v = nodes.select(3000);
+
+    cout << "testPowerOfTwo " << tostr(v) << endl;
+
+    assert(v[2] == 0);
+    assert(v[0] > 0 && v[1] > 0);
+    assert(v[0] + v[1] == 3000);
+
+    cout << "testPowerOfTwo ok" << endl;
+}
+
+/**
+ * 快的节点变慢: 比平均值大的样本马上生效, 请求全部转到另一个节点;
+ * 之后恢复正常的样本按时间衰减, 经过几个衰减周期重新被选中
+ */
+void testSlowdown()
+{
+    Communicator comm;
+
+    LatencyNodes nodes(comm, 2);
+
+    nodes.setLatency(0, 100);
+    nodes.setLatency(1, 500);
+
+    assert(nodes.select(100)[0] == 100);
+
+    //同一时刻的慢样本, 不等衰减直接生效
+    nodes.sample(0, 0, 3000);
+
+    vector<int> v = nodes.select(1000);
+
+    cout << "testSlowdown slowed:" << tostr(v) << endl;
+
+    assert(v[0] == 0 && v[1] == 1000);
+
+    //半个衰减周期后的正常样本: 3000*e^-0.5 + 100*(1-e^-0.5) > 500, 还是不选
+    nodes.sample(0, DECAY_US / 2, 100);
+
+    v = nodes.select(1000);
+
+    cout << "testSlowdown half decay:" << tostr(v) << endl;
+
+    assert(v[0] == 0 && v[1] == 1000);
+
+    //再过5个衰减周期: 约1859*e^-5 + 100 < 500, 又全部选它
+    nodes.sample(0, 5 * DECAY_US, 100);
+
+    v = nodes.select(1000);
+
+    cout << "testSlowdown recovered:" << tostr(v) << endl;
+
+    assert(v[0] == 1000 && v[1] == 0);
+
+    cout << "testSlowdown ok" << endl;
+}
+
+/**
+ * connnum=4: 串行调用时在途请求一样多, 轮流使用所有连接;
+ * 服务端断开一个连接后调用不受影响, 断开的连接会重新建立
+ */
+void testConnNum(TC_EpollServer *server)
+{
+    Communicator comm;
+    comm.setProperty("connnum", TC_Common::tostr(CONN_NUM));
+
+    ServantPrx prx = comm.stringToProxy<ServantPrx>("Test.AdapterProxy.ConnObj@tcp -h 127.0.0.1 -p " + TC_Common::tostr(CONN_PORT) + " -t 60000");
+
+    call(prx, 100);
+
+    pair<unsigned int, int> closed;
+
+    {
+        TC_LockT<TC_ThreadMutex> lock(g_connMutex);
+
+        cout << "testConnNum connections:" << g_conns.size() << endl;
+
+        assert(g_conns.size() == CONN_NUM);
+
+        closed = *g_conns.begin();
+
+        g_conns.clear();
+    }
+
+    //服务端断开一个连接, 等客户端收到关闭
+    server->close(closed.first, closed.second);
+
+    usleep(100000);
+
+    //断开的连接不再选, 调用都成功
+    call(prx, 100);
+
+    {
+        TC_LockT<TC_ThreadMutex> lock(g_connMutex);
+
+        cout << "testConnNum after close:" << g_conns.size() << endl;
+
+        assert(g_conns.find(closed.first) == g_conns.end());
+        assert(g_conns.size() >= CONN_NUM - 1);
+
+        g_conns.clear();
+    }
+
+    //再调用一轮, 断开的连接已经重连, 又是CONN_NUM个连接轮流使用
+    call(prx, 100);
+
+    {
+        TC_LockT<TC_ThreadMutex> lock(g_connMutex);
+
+        cout << "testConnNum after reconnect:" << g_conns.size() << endl;
+
+        assert(g_conns.size() == CONN_NUM);
+        assert(g_conns.find(closed.first) == g_conns.end());
+    }
+
+    cout << "testConnNum ok" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        TC_EpollServerPtr server = new TC_EpollServer(1);
+        server->setNetThreadBufferPoolInfo(1024, 8 * 1024 * 1024, 64 * 1024 * 1024);
+
+        for (int i = 0; i <= PORT_NUM; ++i)
+        {
+            addAdapter(server, i);
+        }
+
+        server->startHandle();
+        server->createEpoll();
+
+        ServerThread thread(server.get());
+        thread.start();
+
+        testSubMillisecond();
+
+        testPowerOfTwo();
+
+        testSlowdown();
+
+        testConnNum(server.get());
+
+        server->terminate();
+        thread.getThreadControl().join();
+    }
+    catch(exception &ex)
+    {
+        cout << ex.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,231 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+
+#include <iostream>
+#include <vector>
+#include <cassert>
+#include <cstdlib>
+#include "tup/Tars.h"
+#include "util/tc_common.h"
+
+using namespace std;
+using namespace tars;
+
+/**
+ * 逐个元素编码和packed编码的对比
+ */
+template<typename T>
+void fill(vector<T> &v, size_t n)
+{
+    v.resize(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        v[i] = (T)((Int64)(rand() - RAND_MAX / 2) * (i % 3 == 0 ? 100000 : 1));
+    }
+}
+
+/**
+ * 和T宽度或类型不同的数值类型, 用来检查类型不匹配
+ */
+template<typename T> struct Other          { typedef Double type; };
+template<> struct Other<Float>             { typedef Short type; };
+template<> struct Other<Double>            { typedef Float type; };
+
+template<typename T>
+void encode(const vector<T> &v, bool bPacked, vector<char> &buff)
+{
+    TarsOutputStream<BufferWriter> os;
+    os.setPacked(bPacked);
+    os.write(v, 1);
+    os.write((Int32)12345, 2);
+    os.swap(buff);
+}
+
+template<typename T>
+void decode(const vector<char> &buff, vector<T> &v)
+{
+    TarsInputStream<BufferReader> is;
+    is.setBuffer(buff);
+    is.read(v, 1, true);
+
+    Int32 n = 0;
+    is.read(n, 2, true);
+    assert(n == 12345);
+}
+
+template<typename T>
+void testCorrect(const vector<T> &v)
+{
+    vector<char> plain, packed;
+    encode(v, false, plain);
+    encode(v, true, packed);
+
+    //两种格式都能读
+    vector<T> v1, v2;
+    decode(plain, v1);
+    decode(packed, v2);
+    assert(v1 == v);
+    assert(v2 == v);
+
+    //跳过packed字段
+    TarsInputStream<BufferReader> is;
+    is.setBuffer(packed);
+    Int32 n = 0;
+    is.read(n, 2, true);
+    assert(n == 12345);
+
+    //packed编码的元素类型不对要报错
+    vector<typename Other<T>::type> vo;
+    bool bMismatch = false;
+    try
+    {
+        decode(packed, vo);
+    }
+    catch (TarsDecodeMismatch &ex)
+    {
+        bMismatch = true;
+    }
+    assert(bMismatch);
+
+    //截断的数据要报错
+    vector<char> cut(packed.begin(), packed.begin() + packed.size() / 2);
+    bool bInvalid = false;
+    try
+    {
+        decode(cut, v1);
+    }
+    catch (TarsDecodeException &ex)
+    {
+        bInvalid = true;
+    }
+    assert(bInvalid);
+
+    //空vector
+    vector<T> empty;
+    encode(empty, true, packed);
+    decode(packed, v1);
+    assert(v1.empty());
+}
+
+/**
+ * 窄类型的packed数组能读到宽类型的字段里(字段从int改成long), 和逐个元素编码的行为一致
+ */
+template<typename From, typename To>
+void testWiden(const vector<From> &v)
+{
+    vector<char> plain, packed;
+    encode(v, false, plain);
+    encode(v, true, packed);
+
+    vector<To> v1, v2;
+    decode(plain, v1);
+    decode(packed, v2);
+
+    assert(v1.size() == v.size());
+    for (size_t i = 0; i < v.size(); ++i)
+    {
+        assert(v1[i] == (To)v[i]);
+    }
+    assert(v2 == v1);
+}
+
+template<typename T>
+void bench(const string &name, const vector<T> &v, int count)
+{
+    vector<char> plain, packed;
+    vector<T> out;
+
+    int64_t t = TC_Common::now2us();
+    for (int i = 0; i < count; ++i)
+    {
+        encode(v, false, plain);
+    }
+    int64_t tEncode = TC_Common::now2us() - t;
+
+    t = TC_Common::now2us();
+    for (int i = 0; i < count; ++i)
+    {
+        decode(plain, out);
+    }
+    int64_t tDecode = TC_Common::now2us() - t;
+
+    t = TC_Common::now2us();
+    for (int i = 0; i < count; ++i)
+    {
+        encode(v, true, packed);
+    }
+    int64_t tEncodePacked = TC_Common::now2us() - t;
+
+    t = TC_Common::now2us();
+    for (int i = 0; i < count; ++i)
+    {
+        decode(packed, out);
+    }
+    int64_t tDecodePacked = TC_Common::now2us() - t;
+
+    cout << name << " x " << v.size() << endl;
+    cout << "  list   size:" << plain.size() << " encode:" << tEncode / count << "us decode:" << tDecode / count << "us" << endl;
+    cout << "  packed size:" << packed.size() << " encode:" << tEncodePacked / count << "us decode:" << tDecodePacked / count << "us" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        size_t n  = argc > 1 ? TC_Common::strto<size_t>(argv[1]) : 100000;
+        int count = argc > 2 ? TC_Common::strto<int>(argv[2]) : 100;
+
+        vector<Short>  vs;
+        vector<Int32>  vi;
+        vector<Int64>  vl;
+        vector<Float>  vf;
+        vector<Double> vd;
+
+        fill(vs, n);
+        fill(vi, n);
+        fill(vl, n);
+        fill(vf, n);
+        fill(vd, n);
+
+        testCorrect(vs);
+        testCorrect(vi);
+        testCorrect(vl);
+        testCorrect(vf);
+        testCorrect(vd);
+
+        cout << "testCorrect ok" << endl;
+
+        testWiden<Int32, Int64>(vi);
+        testWiden<Short, Int32>(vs);
+        testWiden<Short, Int64>(vs);
+        testWiden<Float, Double>(vf);
+
+        cout << "testWiden ok" << endl;
+
+        bench("short", vs, count);
+        bench("int", vi, count);
+        bench("long", vl, count);
+        bench("float", vf, count);
+        bench("double", vd, count);
+    }
+    catch (exception &ex)
+    {
+        cout << ex.what() << endl;
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,379 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+
+#include <iostream>
+#include <cassert>
+#include "servant/StatReport.h"
+#include "servant/Communicator.h"
+#include "util/tc_common.h"
+
+using namespace std;
+using namespace tars;
+
+vector<int> timePoint()
+{
+    int a[] = {5, 10, 50, 100, 200, 500, 1000, 2000, 3000};
+    return vector<int>(a, a + sizeof(a) / sizeof(a[0]));
+}
+
+struct CounterArg
+{
+    StatCounter *counter;
+    int         count;
+};
+
+void *counterThread(void *p)
+{
+    CounterArg *arg = (CounterArg*)p;
+
+    for (int i = 0; i < arg->count; ++i)
+    {
+        arg->counter->report(i % 10 == 0 ? StatReport::STAT_TIMEOUT : (i % 10 == 1 ? StatReport::STAT_EXCE : StatReport::STAT_SUCC), i % 4000);
+    }
+
+    return NULL;
+}
+
+/**
+ * 多个线程同时上报, 取出的结果和单线程逐条合并的结果一致
+ */
+void testCounter()
+{
+    StatMicMsgHead head;
+    head.masterName    = "TestApp.Client@1.1.0";
+    head.slaveName     = "TestApp.HelloServer";
+    head.interfaceName = "testHello";
+
+    StatCounterPtr counter = new StatCounter(head, true, timePoint());
+
+    //计数槽按cache line对齐
+    assert((size_t)counter.get() % 64 == 0);
+
+    int threads = 8;
+    int count   = 100000;
+
+    vector<pthread_t> ids(threads);
+    CounterArg arg = {counter.get(), count};
+    for (int i = 0; i < threads; ++i)
+    {
+        pthread_create(&ids[i], NULL, counterThread, &arg);
+    }
+    for (int i = 0; i < threads; ++i)
+    {
+        pthread_join(ids[i], NULL);
+    }
+
+    StatMicMsgBody body;
+    assert(counter->get(body));
+
+    //期望值
+    StatMicMsgBody expect;
+    vector<int> tp = timePoint();
+    for (size_t j = 0; j < tp.size(); ++j)
+    {
+        expect.intervalCount[tp[j]] = 0;
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        int time = 0;
+        if (i % 10 == 0)
+        {
+            expect.timeoutCount += threads;
+        }
+        else if (i % 10 == 1)
+        {
+            expect.execCount += threads;
+        }
+        else
+        {
+            time = i % 4000;
+            expect.count        += threads;
+            expect.totalRspTime += (int64_t)time * threads;
+            expect.maxRspTime    = max(expect.maxRspTime, time);
+            if (time != 0 && (expect.minRspTime == 0 || time < expect.minRspTime))
+            {
+                expect.minRspTime = time;
+            }
+        }
+
+        vector<int>::iterator it = upper_bound(tp.begin(), tp.end(), time);
+        if (it != tp.end())
+        {
+            expect.intervalCount[*it] += threads;
+        }
+    }
+
+    assert(body == expect);
+
+    //取走后清零
+    assert(!counter->get(body));
+
+    cout << "testCounter ok" << endl;
+}
+
+/**
+ * 高精度分布: 桶的上界不小于原值, 相对误差不超过1/16, 分位数和精确值一致
+ */
+void testHist()
+{
+    for (int64_t v = 0; v < ((int64_t)1 << 31); v = v * 1.01 + 1)
+    {
+        int index = StatCounter::getHistIndex(v);
+        assert(index >= 0 && index < StatCounter::HIST_BUCKETS);
+        assert(index == 0 || StatCounter::getHistValue(index - 1) < v);
+
+        int64_t upper = StatCounter::getHistValue(index);
+        assert(upper >= v && upper - v <= v / 16);
+    }
+    assert(StatCounter::getHistIndex(((int64_t)1 << 40)) == StatCounter::HIST_BUCKETS - 1);
+
+    StatMicMsgHead head;
+    head.interfaceName = "testHist";
+
+    StatCounterPtr counter = new StatCounter(head, true, timePoint(), true);
+
+    srand(1);
+    vector<int64_t> values;
+    for (int i = 0; i < 100000; ++i)
+    {
+        //大部分在100us左右, 少量长尾
+        int64_t us = (i % 100 == 0) ? 10000 + rand() % 90000 : 50 + rand() % 100;
+        values.push_back(us);
+        counter->report(StatReport::STAT_SUCC, us / 1000, us);
+    }
+    counter->report(StatReport::STAT_TIMEOUT, 0, 0);
+
+    StatMicMsgBody body;
+    assert(counter->get(body));
+    assert(body.count == 100000 && body.timeoutCount == 1);
+
+    vector<int64_t> hist(StatCounter::HIST_BUCKETS, 0);
+    for (map<int, int>::iterator it = body.histCount.begin(); it != body.histCount.end(); ++it)
+    {
+        hist[it->first] += it->second;
+    }
+
+    sort(values.begin(), values.end());
+
+    double percents[] = {0.5, 0.9, 0.99, 0.999, 1};
+    for (size_t i = 0; i < sizeof(percents) / sizeof(percents[0]); ++i)
+    {
+        int64_t exact = values[(size_t)(percents[i] * values.size() + 0.5) - 1];
+        int64_t p = StatCounter::getPercentile(&hist[0], percents[i]);
+
+        assert(p == StatCounter::getHistValue(StatCounter::getHistIndex(exact)));
+    }
+
+    //不开启时不上报
+    StatCounterPtr counter2 = new StatCounter(head, true, timePoint());
+    counter2->report(StatReport::STAT_SUCC, 1, 1000);
+    assert(counter2->get(body) && body.histCount.empty());
+
+    cout << "testHist ok" << endl;
+}
+
+struct PropArg
+{
+    PropertyReport  *report;
+    int             count;
+};
+
+void *propThread(void *p)
+{
+    PropArg *arg = (PropArg*)p;
+
+    for (int i = 1; i <= arg->count; ++i)
+    {
+        arg->report->report(i % 100);
+    }
+
+    return NULL;
+}
+
+/**
+ * 多个线程同时上报属性, 各策略的结果和逐条计算的一致
+ */
+void testProperty()
+{
+    StatReport report;
+
+    int a[] = {10, 50, 100};
+    vector<int> range(a, a + sizeof(a) / sizeof(a[0]));
+
+    PropertyReportPtr p = report.createPropertyReport("testProperty",
+        PropertyReport::sum(), PropertyReport::avg(), PropertyReport::distr(range),
+        PropertyReport::max(), PropertyReport::min(), PropertyReport::count());
+
+    //槽按cache line对齐
+    assert((size_t)p.get() % 64 == 0);
+
+    //没有上报时的取值
+    vector<pair<string, string> > v = p->get();
+    assert(v.size() == 6);
+    assert(v[0].second == "0" && v[1].second == "0" && v[2].second == "10|0,50|0,100|0");
+    assert(v[3].second == "-9999999" && v[4].second == "0" && v[5].second == "0");
+
+    int threads = 8;
+    int count   = 100000;
+
+    vector<pthread_t> ids(threads);
+    PropArg arg = {p.get(), count};
+    for (int i = 0; i < threads; ++i)
+    {
+        pthread_create(&ids[i], NULL, propThread, &arg);
+    }
+    for (int i = 0; i < threads; ++i)
+    {
+        pthread_join(ids[i], NULL);
+    }
+
+    int sum = 0, distr[3] = {0};
+    for (int i = 1; i <= count; ++i)
+    {
+        int value = i % 100;
+        sum += value;
+        distr[value < 10 ? 0 : (value < 50 ? 1 : 2)]++;
+    }
+
+    v = p->get();
+    assert(v[0].first == "Sum" && v[0].second == TC_Common::tostr(sum * threads));
+    assert(v[1].first == "Avg" && v[1].second == TC_Common::tostr((double)sum / count));
+    assert(v[2].first == "Distr" && v[2].second == "10|" + TC_Common::tostr(distr[0] * threads)
+           + ",50|" + TC_Common::tostr(distr[1] * threads) + ",100|" + TC_Common::tostr(distr[2] * threads));
+    assert(v[3].first == "Max" && v[3].second == "99");
+    assert(v[4].first == "Min" && v[4].second == "1");
+    assert(v[5].first == "Count" && v[5].second == TC_Common::tostr(count * threads));
+
+    //取走后清零
+    v = p->get();
+    assert(v[0].second == "0" && v[1].second == "0" && v[2].second == "10|0,50|0,100|0");
+    assert(v[3].second == "0" && v[4].second == "0" && v[5].second == "0");
+
+    //负数的平均值: 和在64位的高32位, 不能被个数的进位或符号扩展弄错
+    p->report(-7);
+    p->report(-2);
+    p->report(3);
+    v = p->get();
+    assert(v[1].second == TC_Common::tostr((double)-6 / 3));
+
+    cout << "testProperty ok" << endl;
+}
+
+/**
+ * 每次调用都拼上报头再合并到加锁的map里(原来的做法)
+ */
+class OldReport : public TC_ThreadLock
+{
+public:
+    void report(const string &module, const string &interface, const string &ip, int iSptime)
+    {
+        StatMicMsgHead head;
+        StatMicMsgBody body;
+        head.masterName    = StatReport::trimAndLimitStr(_moduleName + "@" + ClientConfig::TarsVersion, StatReport::MAX_MASTER_NAME_LEN);
+        head.slaveName     = StatReport::trimAndLimitStr(module, StatReport::MAX_MASTER_NAME_LEN);
+        head.slaveIp       = StatReport::trimAndLimitStr(ip, StatReport::MAX_MASTER_IP_LEN);
+        head.interfaceName = StatReport::trimAndLimitStr(interface, StatReport::MAX_MASTER_NAME_LEN);
+        body.count = 1;
+        body.totalRspTime = body.minRspTime = body.maxRspTime = iSptime;
+
+        Lock lock(*this);
+        map<StatMicMsgHead, StatMicMsgBody>::iterator it = _msg.find(head);
+        if (it == _msg.end())
+        {
+            _report.getIntervCount(iSptime, body);
+            _msg[head] = body;
+        }
+        else
+        {
+            it->second.count += 1;
+            it->second.totalRspTime += iSptime;
+            _report.getIntervCount(iSptime, it->second);
+        }
+    }
+
+    string                                  _moduleName;
+    StatReport                              _report;
+    map<StatMicMsgHead, StatMicMsgBody>     _msg;
+};
+
+void bench(int count)
+{
+    string module = "TestApp.HelloServer";
+    string ip     = "10.0.0.1";
+    string func[] = {"testHello", "testVec", "testMap", "testStruct"};
+
+    OldReport old;
+    old._moduleName = "TestApp.Client";
+    old._report.resetStatInterv();
+
+    int64_t t = TC_Common::now2us();
+    for (int i = 0; i < count; ++i)
+    {
+        old.report(module, func[i % 4], ip, i % 100);
+    }
+    int64_t t1 = TC_Common::now2us() - t;
+
+    StatReport report;
+    report.resetStatInterv();
+
+    t = TC_Common::now2us();
+    for (int i = 0; i < count; ++i)
+    {
+        report.report(module, "", func[i % 4], ip, 0, StatReport::STAT_SUCC, i % 100);
+    }
+    int64_t t2 = TC_Common::now2us() - t;
+
+    //调用方缓存了StatCounter(AdapterProxy的做法)
+    StatCounterPtr counters[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        StatMicMsgHead head;
+        head.slaveName     = module;
+        head.interfaceName = func[i];
+        counters[i] = report.getStatCounter(head, true);
+    }
+
+    t = TC_Common::now2us();
+    for (int i = 0; i < count; ++i)
+    {
+        counters[i % 4]->report(StatReport::STAT_SUCC, i % 100);
+    }
+    int64_t t3 = TC_Common::now2us() - t;
+
+    cout << "head+map:" << (double)t1 * 1000 / count << "ns"
+         << " report(cached):" << (double)t2 * 1000 / count << "ns"
+         << " StatCounter:" << (double)t3 * 1000 / count << "ns" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        testCounter();
+
+        testHist();
+
+        testProperty();
+
+        bench(argc > 1 ? TC_Common::strto<int>(argv[1]) : 1000000);
+    }
+    catch(exception &ex)
+    {
+        cout << ex.what() << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,275 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+
+#include "util/tc_arena.h"
+#include "util/tc_common.h"
+#include <iostream>
+#include <cassert>
+#include <vector>
+#include <map>
+#include <string>
+
+using namespace std;
+using namespace tars;
+
+typedef vector<int, TC_ArenaAlloc<int> >                                        IntList;
+typedef map<int, IntList, less<int>, TC_ArenaAlloc<pair<const int, IntList> > > IntListMap;
+
+typedef vector<int>                 PlainIntList;
+typedef map<int, PlainIntList>      PlainIntListMap;
+
+void testCorrect()
+{
+    TC_Arena arena(1024);
+
+    {
+        TC_ArenaGuard guard(&arena);
+        assert(TC_Arena::current() == &arena);
+
+        IntListMap m;
+        for (int i = 0; i < 1000; ++i)
+        {
+            IntList &v = m[i];
+            for (int j = 0; j < i % 20; ++j)
+            {
+                v.push_back(i * j);
+            }
+            assert(v.get_allocator().arena() == &arena);
+        }
+
+        //大的分配单独成块
+        IntList big(100000, 7);
+        assert(big.back() == 7);
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            assert(m[i].size() == (size_t)(i % 20));
+            for (int j = 0; j < i % 20; ++j)
+            {
+                assert(m[i][j] == i * j);
+            }
+        }
+
+        assert(arena.used() > 100000 * sizeof(int));
+
+        guard.release();
+        assert(TC_Arena::current() == NULL);
+
+        //arena外复制的对象从堆上分配
+        IntListMap c = m;
+        assert(c.get_allocator().arena() == NULL);
+        assert(c[999].get_allocator().arena() == NULL);
+        assert(c == m);
+    }
+
+    //没有arena时退化为new/delete
+    IntList v(100, 1);
+    assert(v.get_allocator().arena() == NULL);
+
+    arena.reset();
+    assert(arena.used() == 0);
+    assert(arena.capacity() == 1024);
+
+    cout << "testCorrect ok" << endl;
+}
+
+/**
+ * 填充m, 检查所有节点和嵌套的vector都在arena上
+ */
+static void fill(IntListMap &m, int base)
+{
+    for (int i = 0; i < 100; ++i)
+    {
+        IntList &v = m[base + i];
+        v.push_back(base + i);
+    }
+}
+
+static bool onArena(const IntListMap &m, TC_Arena *arena)
+{
+    if (m.get_allocator().arena() != arena)
+    {
+        return false;
+    }
+
+    for (IntListMap::const_iterator it = m.begin(); it != m.end(); ++it)
+    {
+        if (it->second.get_allocator().arena() != arena)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void testSwap()
+{
+    TC_Arena arenaA(1024), arenaB(1024);
+
+    less<int> cmp;
+    IntListMap a(cmp, IntListMap::allocator_type(&arenaA));
+    IntListMap b(cmp, IntListMap::allocator_type(&arenaB));
+    {
+        TC_ArenaGuard guard(&arenaA);
+        fill(a, 0);
+    }
+    {
+        TC_ArenaGuard guard(&arenaB);
+        fill(b, 1000);
+    }
+
+    //同一个arena直接交换, 不复制
+    {
+        IntListMap c(cmp, a.get_allocator());
+        size_t used = arenaA.used();
+        TC_Arena::swap(a, c);
+        assert(a.empty() && c.size() == 100 && arenaA.used() == used);
+        TC_Arena::swap(a, c);
+    }
+
+    //不同arena: 内容交换, 每边的内存(包括嵌套的vector)仍在自己的arena上
+    TC_Arena::swap(a, b);
+
+    assert(a.begin()->first == 1000 && b.begin()->first == 0);
+    assert(onArena(a, &arenaA) && onArena(b, &arenaB));
+    assert(TC_Arena::current() == NULL);
+
+    //和堆上的容器交换, 堆上的一边不会拿到arena的内存
+    IntListMap h;
+    assert(h.get_allocator().arena() == NULL);
+    TC_Arena::swap(a, h);
+    assert(a.empty() && h.size() == 100 && onArena(h, NULL));
+
+    arenaA.reset();
+    assert(h.begin()->second[0] == 1000);
+
+    cout << "testSwap ok" << endl;
+}
+
+/**
+ * 业务代码保存下来的参数
+ */
+struct Cache
+{
+    IntListMap          m;
+    vector<IntList>     vl;
+};
+
+void testCopyOut()
+{
+    TC_Arena arena(1024), other(1024);
+
+    Cache cache;
+    {
+        //模拟解码一个请求
+        TC_ArenaGuard guard(&arena);
+        IntListMap m;
+        fill(m, 0);
+        IntList v(1000, 3);
+
+        //业务代码中途切到别的arena时, 复制的对象跟着当前arena
+        {
+            TC_ArenaGuard g(&other);
+            IntList t = v;
+            assert(t.get_allocator().arena() == &other);
+        }
+
+        guard.release();
+
+        //请求结束前保存到生命期更长的对象中
+        cache.m = m;
+        cache.vl.push_back(v);
+        cache.vl.push_back(m[1]);
+        IntListMap copy(m);
+        cache.m.swap(copy);
+
+        assert(onArena(cache.m, NULL));
+        assert(cache.vl[0].get_allocator().arena() == NULL);
+        assert(cache.vl[1].get_allocator().arena() == NULL);
+    }
+
+    //arena回收后, 覆盖原来的内存再读复制出来的对象
+    arena.reset();
+    {
+        TC_ArenaGuard guard(&arena);
+        IntList junk(4096, -1);
+    }
+
+    assert(cache.m.size() == 100);
+    for (IntListMap::const_iterator it = cache.m.begin(); it != cache.m.end(); ++it)
+    {
+        assert(it->second.size() == 1 && it->second[0] == it->first);
+    }
+    assert(cache.vl[0].size() == 1000 && cache.vl[0][999] == 3);
+    assert(cache.vl[1].size() == 1 && cache.vl[1][0] == 1);
+
+    cout << "testCopyOut ok" << endl;
+}
+
+template<typename M>
+int64_t build(int count, TC_Arena *arena)
+{
+    int64_t t = TC_Common::now2us();
+
+    for (int i = 0; i < count; ++i)
+    {
+        TC_ArenaGuard guard(arena);
+        {
+            M m;
+            for (int j = 0; j < 50; ++j)
+            {
+                typename M::mapped_type &v = m[j];
+                for (int k = 0; k < 20; ++k)
+                {
+                    v.push_back(k);
+                }
+            }
+        }
+
+        if (arena)
+        {
+            arena->reset();
+        }
+    }
+
+    return TC_Common::now2us() - t;
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        testCorrect();
+
+        testSwap();
+
+        testCopyOut();
+
+        int count = argc > 1 ? TC_Common::strto<int>(argv[1]) : 100000;
+
+        TC_Arena arena;
+
+        //模拟解码一个请求: 50个map节点, 每个节点一个20个元素的vector
+        cout << "new/delete  build:" << build<PlainIntListMap>(count, NULL) << "us" << endl;
+        cout << "arena       build:" << build<IntListMap>(count, &arena) << "us" << endl;
+    }
+    catch(exception &ex)
+    {
+        cout << ex.what() << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,164 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+
+#include "util/tc_cache_alloc.h"
+#include "util/tc_thread.h"
+#include "util/tc_thread_queue.h"
+#include "util/tc_common.h"
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <cstdlib>
+
+using namespace tars;
+
+/**
+ * 请求消息的大小
+ */
+struct Msg
+{
+    char data[600];
+
+    static void *operator new(size_t size) { return TC_CacheAlloc::allocate(size); }
+    static void operator delete(void *p, size_t size) { TC_CacheAlloc::deallocate(p, size); }
+};
+
+struct PlainMsg
+{
+    char data[600];
+};
+
+/**
+ * 一个线程分配, 另一个线程释放(客户端调用线程和网络线程的模式),
+ * 同时在途的个数有限, 类似有超时的请求
+ */
+template<typename T>
+class Producer : public TC_Thread
+{
+public:
+    Producer(TC_ThreadQueue<T*> &queue, int count) : _queue(queue), _count(count) {}
+
+    virtual void run()
+    {
+        for (int i = 0; i < _count; ++i)
+        {
+            while (_queue.size() > 1000)
+            {
+                TC_ThreadControl::yield();
+            }
+
+            T *t = new T;
+            t->data[0] = (char)i;
+            _queue.push_back(t);
+        }
+        _queue.push_back(NULL);
+    }
+
+protected:
+    TC_ThreadQueue<T*> &_queue;
+    int                 _count;
+};
+
+template<typename T>
+int64_t crossThread(int count)
+{
+    TC_ThreadQueue<T*> queue;
+
+    Producer<T> producer(queue, count);
+
+    int64_t t = TC_Common::now2us();
+
+    producer.start();
+
+    while (true)
+    {
+        T *p = NULL;
+        if (queue.pop_front(p, 1000))
+        {
+            if (p == NULL)
+            {
+                break;
+            }
+            delete p;
+        }
+    }
+
+    producer.getThreadControl().join();
+
+    return TC_Common::now2us() - t;
+}
+
+void testCorrect()
+{
+    //各尺寸档和大块, 写满后检查没有互相覆盖
+    vector<pair<char*, size_t> > blocks;
+
+    for (int round = 0; round < 100; ++round)
+    {
+        for (int i = 0; i < 200; ++i)
+        {
+            size_t size = rand() % 3 == 0 ? rand() % 200000 + 1 : rand() % 2048 + 1;
+            char *p = (char*)TC_CacheAlloc::allocate(size);
+            memset(p, (int)(size & 0xff), size);
+            blocks.push_back(make_pair(p, size));
+        }
+
+        while (blocks.size() > 100)
+        {
+            size_t i = rand() % blocks.size();
+            char *p     = blocks[i].first;
+            size_t size = blocks[i].second;
+
+            for (size_t j = 0; j < size; ++j)
+            {
+                assert(p[j] == (char)(size & 0xff));
+            }
+
+            TC_CacheAlloc::deallocate(p, size);
+
+            blocks[i] = blocks.back();
+            blocks.pop_back();
+        }
+    }
+
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        TC_CacheAlloc::deallocate(blocks[i].first, blocks[i].second);
+    }
+
+    cout << "testCorrect ok" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        testCorrect();
+
+        int count = argc > 1 ? TC_Common::strto<int>(argv[1]) : 1000000;
+
+        cout << "new/delete   cross thread:" << crossThread<PlainMsg>(count) << "us" << endl;
+        cout << "cache alloc  cross thread:" << crossThread<Msg>(count) << "us" << endl;
+
+        cout << TC_CacheAlloc::stat();
+    }
+    catch(exception &ex)
+    {
+        cout << ex.what() << endl;
+    }
+
+    return 0;
+}
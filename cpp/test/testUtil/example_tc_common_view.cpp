@@ -0,0 +1,194 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+
+#include "util/tc_common.h"
+#include <iostream>
+#include <cassert>
+#include <cstdlib>
+
+using namespace tars;
+
+/**
+ * 不分配内存的接口和原来返回string/vector的接口对比
+ */
+void checkSep(const string &s, const string &sep, bool withEmpty)
+{
+    vector<string> v = TC_Common::sepstr<string>(s, sep, withEmpty);
+
+    TC_StringView vt[16];
+    size_t n = TC_Common::sepstr(s, sep, vt, 16, withEmpty);
+
+    assert(n == v.size());
+    for (size_t i = 0; i < n && i < 16; ++i)
+    {
+        assert(vt[i].str() == v[i]);
+    }
+
+    //只保存前两个
+    TC_StringView vt2[2];
+    assert(TC_Common::sepstr(s, sep, vt2, 2, withEmpty) == v.size());
+}
+
+template<typename T>
+void checkInt(T t)
+{
+    char buf[32];
+    string s(buf, TC_Common::tochars(buf, t) - buf);
+
+    ostringstream os;
+    os << t;
+    assert(s == os.str());
+    assert(TC_Common::tostr(t) == os.str());
+
+    T r = 0;
+    assert(TC_Common::strto(s, r));
+    assert(r == t);
+}
+
+void testCorrect()
+{
+    const char *ss[] = {"", "|", "||", "a", "|a|b||c|", "a|b", "1.2.3", "a|b,c||d,", "|||x"};
+    for (size_t i = 0; i < sizeof(ss) / sizeof(ss[0]); ++i)
+    {
+        checkSep(ss[i], "|", true);
+        checkSep(ss[i], "|", false);
+        checkSep(ss[i], "|,", true);
+        checkSep(ss[i], "|,", false);
+    }
+
+    srand(1);
+    for (int i = 0; i < 10000; ++i)
+    {
+        int64_t v = ((int64_t)rand() << 32) ^ rand();
+        checkInt(v);
+        checkInt((int)v);
+        checkInt((short)v);
+        checkInt((uint64_t)v);
+        checkInt((unsigned int)v);
+        checkInt((int)(v % 1000));
+    }
+    checkInt(numeric_limits<int64_t>::min());
+    checkInt(numeric_limits<int64_t>::max());
+    checkInt(numeric_limits<uint64_t>::max());
+    checkInt(numeric_limits<int>::min());
+
+    int i = 7;
+    assert(!TC_Common::strto("", i) && i == 7);
+    assert(!TC_Common::strto("-", i));
+    assert(!TC_Common::strto(" 1", i));
+    assert(!TC_Common::strto("12a", i));
+    assert(!TC_Common::strto("2147483648", i));
+    assert(TC_Common::strto("-2147483648", i) && i == numeric_limits<int>::min());
+    assert(TC_Common::strto("+12", i) && i == 12);
+
+    unsigned int u = 0;
+    assert(!TC_Common::strto("-1", u));
+    assert(TC_Common::strto("4294967295", u) && u == 4294967295U);
+    assert(!TC_Common::strto("4294967296", u));
+
+    uint64_t u64 = 0;
+    assert(!TC_Common::strto("18446744073709551616", u64));
+
+    double d = 0;
+    assert(TC_Common::strto("1.5", d) && d == 1.5);
+    assert(!TC_Common::strto("1.5x", d));
+
+    const char *ts[] = {"", " ", "abc", " abc", "abc\r\n", "\t a b \n", "\r\n\t "};
+    for (size_t i = 0; i < sizeof(ts) / sizeof(ts[0]); ++i)
+    {
+        string s = ts[i];
+        assert(TC_Common::trimView(s).str() == TC_Common::trim(s));
+        assert(TC_Common::trimView(s, "\r\t").str() == TC_Common::trim(s, "\r\t"));
+
+        string t = s;
+        TC_Common::trimInPlace(t);
+        assert(t == TC_Common::trim(s));
+    }
+
+    const char *rs[][3] = {{"abcabc", "b", "xx"}, {"aaaa", "aa", "a"}, {"abc", "", "x"}, {"abc", "abcd", "x"}, {"xabcabx", "ab", ""}, {"", "a", "b"}};
+    for (size_t i = 0; i < sizeof(rs) / sizeof(rs[0]); ++i)
+    {
+        string out = "pre";
+        TC_Common::replace(rs[i][0], rs[i][1], rs[i][2], out);
+
+        string s = rs[i][0];
+        string::size_type pos = 0;
+        if (strlen(rs[i][1]) > 0)
+        {
+            while ((pos = s.find(rs[i][1], pos)) != string::npos)
+            {
+                s.replace(pos, strlen(rs[i][1]), rs[i][2]);
+                pos += strlen(rs[i][2]);
+            }
+        }
+        assert(out == "pre" + s);
+        assert(TC_Common::replace(rs[i][0], rs[i][1], rs[i][2]) == s);
+    }
+
+    cout << "testCorrect ok" << endl;
+}
+
+#define BENCH(name, count, code) \
+    { \
+        int64_t t = TC_Common::now2us(); \
+        for (int i = 0; i < count; ++i) { code; } \
+        int64_t w = TC_Common::now2us() - t; \
+        cout << name << ":" << (double)w * 1000 / count << "ns" << endl; \
+    }
+
+void bench(int count)
+{
+    string sample = "1234567890abcdef|3|12";
+    size_t n = 0;
+
+    BENCH("sepstr<string>        ", count, vector<string> v = TC_Common::sepstr<string>(sample, "|"); n += v.size());
+    BENCH("sepstr(view)          ", count, TC_StringView v[3]; n += TC_Common::sepstr(sample, "|", v, 3));
+
+    string num = "123456789";
+    BENCH("strto<int>            ", count, n += TC_Common::strto<int>(num));
+    BENCH("strto<int64_t>        ", count, n += TC_Common::strto<int64_t>(num));
+    BENCH("strto(view, int64_t)  ", count, int64_t v = 0; TC_Common::strto(num, v); n += v);
+
+    BENCH("tostr<int64_t>        ", count, n += TC_Common::tostr((int64_t)i * 7919).length());
+    BENCH("tochars               ", count, char buf[32]; n += TC_Common::tochars(buf, (int64_t)i * 7919) - buf);
+
+    string pad = "\r\t TestApp.HelloServer.HelloObj \r\t";
+    BENCH("trim                  ", count, n += TC_Common::trim(pad, "\r\t").length());
+    BENCH("trimView              ", count, n += TC_Common::trimView(pad, "\r\t").length());
+
+    string text = "select * from t where a = '$a' and b = '$a' and c = '$a'";
+    BENCH("replace               ", count, n += TC_Common::replace(text, "$a", "value").length());
+    string out;
+    BENCH("replace(view, out)    ", count, out.clear(); TC_Common::replace(text, "$a", "value", out); n += out.length());
+
+    cout << "(" << n << ")" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        testCorrect();
+
+        bench(argc > 1 ? TC_Common::strto<int>(argv[1]) : 1000000);
+    }
+    catch(exception &ex)
+    {
+        cout << ex.what() << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,395 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+
+#include "util/tc_epoll_server.h"
+#include "util/tc_clientsocket.h"
+#include "util/tc_common.h"
+#include "util/tc_thread.h"
+#include <arpa/inet.h>
+#include <cassert>
+#include <iostream>
+#include <set>
+
+using namespace tars;
+
+/**
+ * 压测接收路径: 4字节网络序包长+包体的echo服务,
+ * 对比string协议解析器(setProtocol)和零拷贝协议解析器(setSliceProtocol),
+ * 以及handle组共用队列和每个handle一个队列(HANDLE_SCHED_ROUNDROBIN),
+ * 每轮流水线发送1/16/256个请求再收齐响应;
+ * 另外不经过网络, 用同样的数据对比原来的接收路径(string追加+substr)
+ * 和TC_SharedBuffer的接收路径, 并统计收到的包占住的内存
+ */
+
+static int parseString(string &in, string &out)
+{
+    if(in.length() < sizeof(int32_t))
+    {
+        return TC_EpollServer::PACKET_LESS;
+    }
+
+    int32_t iHeaderLen;
+
+    memcpy(&iHeaderLen, in.c_str(), sizeof(int32_t));
+
+    iHeaderLen = ntohl(iHeaderLen);
+
+    if(iHeaderLen < (int32_t)sizeof(int32_t) || iHeaderLen > 10000000)
+    {
+        return TC_EpollServer::PACKET_ERR;
+    }
+
+    if((int)in.length() < iHeaderLen)
+    {
+        return TC_EpollServer::PACKET_LESS;
+    }
+
+    out = in.substr(sizeof(int32_t), iHeaderLen - sizeof(int32_t));
+
+    in  = in.substr(iHeaderLen);
+
+    return TC_EpollServer::PACKET_FULL;
+}
+
+static int parseSlice(const char *data, size_t len, size_t &pos, size_t &end)
+{
+    if(len < sizeof(int32_t))
+    {
+        return TC_EpollServer::PACKET_LESS;
+    }
+
+    int32_t iHeaderLen;
+
+    memcpy(&iHeaderLen, data, sizeof(int32_t));
+
+    iHeaderLen = ntohl(iHeaderLen);
+
+    if(iHeaderLen < (int32_t)sizeof(int32_t) || iHeaderLen > 10000000)
+    {
+        return TC_EpollServer::PACKET_ERR;
+    }
+
+    if(len < (size_t)iHeaderLen)
+    {
+        return TC_EpollServer::PACKET_LESS;
+    }
+
+    pos = sizeof(int32_t);
+
+    end = iHeaderLen;
+
+    return TC_EpollServer::PACKET_FULL;
+}
+
+static string packet(const char *data, size_t len)
+{
+    string s(sizeof(int32_t) + len, '\0');
+
+    int32_t iHeaderLen = htonl(s.length());
+
+    memcpy(&s[0], &iHeaderLen, sizeof(int32_t));
+    memcpy(&s[sizeof(int32_t)], data, len);
+
+    return s;
+}
+
+class EchoHandle : public TC_EpollServer::Handle
+{
+protected:
+    virtual void handle(const TC_EpollServer::tagRecvData &stRecvData)
+    {
+        sendResponse(stRecvData.uid, packet(stRecvData.data(), stRecvData.length()), stRecvData.ip, stRecvData.port, stRecvData.fd);
+    }
+};
+
+class ServerThread : public TC_Thread
+{
+public:
+    ServerThread(TC_EpollServer *server) : _server(server)
+    {
+    }
+
+protected:
+    virtual void run()
+    {
+        _server->waitForShutdown();
+    }
+
+    TC_EpollServer *_server;
+};
+
+static void addAdapter(TC_EpollServerPtr &server, const string &name, int port, bool bSlice, int iSchedule = TC_EpollServer::HANDLE_SCHED_QUEUE)
+{
+    TC_EpollServer::BindAdapterPtr lsPtr = new TC_EpollServer::BindAdapter(server.get());
+
+    lsPtr->setName(name);
+    lsPtr->setEndpoint("tcp -h 127.0.0.1 -p " + TC_Common::tostr(port) + " -t 60000");
+    lsPtr->setQueueCapacity(100000);
+
+    if(bSlice)
+    {
+        lsPtr->setSliceProtocol(parseSlice);
+    }
+    else
+    {
+        lsPtr->setProtocol(parseString);
+    }
+
+    lsPtr->setHandleGroupName(name);
+    lsPtr->setHandleNum(2);
+    lsPtr->setHandleSchedule(iSchedule);
+    lsPtr->setHandle<EchoHandle>();
+
+    server->bind(lsPtr);
+}
+
+static void sendAll(TC_Socket &s, const char *buf, size_t len)
+{
+    size_t n = 0;
+    while(n < len)
+    {
+        int r = s.send(buf + n, len - n);
+        if(r <= 0)
+        {
+            throw TC_Exception("send error");
+        }
+        n += r;
+    }
+}
+
+static void readAll(TC_Socket &s, char *buf, size_t len)
+{
+    size_t n = 0;
+    while(n < len)
+    {
+        int r = s.recv(buf + n, len - n);
+        if(r <= 0)
+        {
+            throw TC_Exception("recv error");
+        }
+        n += r;
+    }
+}
+
+static void bench(const string &name, int port, int pipeline, int total, size_t bodyLen)
+{
+    TC_Socket s;
+    s.createSocket();
+    s.connect("127.0.0.1", port);
+
+    string body(bodyLen, 'a');
+    string req;
+    for(int i = 0; i < pipeline; i++)
+    {
+        req += packet(body.c_str(), body.length());
+    }
+
+    vector<char> rsp(req.length());
+
+    int64_t t = TC_Common::now2us();
+
+    for(int i = 0; i < total / pipeline; i++)
+    {
+        sendAll(s, req.c_str(), req.length());
+        readAll(s, &rsp[0], rsp.size());
+    }
+
+    int64_t cost = TC_Common::now2us() - t;
+
+    cout << name << " pipeline:" << pipeline << ", body:" << bodyLen << ", requests:" << total
+         << ", cost:" << cost / 1000 << "ms, qps:" << (int64_t)total * 1000000 / (cost > 0 ? cost : 1) << endl;
+}
+
+/**
+ * 原来的接收路径: 每次read的数据追加到string, 超过8192字节或读完时用string协议解析
+ */
+static void oldRecvPath(const vector<string> &reads, vector<string> &packets)
+{
+    string recvbuffer;
+
+    for(size_t i = 0; i < reads.size(); i++)
+    {
+        recvbuffer.append(reads[i]);
+
+        while(true)
+        {
+            string ro;
+
+            if(parseString(recvbuffer, ro) != TC_EpollServer::PACKET_FULL)
+            {
+                break;
+            }
+
+            packets.push_back(ro);
+        }
+    }
+}
+
+/**
+ * 现在的接收路径: read到TC_SharedBuffer, 完整的包一次Take出来, 每个包是一个TC_SharedSlice
+ */
+static void newRecvPath(const vector<string> &reads, vector<TC_SharedSlice> &packets)
+{
+    TC_SharedBuffer recvbuffer;
+
+    for(size_t i = 0; i < reads.size(); i++)
+    {
+        recvbuffer.AssureSpace(32 * 1024);
+        memcpy(recvbuffer.WriteAddr(), reads[i].data(), reads[i].length());
+        recvbuffer.Produce(reads[i].length());
+
+        size_t total = 0;
+        size_t n = packets.size();
+
+        while(total < recvbuffer.ReadableSize())
+        {
+            size_t pos = 0, end = 0;
+
+            if(parseSlice(recvbuffer.ReadAddr() + total, recvbuffer.ReadableSize() - total, pos, end) != TC_EpollServer::PACKET_FULL)
+            {
+                break;
+            }
+
+            packets.push_back(TC_SharedSlice(NULL, recvbuffer.ReadAddr() + total + pos, end - pos));
+
+            total += end;
+        }
+
+        const char *base = recvbuffer.ReadAddr();
+
+        TC_SharedSlice data = recvbuffer.Take(total);
+
+        for(; n < packets.size(); n++)
+        {
+            packets[n].block = data.block;
+            packets[n].data  = data.data + (packets[n].data - base);
+        }
+
+        recvbuffer.Shrink();
+    }
+}
+
+static void benchRecvPath(int pipeline, int total, size_t bodyLen)
+{
+    //模拟每次read收到一轮流水线的请求, 最多32K
+    string body(bodyLen, 'a');
+    string stream;
+    for(int i = 0; i < pipeline; i++)
+    {
+        stream += packet(body.c_str(), body.length());
+    }
+
+    vector<string> reads;
+    for(size_t pos = 0; pos < stream.length(); pos += 32 * 1024)
+    {
+        reads.push_back(stream.substr(pos, 32 * 1024));
+    }
+
+    int64_t tOld = 0, tNew = 0;
+    size_t memOld = 0, memNew = 0;
+
+    for(int i = 0; i < total / pipeline; i++)
+    {
+        vector<string> oldPackets;
+        vector<TC_SharedSlice> newPackets;
+
+        int64_t t = TC_Common::now2us();
+        oldRecvPath(reads, oldPackets);
+        tOld += TC_Common::now2us() - t;
+
+        t = TC_Common::now2us();
+        newRecvPath(reads, newPackets);
+        tNew += TC_Common::now2us() - t;
+
+        assert(oldPackets.size() == (size_t)pipeline && newPackets.size() == (size_t)pipeline);
+
+        if(i == 0)
+        {
+            set<TC_SharedBlock*> blocks;
+            for(size_t j = 0; j < newPackets.size(); j++)
+            {
+                assert(string(newPackets[j].data, newPackets[j].len) == oldPackets[j]);
+
+                memOld += oldPackets[j].capacity();
+
+                if(blocks.insert(newPackets[j].block.get()).second)
+                {
+                    memNew += newPackets[j].block->Capacity();
+                }
+            }
+        }
+    }
+
+    cout << "recv path pipeline:" << pipeline << ", body:" << bodyLen << ", requests:" << total
+         << ", old:" << tOld / 1000 << "ms(" << memOld << " bytes held)"
+         << ", new:" << tNew / 1000 << "ms(" << memNew << " bytes held)" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        int total = argc > 1 ? TC_Common::strto<int>(argv[1]) : 200000;
+
+        {
+            int pipelines[] = { 1, 16, 256 };
+            size_t bodys[] = { 64, 4096 };
+
+            for(size_t b = 0; b < sizeof(bodys) / sizeof(bodys[0]); b++)
+            {
+                for(size_t i = 0; i < sizeof(pipelines) / sizeof(pipelines[0]); i++)
+                {
+                    benchRecvPath(pipelines[i], total, bodys[b]);
+                }
+            }
+        }
+
+        TC_EpollServerPtr server = new TC_EpollServer(1);
+        server->setNetThreadBufferPoolInfo(1024, 8 * 1024 * 1024, 64 * 1024 * 1024);
+
+        addAdapter(server, "StringAdapter", 19990, false);
+        addAdapter(server, "SliceAdapter", 19991, true);
+        addAdapter(server, "StealAdapter", 19992, true, TC_EpollServer::HANDLE_SCHED_ROUNDROBIN);
+
+        server->startHandle();
+        server->createEpoll();
+
+        ServerThread thread(server.get());
+        thread.start();
+
+        int pipelines[] = { 1, 16, 256 };
+        size_t bodys[] = { 64, 4096 };
+
+        for(size_t b = 0; b < sizeof(bodys) / sizeof(bodys[0]); b++)
+        {
+            for(size_t i = 0; i < sizeof(pipelines) / sizeof(pipelines[0]); i++)
+            {
+                bench("string", 19990, pipelines[i], total, bodys[b]);
+                bench("slice ", 19991, pipelines[i], total, bodys[b]);
+                bench("steal ", 19992, pipelines[i], total, bodys[b]);
+            }
+        }
+
+        server->terminate();
+        thread.getThreadControl().join();
+    }
+    catch(exception &ex)
+    {
+        cout << ex.what() << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,323 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+
+#include "util/tc_epoll_server.h"
+#include "util/tc_common.h"
+#include "util/tc_thread.h"
+#include <arpa/inet.h>
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <set>
+
+using namespace tars;
+
+/**
+ * SO_REUSEPORT多监听模式(BindAdapter::setReusePort):
+ * 多个网络线程时每个网络线程各自监听、各自accept, 所有连接都能收到响应;
+ * 只有一个网络线程或者是本地socket(端口为0)时退回单线程accept的方式, 连接也都正常处理
+ */
+
+#define NET_THREAD_NUM  4
+#define CONN_NUM        32
+
+#define LOCAL_PATH      "/tmp/example_tc_epoll_server_reuseport.sock"
+
+//服务端看到的连接uid -> 处理它的网络线程序号(uid中编码的序号, 从1开始)
+static TC_ThreadMutex           g_mutex;
+static map<uint32_t, size_t>    g_conns;
+
+static int parse(string &in, string &out)
+{
+    if(in.length() < sizeof(int32_t))
+    {
+        return TC_EpollServer::PACKET_LESS;
+    }
+
+    int32_t iHeaderLen;
+
+    memcpy(&iHeaderLen, in.c_str(), sizeof(int32_t));
+
+    iHeaderLen = ntohl(iHeaderLen);
+
+    if(iHeaderLen < (int32_t)sizeof(int32_t) || iHeaderLen > 10000000)
+    {
+        return TC_EpollServer::PACKET_ERR;
+    }
+
+    if((int)in.length() < iHeaderLen)
+    {
+        return TC_EpollServer::PACKET_LESS;
+    }
+
+    out = in.substr(sizeof(int32_t), iHeaderLen - sizeof(int32_t));
+
+    in  = in.substr(iHeaderLen);
+
+    return TC_EpollServer::PACKET_FULL;
+}
+
+static string packet(const string &body)
+{
+    string s(sizeof(int32_t), '\0');
+
+    int32_t iHeaderLen = htonl(sizeof(int32_t) + body.length());
+
+    memcpy(&s[0], &iHeaderLen, sizeof(int32_t));
+
+    return s + body;
+}
+
+class EchoHandle : public TC_EpollServer::Handle
+{
+protected:
+    virtual void handle(const TC_EpollServer::tagRecvData &stRecvData)
+    {
+        {
+            TC_LockT<TC_ThreadMutex> lock(g_mutex);
+
+            g_conns[stRecvData.uid] = (stRecvData.uid >> 22) & 0xF;
+        }
+
+        sendResponse(stRecvData.uid, packet(string(stRecvData.data(), stRecvData.length())), stRecvData.ip, stRecvData.port, stRecvData.fd);
+    }
+};
+
+class ServerThread : public TC_Thread
+{
+public:
+    ServerThread(TC_EpollServer *server) : _server(server)
+    {
+    }
+
+protected:
+    virtual void run()
+    {
+        _server->waitForShutdown();
+    }
+
+    TC_EpollServer *_server;
+};
+
+static TC_EpollServer::BindAdapterPtr addAdapter(TC_EpollServerPtr &server, const string &name, const string &host, int port)
+{
+    TC_EpollServer::BindAdapterPtr lsPtr = new TC_EpollServer::BindAdapter(server.get());
+
+    lsPtr->setName(name);
+    lsPtr->setEndpoint("tcp -h " + host + " -p " + TC_Common::tostr(port) + " -t 60000");
+    lsPtr->setProtocol(parse);
+    lsPtr->setHandleGroupName(name);
+    lsPtr->setHandleNum(1);
+    lsPtr->setHandle<EchoHandle>();
+    lsPtr->setReusePort(true);
+
+    server->bind(lsPtr);
+
+    return lsPtr;
+}
+
+/**
+ * 有这个adapter监听socket的网络线程数, 各线程的监听fd不能重复
+ */
+static size_t listenThreads(TC_EpollServerPtr &server, const string &name)
+{
+    vector<TC_EpollServer::NetThread*> netThreads = server->getNetThread();
+
+    size_t num = 0;
+    set<int> fds;
+
+    for(size_t i = 0; i < netThreads.size(); i++)
+    {
+        map<int, TC_EpollServer::BindAdapterPtr> listeners = netThreads[i]->getListenSocketInfo();
+
+        for(map<int, TC_EpollServer::BindAdapterPtr>::iterator it = listeners.begin(); it != listeners.end(); ++it)
+        {
+            if(it->second->getName() == name)
+            {
+                assert(fds.insert(it->first).second);
+                ++num;
+            }
+        }
+    }
+
+    return num;
+}
+
+static void readAll(TC_Socket &s, char *buf, size_t len)
+{
+    size_t n = 0;
+    while(n < len)
+    {
+        int r = s.recv(buf + n, len - n);
+        if(r <= 0)
+        {
+            throw TC_Exception("recv error");
+        }
+        n += r;
+    }
+}
+
+/**
+ * 同时建立num个连接, 每个连接发一个请求并收到echo,
+ * 返回服务端处理这些连接的网络线程个数
+ */
+static size_t connectAll(TC_EpollServerPtr &server, const string &host, int port, int num)
+{
+    {
+        TC_LockT<TC_ThreadMutex> lock(g_mutex);
+
+        g_conns.clear();
+    }
+
+    vector<TC_Socket> socks(num);
+
+    for(int i = 0; i < num; i++)
+    {
+        socks[i].createSocket();
+        socks[i].connect(host, port);
+    }
+
+    for(int i = 0; i < num; i++)
+    {
+        string req = packet("conn" + TC_Common::tostr(i));
+
+        assert(socks[i].send(req.c_str(), req.length()) == (int)req.length());
+    }
+
+    for(int i = 0; i < num; i++)
+    {
+        string rsp = packet("conn" + TC_Common::tostr(i));
+
+        vector<char> buf(rsp.length());
+
+        readAll(socks[i], &buf[0], buf.size());
+
+        assert(string(&buf[0], buf.size()) == rsp);
+    }
+
+    assert(server->getConnectionCount() == (size_t)num);
+
+    set<size_t> threads;
+
+    {
+        TC_LockT<TC_ThreadMutex> lock(g_mutex);
+
+        assert(g_conns.size() == (size_t)num);
+
+        for(map<uint32_t, size_t>::iterator it = g_conns.begin(); it != g_conns.end(); ++it)
+        {
+            threads.insert(it->second);
+        }
+    }
+
+    for(int i = 0; i < num; i++)
+    {
+        socks[i].close();
+    }
+
+    //等服务端关闭连接
+    for(int i = 0; i < 100 && server->getConnectionCount() > 0; i++)
+    {
+        usleep(10000);
+    }
+
+    return threads.size();
+}
+
+/**
+ * 多个网络线程: 每个网络线程都有自己的监听socket, 连接分散到多个网络线程accept, 都能收到响应;
+ * 同一个server中本地socket(端口为0)的adapter忽略reuseport, 只有一个网络线程绑定
+ */
+void testReusePort()
+{
+    TC_EpollServerPtr server = new TC_EpollServer(NET_THREAD_NUM);
+    server->setNetThreadBufferPoolInfo(1024, 8 * 1024 * 1024, 64 * 1024 * 1024);
+
+    TC_EpollServer::BindAdapterPtr reuse = addAdapter(server, "ReuseAdapter", "127.0.0.1", 19993);
+    TC_EpollServer::BindAdapterPtr local = addAdapter(server, "LocalAdapter", LOCAL_PATH, 0);
+
+    assert(reuse->isReusePort());
+    assert(listenThreads(server, "ReuseAdapter") == NET_THREAD_NUM);
+
+    assert(!local->isReusePort());
+    assert(listenThreads(server, "LocalAdapter") == 1);
+
+    server->startHandle();
+    server->createEpoll();
+
+    ServerThread thread(server.get());
+    thread.start();
+
+    size_t threads = connectAll(server, "127.0.0.1", 19993, CONN_NUM);
+
+    cout << "testReusePort reuseport connections:" << CONN_NUM << " accept threads:" << threads << endl;
+
+    //CONN_NUM个连接按四元组hash到NET_THREAD_NUM个监听socket, 不会都落在一个上
+    assert(threads > 1);
+
+    server->terminate();
+    thread.getThreadControl().join();
+
+    unlink(LOCAL_PATH);
+
+    cout << "testReusePort ok" << endl;
+}
+
+/**
+ * 只有一个网络线程时忽略reuseport, 退回单线程accept, 连接都正常处理
+ */
+void testSingleNetThread()
+{
+    TC_EpollServerPtr server = new TC_EpollServer(1);
+    server->setNetThreadBufferPoolInfo(1024, 8 * 1024 * 1024, 64 * 1024 * 1024);
+
+    TC_EpollServer::BindAdapterPtr lsPtr = addAdapter(server, "SingleAdapter", "127.0.0.1", 19994);
+
+    assert(!lsPtr->isReusePort());
+    assert(listenThreads(server, "SingleAdapter") == 1);
+
+    server->startHandle();
+    server->createEpoll();
+
+    ServerThread thread(server.get());
+    thread.start();
+
+    size_t threads = connectAll(server, "127.0.0.1", 19994, CONN_NUM);
+
+    assert(threads == 1);
+
+    server->terminate();
+    thread.getThreadControl().join();
+
+    cout << "testSingleNetThread ok" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        testReusePort();
+
+        testSingleNetThread();
+    }
+    catch(exception &ex)
+    {
+        cout << ex.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
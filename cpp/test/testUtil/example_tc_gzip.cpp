@@ -38,6 +38,35 @@ int main(int argc, char *argv[])
 
             assert(file == s1);
         }
+
+        {
+            //限制解压后的长度
+            vector<char> v;
+            tars::TC_GZip::compress(&file[0], file.size(), v);
+
+            string s;
+            assert(tars::TC_GZip::uncompress(&v[0], v.size(), file.size(), s));
+            assert(s == string(&file[0], file.size()));
+
+            assert(tars::TC_GZip::uncompress(&v[0], v.size(), file.size() * 2, s));
+            assert(s.length() == file.size());
+
+            assert(!tars::TC_GZip::uncompress(&v[0], v.size(), file.size() - 1, s));
+            assert(s.empty());
+
+            //不完整的数据
+            assert(!tars::TC_GZip::uncompress(&v[0], v.size() / 2, file.size(), s));
+
+            //压缩比很高的数据, 超过限制时不会全部解压
+            string zero(64 * 1024 * 1024, '\0');
+            tars::TC_GZip::compress(zero.data(), zero.length(), v);
+            zero = string();
+
+            assert(!tars::TC_GZip::uncompress(&v[0], v.size(), 4096, s));
+            assert(s.capacity() < 1024 * 1024);
+
+            cout << "uncompress with limit ok, bomb size:" << v.size() << endl;
+        }
     }
     catch(exception &ex)
     {
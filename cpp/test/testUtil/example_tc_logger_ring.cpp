@@ -0,0 +1,503 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+
+#include "util/tc_logger.h"
+#include "util/tc_common.h"
+#include "util/tc_file.h"
+#include <iostream>
+#include <cassert>
+
+using namespace std;
+using namespace tars;
+
+/**
+ * 记录每个线程收到的最后一个序号, 检查不丢、不乱序
+ */
+class CheckRoll : public TC_LoggerRoll
+{
+public:
+    CheckRoll() : _total(0), _bad(0) {}
+
+    virtual void roll(const deque<pair<int, string> > &ds)
+    {
+        for (deque<pair<int, string> >::const_iterator it = ds.begin(); it != ds.end(); ++it)
+        {
+            vector<string> v = TC_Common::sepstr<string>(it->second, "|");
+            if (v.size() < 2)
+            {
+                continue;
+            }
+
+            int tid = TC_Common::strto<int>(v[0]);
+            int seq = TC_Common::strto<int>(v[1]);
+
+            if (_last.size() <= (size_t)tid)
+            {
+                _last.resize(tid + 1, -1);
+            }
+
+            if (seq <= _last[tid] && _overflow != OVERFLOW_DROP)
+            {
+                ++_bad;
+            }
+            _last[tid] = seq;
+            ++_total;
+        }
+    }
+
+    int overflow() const { return _overflow; }
+
+    vector<int>     _last;
+    size_t          _total;
+    size_t          _bad;
+};
+
+typedef TC_AutoPtr<CheckRoll> CheckRollPtr;
+
+struct WriteArg
+{
+    TC_LoggerRoll * roll;
+    int             tid;
+    int             count;
+    size_t          len;
+    pthread_barrier_t * barrier;
+};
+
+void *writeThread(void *p)
+{
+    WriteArg *arg = (WriteArg*)p;
+
+    string pad(arg->len, 'x');
+    for (int i = 0; i < arg->count; ++i)
+    {
+        string s = TC_Common::tostr(arg->tid) + "|" + TC_Common::tostr(i) + "|" + pad + "\n";
+        arg->roll->write(s.data(), s.length());
+    }
+
+    //写完后等所有线程都写完再退出, 线程序号不会被复用
+    if (arg->barrier)
+    {
+        pthread_barrier_wait(arg->barrier);
+    }
+
+    return NULL;
+}
+
+void runThreads(TC_LoggerRoll *roll, int threads, int count, size_t len, pthread_barrier_t *barrier = NULL)
+{
+    vector<pthread_t> ids(threads);
+    vector<WriteArg> args(threads);
+
+    for (int i = 0; i < threads; ++i)
+    {
+        args[i].roll  = roll;
+        args[i].tid   = i;
+        args[i].count = count;
+        args[i].len   = len;
+        args[i].barrier = barrier;
+        pthread_create(&ids[i], NULL, writeThread, &args[i]);
+    }
+
+    for (int i = 0; i < threads; ++i)
+    {
+        pthread_join(ids[i], NULL);
+    }
+}
+
+void testRing()
+{
+    //新建的roll默认满时直接写, 不丢日志
+    CheckRollPtr roll = new CheckRoll();
+    assert(roll->overflow() == TC_LoggerRoll::OVERFLOW_SYNC);
+
+    TC_LoggerRing ring(100);
+    assert(ring.capacity() == 128);
+
+    deque<pair<int, string> > ds;
+
+    //回绕多次, 每次取出的内容和写入的一致
+    for (int i = 0; i < 1000; ++i)
+    {
+        string s(i % 40, 'a' + i % 26);
+        assert(ring.push(i, s.data(), s.length()));
+        assert(ring.pop(ds) == 1);
+        assert(ds.back().first == i);
+        assert(ds.back().second == s);
+    }
+
+    //写满
+    size_t n = 0;
+    while (ring.push(0, "12345678", 8))
+    {
+        ++n;
+    }
+    assert(n == 8);
+    ds.clear();
+    assert(ring.pop(ds) == n);
+    assert(ring.used() == 0);
+
+    cout << "testRing ok" << endl;
+}
+
+void testPolicy(int overflow, const char *name)
+{
+    TC_LoggerThreadGroup group;
+    group.start(1);
+
+    CheckRollPtr roll = new CheckRoll();
+    roll->setRing(4096, overflow);
+    roll->setupThread(&group);
+
+    int threads = 8;
+    int count   = 20000;
+
+    runThreads(roll.get(), threads, count, 64);
+
+    roll->unSetupThread();
+
+    size_t expect = (size_t)threads * count;
+
+    cout << name << ": total=" << roll->_total << " bad=" << roll->_bad
+         << " drop=" << roll->getDropCount() << " block=" << roll->getBlockCount()
+         << " sync=" << roll->getSyncCount() << endl;
+
+    assert(roll->_bad == 0);
+    if (overflow == TC_LoggerRoll::OVERFLOW_DROP)
+    {
+        //多出来的一条是丢弃的提示
+        assert(roll->_total + roll->getDropCount() == expect);
+    }
+    else
+    {
+        assert(roll->_total == expect);
+    }
+}
+
+/**
+ * 同时写日志的线程超过一块缓冲区指针(RING_CHUNK), 后面的块用到时才分配, 不丢不乱序
+ */
+void testChunks()
+{
+    TC_LoggerThreadGroup group;
+    group.start(1);
+
+    CheckRollPtr roll = new CheckRoll();
+    roll->setRing(1024, TC_LoggerRoll::OVERFLOW_BLOCK);
+    roll->setupThread(&group);
+
+    int threads = TC_LoggerRoll::RING_CHUNK * 2 + 10;
+    int count   = 200;
+
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, threads);
+
+    runThreads(roll.get(), threads, count, 16, &barrier);
+
+    pthread_barrier_destroy(&barrier);
+
+    roll->unSetupThread();
+
+    assert(roll->_bad == 0);
+    assert(roll->_total == (size_t)threads * count);
+
+    cout << "testChunks ok" << endl;
+}
+
+/**
+ * 收集写入的文本
+ */
+class TextRoll : public TC_LoggerRoll
+{
+public:
+    virtual void roll(const deque<pair<int, string> > &ds)
+    {
+        for (deque<pair<int, string> >::const_iterator it = ds.begin(); it != ds.end(); ++it)
+        {
+            _lines.push_back(it->second);
+        }
+    }
+
+    vector<string>  _lines;
+};
+
+typedef TC_AutoPtr<TextRoll> TextRollPtr;
+
+/**
+ * 线程已经有缓冲区后再调大setRing, 介于新旧大小之间的日志不能卡住或者丢掉
+ */
+void testGrowRing()
+{
+    TC_LoggerThreadGroup group;
+    group.start(1);
+
+    TextRollPtr roll = new TextRoll();
+    roll->setRing(1024, TC_LoggerRoll::OVERFLOW_BLOCK);
+    roll->setupThread(&group);
+
+    string small = "small\n";
+    roll->write(small.data(), small.length());
+
+    //当前线程的缓冲区还是1024
+    roll->setRing(64 * 1024, TC_LoggerRoll::OVERFLOW_BLOCK);
+
+    string big = string(2000, 'g') + "\n";
+    roll->write(big.data(), big.length());
+    roll->write(small.data(), small.length());
+
+    roll->unSetupThread();
+
+    assert(roll->_lines.size() == 3);
+    assert(roll->_lines[0] == small && roll->_lines[1] == big && roll->_lines[2] == small);
+    assert(roll->getBlockCount() == 0 && roll->getDropCount() == 0);
+    assert(roll->getSyncCount() == 1);
+
+    cout << "testGrowRing ok" << endl;
+}
+
+void testRecord()
+{
+    string big(1000, 'b');
+
+    TC_LoggerThreadGroup group;
+    group.start(1);
+
+    for (int async = 0; async < 2; ++async)
+    {
+        TextRollPtr roll = new TextRoll();
+        if (async)
+        {
+            roll->setupThread(&group);
+        }
+
+        (LoggerRecord("H|", "{}|{}|{}|{}|{}", roll.get()), 1, -2, "abc", string("def"), 2.5);
+        (LoggerRecord("H|", "{}{}", roll.get()), 'x', (unsigned long)-1, 7, (void*)NULL);
+        LoggerRecord("H|", "{}|{}|end", roll.get()) << true;
+        LoggerRecord("H|", "{}\n", roll.get()) << big;
+        LoggerRecord(NULL, "{}", roll.get()) << 1;
+
+        {
+            //格式串拷贝进了记录, 写日志线程格式化之前改掉也不影响
+            string fmt = "{}|copied|{}";
+            (LoggerRecord("H|", fmt.c_str(), roll.get(), true), 3, "x");
+            fmt.assign(fmt.length(), '#');
+
+            //默认拷贝, 栈上的字符数组也一样
+            char buf[32];
+            strcpy(buf, "{}|stack|{}");
+            (LoggerRecord("H|", buf, roll.get()), 4, "y");
+            memset(buf, '#', strlen(buf));
+
+            //常量只记地址
+            (LoggerRecord("H|", "{}|literal", roll.get(), false), 5);
+        }
+
+        roll->unSetupThread();
+
+        assert(roll->_lines.size() == 7);
+        assert(roll->_lines[0] == "H|1|-2|abc|def|2.5\n");
+        assert(roll->_lines[1] == "H|x184467440737095516157" + string("0\n"));
+        assert(roll->_lines[2] == "H|1|{}|end\n");
+        assert(roll->_lines[3] == "H|" + big + "\n");
+        assert(roll->_lines[4] == "H|3|copied|x\n");
+        assert(roll->_lines[5] == "H|4|stack|y\n");
+        assert(roll->_lines[6] == "H|5|literal\n");
+    }
+
+    cout << "testRecord ok" << endl;
+}
+
+void testLogf()
+{
+    TC_LoggerThreadGroup group;
+    group.start(1);
+
+    string file = "./example_tc_logger_logf";
+    TC_File::removeFile(file + ".log", false);
+
+    {
+        TC_RollLogger logger;
+        logger.init(file, 1024 * 1024, 1);
+        logger.setupThread(&group);
+
+        //logf默认拷贝格式串, 返回后改掉栈上的数组不影响
+        char buf[32];
+        strcpy(buf, "|{}|stack|{}");
+        (logger.logf(TC_RollLogger::ERROR_LOG, buf), 1, "a");
+        memset(buf, '#', strlen(buf));
+
+        (logger.anyf(string("|{}|string")), 2);
+        (logger.logf(TC_RollLogger::ERROR_LOG, TC_LOGFMT("|{}|literal")), 3);
+        (logger.anyf(TC_LOGFMT("|{}|any")), 4);
+
+        logger.unSetupThread();
+    }
+
+    string s = TC_File::load2str(file + ".log");
+    assert(s.find("|1|stack|a\n") != string::npos);
+    assert(s.find("|2|string\n") != string::npos);
+    assert(s.find("|3|literal\n") != string::npos);
+    assert(s.find("|4|any\n") != string::npos);
+    assert(s.find("#") == string::npos);
+
+    TC_File::removeFile(file + ".log", false);
+
+    cout << "testLogf ok" << endl;
+}
+
+TC_RollLogger *g_logger = NULL;
+
+void *benchThread(void *p)
+{
+    int count = *(int*)p;
+
+    for (int i = 0; i < count; ++i)
+    {
+        g_logger->debug() << "|" << i << "|" << "benchmark line for the logger ring" << endl;
+    }
+
+    return NULL;
+}
+
+void *benchRecordThread(void *p)
+{
+    int count = *(int*)p;
+    string ip = "192.168.1.1";
+
+    for (int i = 0; i < count; ++i)
+    {
+        (g_logger->logf(TC_RollLogger::DEBUG_LOG, TC_LOGFMT("|{}|{}|{}|{}")), ip, i, 3.14, "benchmark line for the logger record");
+    }
+
+    return NULL;
+}
+
+void *benchStreamThread(void *p)
+{
+    int count = *(int*)p;
+    string ip = "192.168.1.1";
+
+    for (int i = 0; i < count; ++i)
+    {
+        g_logger->debug() << "|" << ip << "|" << i << "|" << 3.14 << "|" << "benchmark line for the logger record" << endl;
+    }
+
+    return NULL;
+}
+
+int64_t threadCpuUs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void benchRecord(int count, bool record)
+{
+    TC_LoggerThreadGroup group;
+    group.start(1);
+
+    TC_RollLogger logger;
+    logger.init("./example_tc_logger_record", 100 * 1024 * 1024, 2);
+    logger.getRoll()->setRing(1024 * 1024, TC_LoggerRoll::OVERFLOW_SYNC);
+    logger.setupThread(&group);
+    g_logger = &logger;
+
+    int64_t t = threadCpuUs();
+
+    if (record)
+    {
+        benchRecordThread(&count);
+    }
+    else
+    {
+        benchStreamThread(&count);
+    }
+
+    int64_t w = threadCpuUs() - t;
+
+    logger.unSetupThread();
+
+    cout << (record ? "logf  " : "stream") << " cpu:" << w << "us per line:" << (double)w * 1000 / count << "ns" << endl;
+}
+
+void bench(int threads, int count, size_t ringSize)
+{
+    TC_LoggerThreadGroup group;
+    group.start(1);
+
+    TC_RollLogger logger;
+    logger.init("./example_tc_logger_ring", 100 * 1024 * 1024, 2);
+    logger.getRoll()->setRing(ringSize, TC_LoggerRoll::OVERFLOW_SYNC);
+    logger.setupThread(&group);
+    g_logger = &logger;
+
+    int64_t t = TC_Common::now2us();
+
+    vector<pthread_t> ids(threads);
+    for (int i = 0; i < threads; ++i)
+    {
+        pthread_create(&ids[i], NULL, benchThread, &count);
+    }
+    for (int i = 0; i < threads; ++i)
+    {
+        pthread_join(ids[i], NULL);
+    }
+
+    int64_t w = TC_Common::now2us() - t;
+
+    logger.unSetupThread();
+
+    cout << "threads:" << threads << " ring:" << ringSize << " write:" << w << "us"
+         << " per line:" << (double)w * 1000 / ((int64_t)threads * count) << "ns" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        testRing();
+
+        testPolicy(TC_LoggerRoll::OVERFLOW_SYNC, "sync");
+        testPolicy(TC_LoggerRoll::OVERFLOW_BLOCK, "block");
+        testPolicy(TC_LoggerRoll::OVERFLOW_DROP,  "drop");
+
+        testChunks();
+
+        testGrowRing();
+
+        testRecord();
+
+        testLogf();
+
+        int count = argc > 1 ? TC_Common::strto<int>(argv[1]) : 100000;
+
+        for (int threads = 1; threads <= 16; threads *= 4)
+        {
+            bench(threads, count, 0);
+            bench(threads, count, 1024 * 1024);
+        }
+
+        //在写日志的线程中的耗时, 格式化在写日志线程中做
+        benchRecord(count, false);
+        benchRecord(count, true);
+    }
+    catch(exception &ex)
+    {
+        cout << ex.what() << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,148 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+
+#include "util/tc_lz4.h"
+#include "util/tc_gzip.h"
+#include "util/tc_common.h"
+#include <iostream>
+#include <cassert>
+#include <cstdlib>
+
+using namespace std;
+using namespace tars;
+
+void check(const string &src)
+{
+    string c;
+    assert(TC_LZ4::compress(src.data(), src.length(), c));
+    assert(c.length() <= TC_LZ4::compressBound(src.length()));
+
+    string d = "prefix";
+    assert(TC_LZ4::uncompress(c.data(), c.length(), src.length(), d));
+    assert(d == "prefix" + src);
+
+    //原始长度不对
+    string e;
+    assert(!TC_LZ4::uncompress(c.data(), c.length(), src.length() + 1, e));
+    assert(e.empty());
+}
+
+/**
+ * 模拟远程日志的内容
+ */
+string makeLog(size_t lines)
+{
+    string s;
+    for (size_t i = 0; i < lines; ++i)
+    {
+        s += "2026-10-17 12:00:" + TC_Common::tostr(i % 60) + "|10.0.0." + TC_Common::tostr(i % 200)
+           + "|TestApp.HelloServer|sayHello|" + TC_Common::tostr(i * 7919 % 100000) + "|0|succ\n";
+    }
+    return s;
+}
+
+void testCorrect()
+{
+    check("");
+    check("a");
+    check("abcdefghijklm");
+    check(string(100000, 'x'));
+    check(makeLog(1000));
+
+    string r;
+    srand(1);
+    for (int i = 0; i < 100000; ++i)
+    {
+        r += (char)(rand() % 256);
+    }
+    check(r);
+
+    //短周期的重复, 匹配和自身重叠
+    string p;
+    for (int i = 0; i < 10000; ++i)
+    {
+        p += "ab";
+    }
+    check(p);
+
+    //随便改坏的数据不能越界
+    string src = makeLog(100);
+    string c;
+    TC_LZ4::compress(src.data(), src.length(), c);
+    for (size_t i = 0; i < c.length(); ++i)
+    {
+        string bad = c;
+        bad[i] = (char)(bad[i] ^ 0x5a);
+        string d;
+        TC_LZ4::uncompress(bad.data(), bad.length(), src.length(), d);
+
+        d.clear();
+        TC_LZ4::uncompress(bad.data(), i, src.length(), d);
+    }
+
+    cout << "testCorrect ok" << endl;
+}
+
+void bench(int count)
+{
+    string src = makeLog(10000);
+
+    string c;
+    int64_t t = TC_Common::now2us();
+    for (int i = 0; i < count; ++i)
+    {
+        c.clear();
+        TC_LZ4::compress(src.data(), src.length(), c);
+    }
+    int64_t tc = TC_Common::now2us() - t;
+
+    string d;
+    t = TC_Common::now2us();
+    for (int i = 0; i < count; ++i)
+    {
+        d.clear();
+        TC_LZ4::uncompress(c.data(), c.length(), src.length(), d);
+    }
+    int64_t td = TC_Common::now2us() - t;
+
+    vector<char> g;
+    t = TC_Common::now2us();
+    for (int i = 0; i < count; ++i)
+    {
+        TC_GZip::compress(src.data(), src.length(), g);
+    }
+    int64_t tg = TC_Common::now2us() - t;
+
+    cout << "raw:" << src.length() << " lz4:" << c.length() << " gzip:" << g.size() << endl;
+    cout << "lz4  compress:" << (double)src.length() * count / tc << "MB/s uncompress:" << (double)src.length() * count / td << "MB/s" << endl;
+    cout << "gzip compress:" << (double)src.length() * count / tg << "MB/s" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        testCorrect();
+
+        bench(argc > 1 ? TC_Common::strto<int>(argv[1]) : 100);
+    }
+    catch(exception &ex)
+    {
+        cout << ex.what() << endl;
+    }
+
+    return 0;
+}
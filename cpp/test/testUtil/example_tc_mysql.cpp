@@ -15,6 +15,7 @@
  */
 
 #include "util/tc_mysql.h"
+#include "util/tc_common.h"
 #include <iostream>
 
 using namespace tars;
@@ -45,6 +46,23 @@ void testInsert()
     mysql.updateRecord("t_user_logs", m, "where ID=2234");
 }
 
+void testBulk()
+{
+    //BM_LOAD_DATA要求init时带CLIENT_LOCAL_FILES, 生成的TSV见example_tc_mysql_bulk
+    TC_MysqlBulk bulk(&mysql, TC_MysqlBulk::BM_INSERT, 100);
+    bulk.begin("t_user_logs", "ID,USERID,APP");
+    for(int i = 0; i < 1000; i++)
+    {
+        bulk.addInt(10000 + i);
+        bulk.addStr("user\t'" + TC_Common::tostr(i));
+        bulk.addStr("app");
+        bulk.endRow();
+    }
+    bulk.flush();
+
+    cout << "rows:" << bulk.total() << endl;
+}
+
 int main(int argc, char *argv[])
 {
     try
@@ -60,6 +78,8 @@ int main(int argc, char *argv[])
         mysql.execute("select * from t_app_users");
         test();
 
+        testBulk();
+
 //        sleep(10);
 //        test();
     }
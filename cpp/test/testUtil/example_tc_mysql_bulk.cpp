@@ -0,0 +1,200 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+
+#include "util/tc_mysql.h"
+#include "util/tc_common.h"
+#include <iostream>
+#include <cassert>
+
+using namespace std;
+using namespace tars;
+
+/**
+ * 不连数据库, 记下每次要写入的内容
+ */
+class BulkRecorder : public TC_MysqlBulk
+{
+public:
+    BulkRecorder(TC_Mysql *pMysql, BulkMode eMode, size_t iMaxRows, size_t iMaxPacket)
+    : TC_MysqlBulk(pMysql, eMode, iMaxRows, iMaxPacket)
+    {
+    }
+
+    vector<string>  written;
+
+protected:
+    virtual void write()
+    {
+        written.push_back(_buffer);
+    }
+};
+
+//没有连接, 字符串字段只用于load data
+TC_Mysql mysql;
+
+void testLoadDataEscape()
+{
+    BulkRecorder bulk(&mysql, TC_MysqlBulk::BM_LOAD_DATA, 1000, 1024*1024);
+    bulk.begin("t_test", "a,b,c,d");
+
+    bulk.addStr(string("tab\tlf\ncr\rbs\\nul\0end", 20));
+    bulk.addNull();
+    bulk.addInt(-12);
+    bulk.addStr("plain 'quote' \"dq\"");
+    bulk.endRow();
+
+    //空串和NULL不同
+    bulk.addStr("");
+    bulk.addNull();
+    bulk.addInt(0);
+    bulk.addStr("\\N");
+    bulk.endRow();
+
+    assert(bulk.pending() == 2);
+    assert(bulk.buffer() ==
+           "tab\\tlf\\ncr\\rbs\\\\nul\\0end\t\\N\t-12\tplain 'quote' \"dq\"\n"
+           "\t\\N\t0\t\\\\N\n");
+
+    assert(bulk.flush() == 2);
+    assert(bulk.written.size() == 1);
+    assert(bulk.pending() == 0 && bulk.buffer().empty());
+
+    cout << "testLoadDataEscape ok" << endl;
+}
+
+void testInsertMaxRows()
+{
+    BulkRecorder bulk(&mysql, TC_MysqlBulk::BM_INSERT, 3, 1024*1024);
+    bulk.begin("t_test", "a,b");
+
+    for(int i = 0; i < 7; i++)
+    {
+        bulk.addInt(i);
+        bulk.addNull();
+        assert(bulk.endRow() == (i % 3 == 2 ? 3 : 0));
+    }
+    assert(bulk.written.size() == 2 && bulk.pending() == 1);
+
+    bulk.flush();
+    assert(bulk.total() == 7);
+    assert(bulk.written.size() == 3);
+    assert(bulk.written[0] == "insert ignore into t_test (a,b) values (0,NULL),(1,NULL),(2,NULL)");
+    assert(bulk.written[1] == "insert ignore into t_test (a,b) values (3,NULL),(4,NULL),(5,NULL)");
+    assert(bulk.written[2] == "insert ignore into t_test (a,b) values (6,NULL)");
+
+    //没有数据不写入
+    assert(bulk.flush() == 0 && bulk.written.size() == 3);
+
+    cout << "testInsertMaxRows ok" << endl;
+}
+
+void testInsertMaxPacket()
+{
+    string head = "insert into t_test (a,b) values ";
+    string row  = "(1000000,2000000)";
+    string row2 = head + row + "," + row;
+    string row3 = row2 + "," + row;
+
+    //刚好放下3行
+    BulkRecorder bulk(&mysql, TC_MysqlBulk::BM_INSERT, 1000, row3.length());
+    bulk.begin("t_test", "a,b", false);
+    for(int i = 0; i < 10; i++)
+    {
+        bulk.addInt(1000000);
+        bulk.addInt(2000000);
+        bulk.endRow();
+    }
+    bulk.flush();
+
+    assert(bulk.total() == 10);
+    assert(bulk.written.size() == 4);
+    assert(bulk.written[0] == row3 && bulk.written[1] == row3 && bulk.written[2] == row3);
+    assert(bulk.written[3] == head + row);
+
+    //差一个字节放不下第3行, 第3行留到下一条语句
+    BulkRecorder split(&mysql, TC_MysqlBulk::BM_INSERT, 1000, row3.length() - 1);
+    split.begin("t_test", "a,b", false);
+    for(int i = 0; i < 10; i++)
+    {
+        split.addInt(1000000);
+        split.addInt(2000000);
+
+        //第3行放不下时写入前2行, 这一行留在缓冲区
+        assert(split.endRow() == (i % 2 == 0 && i > 0 ? 2 : 0));
+    }
+    split.flush();
+
+    assert(split.total() == 10);
+    assert(split.written.size() == 5);
+    for(size_t i = 0; i < split.written.size(); i++)
+    {
+        assert(split.written[i] == row2);
+    }
+
+    //单独一行超过限制时整行写入
+    BulkRecorder big(&mysql, TC_MysqlBulk::BM_INSERT, 1000, 10);
+    big.begin("t_test", "a,b", false);
+    big.addInt(1);
+    big.addInt(2);
+    assert(big.endRow() == 1);
+    assert(big.written.size() == 1 && big.written[0] == head + "(1,2)");
+
+    cout << "testInsertMaxPacket ok" << endl;
+}
+
+void testLoadDataMaxPacket()
+{
+    //每行"123456\t\\N\n"共10字节, 最多25字节: 每次写入2行
+    BulkRecorder bulk(&mysql, TC_MysqlBulk::BM_LOAD_DATA, 1000, 25);
+    bulk.begin("t_test", "a,b");
+
+    for(int i = 0; i < 5; i++)
+    {
+        bulk.addInt(123456);
+        bulk.addNull();
+        assert(bulk.endRow() == (i == 2 || i == 4 ? 2 : 0));
+        assert(bulk.pending() == (size_t)(i % 2 == 0 ? 1 : 2));
+    }
+    bulk.flush();
+
+    assert(bulk.written.size() == 3);
+    assert(bulk.written[0] == "123456\t\\N\n123456\t\\N\n");
+    assert(bulk.written[1] == "123456\t\\N\n123456\t\\N\n");
+    assert(bulk.written[2] == "123456\t\\N\n");
+
+    cout << "testLoadDataMaxPacket ok" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        testLoadDataEscape();
+
+        testInsertMaxRows();
+
+        testInsertMaxPacket();
+
+        testLoadDataMaxPacket();
+    }
+    catch(exception &ex)
+    {
+        cout << ex.what() << endl;
+        return -1;
+    }
+
+    return 0;
+}
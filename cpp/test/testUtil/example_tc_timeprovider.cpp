@@ -0,0 +1,163 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+
+#include "util/tc_timeprovider.h"
+#include "util/tc_common.h"
+#include <iostream>
+#include <cassert>
+#include <cstdlib>
+
+using namespace tars;
+
+string strftime(time_t t, const char *format, bool gmt)
+{
+    struct tm tt;
+    if (gmt)
+    {
+        gmtime_r(&t, &tt);
+    }
+    else
+    {
+        localtime_r(&t, &tt);
+    }
+
+    char buf[64];
+    strftime(buf, sizeof(buf), format, &tt);
+    return buf;
+}
+
+void check(time_t t)
+{
+    static const char *formats[] = {"%Y-%m-%d %H:%M:%S", "%Y%m%d%H%M%S", "%Y%m%d%H%M", "%Y%m%d", "%a, %d %b %Y %H:%M:%S GMT"};
+
+    for (int f = TC_TimeProvider::TF_DATETIME; f <= TC_TimeProvider::TF_GMT; ++f)
+    {
+        char buf[32];
+        size_t len = TC_TimeProvider::tm2str(t, f, buf);
+
+        string s = strftime(t, formats[f], f == TC_TimeProvider::TF_GMT);
+        if (s != buf || len != s.length())
+        {
+            cout << "error t:" << t << " " << buf << " != " << s << endl;
+            assert(false);
+        }
+    }
+
+    struct tm a, b;
+    localtime_r(&t, &a);
+    TC_TimeProvider::localtime(t, b);
+    assert(a.tm_year == b.tm_year && a.tm_mon == b.tm_mon && a.tm_mday == b.tm_mday);
+    assert(a.tm_hour == b.tm_hour && a.tm_min == b.tm_min && a.tm_sec == b.tm_sec);
+    assert(a.tm_wday == b.tm_wday && a.tm_yday == b.tm_yday && a.tm_isdst == b.tm_isdst);
+}
+
+void testCorrect()
+{
+    //顺序走过若干天, 包括夏令时切换
+    time_t begin = 1710000000;      //2024-03-09, 纽约3月10号切换夏令时
+    for (time_t t = begin; t < begin + 5 * 86400; t += 7)
+    {
+        check(t);
+    }
+
+    begin = 1730500000;             //2024-11-01, 11月3号切换回来
+    for (time_t t = begin; t < begin + 5 * 86400; t += 7)
+    {
+        check(t);
+    }
+
+    //随机的时间, 来回跳
+    srand(1);
+    for (int i = 0; i < 100000; ++i)
+    {
+        check((time_t)rand() * 2);
+    }
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        char buf[8];
+        snprintf(buf, sizeof(buf), ".%03d", i);
+        assert(string(TC_TimeProvider::msStr(i)) == buf);
+    }
+
+    assert(TC_Common::tm2str(begin, "%Y%m%d") == strftime(begin, "%Y%m%d", false));
+    assert(TC_Common::tm2str(begin, "%H:%M") == strftime(begin, "%H:%M", false));
+    assert(TC_Common::tm2GMTstr(begin) == strftime(begin, "%a, %d %b %Y %H:%M:%S GMT", true));
+
+    cout << "testCorrect ok" << endl;
+}
+
+void bench(int count)
+{
+    time_t now = time(NULL);
+
+    int64_t t = TC_Common::now2us();
+    size_t n = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        n += strftime(now + i % 60, "%Y-%m-%d %H:%M:%S", false).length();
+    }
+    int64_t t1 = TC_Common::now2us() - t;
+
+    t = TC_Common::now2us();
+    for (int i = 0; i < count; ++i)
+    {
+        char buf[32];
+        n += TC_TimeProvider::tm2str(now + i % 60, TC_TimeProvider::TF_DATETIME, buf);
+    }
+    int64_t t2 = TC_Common::now2us() - t;
+
+    //不在当天的时间(历史数据等)不走缓存, 也不能比原来慢
+    t = TC_Common::now2us();
+    for (int i = 0; i < count; ++i)
+    {
+        n += strftime(now - 86400 * (i % 365 + 1), "%Y-%m-%d %H:%M:%S", false).length();
+    }
+    int64_t t3 = TC_Common::now2us() - t;
+
+    t = TC_Common::now2us();
+    for (int i = 0; i < count; ++i)
+    {
+        char buf[32];
+        n += TC_TimeProvider::tm2str(now - 86400 * (i % 365 + 1), TC_TimeProvider::TF_DATETIME, buf);
+    }
+    int64_t t4 = TC_Common::now2us() - t;
+
+    cout << "today localtime_r+strftime:" << (double)t1 * 1000 / count << "ns"
+         << " tm2str:" << (double)t2 * 1000 / count << "ns" << endl;
+    cout << "other days localtime_r+strftime:" << (double)t3 * 1000 / count << "ns"
+         << " tm2str:" << (double)t4 * 1000 / count << "ns (" << n << ")" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        //缓存是进程内共享的, 时区要在第一次调用之前设置
+        setenv("TZ", "America/New_York", 1);
+        tzset();
+
+        testCorrect();
+
+        bench(argc > 1 ? TC_Common::strto<int>(argv[1]) : 1000000);
+    }
+    catch(exception &ex)
+    {
+        cout << ex.what() << endl;
+    }
+
+    return 0;
+}
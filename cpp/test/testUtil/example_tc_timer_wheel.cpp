@@ -0,0 +1,141 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+
+#include "util/tc_timer_wheel.h"
+#include "util/tc_common.h"
+#include <iostream>
+#include <map>
+#include <cassert>
+#include <cstdlib>
+
+using namespace tars;
+
+/**
+ * 随机挂入/摘除/推进, 和按到期时间排序的multimap对比取出的结果
+ */
+void testCorrect()
+{
+    const uint32_t size = 10000;
+
+    TC_TimerWheel wheel;
+
+    int64_t now = 1000000;
+
+    wheel.init(size, now);
+
+    vector<int64_t> expire(size + 1, -1);
+
+    for(int round = 0; round < 2000; ++round)
+    {
+        for(int i = 0; i < 100; ++i)
+        {
+            uint32_t id = rand() % size + 1;
+
+            if(rand() % 4 == 0)
+            {
+                wheel.del(id);
+                expire[id] = -1;
+            }
+            else
+            {
+                //覆盖各层, 偶尔有已经过期的
+                int64_t range[] = { 10, 300, 20000, 2000000, 200000000 };
+                int64_t e = now + (int64_t)(rand() % range[rand() % 5]) - 5;
+                wheel.add(id, e);
+                expire[id] = e;
+            }
+        }
+
+        //偶尔跳变
+        now += (rand() % 100 == 0) ? 50000 : rand() % 30 + 1;
+
+        vector<uint32_t> ids;
+        wheel.expire(now, ids);
+
+        multimap<int64_t, uint32_t> should;
+        for(uint32_t id = 1; id <= size; ++id)
+        {
+            if(expire[id] != -1 && expire[id] <= now)
+            {
+                should.insert(make_pair(expire[id], id));
+            }
+        }
+
+        assert(ids.size() == should.size());
+
+        for(size_t i = 0; i < ids.size(); ++i)
+        {
+            assert(expire[ids[i]] != -1 && expire[ids[i]] <= now);
+            assert(!wheel.exist(ids[i]));
+            expire[ids[i]] = -1;
+        }
+    }
+
+    cout << "testCorrect ok, left:" << wheel.size() << endl;
+}
+
+/**
+ * 空闲长连接场景: 每次事件都刷新超时时间点
+ */
+void testPerf(uint32_t size, int events)
+{
+    TC_TimerWheel wheel;
+    multimap<int64_t, uint32_t> tl;
+    vector<multimap<int64_t, uint32_t>::iterator> its(size + 1);
+
+    int64_t now = 1000000;
+
+    wheel.init(size, now);
+
+    for(uint32_t id = 1; id <= size; ++id)
+    {
+        wheel.add(id, now + 60);
+        its[id] = tl.insert(make_pair(now + 60, id));
+    }
+
+    int64_t t = TC_Common::now2us();
+    for(int i = 0; i < events; ++i)
+    {
+        uint32_t id = rand() % size + 1;
+        tl.erase(its[id]);
+        its[id] = tl.insert(make_pair(now + 60 + i % 60, id));
+    }
+    cout << "multimap refresh:" << (TC_Common::now2us() - t) << "us" << endl;
+
+    t = TC_Common::now2us();
+    for(int i = 0; i < events; ++i)
+    {
+        uint32_t id = rand() % size + 1;
+        wheel.add(id, now + 60 + i % 60);
+    }
+    cout << "wheel    refresh:" << (TC_Common::now2us() - t) << "us" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        testCorrect();
+
+        testPerf(100000, 1000000);
+    }
+    catch(exception &ex)
+    {
+        cout << ex.what() << endl;
+    }
+
+    return 0;
+}
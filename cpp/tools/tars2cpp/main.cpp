@@ -31,6 +31,8 @@ void usage()
     cout << "  --unknown                                   生成处理tars数据流中的unkown field的代码" << endl;
     cout << "  --tarsMaster                                 生成获取主调信息的选项" << endl;
     cout << "  --currentPriority						   use current path first." << endl;
+    cout << "  --packed[=interface1;interface2]            接口中的数值vector支持packed编码(不指定接口则所有接口), 请求需调用tars_packed(true)打开" << endl;
+    cout << "  --arena                                     vector/map使用TC_ArenaAlloc, 服务端从请求级的内存池解码参数(需要C++11)" << endl;
     cout << "  tars2cpp support type: bool byte short int long float double vector map" << endl;
     exit(0);
 }
@@ -104,6 +106,10 @@ int main(int argc, char* argv[])
 
     t2c.setTarsMaster(option.hasParam("tarsMaster"));
 
+    t2c.setPacked(option.hasParam("packed"), tars::TC_Common::sepstr<string>(option.getValue("packed"), ";", false));
+
+    t2c.setArena(option.hasParam("arena"));
+
     try
     {
         //增加include搜索路径
@@ -19,6 +19,8 @@
 #include "util/tc_file.h"
 #include "util/tc_common.h"
 #include <string>
+#include <algorithm>
+#include <set>
 
 #define TAB g_parse->getTab()
 #define INC_TAB g_parse->incTab()
@@ -32,6 +34,9 @@ Tars2Cpp::Tars2Cpp()
 , _namespace("tars")
 , _unknownField(false)
 , _tarsMaster(false)
+, _packed(false)
+, _arena(false)
+, _plainType(false)
 {
 
 }
@@ -331,7 +336,11 @@ string Tars2Cpp::tostrVector(const VectorPtr& pPtr) const
 
     string s = Builtin::builtinTable[Builtin::KindVector] + string("<") + tostr(pPtr->getTypePtr());
 
-    if (MapPtr::dynamicCast(pPtr->getTypePtr()) || VectorPtr::dynamicCast(pPtr->getTypePtr()))
+    if (_arena && !_plainType)
+    {
+        s += ", tars::TC_ArenaAlloc<" + tostr(pPtr->getTypePtr()) + " > >";
+    }
+    else if (MapPtr::dynamicCast(pPtr->getTypePtr()) || VectorPtr::dynamicCast(pPtr->getTypePtr()))
     {
         s += " >";
     }
@@ -345,7 +354,12 @@ string Tars2Cpp::tostrVector(const VectorPtr& pPtr) const
 string Tars2Cpp::tostrMap(const MapPtr& pPtr) const
 {
     string s = Builtin::builtinTable[Builtin::KindMap] + string("<") + tostr(pPtr->getLeftTypePtr()) + ", " + tostr(pPtr->getRightTypePtr());
-    if (MapPtr::dynamicCast(pPtr->getRightTypePtr()) || VectorPtr::dynamicCast(pPtr->getRightTypePtr()))
+    if (_arena && !_plainType)
+    {
+        s += ", std::less<" + tostr(pPtr->getLeftTypePtr()) + " >, tars::TC_ArenaAlloc<std::pair<const "
+            + tostr(pPtr->getLeftTypePtr()) + ", " + tostr(pPtr->getRightTypePtr()) + " > > >";
+    }
+    else if (MapPtr::dynamicCast(pPtr->getRightTypePtr()) || VectorPtr::dynamicCast(pPtr->getRightTypePtr()))
     {
         s += " >";
     }
@@ -366,10 +380,12 @@ string Tars2Cpp::MD5(const StructPtr& pPtr) const
 {
     string s;
     vector<TypeIdPtr>& member = pPtr->getAllMemberPtr();
+    _plainType = true;
     for (size_t j = 0; j < member.size(); j++)
     {
         s += "_" + tostr(member[j]->getTypePtr());
     }
+    _plainType = false;
 
     return "\"" + tars::TC_MD5::md5str(s) + "\"";
 }
@@ -1051,7 +1067,11 @@ string Tars2Cpp::generateServantDispatch(const OperationPtr& pPtr, const string&
 {
     ostringstream s;
     s << TAB << _namespace + "::TarsInputStream<" + _namespace + "::BufferReader> _is;" << endl;
-    s << TAB << "_is.setBuffer(_current->getRequestBuffer());" << endl;
+    s << TAB << "_is.setBuffer(_current->getRequestData(), _current->getRequestLength());" << endl;
+    if (_arena)
+    {
+        s << TAB << "tars::TC_ArenaGuard _arenaGuard(_current->getArena());" << endl;
+    }
 
     vector<ParamDeclPtr>& vParamDecl = pPtr->getAllParamDeclPtr();
 
@@ -1122,6 +1142,12 @@ string Tars2Cpp::generateServantDispatch(const OperationPtr& pPtr, const string&
     DEL_TAB;
     s << TAB << "}" << endl;
 
+    if (_arena)
+    {
+        //业务代码里新建的容器不从arena分配
+        s << TAB << "_arenaGuard.release();" << endl;
+    }
+
     if(pPtr->getReturnPtr()->getTypePtr())
     {
         s << TAB << tostr(pPtr->getReturnPtr()->getTypePtr()) << " " << pPtr->getReturnPtr()->getId() << " = " << pPtr->getId() << "(";
@@ -1177,6 +1203,10 @@ string Tars2Cpp::generateServantDispatch(const OperationPtr& pPtr, const string&
     s << TAB << "{" << endl;
     INC_TAB;
     s << TAB << _namespace + "::TarsOutputStream<" + _namespace + "::BufferWriter> _os;" << endl;
+    if (isPacked(cn))
+    {
+        s << TAB << "_os.setPacked(_current->isPackedAccepted());" << endl;
+    }
 
     if (pPtr->getReturnPtr()->getTypePtr())
     {
@@ -1267,6 +1297,17 @@ bool Tars2Cpp::isPromiseDispatchInitValue(const TypeIdPtr &pPtr) const
     }
     return false;
 }
+
+bool Tars2Cpp::isPacked(const string &interfaceId) const
+{
+    if (!_packed)
+    {
+        return false;
+    }
+
+    return _packedInterface.empty() || find(_packedInterface.begin(), _packedInterface.end(), interfaceId) != _packedInterface.end();
+}
+
 string Tars2Cpp::generateHAsync(const OperationPtr& pPtr, const string& cn) const
 {
     ostringstream s;
@@ -1303,6 +1344,11 @@ string Tars2Cpp::generateHAsync(const OperationPtr& pPtr, const string& cn) cons
 
     s << TAB << _namespace + "::TarsOutputStream<" + _namespace + "::BufferWriter> _os;" << endl;
 
+    if (isPacked(cn))
+    {
+        s << TAB << "_os.setPacked(tars_packed());" << endl;
+    }
+
     for (size_t i = 0; i < vParamDecl.size(); i++)
     {
         if (vParamDecl[i]->isOut())
@@ -1314,6 +1360,11 @@ string Tars2Cpp::generateHAsync(const OperationPtr& pPtr, const string& cn) cons
 
     s << TAB << "std::map<string, string> _mStatus;" << endl;
 
+    if (isPacked(cn))
+    {
+        s << TAB << "_mStatus.insert(std::make_pair(ServantProxy::STATUS_PACKED_KEY, \"1\"));" << endl;
+    }
+
     if (!routekey.empty())
     {
         ostringstream os;
@@ -1356,6 +1407,11 @@ string Tars2Cpp::generateHAsync(const OperationPtr& pPtr, const string& cn) cons
 
     s << TAB << _namespace + "::TarsOutputStream<" + _namespace + "::BufferWriter> _os;" << endl;
 
+    if (isPacked(cn))
+    {
+        s << TAB << "_os.setPacked(tars_packed());" << endl;
+    }
+
     for(size_t i = 0; i < vParamDecl.size(); i++)
     {
         if(vParamDecl[i]->isOut())
@@ -1367,6 +1423,11 @@ string Tars2Cpp::generateHAsync(const OperationPtr& pPtr, const string& cn) cons
 
     s << TAB << "std::map<string, string> _mStatus;" << endl;
 
+    if (isPacked(cn))
+    {
+        s << TAB << "_mStatus.insert(std::make_pair(ServantProxy::STATUS_PACKED_KEY, \"1\"));" << endl;
+    }
+
     if (!routekey.empty())
     {
         ostringstream os;
@@ -1409,6 +1470,11 @@ string Tars2Cpp::generateHAsync(const OperationPtr& pPtr, const string& cn) cons
 
     s << TAB << _namespace + "::TarsOutputStream<" + _namespace + "::BufferWriter> _os;" << endl;
 
+    if (isPacked(cn))
+    {
+        s << TAB << "_os.setPacked(tars_packed());" << endl;
+    }
+
     for (size_t i = 0; i < vParamDecl.size(); i++)
     {
         if (vParamDecl[i]->isOut())
@@ -1420,6 +1486,11 @@ string Tars2Cpp::generateHAsync(const OperationPtr& pPtr, const string& cn) cons
 
     s << TAB << "std::map<string, string> _mStatus;" << endl;
 
+    if (isPacked(cn))
+    {
+        s << TAB << "_mStatus.insert(std::make_pair(ServantProxy::STATUS_PACKED_KEY, \"1\"));" << endl;
+    }
+
     if (!routekey.empty())
     {
         ostringstream os;
@@ -1480,6 +1551,11 @@ string Tars2Cpp::generateH(const OperationPtr& pPtr, bool bVirtual, const string
 
         s << TAB << _namespace + "::TarsOutputStream<" + _namespace + "::BufferWriter> _os;" << endl;
 
+        if (isPacked(interfaceId))
+        {
+            s << TAB << "_os.setPacked(tars_packed());" << endl;
+        }
+
         for (size_t i = 0; i < vParamDecl.size(); i++)
         {
             //if(vParamDecl[i]->isOut()) continue;
@@ -1490,6 +1566,11 @@ string Tars2Cpp::generateH(const OperationPtr& pPtr, bool bVirtual, const string
 
         s << TAB << "std::map<string, string> _mStatus;" << endl;
 
+        if (isPacked(interfaceId))
+        {
+            s << TAB << "_mStatus.insert(std::make_pair(ServantProxy::STATUS_PACKED_KEY, \"1\"));" << endl;
+        }
+
         if (!routekey.empty())
         {
             ostringstream os;
@@ -1600,6 +1681,10 @@ string Tars2Cpp::generateH(const OperationPtr& pPtr, bool bVirtual, const string
         INC_TAB;
 
         s << TAB <<  _namespace + "::TarsOutputStream<" + _namespace + "::BufferWriter> _os;" << endl;
+        if (isPacked(interfaceId))
+        {
+            s << TAB << "_os.setPacked(current->isPackedAccepted());" << endl;
+        }
         if(pPtr->getReturnPtr()->getTypePtr())
         {
 	        s << writeTo(pPtr->getReturnPtr()) << endl;
@@ -1795,6 +1880,91 @@ string Tars2Cpp::generateDispatchPromiseAsync(const OperationPtr &pPtr, const st
 
     return s.str();
 }
+string Tars2Cpp::generateDispatchIndex(const vector<OperationPtr> &vOperation, const string &iname) const
+{
+    ostringstream s;
+
+    map<size_t, vector<pair<string, size_t> > > mLen;
+    for (size_t i = 0; i < vOperation.size(); i++)
+    {
+        mLen[vOperation[i]->getId().length()].push_back(make_pair(vOperation[i]->getId(), i));
+    }
+
+    s << TAB << "/* map function name to the index of the sorted operations, -1 if not found */" << endl;
+    s << TAB << "inline int " << iname << "(const char *_name, size_t _len)" << endl;
+    s << TAB << "{" << endl;
+    INC_TAB;
+    s << TAB << "switch (_len)" << endl;
+    s << TAB << "{" << endl;
+
+    map<size_t, vector<pair<string, size_t> > >::iterator it = mLen.begin();
+    while (it != mLen.end())
+    {
+        s << TAB << "case " << it->first << ":" << endl;
+        INC_TAB;
+        generateNameSwitch(s, it->second, it->first);
+        s << TAB << "break;" << endl;
+        DEL_TAB;
+        ++it;
+    }
+
+    s << TAB << "}" << endl;
+    s << TAB << "return -1;" << endl;
+    DEL_TAB;
+    s << TAB << "}" << endl;
+
+    return s.str();
+}
+
+void Tars2Cpp::generateNameSwitch(ostream &s, const vector<pair<string, size_t> > &vName, size_t len) const
+{
+    if (vName.size() == 1)
+    {
+        s << TAB << "if (memcmp(_name, \"" << vName[0].first << "\", " << len << ") == 0) return " << vName[0].second << ";" << endl;
+        return;
+    }
+
+    //同样长度的函数名互不相同, 区分度最高的位置至少能分出两组
+    size_t pos  = 0;
+    size_t best = 0;
+    for (size_t p = 0; p < len; p++)
+    {
+        set<char> sc;
+        for (size_t i = 0; i < vName.size(); i++)
+        {
+            sc.insert(vName[i].first[p]);
+        }
+
+        if (sc.size() > best)
+        {
+            best = sc.size();
+            pos  = p;
+        }
+    }
+
+    map<char, vector<pair<string, size_t> > > mChar;
+    for (size_t i = 0; i < vName.size(); i++)
+    {
+        mChar[vName[i].first[pos]].push_back(vName[i]);
+    }
+
+    s << TAB << "switch (_name[" << pos << "])" << endl;
+    s << TAB << "{" << endl;
+
+    map<char, vector<pair<string, size_t> > >::iterator it = mChar.begin();
+    while (it != mChar.end())
+    {
+        s << TAB << "case '" << it->first << "':" << endl;
+        INC_TAB;
+        generateNameSwitch(s, it->second, len);
+        s << TAB << "break;" << endl;
+        DEL_TAB;
+        ++it;
+    }
+
+    s << TAB << "}" << endl;
+}
+
 /******************************InterfacePtr***************************************/
 string Tars2Cpp::generateH(const InterfacePtr &pPtr, const NamespacePtr &nPtr) const
 {
@@ -1803,6 +1973,11 @@ string Tars2Cpp::generateH(const InterfacePtr &pPtr, const NamespacePtr &nPtr) c
 
     std::sort(vOperation.begin(), vOperation.end(), SortOperation());
 
+    //函数名到下标的映射, 各个onDispatch共用
+    string iname = "__" + nPtr->getId() + "__" + pPtr->getId() + "_index";
+
+    s << generateDispatchIndex(vOperation, iname) << endl;
+
     //生成异步回调Proxy
     s << TAB << "/* callback of async proxy for client */" << endl;
     s << TAB << "class " << pPtr->getId() << "PrxCallback: public tars::ServantProxyCallback" << endl;
@@ -1847,30 +2022,7 @@ string Tars2Cpp::generateH(const InterfacePtr &pPtr, const NamespacePtr &nPtr) c
     //生成异步回调接口
     s << TAB << "{" << endl;
     INC_TAB;
-    string dname    = "__" + pPtr->getId() + "_all";
-    string dispatch =  "static ::std::string " + dname;
-    s << TAB << dispatch << "[]=" << endl;
-    s << TAB << "{" << endl;
-    INC_TAB;
-
-    for (size_t i = 0; i < vOperation.size(); i++)
-    {
-        s << TAB << "\"" << vOperation[i]->getId() << "\"";
-        if (i != vOperation.size() - 1)
-        {
-            s << ",";
-        }
-        s << endl;
-
-    }
-    DEL_TAB;
-    s << TAB << "};" << endl;
-
-    s << TAB << "pair<string*, string*> r = equal_range(" << dname << ", " << dname << "+" << vOperation.size() << ", string(msg->request.sFuncName));" << endl;
-
-    s << TAB << "if(r.first == r.second) return tars::TARSSERVERNOFUNCERR;" << endl;
-
-    s << TAB << "switch(r.first - " << dname << ")" << endl;
+    s << TAB << "switch (" << iname << "(msg->request.sFuncName.data(), msg->request.sFuncName.size()))" << endl;
     s << TAB << "{" << endl;
     INC_TAB;
 
@@ -1923,32 +2075,7 @@ string Tars2Cpp::generateH(const InterfacePtr &pPtr, const NamespacePtr &nPtr) c
 	s << TAB << "{" << endl;
     INC_TAB;
 
-    dname    = "__" + pPtr->getId() + "_all";
-    dispatch =  "static ::std::string " + dname;
-    s << TAB << dispatch << "[]=" << endl;
-    s << TAB << "{" << endl;
-    INC_TAB;
-
-    for (size_t i = 0; i < vOperation.size(); i++)
-    {
-        s << TAB << "\"" << vOperation[i]->getId() << "\"";
-        if (i != vOperation.size() - 1)
-        {
-            s << ",";
-        }
-        s << endl;
-    }
-
-    DEL_TAB;
-    s << TAB << "};" << endl;
-
-    s << endl;
-
-    s << TAB << "pair<string*, string*> r = equal_range(" << dname << ", " << dname << "+" << vOperation.size() << ", string(msg->request.sFuncName));" << endl;
-
-    s << TAB << "if(r.first == r.second) return tars::TARSSERVERNOFUNCERR;" << endl;
-
-    s << TAB << "switch(r.first - " << dname << ")" << endl;
+    s << TAB << "switch (" << iname << "(msg->request.sFuncName.data(), msg->request.sFuncName.size()))" << endl;
     s << TAB << "{" << endl;
     INC_TAB;
 
@@ -2004,32 +2131,7 @@ string Tars2Cpp::generateH(const InterfacePtr &pPtr, const NamespacePtr &nPtr) c
     s << TAB << "int onDispatch(tars::ReqMessagePtr msg)" << endl;
     s << TAB << "{" << endl;
     INC_TAB;
-    dname    = "__" + pPtr->getId() + "_all";
-    dispatch =  "static ::std::string " + dname;
-    s << TAB << dispatch << "[]=" << endl;
-    s << TAB << "{" << endl;
-    INC_TAB;
-
-    for (size_t i = 0; i < vOperation.size(); i++)
-    {
-        s << TAB << "\"" << vOperation[i]->getId() << "\"";
-        if (i != vOperation.size() - 1)
-        {
-            s << ",";
-        }
-        s << endl;
-    }
-
-    DEL_TAB;
-    s << TAB << "};" << endl;
-
-    s << endl;
-
-    s << TAB << "pair<string*, string*> r = equal_range(" << dname << ", " << dname << "+" << vOperation.size() << ", string(msg->request.sFuncName));" << endl;
-
-    s << TAB << "if(r.first == r.second) return tars::TARSSERVERNOFUNCERR;" << endl;
-
-    s << TAB << "switch(r.first - " << dname << ")" << endl;
+    s << TAB << "switch (" << iname << "(msg->request.sFuncName.data(), msg->request.sFuncName.size()))" << endl;
     s << TAB << "{" << endl;
     INC_TAB;
 
@@ -2134,32 +2236,8 @@ string Tars2Cpp::generateH(const InterfacePtr &pPtr, const NamespacePtr &nPtr) c
 
     s << TAB << "{" << endl;
     INC_TAB;
-    dname    = "__" + nPtr->getId() + "__" + pPtr->getId() + "_all";
-    dispatch =  "static ::std::string " + dname;
-    s << TAB << dispatch << "[]=" << endl;
-    s << TAB << "{" << endl;
-    INC_TAB;
-
-    for (size_t i = 0; i < vOperation.size(); i++)
-    {
-        s << TAB << "\"" << vOperation[i]->getId() << "\"";
-        if (i != vOperation.size() - 1)
-        {
-            s << ",";
-        }
-        s << endl;
-    }
-
-    DEL_TAB;
-    s << TAB << "};" << endl;
-
-    s << endl;
-
-    s << TAB << "pair<string*, string*> r = equal_range(" << dname << ", " << dname << "+" << vOperation.size() << ", _current->getFuncName());" << endl;
-
-    s << TAB << "if(r.first == r.second) return tars::TARSSERVERNOFUNCERR;" << endl;
-
-    s << TAB << "switch(r.first - " << dname << ")" << endl;
+    s << TAB << "const std::string &_funcName = _current->getFuncName();" << endl;
+    s << TAB << "switch (" << iname << "(_funcName.data(), _funcName.size()))" << endl;
     s << TAB << "{" << endl;
     INC_TAB;
 
@@ -2344,6 +2422,14 @@ void Tars2Cpp::generateH(const ContextPtr &pPtr) const
     s << "#include <string>" << endl;
     s << "#include <vector>" << endl;
     s << "#include \"tup/Tars.h\"" << endl;
+    if (_arena)
+    {
+        s << "#include \"util/tc_arena.h\"" << endl;
+        //C++98复制容器时不会换掉分配器, 复制出来的参数仍指向请求的arena
+        s << "#if __cplusplus < 201103L" << endl;
+        s << "#error \"" << n << ".h generated by tars2cpp --arena requires C++11\"" << endl;
+        s << "#endif" << endl;
+    }
 
     s << "using namespace std;" << endl;
 
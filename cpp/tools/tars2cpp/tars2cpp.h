@@ -66,6 +66,16 @@ public:
      */
     void setTarsMaster(bool bTarsMaster) { _tarsMaster = bTarsMaster; }
 
+    /**
+     * 设置数值列表用packed编码的接口, vInterface为空表示所有接口
+     */
+    void setPacked(bool bPacked, const vector<string> &vInterface) { _packed = bPacked; _packedInterface = vInterface; }
+
+    /**
+     * 设置vector/map是否使用TC_ArenaAlloc, 服务端解码请求参数时从请求级的arena分配
+     */
+    void setArena(bool bArena) { _arena = bArena; }
+
 
     //下面是编解码的源码生成
 protected:
@@ -361,6 +371,23 @@ protected:
      */
     string generateH(const InterfacePtr &pPtr, const NamespacePtr &nPtr) const;
 
+    /**
+     * 生成函数名到下标的映射函数, 先按长度, 再按区分度最高的字符switch, 最后比较一次全名
+     * @param vOperation 已经排序的接口函数
+     * @param iname      生成的函数名
+     *
+     * @return string
+     */
+    string generateDispatchIndex(const vector<OperationPtr> &vOperation, const string &iname) const;
+
+    /**
+     * 生成长度相同的一组函数名的switch
+     * @param s
+     * @param vName 函数名和下标
+     * @param len   函数名长度
+     */
+    void generateNameSwitch(ostream &s, const vector<pair<string, size_t> > &vName, size_t len) const;
+
     /**
      * 生成枚举的头文件源码
      * @param pPtr
@@ -421,6 +448,14 @@ protected:
 
     bool isPromiseDispatchInitValue(const TypeIdPtr &pPtr) const;
 
+    /**
+     * 接口是否用packed编码
+     * @param interfaceId
+     *
+     * @return bool
+     */
+    bool isPacked(const string &interfaceId) const;
+
 private:
     std::string _baseDir;
 
@@ -433,6 +468,17 @@ private:
     bool _unknownField;
 
     bool _tarsMaster;
+
+    bool _packed;
+
+    vector<string> _packedInterface;
+
+    bool _arena;
+
+    /**
+     * 生成类型名时不带arena分配器(计算MD5时用, 保证和不带--arena时一致)
+     */
+    mutable bool _plainType;
 };
 
 #endif
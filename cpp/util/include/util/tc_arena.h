@@ -0,0 +1,306 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+
+#ifndef __TC_ARENA_H_
+#define __TC_ARENA_H_
+
+#include <new>
+#include <cstddef>
+#include <stdint.h>
+#if __cplusplus >= 201103L
+#include <type_traits>
+#include <utility>
+#endif
+
+namespace tars
+{
+/////////////////////////////////////////////////
+/**
+ * @file  tc_arena.h
+ * @brief 请求级的内存池(arena)和对应的STL分配器.
+ *
+ * TC_Arena从大块内存中顺序切分, 单个释放是空操作, reset()时一次性全部回收
+ * (保留第一块内存, 下次复用), 适合解码一个请求时产生的大量vector/map节点.
+ *
+ * TC_ArenaAlloc在构造时记下当前线程的arena(TC_Arena::current()),
+ * 没有设置时退化为普通的new/delete; 容器的内存都从构造时的arena分配.
+ * arena中的对象只在arena reset之前有效, 不要把它们move到生命期更长的对象中,
+ * 复制到其他对象时按复制时的当前arena重新分配.
+ * 容器的swap要求两边是同一个arena(分配器不随swap交换), 可能不是同一个arena时用TC_Arena::swap.
+ * C++98的容器复制时原样复制分配器, 复制出来的对象仍指向原来的arena, reset后失效,
+ * 所以TC_ArenaAlloc和TC_Arena::swap只在C++11下提供; TC_Arena本身不受限制.
+ * 非线程安全, 一个arena同一时刻只能在一个线程中使用.
+ */
+/////////////////////////////////////////////////
+
+class TC_Arena
+{
+public:
+    enum
+    {
+        DEFAULT_BLOCK = 8192,
+        ALIGN         = 16
+    };
+
+    /**
+     * @brief 构造函数
+     *
+     * @param blockSize 每次向系统申请的内存块大小
+     */
+    explicit TC_Arena(size_t blockSize = DEFAULT_BLOCK);
+
+    /**
+     * @brief 析构, 释放所有内存块
+     */
+    ~TC_Arena();
+
+    /**
+     * @brief 分配内存, 按ALIGN对齐
+     *
+     * @param size 大小
+     * @return void*, 失败抛出std::bad_alloc
+     */
+    void *allocate(size_t size)
+    {
+        size = (size + ALIGN - 1) & ~((size_t)ALIGN - 1);
+
+        if ((size_t)(_end - _cur) >= size)
+        {
+            void *p = _cur;
+            _cur   += size;
+            _used  += size;
+            return p;
+        }
+
+        return allocateSlow(size);
+    }
+
+    /**
+     * @brief 回收所有分配出去的内存, 只保留第一块
+     */
+    void reset();
+
+    /**
+     * @brief 已分配出去的字节数
+     */
+    size_t used() const { return _used; }
+
+    /**
+     * @brief 占用的系统内存字节数
+     */
+    size_t capacity() const { return _capacity; }
+
+    /**
+     * @brief 当前线程正在使用的arena
+     *
+     * @return TC_Arena*, 没有设置时为NULL
+     */
+    static TC_Arena *current();
+
+    /**
+     * @brief 设置当前线程正在使用的arena
+     *
+     * @param arena 可以为NULL
+     */
+    static void setCurrent(TC_Arena *arena);
+
+#if __cplusplus >= 201103L
+    /**
+     * @brief 交换两个用TC_ArenaAlloc的容器
+     *
+     * 同一个arena(或者都不在arena上)时直接swap;
+     * 不同arena时各自在自己的arena上复制对方的内容(包括嵌套的容器), 内存不会跨arena
+     * @param a
+     * @param b
+     */
+    template<typename C>
+    static void swap(C &a, C &b);
+#endif
+
+protected:
+    /**
+     * 当前块不够时申请新块, 大的分配单独成块
+     */
+    void *allocateSlow(size_t size);
+
+private:
+    /**
+     * 不允许复制
+     */
+    TC_Arena(const TC_Arena &);
+    TC_Arena &operator=(const TC_Arena &);
+
+protected:
+    /**
+     * 内存块头, 后面紧跟数据
+     */
+    struct Block
+    {
+        Block *     next;
+        size_t      size;
+    };
+
+    Block *     _head;
+    char *      _cur;
+    char *      _end;
+    size_t      _blockSize;
+    size_t      _used;
+    size_t      _capacity;
+};
+
+/**
+ * 设置当前线程的arena, 析构时恢复原来的
+ */
+class TC_ArenaGuard
+{
+public:
+    explicit TC_ArenaGuard(TC_Arena *arena) : _prev(TC_Arena::current()), _active(true)
+    {
+        TC_Arena::setCurrent(arena);
+    }
+
+    ~TC_ArenaGuard()
+    {
+        release();
+    }
+
+    /**
+     * @brief 提前恢复
+     */
+    void release()
+    {
+        if (_active)
+        {
+            TC_Arena::setCurrent(_prev);
+            _active = false;
+        }
+    }
+
+private:
+    TC_ArenaGuard(const TC_ArenaGuard &);
+    TC_ArenaGuard &operator=(const TC_ArenaGuard &);
+
+protected:
+    TC_Arena *  _prev;
+    bool        _active;
+};
+
+#if __cplusplus >= 201103L
+/**
+ * 从arena分配的STL分配器
+ */
+template<typename T>
+class TC_ArenaAlloc
+{
+public:
+    typedef T               value_type;
+    typedef T *             pointer;
+    typedef const T *       const_pointer;
+    typedef T &             reference;
+    typedef const T &       const_reference;
+    typedef size_t          size_type;
+    typedef ptrdiff_t       difference_type;
+
+    template<typename U>
+    struct rebind
+    {
+        typedef TC_ArenaAlloc<U> other;
+    };
+
+    typedef std::false_type propagate_on_container_copy_assignment;
+    typedef std::false_type propagate_on_container_move_assignment;
+    typedef std::false_type propagate_on_container_swap;
+
+    TC_ArenaAlloc select_on_container_copy_construction() const { return TC_ArenaAlloc(); }
+
+    TC_ArenaAlloc() : _arena(TC_Arena::current()) {}
+
+    explicit TC_ArenaAlloc(TC_Arena *arena) : _arena(arena) {}
+
+    template<typename U>
+    TC_ArenaAlloc(const TC_ArenaAlloc<U> &a) : _arena(a.arena()) {}
+
+    pointer allocate(size_type n, const void * = 0)
+    {
+        if (_arena)
+        {
+            return (pointer)_arena->allocate(n * sizeof(T));
+        }
+        return (pointer)::operator new(n * sizeof(T));
+    }
+
+    void deallocate(pointer p, size_type)
+    {
+        if (!_arena)
+        {
+            ::operator delete(p);
+        }
+    }
+
+    size_type max_size() const { return ((size_t)-1) / sizeof(T); }
+
+    void construct(pointer p, const T &t) { new ((void *)p) T(t); }
+
+    void destroy(pointer p) { p->~T(); }
+
+    template<typename U, typename... Args>
+    void construct(U *p, Args&&... args) { ::new ((void *)p) U(std::forward<Args>(args)...); }
+
+    template<typename U>
+    void destroy(U *p) { p->~U(); }
+
+    pointer address(reference r) const { return &r; }
+
+    const_pointer address(const_reference r) const { return &r; }
+
+    TC_Arena *arena() const { return _arena; }
+
+protected:
+    TC_Arena *  _arena;
+};
+
+template<typename T, typename U>
+inline bool operator==(const TC_ArenaAlloc<T> &a, const TC_ArenaAlloc<U> &b) { return a.arena() == b.arena(); }
+
+template<typename T, typename U>
+inline bool operator!=(const TC_ArenaAlloc<T> &a, const TC_ArenaAlloc<U> &b) { return a.arena() != b.arena(); }
+
+template<typename C>
+void TC_Arena::swap(C &a, C &b)
+{
+    if (a.get_allocator() == b.get_allocator())
+    {
+        a.swap(b);
+        return;
+    }
+
+    //嵌套的容器复制时用当前arena, 复制期间切到目标arena
+    TC_ArenaGuard ga(a.get_allocator().arena());
+    C ta(b, a.get_allocator());
+    ga.release();
+
+    TC_ArenaGuard gb(b.get_allocator().arena());
+    C tb(a, b.get_allocator());
+    gb.release();
+
+    a.swap(ta);
+    b.swap(tb);
+}
+#endif
+
+}
+
+#endif
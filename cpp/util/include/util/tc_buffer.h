@@ -18,6 +18,7 @@
 #define __TC_BUFFER_H
 
 #include <cstring>
+#include "util/tc_autoptr.h"
 
 namespace tars
 {
@@ -223,6 +224,254 @@ private:
     void ResetBuffer(void* ptr = NULL);
 };
 
+/** 
+ *@brief  引用计数的定长内存块, 由TC_SharedBuffer分配, 
+ *        被TC_SharedSlice共享, 最后一个引用释放时回收. 
+ */
+class TC_SharedBlock : public TC_HandleBase
+{
+public:
+   /**
+	* @brief 构造函数. 
+	* @param capacity 内存块字节数
+    */
+    explicit TC_SharedBlock(std::size_t capacity) :
+        _capacity(capacity),
+        _buffer(new char[capacity])
+    {
+    }
+
+   /**
+	* @brief 构造函数, 接管已经写好数据的内存, 不拷贝. 
+	* @param buffer   new[]分配的内存
+	* @param capacity 内存字节数
+    */
+    TC_SharedBlock(char* buffer, std::size_t capacity) :
+        _capacity(capacity),
+        _buffer(buffer)
+    {
+    }
+
+   /**
+    * @brief 析构函数. 
+    */
+    ~TC_SharedBlock()
+    {
+        delete[] _buffer;
+    }
+
+	/**
+	 * @brief 内存块起始地址
+	 */
+    char* Data() { return _buffer; }
+
+	/**
+	 * @brief 内存块字节数
+	 */
+    std::size_t Capacity() const { return _capacity; }
+
+private:
+   /**
+    * @brief 禁止复制
+    */
+    TC_SharedBlock(const TC_SharedBlock& );
+    void operator=(const TC_SharedBlock& );
+
+    /**
+     * 内存块字节数
+     */
+    std::size_t _capacity;
+
+    /**
+     * 内存块
+     */
+    char* _buffer;
+};
+
+typedef TC_AutoPtr<TC_SharedBlock> TC_SharedBlockPtr;
+
+/** 
+ *@brief  TC_SharedBlock中的一段数据, 持有内存块的引用, 
+ *        可以跨线程传递而不拷贝数据. 
+ */
+struct TC_SharedSlice
+{
+    TC_SharedSlice() : data(NULL), len(0)
+    {
+    }
+
+    TC_SharedSlice(const TC_SharedBlockPtr& b, const char* d, std::size_t l) : block(b), data(d), len(l)
+    {
+    }
+
+	/**
+	 * @brief 是否没有数据
+	 */
+    bool empty() const { return len == 0; }
+
+    /**
+     * 所引用的内存块
+     */
+    TC_SharedBlockPtr block;
+
+    /**
+     * 数据起始地址
+     */
+    const char* data;
+
+    /**
+     * 数据字节数
+     */
+    std::size_t len;
+};
+
+/** 
+ *@brief  共享内存块的字节流缓冲区. 
+ * 
+ * 数据写在TC_SharedBlock上, 通过Slice()取出的数据只是引用, 不拷贝,
+ * Take()在数据远小于内存块时拷贝一份, 以限制被引用住的内存;
+ * 读游标之前的数据可能仍被TC_SharedSlice引用, 所以只有内存块没有被
+ * 其他对象引用时才原地整理, 否则分配新的内存块并只拷贝未读的数据.
+ * 只能在一个线程中读写, TC_SharedSlice可以在其他线程释放.
+ */
+class TC_SharedBuffer
+{
+public:
+   /**
+	* @brief 构造函数. 
+    */
+    TC_SharedBuffer() :
+        _readPos(0),
+        _writePos(0)
+    {
+    }
+
+private:
+   /**
+    * @brief 禁止复制
+    */
+    TC_SharedBuffer(const TC_SharedBuffer& );
+    void operator=(const TC_SharedBuffer& );
+
+public:
+	/**
+	 * @brief 将数据放入缓冲
+	 *  
+	 * @param data  要写入的数据起始地址
+	 * @param size  要写入的数据字节数
+	 * @return      写入的字节数
+	 */
+    std::size_t PushData(const void* data, std::size_t size);
+
+	/**
+	 * @brief 调整缓冲区写游标
+	 *  
+	 * @param bytes 要调整的字节数
+	 */
+    void Produce(std::size_t bytes) { _writePos += bytes; }
+
+	/**
+	 * @brief 调整缓冲区读游标
+	 *  
+	 * @param bytes 要调整的字节数
+	 */
+    void Consume(std::size_t bytes);
+
+	/**
+	 * @brief 引用可读数据中的一段, 不拷贝, 不调整读游标
+	 *  
+	 * @param offset 相对读游标的偏移
+	 * @param size   字节数
+	 * @return       数据引用
+	 */
+    TC_SharedSlice Slice(std::size_t offset, std::size_t size);
+
+	/**
+	 * @brief 取出可读数据的前size字节, 并调整读游标. 
+	 *        数据不到内存块一半时拷贝到大小正好的新内存块, 
+	 *        避免几个小包长时间占住整个内存块; 否则直接引用, 不拷贝
+	 *  
+	 * @param size 字节数
+	 * @return     数据引用
+	 */
+    TC_SharedSlice Take(std::size_t size);
+
+	/**
+	 * @brief 缓冲区可读数据起始地址
+	 *  
+	 * @return 缓冲区可读数据起始地址
+	 */
+    char* ReadAddr()  {  return _block ? _block->Data() + _readPos : NULL;  }
+
+	/**
+	 * @brief 缓冲区可写起始地址
+	 *  
+	 * @return 缓冲区可写起始地址
+	 */
+    char* WriteAddr() {  return _block ? _block->Data() + _writePos : NULL; }
+
+	/**
+	 * @brief 缓冲区是否有数据
+	 *  
+	 * @return True:缓冲区没有数据
+	 */
+    bool IsEmpty() const { return ReadableSize() == 0; }
+
+	/**
+	 * @brief 缓冲区数据大小
+	 *  
+	 * @return 缓冲区数据字节数
+	 */
+    std::size_t ReadableSize() const {  return _writePos - _readPos;  }
+
+	/**
+	 * @brief 缓冲区可写空间大小
+	 *  
+	 * @return 缓冲区可写空间字节数
+	 */
+    std::size_t WritableSize() const {  return _block ? _block->Capacity() - _writePos : 0;  }
+
+	/**
+	 * @brief 确保缓冲有足够大小容纳size字节的数据写入
+	 *  
+	 * @param size 将要写入的数据字节数
+	 */
+    void AssureSpace(std::size_t size);
+
+	/**
+	 * @brief 清除数据
+	 *  
+	 */
+    void Clear() { Consume(ReadableSize()); }
+
+	/**
+	 * @brief 没有数据时释放内存块, 避免空闲连接占用内存
+	 *  
+	 */
+    void Shrink();
+
+    /**
+     * 内存块默认大小
+     */
+    static const std::size_t kDefaultSize;
+
+private:
+    /**
+     * 读游标
+     */
+    std::size_t _readPos;
+
+    /**
+     * 写游标 
+     */
+    std::size_t _writePos;
+
+    /**
+     * 当前内存块
+     */
+    TC_SharedBlockPtr _block;
+};
+
 } // end namespace tars
 
 #endif
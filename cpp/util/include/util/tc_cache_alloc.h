@@ -0,0 +1,99 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+
+#ifndef __TC_CACHE_ALLOC_H_
+#define __TC_CACHE_ALLOC_H_
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <stdint.h>
+
+namespace tars
+{
+/////////////////////////////////////////////////
+/**
+ * @file  tc_cache_alloc.h
+ * @brief 带线程缓存的定长内存块分配器.
+ *
+ * 按2的幂分成若干尺寸档(64字节到64K), 每个线程每档缓存一组空闲块,
+ * 分配/释放优先在本线程缓存中完成, 不加锁;
+ * 本线程缓存空了从全局空闲链表批量取一半, 满了批量还一半给全局,
+ * 全局每档缓存的块数有上限, 超出的直接释放;
+ * 大于64K的直接malloc/free.
+ *
+ * 适合一个线程分配、另一个线程释放的短生命期对象(如客户端的请求消息),
+ * 释放时必须给出分配时的大小.
+ */
+/////////////////////////////////////////////////
+
+class TC_CacheAlloc
+{
+public:
+    enum
+    {
+        MIN_SHIFT   = 6,
+        MAX_SHIFT   = 16,
+        CLASS_NUM   = MAX_SHIFT - MIN_SHIFT + 1,
+        CACHE_NUM   = 64,
+        GLOBAL_NUM  = 4096
+    };
+
+    /**
+     * 每个尺寸档的统计
+     */
+    struct Stat
+    {
+        size_t      size;       //块大小
+        int64_t     hit;        //从缓存中分配的次数
+        int64_t     miss;       //缓存为空, 向系统申请的次数
+        size_t      cached;     //全局空闲链表中的块数
+    };
+
+    /**
+     * @brief 分配内存
+     *
+     * @param size 大小
+     * @return void*, 失败抛出std::bad_alloc
+     */
+    static void *allocate(size_t size);
+
+    /**
+     * @brief 释放内存
+     *
+     * @param p    allocate返回的地址, 可以为NULL
+     * @param size 分配时的大小
+     */
+    static void deallocate(void *p, size_t size);
+
+    /**
+     * @brief 获取各尺寸档的统计, 当前线程缓存中还没有汇总的计数会先汇总
+     *
+     * @param stats [out]
+     */
+    static void getStat(std::vector<Stat> &stats);
+
+    /**
+     * @brief 统计信息的可读形式, 每档一行
+     *
+     * @return string
+     */
+    static std::string stat();
+};
+
+}
+
+#endif
@@ -32,6 +32,7 @@
 #include <sys/types.h>
 #include <cassert>
 #include <cstdio>
+#include <cstring>
 #include <string>
 #include <iostream>
 #include <sstream>
@@ -40,6 +41,7 @@
 #include <map>
 #include <stack>
 #include <vector>
+#include <limits>
 #include "util/tc_loki.h"
 
 using namespace std;
@@ -54,6 +56,52 @@ namespace tars
 */
 /////////////////////////////////////////////////
 
+/**
+ * @brief 字符串片段, 只引用数据不拷贝(类似string_view).
+ *
+ * 调用者保证引用的数据在使用期间有效.
+ */
+class TC_StringView
+{
+public:
+    TC_StringView() : _data(""), _len(0) {}
+
+    TC_StringView(const char *data, size_t len) : _data(data), _len(len) {}
+
+    TC_StringView(const char *data) : _data(data), _len(strlen(data)) {}
+
+    TC_StringView(const string &s) : _data(s.data()), _len(s.length()) {}
+
+    const char *data() const    { return _data; }
+
+    size_t size() const         { return _len; }
+
+    size_t length() const       { return _len; }
+
+    bool empty() const          { return _len == 0; }
+
+    char operator[](size_t i) const { return _data[i]; }
+
+    /**
+     * @brief 拷贝成string
+     */
+    string str() const          { return string(_data, _len); }
+
+    bool operator==(const TC_StringView &v) const
+    {
+        return _len == v._len && memcmp(_data, v._data, _len) == 0;
+    }
+
+    bool operator!=(const TC_StringView &v) const
+    {
+        return !(*this == v);
+    }
+
+protected:
+    const char  *_data;
+    size_t      _len;
+};
+
  /**
  * @brief  基础工具类，提供了一些非常基本的函数使用.
  *
@@ -99,6 +147,23 @@ public:
     */
     static string trimright(const string &sStr, const string &s = " \r\n\t", bool bChar = true);
 
+    /**
+    * @brief  去掉头部以及尾部s中的字符, 不拷贝.
+    *
+    * @param sStr    输入字符串
+    * @param s       需要去掉的字符
+    * @return        sStr中去掉后剩下的部分
+    */
+    static TC_StringView trimView(const TC_StringView &sStr, const char *s = " \r\n\t");
+
+    /**
+    * @brief  原地去掉头部以及尾部s中的字符, 不分配内存.
+    *
+    * @param sStr    输入输出字符串
+    * @param s       需要去掉的字符
+    */
+    static void trimInPlace(string &sStr, const char *s = " \r\n\t");
+
     /**
     * @brief  字符串转换成小写.
     *
@@ -242,6 +307,18 @@ public:
     template<typename T>
     static T strto(const string &sStr, const string &sDefault);
 
+    /**
+    * @brief  字符串转化成数值, 不经过istringstream, 不分配内存.
+    *
+    * 整数只接受可选的符号和数字, 不能有空格, 溢出则失败; 浮点数用strtod.
+    *
+    * @param sStr  要转换的字符串
+    * @param t     输出, 失败时不修改
+    * @return      整个字符串都转换成功返回true
+    */
+    template<typename T>
+    static bool strto(const TC_StringView &sStr, T &t);
+
     /**
     * @brief  解析字符串,用分隔符号分隔,保存在vector里
     *
@@ -261,6 +338,20 @@ public:
     template<typename T>
     static vector<T> sepstr(const string &sStr, const string &sSep, bool withEmpty = false);
 
+    /**
+    * @brief  解析字符串, 结果放在调用者提供的数组里, 不分配内存.
+    *
+    * 分隔的规则和sepstr<string>一样, 超过max的部分只计数不保存.
+    *
+    * @param sStr      输入字符串
+    * @param sSep      分隔字符串(每个字符都算为分隔符)
+    * @param vt        输出, 引用sStr中的数据
+    * @param max       vt的大小
+    * @param withEmpty true代表空的也算一个元素, false时空的过滤
+    * @return          元素的个数, 大于max说明没有保存完
+    */
+    static size_t sepstr(const TC_StringView &sStr, const TC_StringView &sSep, TC_StringView *vt, size_t max, bool withEmpty = false);
+
     /**
     * @brief T型转换成字符串，只要T能够使用ostream对象用<<重载,即可以被该函数支持
     * @param t 要转换的数据
@@ -315,6 +406,16 @@ public:
     template <typename InputIter>
     static string tostr(InputIter iFirst, InputIter iLast, const string &sSep = "|");
 
+    /**
+    * @brief  整数格式化到buf中(类似to_chars), 不分配内存.
+    *
+    * @param buf  输出, 至少21字节, 不以'\0'结尾
+    * @param t    整数
+    * @return     写入后的结尾位置
+    */
+    template<typename T>
+    static char *tochars(char *buf, T t);
+
     /**
     * @brief  二进制数据转换成字符串.
     *
@@ -375,6 +476,16 @@ public:
     */
     static string replace(const string &sString, const map<string,string>& mSrcDest);
 
+    /**
+    * @brief  替换字符串, 结果追加到sOut后面, sOut可以重复使用以避免分配内存.
+    *
+    * @param sString  输入字符串
+    * @param sSrc     原字符串
+    * @param sDest    目的字符串
+    * @param sOut     输出
+    */
+    static void replace(const TC_StringView &sString, const TC_StringView &sSrc, const TC_StringView &sDest, string &sOut);
+
     /**
      * @brief 匹配以.分隔的字符串，pat中*则代表通配符，代表非空的任何字符串
      * s为空, 返回false ，pat为空, 返回true
@@ -430,6 +541,20 @@ public:
 
 namespace p
 {
+    /**
+     * 无符号整数格式化, 返回结尾位置
+     */
+    char *u64tochars(char *buf, uint64_t v);
+
+    /**
+     * 整数解析, 只接受可选的符号和数字, 溢出返回false
+     */
+    bool str2i64(const char *s, size_t len, int64_t &v);
+
+    bool str2u64(const char *s, size_t len, uint64_t &v);
+
+    bool str2double(const char *s, size_t len, double &v);
+
     template<typename D>
     struct strto1
     {
@@ -614,6 +739,40 @@ T TC_Common::strto(const string &sStr)
     return strto_type()(sStr);
 }
 
+template<typename T>
+bool TC_Common::strto(const TC_StringView &sStr, T &t)
+{
+    if(!numeric_limits<T>::is_integer)
+    {
+        double d;
+        if(!p::str2double(sStr.data(), sStr.length(), d))
+        {
+            return false;
+        }
+        t = (T)d;
+        return true;
+    }
+
+    if(numeric_limits<T>::is_signed)
+    {
+        int64_t v;
+        if(!p::str2i64(sStr.data(), sStr.length(), v) || v < (int64_t)numeric_limits<T>::min() || v > (int64_t)numeric_limits<T>::max())
+        {
+            return false;
+        }
+        t = (T)v;
+        return true;
+    }
+
+    uint64_t v;
+    if(!p::str2u64(sStr.data(), sStr.length(), v) || v > (uint64_t)numeric_limits<T>::max())
+    {
+        return false;
+    }
+    t = (T)v;
+    return true;
+}
+
 template<typename T>
 T TC_Common::strto(const string &sStr, const string &sDefault)
 {
@@ -684,6 +843,34 @@ vector<T> TC_Common::sepstr(const string &sStr, const string &sSep, bool withEmp
 
     return vt;
 }
+template<typename T>
+char *TC_Common::tochars(char *buf, T t)
+{
+    if(t < (T)0)
+    {
+        *buf++ = '-';
+        return p::u64tochars(buf, (uint64_t)0 - (uint64_t)(int64_t)t);
+    }
+
+    return p::u64tochars(buf, (uint64_t)t);
+}
+
+/**
+ * 整数的特化在tc_common.cpp中实现(不经过ostringstream), 这里声明以保证调用到;
+ * 只声明和ostringstream输出完全一致的类型, 浮点数和char的特化输出格式不同(如1e-06会变成0),
+ * 其他编译单元仍然用ostringstream
+ */
+template <> string TC_Common::tostr<bool>(const bool &t);
+template <> string TC_Common::tostr<short>(const short &t);
+template <> string TC_Common::tostr<unsigned short>(const unsigned short &t);
+template <> string TC_Common::tostr<int>(const int &t);
+template <> string TC_Common::tostr<unsigned int>(const unsigned int &t);
+template <> string TC_Common::tostr<long>(const long &t);
+template <> string TC_Common::tostr<long long>(const long long &t);
+template <> string TC_Common::tostr<unsigned long>(const unsigned long &t);
+template <> string TC_Common::tostr<unsigned long long>(const unsigned long long &t);
+template <> string TC_Common::tostr<std::string>(const std::string &t);
+
 template<typename T>
 string TC_Common::tostr(const T &t)
 {
@@ -35,6 +35,8 @@
 #include "util/tc_fifo.h"
 #include "util/tc_buffer.h"
 #include "util/tc_buffer_pool.h"
+#include "util/tc_timer_wheel.h"
+#include "util/tc_mpsc_queue.h"
 
 using namespace std;
 
@@ -89,6 +91,14 @@ public:
     typedef TC_Functor<int, TL::TLMaker<string &, string&>::Result> protocol_functor;
     typedef TC_Functor<int, TL::TLMaker<int, string&>::Result>      header_filter_functor;
 
+    /**
+     * 定义零拷贝协议解析接口的操作对象, 参数依次为:
+     * 接收缓冲区可读数据, 数据长度, [out]包体起始偏移, [out]包结束偏移(即本次消费的字节数)
+     * 返回PACKET_LESS/PACKET_FULL/PACKET_ERR, 只解析, 不修改缓冲区
+     * 注意必须是线程安全的或是可以重入的
+     */
+    typedef TC_Functor<int, TL::TLMaker<const char*, size_t, size_t&, size_t&>::Result> slice_protocol_functor;
+
     class NetThread;
 
     class BindAdapter;
@@ -106,15 +116,21 @@ public:
     struct tagRecvData
     {
         uint32_t        uid;            /**连接标示*/
-        string          buffer;         /**需要发送的内容*/
+        string          buffer;         /**收到的内容(setProtocol注册的解析器)*/
+        TC_SharedSlice  slice;          /**收到的内容(setSliceProtocol注册的解析器), 引用接收缓冲区, 不拷贝*/
         string          ip;             /**远程连接的ip*/
         uint16_t        port;           /**远程连接的端口*/
         int64_t         recvTimeStamp;  /**接收到数据的时间*/
+        int64_t         recvTimeUs;     /**接收到数据的时间(微秒), 统计耗时分布用*/
         bool            isOverload;     /**是否已过载 */
         bool            isClosed;       /**是否已关闭*/
         int                fd;                /*保存产生该消息的fd，用于回包时选择网络线程*/
         BindAdapterPtr  adapter;        /**标识哪一个adapter的消息*/
         int             closeType;     /*如果是关闭消息包，则标识关闭类型,0:表示客户端主动关闭；1:服务端主动关闭;2:连接超时服务端主动关闭*/
+
+        /**收到的内容, 不区分解析器*/
+        const char* data() const    { return slice.empty() ? buffer.data() : slice.data; }
+        size_t length() const       { return slice.empty() ? buffer.length() : slice.len; }
     };
 
     struct tagSendData
@@ -122,8 +138,14 @@ public:
         char            cmd;            /**命令:'c',关闭fd; 's',有数据需要发送*/
         uint32_t        uid;            /**连接标示*/
         string          buffer;         /**需要发送的内容*/
+        TC_SharedSlice  slice;          /**需要发送的内容, 引用业务线程编码好的内存块, 不拷贝*/
         string          ip;             /**远程连接的ip*/
         uint16_t        port;           /**远程连接的端口*/
+        tagSendData * volatile next;    /**发送队列(TC_MpscQueue)中的下一个*/
+
+        /**需要发送的内容, 不区分buffer/slice*/
+        const char* data() const    { return slice.empty() ? buffer.data() : slice.data; }
+        size_t length() const       { return slice.empty() ? buffer.length() : slice.len; }
     };
 
     typedef TC_ThreadQueue<tagRecvData*, deque<tagRecvData*> > recv_queue;
@@ -143,17 +165,34 @@ public:
         int             iLastRefreshTime;
     };
     ////////////////////////////////////////////////////////////////////////////
+    /**
+     * handle组分发请求的方式
+     */
+    enum EHandleSchedule
+    {
+        HANDLE_SCHED_QUEUE      = 0,    /**所有handle共用adapter的队列(缺省)*/
+        HANDLE_SCHED_ROUNDROBIN = 1,    /**每个handle一个队列, 网络线程轮转分发*/
+        HANDLE_SCHED_AFFINITY   = 2     /**每个handle一个队列, 同一个连接的请求分发给同一个handle*/
+    };
+
     /**
      * 按name对handle分组，
      * 每组handle处理一个或多个Adapter消息
      * 每个handle对象一个线程
+     * 非共用队列模式下, 空闲的handle从其他handle的队列尾部偷取请求,
+     * 有请求时只唤醒一个等待中的handle
      */
     struct HandleGroup : public TC_HandleBase
     {
+        HandleGroup() : schedule(HANDLE_SCHED_QUEUE) {}
+
         string                      name;
         TC_ThreadLock               monitor;
         vector<HandlePtr>           handles;
         map<string, BindAdapterPtr> adapters;
+        int                         schedule;   /**分发方式, EHandleSchedule*/
+        TC_Atomic                   next;       /**轮转分发的序号*/
+        TC_Atomic                   idle;       /**等待中的handle个数*/
     };
     ////////////////////////////////////////////////////////////////////////////
     /**
@@ -213,6 +252,13 @@ public:
          */
         void sendResponse(unsigned int uid, const string &sSendBuffer, const string &ip, int port, int fd);
 
+        /**
+         * 发送数据, 只传递内存块的引用, 网络线程直接从slice发送
+         * @param uid
+         * @param slice
+         */
+        void sendResponse(unsigned int uid, const TC_SharedSlice &slice, const string &ip, int port, int fd);
+
         /**
          * 关闭链接
          * @param stRecvData
@@ -235,7 +281,34 @@ public:
          */
         virtual void notifyFilter();
 
+        /**
+         * 放入本handle的队列(非共用队列模式),
+         * 本handle在等待则唤醒它, 否则唤醒一个等待中的handle来偷取
+         * @param vtRecvData
+         * @param bPushBack
+         */
+        void pushRecvData(const recv_queue_type &vtRecvData, bool bPushBack);
+
     protected:
+        /**
+         * 取一个请求(非共用队列模式): 先取本handle的队列, 为空则从其他handle的队列尾部偷取
+         * @param recv
+         * @return bool, false:都没有请求
+         */
+        bool popRecvData(tagRecvData* &recv);
+
+        /**
+         * 没有请求时在本handle上等待(非共用队列模式), 只会被单独唤醒
+         * @param iWaitTime
+         */
+        void waitForRecvData(uint32_t iWaitTime);
+
+        /**
+         * 处理一个请求, 请求需要设置好adapter
+         * @param recv
+         */
+        void processRecvData(tagRecvData *recv);
+
         /**
          * 具体的处理逻辑
          */
@@ -331,6 +404,17 @@ public:
          */
         uint32_t  _iWaitTime;
 
+        /**
+         * 在handle组中的序号
+         */
+        size_t    _index;
+
+        /**
+         * 本handle的请求队列及等待(非共用队列模式)
+         */
+        TC_ThreadLock           _localMonitor;
+        deque<tagRecvData*>     _localQueue;
+        bool                    _bWaiting;
     };
 
     typedef TC_Functor<bool /*processed*/, TL::TLMaker<void* /*conn*/, const std::string& /*data*/ >::Result> auth_process_wrapper_functor;
@@ -575,6 +659,27 @@ public:
          */
         header_filter_functor &getHeaderFilterFunctor();
 
+        /**
+         * 注册零拷贝协议解析器, 收到的包以slice的形式放入tagRecvData, 
+         * 注册后setProtocol注册的解析器不再生效
+         * @param spf
+         * @param iHeaderLen
+         * @param hf
+         */
+        void setSliceProtocol(const slice_protocol_functor& spf, int iHeaderLen = 0, const header_filter_functor& hf = echo_header_filter);
+
+        /**
+         * 获取零拷贝协议解析器
+         * @return slice_protocol_functor&
+         */
+        slice_protocol_functor &getSliceProtocol();
+
+        /**
+         * 是否使用零拷贝协议解析器
+         * @return bool
+         */
+        bool isSliceProtocol() const;
+
         /**
          * 增加数据到队列中
          * @param vtRecvData
@@ -608,6 +713,16 @@ public:
          */
         static int echo_protocol(string &r, string &o);
 
+        /**
+         * 默认的零拷贝协议解析类, 直接echo
+         * @param data
+         * @param len
+         * @param pos
+         * @param end
+         * @return int
+         */
+        static int echo_slice_protocol(const char *data, size_t len, size_t &pos, size_t &end);
+
         /**
          * 默认的包头处理
          * @param i
@@ -682,6 +797,33 @@ public:
          */
         size_t getBackPacketBuffLimit();
 
+        /**
+         * 设置是否启用SO_REUSEPORT多监听模式:
+         * 每个网络线程各自绑定一个监听socket, 各自accept并管理自己的连接,
+         * 不再由一个网络线程accept后转交给其他网络线程
+         * @param bReusePort
+         */
+        void setReusePort(bool bReusePort);
+
+        /**
+         * 是否启用SO_REUSEPORT多监听模式
+         * @return bool
+         */
+        bool isReusePort() const;
+
+        /**
+         * 设置handle组分发请求的方式(EHandleSchedule), 在setHandle之前设置,
+         * 创建handle组的adapter决定整个组的方式
+         * @param iSchedule
+         */
+        void setHandleSchedule(int iSchedule);
+
+        /**
+         * 获取handle组分发请求的方式
+         * @return int
+         */
+        int getHandleSchedule() const;
+
         /**
          * 注册鉴权包裹函数
          * @param apwf
@@ -704,6 +846,7 @@ public:
     protected:
         friend class TC_EpollServer;
         friend class NetThread;
+        friend class Handle;
 
         /**
          * 服务
@@ -720,6 +863,16 @@ public:
          */
         protocol_functor _pf;
 
+        /**
+         * 零拷贝协议解析
+         */
+        slice_protocol_functor _spf;
+
+        /**
+         * 是否使用零拷贝协议解析
+         */
+        bool            _bSliceProtocol;
+
         /**
          * 首个数据包包头过滤
          */
@@ -780,6 +933,11 @@ public:
          */
         recv_queue      _rbuffer;
 
+        /**
+         * 非共用队列模式下, 分发到各handle队列中的请求数
+         */
+        TC_Atomic       _iHandleQueueSize;
+
         /**
          * 队列最大容量
          */
@@ -808,6 +966,16 @@ public:
         //回包缓存限制大小
         size_t                    _iBackPacketBuffLimit;
 
+        /**
+         * 是否每个网络线程各自监听(SO_REUSEPORT), 缺省为false
+         */
+        bool                      _bReusePort;
+
+        /**
+         * handle组分发请求的方式, 缺省为HANDLE_SCHED_QUEUE
+         */
+        int                       _iHandleSchedule;
+
         /**
          * 包裹认证函数,不能为空
          */
@@ -973,6 +1141,13 @@ public:
               */
              int send(const std::vector<TC_Slice>& slices);
 
+            /**
+             * 批量发送, 所有数据只调用一次writev, 没发完的放入发送buffer
+             * @param vSend
+             * @return int, -1:发送出错, -2:需要关闭连接, 0:成功
+             */
+            int send(const std::vector<tagSendData*>& vSend);
+
 
             /**
              * 读取数据
@@ -988,6 +1163,29 @@ public:
              */
             int parseProtocol(recv_queue::queue_type &o);
 
+            /**
+             * 用零拷贝协议解析器解析
+             * @param rbuf
+             * @param o
+             * @return int: <0:协议错误, >=0:收到的包个数
+             */
+            int parseSliceProtocol(TC_SharedBuffer &rbuf, recv_queue::queue_type &o);
+
+            /**
+             * 用string协议解析器解析
+             * @param rbuf
+             * @param o
+             * @return int: <0:协议错误, >=0:收到的包个数
+             */
+            int parseStringProtocol(TC_SharedBuffer &rbuf, recv_queue::queue_type &o);
+
+            /**
+             * 收到完整的包, 放入临时队列
+             * @param recv
+             * @param o
+             */
+            void pushRecvData(tagRecvData *recv, recv_queue::queue_type &o);
+
             /**
              * 增加数据到队列中
              * @param vtRecvData
@@ -1010,6 +1208,26 @@ public:
             int tcpSend(const void* data, size_t len);
             int tcpWriteV(const std::vector<iovec>& buffers);
 
+            /**
+             * 按IOV_MAX分批writev, 直到发完或者发不出去
+             * @param buffers
+             * @return int, -1:发送出错, >= 0:发送的字节数
+             */
+            int sendv(const std::vector<iovec>& buffers);
+
+            /**
+             * 把数据放入发送buffer
+             * @param data
+             * @param len
+             */
+            void appendSendBuffer(const char* data, size_t len);
+
+            /**
+             * 检查发送buffer是否超限, 是否需要关闭连接
+             * @return int, -2:需要关闭连接, 0:正常
+             */
+            int checkSendBuffer();
+
             /**
              * 清空buffer-slices
              * @param slices
@@ -1067,15 +1285,25 @@ public:
             uint16_t             _port;
 
             /**
-             * 接收数据buffer
+             * 接收数据buffer, 收到的包直接引用其中的数据
              */
-            string              _recvbuffer;
+            TC_SharedBuffer     _recvbuffer;
+
+            /**
+             * string协议解析器(setProtocol)还没解析完的数据
+             */
+            string              _strbuffer;
 
             /**
              * 发送数据buffer
              */
             std::vector<TC_Slice>  _sendbuffer;
 
+            /**
+             * 网络线程本轮从发送队列取出、还没发送的数据
+             */
+            std::vector<tagSendData*> _pendingSend;
+
             /**
              * 需要过滤的头部字节数
              */
@@ -1098,10 +1326,8 @@ public:
             bool                _bEmptyConn;
 
             /*
-             *接收数据的临时buffer,加这个目的是对udp接收数据包大小进行设置
+             *udp接收数据包的最大长度
              */
-            char                *_pRecvBuffer;
-
             size_t                _nRecvBufferSize;
         public:
             /*
@@ -1114,6 +1340,11 @@ public:
             bool                _authInit;
 #if TARS_SSL
             TC_OpenSSL*         _openssl;
+
+            /*
+             *ssl解密后的数据
+             */
+            TC_SharedBuffer     _sslbuffer;
 #endif
         };
         ////////////////////////////////////////////////////////////////////////////
@@ -1154,7 +1385,7 @@ public:
             void add(Connection *cPtr, time_t iTimeOutStamp);
 
             /**
-             * 刷新时间链
+             * 刷新超时时间点, 只记录, 不调整时间轮, 只能在本网络线程中调用
              * @param uid
              * @param iTimeOutStamp, 超时时间点
              */
@@ -1192,7 +1423,7 @@ public:
             size_t size();
 
         protected:
-            typedef pair<Connection*, multimap<time_t, uint32_t>::iterator> list_data;
+            typedef pair<Connection*, time_t> list_data;
 
             /**
              * 内部删除, 不加锁
@@ -1200,6 +1431,13 @@ public:
              */
             void _del(uint32_t uid);
 
+            /**
+             * 连接下次需要检查的时间点(超时时间点, 或者空连接的超时时间点)
+             * @param uid
+             * @return time_t
+             */
+            time_t getCheckTime(uint32_t uid);
+
         protected:
             /**
              * 服务
@@ -1227,9 +1465,14 @@ public:
             list_data                       *_vConn;
 
             /**
-             * 超时链表
+             * 超时时间轮, 到期时如果连接的超时时间点已经后移, 再重新挂入
+             */
+            TC_TimerWheel                   _wheel;
+
+            /**
+             * 时间轮取出的到期连接
              */
-            multimap<time_t, uint32_t>      _tl;
+            vector<uint32_t>                _expired;
 
             /**
              * 上次检查超时时间
@@ -1259,6 +1502,14 @@ public:
          */
         int bind(BindAdapterPtr &lsPtr);
 
+        /**
+         * SO_REUSEPORT模式下, 为本网络线程单独绑定一个监听socket,
+         * 该socket由本线程accept, 连接也由本线程管理
+         * @param lsPtr
+         * @return int, 监听fd
+         */
+        int bindReusePort(BindAdapterPtr &lsPtr);
+
         /**
          * 网络线程执行函数
          */
@@ -1319,6 +1570,13 @@ public:
          */
         void send(unsigned int uid, const string &s, const string &ip, uint16_t port);
 
+         /**
+         * 发送数据, 不拷贝
+         * @param uid
+         * @param slice
+         */
+        void send(unsigned int uid, const TC_SharedSlice &slice, const string &ip, uint16_t port);
+
         /**
          * 获取某一监听端口的连接数
          * @param lfd
@@ -1438,6 +1696,25 @@ public:
          */
         void processPipe();
 
+        /**
+         * 放入发送队列, 并通知网络线程
+         * @param send
+         */
+        void pushSendData(tagSendData *send);
+
+        /**
+         * 发送连接本轮积攒的数据
+         * @param cPtr
+         * @return bool, false:连接已经删除
+         */
+        bool flushSendData(Connection *cPtr);
+
+        /**
+         * 回收发送记录
+         * @param send
+         */
+        void freeSendData(tagSendData *send);
+
         /**
          * 处理网络请求
          */
@@ -1458,8 +1735,9 @@ public:
          * 绑定端口
          * @param ep
          * @param s
+         * @param bReusePort 是否设置SO_REUSEPORT
          */
-        void bind(const TC_Endpoint &ep, TC_Socket &s);
+        void bind(const TC_Endpoint &ep, TC_Socket &s, bool bReusePort = false);
 
         /**
          * 空连接超时时间
@@ -1535,8 +1813,13 @@ public:
          */
         TC_Socket                   _shutdown;
 
-        //管道(用于通知有数据需要发送就)
-        TC_Socket                   _notify;
+        //eventfd(用于通知有数据需要发送)
+        int                         _notify;
+
+        /**
+         * 是否已经通知过且网络线程还没有处理, 用于合并通知
+         */
+        volatile int                _notified;
 
         /**
          * 管理的连接链表
@@ -1546,7 +1829,22 @@ public:
         /**
          * 发送队列
          */
-        send_queue                  _sbuffer;
+        TC_MpscQueue<tagSendData>   _sbuffer;
+
+        /**
+         * 本轮有数据要发送的连接
+         */
+        vector<uint32_t>            _pendingConn;
+
+        /**
+         * 用完的发送记录, 攒够一批再还回去
+         */
+        tagSendData                 *_freeSend;
+
+        /**
+         * _freeSend的个数
+         */
+        size_t                      _freeSendSize;
 
         /**
          * BindAdapter是否有udp监听
@@ -1651,6 +1949,8 @@ public:
 
             hg->name = groupName;
 
+            hg->schedule = adapter->getHandleSchedule();
+
             adapter->_handleGroup = hg;
 
             for (int32_t i = 0; i < handleNum; ++i)
@@ -1682,6 +1982,25 @@ public:
         return _netThreads[fd % _netThreads.size()];
     }
 
+    /**
+     * 选择连接所属的网络线程
+     * uid中编码了所属网络线程的序号(见ConnectionList::init), 优先按uid选择,
+     * 这样SO_REUSEPORT模式下由本线程accept的连接也能找到正确的网络线程
+     * @param uid
+     * @param fd
+     */
+    NetThread* getNetThreadOfConn(uint32_t uid, int fd)
+    {
+        size_t iIndex = (uid >> 22) & 0xF;
+
+        if(iIndex > 0 && iIndex <= _netThreads.size())
+        {
+            return _netThreads[iIndex - 1];
+        }
+
+        return getNetThreadOfFd(fd);
+    }
+
     /**
      * 绑定监听socket
      * @param ls
@@ -1740,6 +2059,13 @@ public:
      */
     void send(unsigned int uid, const string &s, const string &ip, uint16_t port, int fd);
 
+    /**
+     * 发送数据, 不拷贝
+     * @param uid
+     * @param slice
+     */
+    void send(unsigned int uid, const TC_SharedSlice &slice, const string &ip, uint16_t port, int fd);
+
     /**
      * 获取某一监听端口的连接数
      * @param lfd
@@ -108,6 +108,59 @@ public:
         return uncompress(src, length, output);
     }
 
+    /**
+    * @brief  对数据进行解压, 解压后超过maxLength时停止并返回失败, 
+    *         用于不可信的数据, 内存不超过maxLength
+    *  
+    * @param src         需要解压的数据
+    * @param length      数据长度
+    * @param maxLength   解压后的最大长度
+    * @param buffer      输出buffer
+    * @return bool       成功失败(数据不合法或者超过maxLength)
+    */
+    static bool uncompress(const char *src, size_t length, size_t maxLength, string& buffer)
+    {
+        buffer.clear();
+
+        z_stream strm;
+
+        strm.zalloc   = Z_NULL;
+        strm.zfree    = Z_NULL;
+        strm.opaque   = Z_NULL;
+        strm.avail_in = 0;
+        strm.next_in  = Z_NULL;
+
+        if (inflateInit2(&strm, 47) != Z_OK)
+        {
+            return false;
+        }
+
+        //直接解压到buffer, 一次给出全部输入, 输出不够时返回Z_BUF_ERROR
+        char dummy;
+        buffer.resize(maxLength);
+
+        strm.avail_in  = length;
+        strm.next_in   = (unsigned char *)src;
+        strm.avail_out = maxLength;
+        strm.next_out  = (unsigned char *)(maxLength > 0 ? &buffer[0] : &dummy);
+
+        int ret = inflate(&strm, Z_FINISH);
+
+        size_t n = maxLength - strm.avail_out;
+
+        inflateEnd(&strm);
+
+        if (ret != Z_STREAM_END)
+        {
+            buffer.clear();
+            return false;
+        }
+
+        buffer.resize(n);
+
+        return true;
+    }
+
     /**
     * @brief  对数据进行分片解压, 
     *         每次解压的数据调用Output输出
@@ -78,6 +78,25 @@ namespace tars
  *
  *  typedef TC_Logger<MyWriteT, MyRoll> MyLogger;
  *
+ *  异步写日志(setupThread)时, 每个写日志的线程在每个TC_LoggerRoll上有一个环形缓冲区(TC_LoggerRing),
+ *
+ *  写入不加锁, TC_LoggerThreadGroup的线程批量取出所有缓冲区的数据, 每个文件一次写入.
+ *
+ *  缓冲区满时按setRing设置的策略处理: 在当前线程中直接写(默认), 等待, 或者丢弃并计数(计数会写到日志里, 要显式设置).
+ *
+ *  缓冲区在线程第一次写这个roll时才分配, 内存约为 写日志的线程数 x roll数 x 缓冲区大小(默认64K).
+ *
+ *  同一个线程的日志保持顺序, 不同线程之间按取出的顺序写入.
+ *
+ *  logf/anyf返回LoggerRecord, 只把格式串和参数的二进制值写进缓冲区,
+ *
+ *  格式化({}依次替换成参数)推迟到写日志线程取出时做, 写到文件的内容和<<方式的一样:
+ *
+ *  (logger.logf(TC_DayLogger::INFO_LOG, "{}|{}|{}"), ip, port, ret);
+ *
+ *  格式串默认拷贝进记录, 调用返回后可以释放; 只有用TC_LOGFMT("...")包起来的字符串常量才只记地址:
+ *
+ *  (logger.logf(TC_DayLogger::INFO_LOG, TC_LOGFMT("{}|{}|{}")), ip, port, ret);
  *
  */
 
@@ -100,18 +119,143 @@ namespace tars
     public:
         void operator()(ostream &of, const deque<pair<int, string> > &ds)
         {
+            //拼成一块一次写入
+            size_t len = 0;
             deque<pair<int, string> >::const_iterator it = ds.begin();
             while (it != ds.end())
             {
-                of << it->second;
+                len += it->second.length();
                 ++it;
             }
+
+            string s;
+            s.reserve(len);
+
+            it = ds.begin();
+            while (it != ds.end())
+            {
+                s.append(it->second);
+                ++it;
+            }
+
+            of.write(s.data(), s.length());
             of.flush();
         }
     };
 
     class TC_LoggerThreadGroup;
 
+/**
+ * @brief 日志头部信息和格式化用的流的缓存, 每个线程一份
+ */
+    struct TC_LoggerHead
+    {
+        /**
+         * @brief 格式化好的时间(%Y-%m-%d %H:%M:%S), 同一秒内只格式化一次
+         *
+         * @param t
+         * @return const char*, 19个字符
+         */
+        static const char *timeStr(time_t t);
+
+        /**
+         * @brief 线程id的字符串
+         *
+         * @return const char*
+         */
+        static const char *tidStr();
+
+        /**
+         * @brief 取格式化用的stringstream, 优先用线程缓存的那个(避免每条日志构造一次)
+         *
+         * @return std::stringstream*
+         */
+        static std::stringstream *allocStream();
+
+        /**
+         * @brief 归还allocStream取到的stringstream
+         *
+         * @param ss
+         */
+        static void freeStream(std::stringstream *ss);
+    };
+
+/**
+ * @brief 单生产者单消费者的日志环形缓冲区.
+ *
+ * 每条记录: 4字节长度(最高位表示二进制记录) + 4字节染色标记 + 数据, 按8字节对齐;
+ * 尾部放不下时写一个回绕标记, 从头开始写. 写入方和取出方都不加锁.
+ */
+    class TC_LoggerRing
+    {
+    public:
+        /**
+         * @brief 构造函数
+         *
+         * @param size 缓冲区大小, 向上取2的幂
+         */
+        explicit TC_LoggerRing(size_t size);
+
+        /**
+         * @brief 析构
+         */
+        ~TC_LoggerRing();
+
+        /**
+         * @brief 写入一条(只能在一个线程中调用).
+         *
+         * @param dyeing 染色标记
+         * @param data
+         * @param len
+         * @param record 是否是LoggerRecord的二进制记录, 取出时格式化
+         * @return bool, 空间不够返回false
+         */
+        bool push(int dyeing, const char *data, size_t len, bool record = false);
+
+        /**
+         * @brief 取出全部记录(只能在一个线程中调用).
+         *
+         * @param ds 追加到后面
+         * @return size_t, 取出的条数
+         */
+        size_t pop(deque<pair<int, string> > &ds);
+
+        /**
+         * @brief 已经使用的字节数
+         */
+        size_t used() const     { return _head - _tail; }
+
+        /**
+         * @brief 缓冲区大小
+         */
+        size_t capacity() const { return _size; }
+
+    protected:
+        TC_LoggerRing(const TC_LoggerRing &);
+        TC_LoggerRing &operator=(const TC_LoggerRing &);
+
+    protected:
+        /**
+         * 缓冲区
+         */
+        char *              _buf;
+
+        /**
+         * 缓冲区大小
+         */
+        size_t              _size;
+
+        /**
+         * 写位置(只增加), 写入方修改
+         */
+        volatile size_t     _head;
+
+        /**
+         * 读位置(只增加), 取出方修改
+         */
+        volatile size_t     _tail;
+    };
+
 //////////////////////////////////////////////////////////////////////////////
 /**
  * @brief 具体写日志基类
@@ -120,11 +264,33 @@ namespace tars
     {
     public:
         /**
-         * @brief 构造函数
+         * @brief 缓冲区满时的处理策略
          */
-        TC_LoggerRoll() : _pThreadGroup(NULL)
+        enum
         {
-        }
+            OVERFLOW_SYNC   = 0,    /**在当前线程中直接把缓冲区写到日志*/
+            OVERFLOW_DROP   = 1,    /**丢弃*/
+            OVERFLOW_BLOCK  = 2     /**等待写日志线程取走*/
+        };
+
+        /**
+         * @brief 每个TC_LoggerRoll上最多的写日志线程数, 超过的线程走加锁的队列
+         */
+        enum
+        {
+            MAX_RING_THREAD = 1024,
+            RING_CHUNK      = 64    /**缓冲区指针按块分配, 每块的个数*/
+        };
+
+        /**
+         * @brief 构造函数
+         */
+        TC_LoggerRoll();
+
+        /**
+         * @brief 析构函数
+         */
+        virtual ~TC_LoggerRoll();
 
         /**
          * @brief 实时记日志, 并且滚动.
@@ -154,11 +320,59 @@ namespace tars
          */
         void write(const pair<int, string> &buffer);
 
+        /**
+         * @brief 写到日志.
+         *
+         * @param buffer 日志内容
+         * @param len
+         */
+        void write(const char *buffer, size_t len);
+
+        /**
+         * @brief 写LoggerRecord编码的二进制记录, 异步时到写日志线程再格式化.
+         *
+         * @param record
+         * @param len
+         */
+        void writeRecord(const char *record, size_t len);
+
         /**
          * @brief 刷新缓存到文件
          */
         void flush();
 
+        /**
+         * @brief 设置每个线程的缓冲区大小和满时的策略.
+         *
+         * 只影响之后新建的线程缓冲区
+         * @param ringSize 缓冲区大小, 0表示不用缓冲区(都走加锁的队列)
+         * @param overflow OVERFLOW_DROP/OVERFLOW_SYNC/OVERFLOW_BLOCK
+         */
+        void setRing(size_t ringSize, int overflow);
+
+        /**
+         * @brief 设置新建的TC_LoggerRoll默认的缓冲区大小和满时的策略
+         *
+         * @param ringSize
+         * @param overflow
+         */
+        static void setDefaultRing(size_t ringSize, int overflow);
+
+        /**
+         * @brief 缓冲区满被丢弃的条数
+         */
+        size_t getDropCount() const     { return _dropCount; }
+
+        /**
+         * @brief 缓冲区满等待的次数
+         */
+        size_t getBlockCount() const    { return _blockCount; }
+
+        /**
+         * @brief 缓冲区满或者单条太大, 在当前线程中直接写的次数
+         */
+        size_t getSyncCount() const     { return _syncCount; }
+
         /**
          * @brief 设置染色是否生效.
          *
@@ -183,6 +397,32 @@ namespace tars
             //_bDyeingFlag = (_setThreadID.size() > 0);
         }
 
+    protected:
+
+        /**
+         * @brief 写到当前线程的缓冲区
+         *
+         * @return bool, false表示缓冲区写不下
+         */
+        bool pushRing(int dyeing, const char *buffer, size_t len, bool record = false);
+
+        /**
+         * @brief 取出所有缓冲区和队列中的数据, 加上最后一条(buffer不为NULL时)一起写到日志
+         */
+        void flush(int dyeing, const char *buffer, size_t len);
+
+        /**
+         * @brief 当前线程的缓冲区, 第一次写时创建
+         *
+         * @return TC_LoggerRing*, 超过线程数限制返回NULL
+         */
+        TC_LoggerRing *getRing();
+
+        /**
+         * @brief 当前线程的染色标记
+         */
+        int dyeingId();
+
     protected:
 
         /**
@@ -195,6 +435,54 @@ namespace tars
          */
         TC_ThreadMutex          _mutex;
 
+        /**
+         * 每个线程的缓冲区, 按线程序号索引; 分成块, 用到时才分配, 分配后不释放
+         */
+        TC_LoggerRing * volatile * volatile _rings[MAX_RING_THREAD / RING_CHUNK];
+
+        /**
+         * 用到的最大线程序号+1
+         */
+        volatile size_t         _ringNum;
+
+        /**
+         * 创建缓冲区的锁
+         */
+        TC_ThreadMutex          _ringMutex;
+
+        /**
+         * 取出数据的锁, 保证取出和写入的顺序一致
+         */
+        TC_ThreadMutex          _flushMutex;
+
+        /**
+         * 缓冲区大小
+         */
+        size_t                  _ringSize;
+
+        /**
+         * 缓冲区满时的策略
+         */
+        int                     _overflow;
+
+        /**
+         * 计数
+         */
+        volatile size_t         _dropCount;
+        volatile size_t         _blockCount;
+        volatile size_t         _syncCount;
+
+        /**
+         * 上次写到日志里的丢弃条数
+         */
+        size_t                  _dropReported;
+
+        /**
+         * 默认的缓冲区大小和策略
+         */
+        static size_t           _defaultRingSize;
+        static int              _defaultOverflow;
+
         /**
          * 线程组
          */
@@ -266,6 +554,11 @@ namespace tars
          */
         void flush();
 
+        /**
+         * @brief 唤醒写日志线程(某个线程的缓冲区过半时调用)
+         */
+        void wakeup();
+
     protected:
 
         /**
@@ -303,6 +596,11 @@ namespace tars
          */
         logger_set      _logger;
 
+        /**
+         * 已经唤醒还没处理
+         */
+        volatile int    _notified;
+
     };
 
 /**
@@ -411,9 +709,29 @@ namespace tars
          * @param stream
          * @param mutex
          */
-		LoggerStream(const char *header, ostream *stream, ostream *estream, TC_ThreadRecMutex &mutex) : _stream(stream), _estream(estream), _mutex(mutex)
+		LoggerStream(const char *header, ostream *stream, ostream *estream, TC_ThreadRecMutex &mutex) : _buffer(NULL), _stream(stream), _estream(estream), _mutex(&mutex), _roll(NULL), _enable(stream != NULL)
         {
-            _buffer << header;
+            if (_enable)
+            {
+                _buffer = TC_LoggerHead::allocStream();
+                (*_buffer) << header;
+            }
+        }
+
+        /**
+         * @brief 构造, 析构时直接写到roll, 不经过共享的流, 不加锁.
+         *
+         * @param header 头部, NULL表示不写日志
+         * @param roll
+         * @param estream
+         */
+        LoggerStream(const char *header, TC_LoggerRoll *roll, ostream *estream) : _buffer(NULL), _stream(NULL), _estream(estream), _mutex(NULL), _roll(roll), _enable(header != NULL)
+        {
+            if (_enable)
+            {
+                _buffer = TC_LoggerHead::allocStream();
+                (*_buffer) << header;
+            }
         }
 
         /**
@@ -421,33 +739,45 @@ namespace tars
          */
         ~LoggerStream()
         {
-            if (_stream)
+            if (!_enable)
+            {
+                return;
+            }
+
+            if (_roll)
             {
-				TC_LockT<TC_ThreadRecMutex> lock(_mutex);
+                const string &s = _buffer->str();
+                _roll->write(s.data(), s.length());
+            }
+            else if (_stream)
+            {
+				TC_LockT<TC_ThreadRecMutex> lock(*_mutex);
                 _stream->clear();
-                (*_stream) << _buffer.str();
+                (*_stream) << _buffer->str();
 
                 _stream->flush();
             }
+
+            TC_LoggerHead::freeStream(_buffer);
         }
 
         /**
         * @brief 重载<<
         */
         template <typename P>
-        LoggerStream& operator << (const P &t)  { if (_stream) _buffer << t;return *this;}
+        LoggerStream& operator << (const P &t)  { if (_enable) (*_buffer) << t;return *this;}
 
         /**
          * @brief endl,flush等函数
          */
         typedef ostream& (*F)(ostream& os);
-        LoggerStream& operator << (F f)         { if (_stream) (f)(_buffer);return *this;}
+        LoggerStream& operator << (F f)         { if (_enable) (f)(*_buffer);return *this;}
 
         /**
          * @brief  hex等系列函数
          */
         typedef ios_base& (*I)(ios_base& os);
-        LoggerStream& operator << (I f)         { if (_stream) (f)(_buffer);return *this;}
+        LoggerStream& operator << (I f)         { if (_enable) (f)(*_buffer);return *this;}
 
         /**
          * @brief 字段转换成ostream类型.
@@ -456,9 +786,9 @@ namespace tars
          */
         operator ostream&()
         {
-            if (_stream)
+            if (_enable)
             {
-                return _buffer;
+                return *_buffer;
             }
 
             return *_estream;
@@ -471,9 +801,9 @@ namespace tars
     protected:
 
         /**
-	     * 缓冲区
+	     * 缓冲区, 不写日志时为NULL
 	     */
-        std::stringstream _buffer;
+        std::stringstream *_buffer;
 
         /**
          * 输出流
@@ -488,7 +818,165 @@ namespace tars
         /**
          * 锁
          */
-		TC_ThreadRecMutex  &_mutex;
+		TC_ThreadRecMutex  *_mutex;
+
+        /**
+         * 直接写入的roll
+         */
+        TC_LoggerRoll   *_roll;
+
+        /**
+         * 是否写日志
+         */
+        bool            _enable;
+    };
+
+/**
+ * @brief 字符串常量格式串, logf/anyf只记地址不拷贝.
+ *
+ * 用TC_LOGFMT("...")构造, 宏里拼接了空串, 传非常量时编译不过
+ */
+    struct TC_LogLiteral
+    {
+        explicit TC_LogLiteral(const char *s) : fmt(s) {}
+
+        const char *fmt;
+    };
+
+#define TC_LOGFMT(s) tars::TC_LogLiteral("" s)
+
+/**
+ * @brief 临时类, 记录格式串和参数的二进制值, 析构的时候写日志.
+ *
+ * 编码: 2字节头部长度 + 头部 + 格式串 + 参数(1字节类型 + 值),
+ * 格式串默认拷贝: 头部长度的最高位置1, 格式串按4字节长度 + 内容(含结尾的0)拷贝进来;
+ * 常量(TC_LOGFMT, 地址在进程内一直有效)只记地址. 格式串中的{}依次替换成参数,
+ * 多出来的参数接在后面, 结尾没有换行时补一个.
+ * 基本类型和字符串直接编码, 其它类型用ostream格式化成字符串再编码.
+ */
+    class LoggerRecord
+    {
+    public:
+        /**
+         * @brief 参数类型
+         */
+        enum
+        {
+            ARG_INT     = 1,
+            ARG_UINT    = 2,
+            ARG_DOUBLE  = 3,
+            ARG_CHAR    = 4,
+            ARG_STRING  = 5,
+            ARG_POINTER = 6
+        };
+
+        /**
+         * @brief 构造
+         *
+         * @param header 头部, NULL表示不写日志
+         * @param fmt 格式串
+         * @param roll
+         * @param bCopy 是否拷贝格式串, false时只记地址, 只能用于字符串常量
+         */
+        LoggerRecord(const char *header, const char *fmt, TC_LoggerRoll *roll, bool bCopy = true);
+
+        /**
+         * @brief 析构, 写到roll
+         */
+        ~LoggerRecord();
+
+        LoggerRecord& operator << (bool t)                  { return appendInt(t); }
+        LoggerRecord& operator << (short t)                 { return appendInt(t); }
+        LoggerRecord& operator << (unsigned short t)        { return appendUInt(t); }
+        LoggerRecord& operator << (int t)                   { return appendInt(t); }
+        LoggerRecord& operator << (unsigned int t)          { return appendUInt(t); }
+        LoggerRecord& operator << (long t)                  { return appendInt(t); }
+        LoggerRecord& operator << (unsigned long t)         { return appendUInt(t); }
+        LoggerRecord& operator << (long long t)             { return appendInt(t); }
+        LoggerRecord& operator << (unsigned long long t)    { return appendUInt(t); }
+        LoggerRecord& operator << (float t)                 { return appendDouble(t); }
+        LoggerRecord& operator << (double t)                { return appendDouble(t); }
+        LoggerRecord& operator << (const void *t);
+        LoggerRecord& operator << (char t);
+        LoggerRecord& operator << (unsigned char t)         { return *this << (char)t; }
+        LoggerRecord& operator << (signed char t)           { return *this << (char)t; }
+        LoggerRecord& operator << (const char *t)           { return appendString(t, t ? strlen(t) : 0); }
+        LoggerRecord& operator << (const string &t)         { return appendString(t.data(), t.length()); }
+
+        /**
+         * @brief 其它类型在当前线程格式化
+         */
+        template <typename P>
+        LoggerRecord& operator << (const P &t)
+        {
+            if (_roll)
+            {
+                ostringstream os;
+                os << t;
+                const string &s = os.str();
+                appendString(s.data(), s.length());
+            }
+            return *this;
+        }
+
+        /**
+         * @brief 逗号分隔参数, 用于TLOGINFOF等宏
+         */
+        template <typename P>
+        LoggerRecord& operator , (const P &t)   { return *this << t; }
+
+        /**
+         * @brief 把编码后的记录格式化成文本
+         *
+         * @param data
+         * @param len
+         * @param out 追加到后面
+         */
+        static void format(const char *data, size_t len, string &out);
+
+        //不实现
+        LoggerRecord(const LoggerRecord& lt);
+        LoggerRecord& operator=(const LoggerRecord& lt);
+
+    protected:
+        LoggerRecord& appendInt(int64_t t);
+        LoggerRecord& appendUInt(uint64_t t);
+        LoggerRecord& appendDouble(double t);
+        LoggerRecord& appendString(const char *t, size_t len);
+
+        /**
+         * @brief 保证还有len个字节的空间
+         */
+        char *reserve(size_t len)
+        {
+            if (_len + len > _cap)
+            {
+                grow(_len + len);
+            }
+            return _data + _len;
+        }
+
+        void grow(size_t len);
+
+    protected:
+        enum
+        {
+            INLINE_SIZE = 256,
+            FMT_COPIED  = 0x8000   /**头部长度的最高位, 表示格式串拷贝在记录里*/
+        };
+
+        /**
+         * 写入的roll, 不写日志时为NULL
+         */
+        TC_LoggerRoll   *_roll;
+
+        /**
+         * 编码的数据, 开始时指向_inline, 不够时在堆上分配
+         */
+        char            *_data;
+        size_t          _len;
+        size_t          _cap;
+        char            _inline[INLINE_SIZE];
     };
 
 /**
@@ -704,6 +1192,30 @@ namespace tars
         LoggerStream any()      { return stream(0);}
 
         LoggerStream log(int level) { return stream(level);}
+
+        /**
+         * @brief 按等级记录, 格式化推迟到写日志线程, 格式串拷贝
+         *
+         * @param level
+         * @param fmt 格式串, {}依次替换成参数
+         */
+        LoggerRecord logf(int level, const char *fmt)          { return record(level, fmt, true);}
+
+        LoggerRecord logf(int level, const string &fmt)        { return record(level, fmt.c_str(), true);}
+
+        /**
+         * @brief 按等级记录, 格式串是TC_LOGFMT包起来的常量, 只记地址
+         */
+        LoggerRecord logf(int level, const TC_LogLiteral &fmt) { return record(level, fmt.fmt, false);}
+
+        /**
+         * @brief 记所有日志, 与等级无关, 格式化推迟到写日志线程
+         */
+        LoggerRecord anyf(const char *fmt)                     { return record(0, fmt, true);}
+
+        LoggerRecord anyf(const string &fmt)                   { return record(0, fmt.c_str(), true);}
+
+        LoggerRecord anyf(const TC_LogLiteral &fmt)            { return record(0, fmt.fmt, false);}
     protected:
 
         /**
@@ -717,31 +1229,45 @@ namespace tars
         {
             size_t n = 0;
 
-            if (hasFlag(TC_Logger::HAS_MTIME))
+            //时间按秒缓存格式化的结果, 毫秒单独追加
+            if (hasFlag(TC_Logger::HAS_MTIME) || hasFlag(TC_Logger::HAS_TIME))
             {
                 struct timeval t;
-                TC_TimeProvider::getInstance()->getNow(&t);
-                //gettimeofday(&t, NULL);
-
-                tm tt;
-                localtime_r(&t.tv_sec, &tt);
-                const char *szFormat = (_bHasSquareBracket)?("[%04d-%02d-%02d %02d:%02d:%02d.%03ld]%s"):("%04d-%02d-%02d %02d:%02d:%02d.%03ld%s");
-                n += snprintf(c + n, len-n, szFormat,
-                              tt.tm_year + 1900, tt.tm_mon+1, tt.tm_mday, tt.tm_hour, tt.tm_min, tt.tm_sec, t.tv_usec/1000,_sSepar.c_str());
-            }
-            else if (hasFlag(TC_Logger::HAS_TIME))
-            {
-                time_t t = TNOW;
-                tm tt;
-                localtime_r(&t, &tt);
-                const char *szFormat = (_bHasSquareBracket)?("[%04d-%02d-%02d %02d:%02d:%02d]%s"):("%04d-%02d-%02d %02d:%02d:%02d%s");
-                n += snprintf(c + n, len-n, szFormat,
-                              tt.tm_year + 1900, tt.tm_mon+1, tt.tm_mday, tt.tm_hour, tt.tm_min, tt.tm_sec,_sSepar.c_str());
+                if (hasFlag(TC_Logger::HAS_MTIME))
+                {
+                    TC_TimeProvider::getInstance()->getNow(&t);
+                }
+                else
+                {
+                    t.tv_sec  = TNOW;
+                    t.tv_usec = 0;
+                }
+
+                if (_bHasSquareBracket)
+                {
+                    c[n++] = '[';
+                }
+
+                memcpy(c + n, TC_LoggerHead::timeStr(t.tv_sec), 19);
+                n += 19;
+
+                if (hasFlag(TC_Logger::HAS_MTIME))
+                {
+                    memcpy(c + n, TC_TimeProvider::msStr(t.tv_usec / 1000), 4);
+                    n += 4;
+                }
+
+                if (_bHasSquareBracket)
+                {
+                    c[n++] = ']';
+                }
+
+                n += snprintf(c + n, len - n, "%s", _sSepar.c_str());
             }
 
             if (hasFlag(TC_Logger::HAS_PID))
             {
-                n += snprintf(c + n, len - n, "%ld%s", syscall(SYS_gettid), _sSepar.c_str());
+                n += snprintf(c + n, len - n, "%s%s", TC_LoggerHead::tidStr(), _sSepar.c_str());
             }
 
             if (hasFlag(TC_Logger::HAS_LEVEL))
@@ -758,19 +1284,36 @@ namespace tars
          */
         LoggerStream stream(int level)
         {
-            ostream *ost = NULL;
-
             if (level <= _level)
             {
                 char c[128] = "\0";
                 head(c, sizeof(c) - 1, level);
 
-                ost = &_stream;
+                return LoggerStream(c, this->_roll.get(), &_estream);
+            }
+
+            return LoggerStream(NULL, (TC_LoggerRoll*)NULL, &_estream);
+        }
+
+        /**
+         * @brief 二进制记录.
+         *
+         * @param level
+         * @param fmt
+         * @param bCopy 是否拷贝格式串
+         * @return LoggerRecord
+         */
+        LoggerRecord record(int level, const char *fmt, bool bCopy)
+        {
+            if (level <= _level)
+            {
+                char c[128] = "\0";
+                head(c, sizeof(c) - 1, level);
 
-                return LoggerStream(c, ost, &_estream, _mutex);
+                return LoggerRecord(c, fmt, this->_roll.get(), bCopy);
             }
 
-            return LoggerStream(NULL, ost, &_estream, _mutex);
+            return LoggerRecord(NULL, fmt, NULL);
         }
 
         /**
@@ -881,6 +1424,16 @@ namespace tars
          *@brief 按照等级来输出日志
          */
         virtual LoggerStream log(int level)=0;
+
+        /**
+         * @brief 按照等级来输出日志, 格式化推迟到写日志线程, 格式串拷贝
+         */
+        virtual LoggerRecord logf(int level, const string &fmt) = 0;
+
+        /**
+         * @brief 记所有日志, 格式化推迟到写日志线程, 格式串拷贝
+         */
+        virtual LoggerRecord anyf(const string &fmt) = 0;
         /**
          * @brief 如果是异步调用，则马上进行刷新
          */
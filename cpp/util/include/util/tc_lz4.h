@@ -0,0 +1,71 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+
+#ifndef __TC_LZ4_H
+#define __TC_LZ4_H
+
+#include <string>
+
+using namespace std;
+
+namespace tars
+{
+/////////////////////////////////////////////////
+/**
+* @file tc_lz4.h
+* @brief  LZ4块格式的压缩/解压, 不依赖外部库.
+*
+* 压缩比不如gzip, 但压缩和解压都快很多, 适合日志等大量文本的传输;
+* 输出是标准的LZ4 block格式(不带frame头), 解压时需要知道原始长度.
+*/
+/////////////////////////////////////////////////
+
+class TC_LZ4
+{
+public:
+    /**
+    * @brief  压缩
+    *
+    * @param src         需要压缩的数据
+    * @param length      数据长度
+    * @param buffer      输出buffer(追加到后面)
+    * @return bool       成功失败
+    */
+    static bool compress(const char *src, size_t length, string& buffer);
+
+    /**
+    * @brief  解压, 会检查数据的合法性, 不会越界
+    *
+    * @param src         压缩的数据
+    * @param length      压缩数据长度
+    * @param rawLength   原始数据长度
+    * @param buffer      输出buffer(追加到后面)
+    * @return bool       成功失败(数据不合法或者长度和rawLength不一致)
+    */
+    static bool uncompress(const char *src, size_t length, size_t rawLength, string& buffer);
+
+    /**
+    * @brief  压缩后最大可能的长度
+    *
+    * @param length      原始数据长度
+    * @return size_t
+    */
+    static size_t compressBound(size_t length) { return length + length / 255 + 16; }
+};
+
+}
+
+#endif
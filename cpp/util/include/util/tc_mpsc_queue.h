@@ -0,0 +1,172 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+
+#ifndef _TC_MPSC_QUEUE_H_
+#define _TC_MPSC_QUEUE_H_
+
+#include <cstddef>
+#include "util/tc_atomic.h"
+
+namespace tars
+{
+/////////////////////////////////////////////////
+/**
+ * @file tc_mpsc_queue.h
+ * @brief 多生产者单消费者的无锁侵入式队列.
+ *
+ * 元素自带next指针(T::next), 入队不分配内存, 只有一次原子交换;
+ * 多个线程可以同时push, 只能有一个线程pop.
+ * 生产者交换完尾指针、还没链上next的瞬间, pop可能暂时取不到这个元素(返回NULL),
+ * 调用者需要在push之后再通知消费者, 消费者被通知后再取一次即可.
+ * 元素的生命周期由调用者管理.
+ */
+/////////////////////////////////////////////////
+
+template<typename T>
+class TC_MpscQueue
+{
+public:
+    /**
+     * @brief 构造函数
+     */
+    TC_MpscQueue()
+    {
+        _stub.next = NULL;
+        _head      = &_stub;
+        _tail      = &_stub;
+    }
+
+    /**
+     * @brief 入队, 可以多线程同时调用
+     *
+     * @param t
+     */
+    void push(T *t)
+    {
+        t->next = NULL;
+
+        ++_size;
+
+        link(t);
+    }
+
+    /**
+     * @brief 出队, 只能在一个线程中调用
+     *
+     * @return T*, 队列为空(或者元素还没有链上)时返回NULL
+     */
+    T *pop()
+    {
+        T *tail = _tail;
+        T *next = tail->next;
+
+        if (tail == &_stub)
+        {
+            if (next == NULL)
+            {
+                return NULL;
+            }
+
+            _tail = next;
+            tail  = next;
+            next  = next->next;
+        }
+
+        if (next != NULL)
+        {
+            _tail = next;
+            --_size;
+            return tail;
+        }
+
+        //还有生产者正在链入
+        if (tail != _head)
+        {
+            return NULL;
+        }
+
+        //tail是最后一个元素, 放回stub才能把它取出来
+        _stub.next = NULL;
+        link(&_stub);
+
+        next = tail->next;
+
+        if (next != NULL)
+        {
+            _tail = next;
+            --_size;
+            return tail;
+        }
+
+        return NULL;
+    }
+
+    /**
+     * @brief 队列中的元素个数(近似值)
+     *
+     * @return size_t
+     */
+    size_t size() const
+    {
+        int n = _size.get();
+        return n > 0 ? n : 0;
+    }
+
+protected:
+    /**
+     * 原子地换上新的头, 再把旧头链到它上面
+     */
+    void link(T *t)
+    {
+        __sync_synchronize();
+
+        T *prev = __sync_lock_test_and_set(&_head, t);
+
+        prev->next = t;
+    }
+
+private:
+    /**
+     * 不允许复制
+     */
+    TC_MpscQueue(const TC_MpscQueue &);
+    TC_MpscQueue &operator=(const TC_MpscQueue &);
+
+protected:
+    /**
+     * 占位元素, 保证队列至少有一个元素
+     */
+    T               _stub;
+
+    /**
+     * 生产者端(最后入队的元素)
+     */
+    T * volatile    _head;
+
+    /**
+     * 消费者端
+     */
+    T *             _tail;
+
+    /**
+     * 元素个数
+     */
+    TC_Atomic       _size;
+};
+
+}
+
+#endif
@@ -22,6 +22,7 @@
 #include <map>
 #include <vector>
 #include <stdlib.h>
+#include <stdint.h>
 
 namespace tars
 {
@@ -224,6 +225,15 @@ public:
     */
     string escapeString(const string& sFrom);
 
+    /**
+    *  @brief 字符转义, 结果追加到sTo后面, 不用临时内存. 
+    *  
+    * @param sFrom  源字符串
+    * @param iLen   源字符串长度
+    * @param sTo    输出字符串
+    */
+    void escapeString(const char *sFrom, size_t iLen, string &sTo);
+
     /**
     * @brief 更新或者插入数据. 
     *  
@@ -233,6 +243,18 @@ public:
     */
     void execute(const string& sSql);
 
+    /**
+    * @brief 用LOAD DATA LOCAL INFILE导入内存中的数据. 
+    *  
+    * 语句里的文件名不会被打开, 数据直接从内存读; 
+    * 服务端要允许local_infile, 客户端标识要带CLIENT_LOCAL_FILES
+    * @param sSql  load data local infile语句
+    * @param data  文件内容
+    * @param len   长度
+    * @throws      TC_Mysql_Exception
+    */
+    void loadData(const string& sSql, const char *data, size_t len);
+
     /**
      *  @brief mysql的一条记录
      */
@@ -440,6 +462,13 @@ public:
      * @return int
      */
      size_t getAffectedRows();
+
+    /**
+     * @brief 数据库配置
+     * @return TC_DBConf
+     */
+    const TC_DBConf& getDBConf() const { return _dbConf; }
+
 protected:
     /**
     * @brief copy contructor，只申明,不定义,保证不被使用 
@@ -477,5 +506,141 @@ private:
   
 };
 
+/**
+* @brief 批量写入. 
+*  
+* 按行追加字段, 攒够iMaxRows行或者iMaxPacket字节后一次写入, 
+* 字段直接转义/格式化到缓冲区里, 不生成中间字符串: 
+* BM_INSERT用多行insert ... values (...),(...); 
+* BM_LOAD_DATA生成TSV, 用LOAD DATA LOCAL INFILE从内存导入, 
+* 连接的客户端标识要带CLIENT_LOCAL_FILES. 
+*  
+* 用法: 
+* TC_MysqlBulk bulk(&mysql, TC_MysqlBulk::BM_INSERT, 1000); 
+* bulk.begin("t_table", "a,b"); 
+* for(...) { bulk.addStr(a); bulk.addInt(b); bulk.endRow(); } 
+* bulk.flush(); 
+*/
+class TC_MysqlBulk
+{
+public:
+    /**
+    * 写入方式
+    */
+    enum BulkMode
+    {
+        BM_INSERT       = 0,
+        BM_LOAD_DATA    = 1
+    };
+
+    /**
+    * @brief 构造函数. 
+    *  
+    * @param pMysql      数据库
+    * @param eMode       写入方式
+    * @param iMaxRows    每次最多写入的行数
+    * @param iMaxPacket  每次写入的语句(load data是TSV)的最大字节数, 
+    *                    不要超过服务端的max_allowed_packet; 单独一行超过时仍然整行写入
+    */
+    TC_MysqlBulk(TC_Mysql *pMysql, BulkMode eMode = BM_INSERT, size_t iMaxRows = 1000, size_t iMaxPacket = 1024*1024);
+
+    /**
+    * @brief 析构, 没有flush的行丢弃. 
+    */
+    virtual ~TC_MysqlBulk() {}
+
+    /**
+    * @brief 配置串转成写入方式, "loaddata"是BM_LOAD_DATA, 其他都是BM_INSERT. 
+    */
+    static BulkMode toMode(const string &sMode);
+
+    /**
+    * @brief 开始写一个表, 之前的数据要先flush. 
+    *  
+    * @param sTable    表名
+    * @param sColumns  字段名, 逗号分隔
+    * @param bIgnore   主键重复的记录是否忽略
+    */
+    void begin(const string &sTable, const string &sColumns, bool bIgnore = true);
+
+    /**
+    * @brief 追加字符串字段. 
+    */
+    void addStr(const char *str, size_t len);
+
+    void addStr(const string &str) { addStr(str.c_str(), str.length()); }
+
+    /**
+    * @brief 追加整数字段. 
+    */
+    void addInt(int64_t i);
+
+    /**
+    * @brief 追加NULL字段. 
+    */
+    void addNull();
+
+    /**
+    * @brief 一行结束, 够iMaxRows行或者iMaxPacket字节时写入, 
+    * 加上这一行超过iMaxPacket时先写入之前的行. 
+    * @throws TC_Mysql_Exception
+    * @return 本次写入的行数, 没有写入是0
+    */
+    size_t endRow();
+
+    /**
+    * @brief 写入缓冲区里的行. 
+    * @throws TC_Mysql_Exception
+    * @return 本次写入的行数
+    */
+    size_t flush();
+
+    /**
+    * @brief 缓冲区里还没写入的行数. 
+    */
+    size_t pending() const { return _iRows; }
+
+    /**
+    * @brief begin以来写入的行数. 
+    */
+    size_t total() const { return _iTotal; }
+
+    /**
+    * @brief 缓冲区内容, 下一次flush要执行的sql或者TSV. 
+    */
+    const string &buffer() const { return _buffer; }
+
+protected:
+    void reset();
+
+    /**
+    * @brief 执行缓冲区里的语句, 默认写入数据库. 
+    * @throws TC_Mysql_Exception
+    */
+    virtual void write();
+
+    /**
+    * @brief 追加字段前的分隔符. 
+    */
+    void addSep();
+
+protected:
+    TC_Mysql    *_pMysql;
+    BulkMode    _eMode;
+    size_t      _iMaxRows;
+    size_t      _iMaxPacket;
+
+    //insert方式是语句头, load data方式是整条语句
+    string      _sHead;
+    string      _buffer;
+
+    size_t      _iRows;
+    size_t      _iFields;
+    size_t      _iTotal;
+
+    //当前行在_buffer中的起始位置
+    size_t      _iRowBegin;
+};
+
 }
 #endif //_TC_MYSQL_H
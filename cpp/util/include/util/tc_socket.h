@@ -397,6 +397,14 @@ public:
      */
     void setKeepAlive();
 
+    /**
+     * @brief 设置SO_REUSEPORT, 允许多个socket监听同一个端口(必须在bind之前调用). 
+     *  
+     * @throws TC_Socket_Exception
+     * @return 
+     */
+    void setReusePort();
+
     /**
     * @brief 获取recv buffer 大小. 
     *  
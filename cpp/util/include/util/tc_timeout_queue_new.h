@@ -18,6 +18,7 @@
 #define __TC_TIMEOUT_QUEUE_NEW_H
 #include <map>
 #include <list>
+#include <vector>
 #include <ext/hash_map>
 #include <iostream>
 #include <cassert>
@@ -100,6 +101,12 @@ public:
      */
     bool getSend(T & t);
 
+    /**
+     * 按发送顺序获取最多iMaxNum个要发送的数据, 发送后逐个popSend
+     * @return size_t, 获取的个数
+     */
+    size_t getSend(vector<T> & vt, size_t iMaxNum);
+
     /**
      * 把已经发送的数据从list里面删除
      */
@@ -184,6 +191,21 @@ template<typename T> bool TC_TimeoutQueueNew<T>::getSend(T & t)
     return true;
 }
 
+template<typename T> size_t TC_TimeoutQueueNew<T>::getSend(vector<T> & vt, size_t iMaxNum)
+{
+    vt.clear();
+
+    //最早放入的在链表尾部
+    typename send_type::reverse_iterator it = _send.rbegin();
+
+    for(; it != _send.rend() && vt.size() < iMaxNum; ++it)
+    {
+        assert(!it->dataIter->second.hasSend);
+        vt.push_back(it->dataIter->second.ptr);
+    }
+
+    return vt.size();
+}
 
 template<typename T> void TC_TimeoutQueueNew<T>::popSend(bool del)
 {
@@ -19,6 +19,7 @@
 
 #include <string>
 #include <string.h>
+#include <time.h>
 #include "util/tc_monitor.h"
 #include "util/tc_thread.h"
 #include "util/tc_autoptr.h"
@@ -28,6 +29,7 @@
 
 #define TNOW     tars::TC_TimeProvider::getInstance()->getNow()
 #define TNOWMS   tars::TC_TimeProvider::getInstance()->getNowMs()
+#define TNOWUS   tars::TC_TimeProvider::getInstance()->getNowUs()
 
 namespace tars
 {
@@ -49,6 +51,18 @@ class TC_TimeProvider : public TC_Thread, public TC_HandleBase
 {
 public:
 
+    /**
+     * 预先缓存的时间格式
+     */
+    enum TimeFormat
+    {
+        TF_DATETIME = 0,        /**"%Y-%m-%d %H:%M:%S"*/
+        TF_NUMBER   = 1,        /**"%Y%m%d%H%M%S"*/
+        TF_MINUTE   = 2,        /**"%Y%m%d%H%M", 统计按分钟分桶*/
+        TF_DATE     = 3,        /**"%Y%m%d"*/
+        TF_GMT      = 4         /**"%a, %d %b %Y %H:%M:%S GMT", http的Date头*/
+    };
+
     /**
      * @brief 获取实例. 
      *  
@@ -97,6 +111,14 @@ public:
      * @return void 
      */
     int64_t getNowMs();
+
+    /**
+     * @brief 获取us时间, 和getNowMs一样由tsc推算, 不用每次调gettimeofday.
+     *        getNowUs()/1000和getNowMs()是同一个时间.
+     *
+     * @return int64_t
+     */
+    int64_t getNowUs();
     
     /**
      * @brief 获取cpu主频.
@@ -106,6 +128,37 @@ public:
 
     float cpuMHz();
 
+    /**
+     * @brief 按固定格式格式化时间, 不调用localtime_r/strftime.
+     *
+     * 当天的日期部分(本地和GMT)缓存在一份用seqlock保护的数据里,
+     * 时分秒直接由秒数算出; 缓存由时间线程在跨天(或夏令时切换)时更新,
+     * 不在当天的时间各自调用一次localtime_r/gmtime_r, 不影响缓存.
+     * 不启动时间线程也可以调用, 此时缓存的是第一次调用的那一天.
+     *
+     * @param t       时间
+     * @param format  TimeFormat
+     * @param buf     输出, 至少32字节, 以'\0'结尾
+     * @return size_t 长度
+     */
+    static size_t tm2str(time_t t, int format, char *buf);
+
+    /**
+     * @brief 本地时间, 和localtime_r的结果一样, 但是当天内不再计算时区
+     *
+     * @param t
+     * @param tt
+     */
+    static void localtime(time_t t, struct tm &tt);
+
+    /**
+     * @brief 毫秒的后缀 ".000" ~ ".999", 固定4个字符
+     *
+     * @param ms 0~999
+     * @return const char*
+     */
+    static const char *msStr(int ms);
+
     /**
      * @brief 运行
      */
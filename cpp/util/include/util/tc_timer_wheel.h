@@ -0,0 +1,158 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+
+#ifndef __TC_TIMER_WHEEL_H_
+#define __TC_TIMER_WHEEL_H_
+
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+namespace tars
+{
+/////////////////////////////////////////////////
+/**
+ * @file  tc_timer_wheel.h
+ * @brief 分层时间轮.
+ *
+ * 定时项用[1, size]的整数编号标识, 节点预先分配, 挂入/摘除都是O(1);
+ * 第一层256个槽, 每槽一个刻度, 后面四层各64个槽, 每层一个槽覆盖上一层一整圈,
+ * 时间推进到某层转完一圈时, 把上一层对应槽里的项重新分散到下层(cascade).
+ * 非线程安全, 由调用者加锁.
+ */
+/////////////////////////////////////////////////
+
+class TC_TimerWheel
+{
+public:
+    /**
+     * @brief 构造函数
+     */
+    TC_TimerWheel();
+
+    /**
+     * @brief 初始化
+     *
+     * @param size 编号的最大值, 可用编号为[1, size]
+     * @param now  当前刻度
+     */
+    void init(uint32_t size, int64_t now);
+
+    /**
+     * @brief 挂入定时项, 已经在时间轮中的先摘除
+     *
+     * @param id     编号
+     * @param expire 到期刻度, 已经过期的在推进到下一个刻度时取出
+     */
+    void add(uint32_t id, int64_t expire);
+
+    /**
+     * @brief 摘除定时项, 不在时间轮中的忽略
+     *
+     * @param id 编号
+     */
+    void del(uint32_t id);
+
+    /**
+     * @brief 是否在时间轮中
+     *
+     * @param id 编号
+     * @return bool
+     */
+    bool exist(uint32_t id) const { return _nodes[id].next != 0; }
+
+    /**
+     * @brief 推进到now, 取出所有到期的定时项(取出后不再在时间轮中)
+     *
+     * @param now 当前刻度
+     * @param ids [out]到期的编号, 追加在后面
+     */
+    void expire(int64_t now, std::vector<uint32_t> &ids);
+
+    /**
+     * @brief 时间轮中的定时项个数
+     *
+     * @return size_t
+     */
+    size_t size() const { return _count; }
+
+protected:
+    enum
+    {
+        ROOT_BITS   = 8,
+        LEVEL_BITS  = 6,
+        LEVEL_NUM   = 4,
+        ROOT_SIZE   = 1 << ROOT_BITS,
+        LEVEL_SIZE  = 1 << LEVEL_BITS,
+        SLOT_NUM    = ROOT_SIZE + LEVEL_NUM * LEVEL_SIZE
+    };
+
+    /**
+     * 节点, 槽的头节点也放在_nodes中(编号size+1起),
+     * next为0表示不在时间轮中
+     */
+    struct Node
+    {
+        uint32_t    prev;
+        uint32_t    next;
+        int64_t     expire;
+    };
+
+    /**
+     * 按到期刻度选择槽, 挂到槽的尾部
+     */
+    void place(uint32_t id);
+
+    /**
+     * 摘除
+     */
+    void unlink(uint32_t id);
+
+    /**
+     * 把上层的一个槽重新分散到下层
+     */
+    void cascade(uint32_t slot);
+
+    /**
+     * 槽的头节点编号
+     */
+    uint32_t head(uint32_t slot) const { return _size + 1 + slot; }
+
+protected:
+    /**
+     * 编号最大值
+     */
+    uint32_t            _size;
+
+    /**
+     * 定时项个数
+     */
+    size_t              _count;
+
+    /**
+     * 下一个要处理的刻度
+     */
+    int64_t             _current;
+
+    /**
+     * 节点, [1, size]为定时项, 之后为槽的头节点
+     */
+    std::vector<Node>   _nodes;
+};
+
+}
+
+#endif
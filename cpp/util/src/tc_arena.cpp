@@ -0,0 +1,116 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+
+#include "util/tc_arena.h"
+#include <cstdlib>
+
+namespace tars
+{
+
+static __thread TC_Arena *  t_current = NULL;
+
+/**
+ * 块头按ALIGN对齐, 保证数据区的起始地址对齐
+ */
+static const size_t BLOCK_HEAD = (sizeof(void*) + sizeof(size_t) + TC_Arena::ALIGN - 1) & ~((size_t)TC_Arena::ALIGN - 1);
+
+TC_Arena::TC_Arena(size_t blockSize)
+: _head(NULL)
+, _cur(NULL)
+, _end(NULL)
+, _blockSize(blockSize)
+, _used(0)
+, _capacity(0)
+{
+}
+
+TC_Arena::~TC_Arena()
+{
+    while (_head)
+    {
+        Block *next = _head->next;
+        ::free(_head);
+        _head = next;
+    }
+}
+
+void *TC_Arena::allocateSlow(size_t size)
+{
+    //大的分配单独成块, 挂在当前块后面, 不浪费当前块剩余的空间
+    bool   bLarge = size > _blockSize / 4;
+    size_t len    = bLarge ? size : _blockSize;
+
+    Block *b = (Block*)::malloc(BLOCK_HEAD + len);
+    if (b == NULL)
+    {
+        throw std::bad_alloc();
+    }
+
+    b->size    = len;
+    _capacity += len;
+    _used     += size;
+
+    char *data = (char*)b + BLOCK_HEAD;
+
+    if (bLarge && _head != NULL)
+    {
+        b->next     = _head->next;
+        _head->next = b;
+        return data;
+    }
+
+    b->next = _head;
+    _head   = b;
+    _cur    = data + size;
+    _end    = data + len;
+
+    return data;
+}
+
+void TC_Arena::reset()
+{
+    if (_head == NULL)
+    {
+        return;
+    }
+
+    //保留最后申请的那块(当前块), 其余释放
+    Block *b = _head->next;
+    while (b)
+    {
+        Block *next = b->next;
+        ::free(b);
+        b = next;
+    }
+
+    _head->next = NULL;
+    _capacity   = _head->size;
+    _used       = 0;
+    _cur        = (char*)_head + BLOCK_HEAD;
+    _end        = _cur + _head->size;
+}
+
+TC_Arena *TC_Arena::current()
+{
+    return t_current;
+}
+
+void TC_Arena::setCurrent(TC_Arena *arena)
+{
+    t_current = arena;
+}
+
+}
@@ -191,6 +191,107 @@ void TC_Buffer::SetHighWaterPercent(size_t percents)
 
     _highWaterPercent = percents;
 }
+
+const std::size_t TC_SharedBuffer::kDefaultSize = 64 * 1024;
+
+std::size_t TC_SharedBuffer::PushData(const void* data, std::size_t size)
+{
+    if (!data || size == 0)
+        return 0;
+
+    AssureSpace(size);
+    ::memcpy(WriteAddr(), data, size);
+    Produce(size);
+
+    return size;
+}
+
+void TC_SharedBuffer::Consume(std::size_t bytes)
+{
+    assert (_readPos + bytes <= _writePos);
+
+    _readPos += bytes;
+
+    // 没有被TC_SharedSlice引用时, 从头开始复用内存块
+    if (IsEmpty() && _block && _block->getRef() == 1)
+        _readPos = _writePos = 0;
+}
+
+void TC_SharedBuffer::Shrink()
+{
+    if (!IsEmpty())
+        return;
+
+    _block = NULL;
+    _readPos = _writePos = 0;
+}
+
+TC_SharedSlice TC_SharedBuffer::Slice(std::size_t offset, std::size_t size)
+{
+    assert (offset + size <= ReadableSize());
+
+    return TC_SharedSlice(_block, ReadAddr() + offset, size);
+}
+
+TC_SharedSlice TC_SharedBuffer::Take(std::size_t size)
+{
+    assert (size <= ReadableSize());
+
+    TC_SharedSlice slice;
+
+    if (size == 0)
+        return slice;
+
+    // 数据不到内存块的一半, 拷贝出来, 内存块留给后面的数据复用
+    if (size * 2 < _block->Capacity())
+    {
+        TC_SharedBlockPtr block = new TC_SharedBlock(size);
+
+        ::memcpy(block->Data(), ReadAddr(), size);
+
+        slice = TC_SharedSlice(block, block->Data(), size);
+    }
+    else
+    {
+        slice = Slice(0, size);
+    }
+
+    Consume(size);
+
+    return slice;
+}
+
+void TC_SharedBuffer::AssureSpace(std::size_t needsize)
+{
+    if (WritableSize() >= needsize)
+        return;
+
+    const std::size_t dataSize = ReadableSize();
+
+    // 内存块只有自己引用, 且整理后空间足够, 原地整理
+    if (_block && _block->getRef() == 1 && _block->Capacity() >= dataSize + needsize)
+    {
+        ::memmove(_block->Data(), ReadAddr(), dataSize);
+    }
+    else
+    {
+        std::size_t capacity = kDefaultSize;
+        while (capacity < dataSize + needsize)
+            capacity *= 2;
+
+        TC_SharedBlockPtr block = new TC_SharedBlock(capacity);
+
+        if (dataSize != 0)
+            ::memcpy(block->Data(), ReadAddr(), dataSize);
+
+        _block = block;
+    }
+
+    _readPos = 0;
+    _writePos = dataSize;
+
+    assert (needsize <= WritableSize());
+}
     
 } // end namespace tars
 
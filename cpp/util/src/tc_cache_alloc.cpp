@@ -0,0 +1,253 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+
+#include "util/tc_cache_alloc.h"
+#include "util/tc_thread_mutex.h"
+#include "util/tc_lock.h"
+#include <new>
+#include <sstream>
+#include <cstdlib>
+#include <pthread.h>
+
+namespace tars
+{
+
+/**
+ * 全局的每档空闲链表, 第一次使用时创建, 不释放(进程退出时其它线程可能还在归还)
+ */
+struct CacheAllocClass
+{
+    TC_ThreadMutex          mutex;
+    std::vector<void*>      free;
+    volatile int64_t        hit;
+    volatile int64_t        miss;
+
+    CacheAllocClass() : hit(0), miss(0) {}
+};
+
+static CacheAllocClass *   g_class = NULL;
+
+/**
+ * 线程缓存, 命中次数先记在线程里, 攒够了再加到全局
+ */
+static __thread void *      t_cache[TC_CacheAlloc::CLASS_NUM][TC_CacheAlloc::CACHE_NUM];
+static __thread uint32_t    t_count[TC_CacheAlloc::CLASS_NUM];
+static __thread uint32_t    t_hit[TC_CacheAlloc::CLASS_NUM];
+static __thread bool        t_registered = false;
+
+static pthread_once_t       g_once = PTHREAD_ONCE_INIT;
+static pthread_key_t        g_key;
+
+static const uint32_t HIT_FLUSH = 256;
+
+static inline size_t classOf(size_t size)
+{
+    if (size <= ((size_t)1 << TC_CacheAlloc::MIN_SHIFT))
+    {
+        return 0;
+    }
+
+    return sizeof(unsigned long) * 8 - __builtin_clzl(size - 1) - TC_CacheAlloc::MIN_SHIFT;
+}
+
+static inline void flushHit(size_t idx)
+{
+    if (t_hit[idx] > 0)
+    {
+        __sync_fetch_and_add(&g_class[idx].hit, (int64_t)t_hit[idx]);
+        t_hit[idx] = 0;
+    }
+}
+
+/**
+ * 把线程缓存中从start开始的块还给全局, 全局满了直接释放
+ */
+static void release(size_t idx, uint32_t start)
+{
+    CacheAllocClass &c = g_class[idx];
+
+    {
+        TC_LockT<TC_ThreadMutex> lock(c.mutex);
+
+        while (t_count[idx] > start && c.free.size() < (size_t)TC_CacheAlloc::GLOBAL_NUM)
+        {
+            c.free.push_back(t_cache[idx][--t_count[idx]]);
+        }
+    }
+
+    while (t_count[idx] > start)
+    {
+        ::free(t_cache[idx][--t_count[idx]]);
+    }
+
+    flushHit(idx);
+}
+
+/**
+ * 线程退出时把缓存全部还给全局
+ */
+static void threadExit(void *)
+{
+    t_registered = false;
+
+    for (size_t idx = 0; idx < (size_t)TC_CacheAlloc::CLASS_NUM; ++idx)
+    {
+        release(idx, 0);
+    }
+}
+
+static void init()
+{
+    g_class = new CacheAllocClass[TC_CacheAlloc::CLASS_NUM];
+
+    pthread_key_create(&g_key, threadExit);
+}
+
+static void registerThread()
+{
+    t_registered = true;
+
+    pthread_once(&g_once, init);
+
+    pthread_setspecific(g_key, (void*)1);
+}
+
+void *TC_CacheAlloc::allocate(size_t size)
+{
+    if (size > ((size_t)1 << MAX_SHIFT))
+    {
+        void *p = ::malloc(size);
+        if (p == NULL)
+        {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+
+    size_t idx = classOf(size);
+
+    if (t_count[idx] == 0)
+    {
+        if (!t_registered)
+        {
+            registerThread();
+        }
+
+        //从全局批量取一半
+        CacheAllocClass &c = g_class[idx];
+
+        TC_LockT<TC_ThreadMutex> lock(c.mutex);
+
+        while (t_count[idx] < (uint32_t)CACHE_NUM / 2 && !c.free.empty())
+        {
+            t_cache[idx][t_count[idx]++] = c.free.back();
+            c.free.pop_back();
+        }
+    }
+
+    if (t_count[idx] > 0)
+    {
+        if (++t_hit[idx] >= HIT_FLUSH)
+        {
+            flushHit(idx);
+        }
+
+        return t_cache[idx][--t_count[idx]];
+    }
+
+    __sync_fetch_and_add(&g_class[idx].miss, (int64_t)1);
+
+    void *p = ::malloc((size_t)1 << (idx + MIN_SHIFT));
+    if (p == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void TC_CacheAlloc::deallocate(void *p, size_t size)
+{
+    if (p == NULL)
+    {
+        return;
+    }
+
+    if (size > ((size_t)1 << MAX_SHIFT))
+    {
+        ::free(p);
+        return;
+    }
+
+    if (!t_registered)
+    {
+        registerThread();
+    }
+
+    size_t idx = classOf(size);
+
+    if (t_count[idx] == (uint32_t)CACHE_NUM)
+    {
+        release(idx, CACHE_NUM / 2);
+    }
+
+    t_cache[idx][t_count[idx]++] = p;
+}
+
+void TC_CacheAlloc::getStat(std::vector<Stat> &stats)
+{
+    pthread_once(&g_once, init);
+
+    stats.resize(CLASS_NUM);
+
+    for (size_t idx = 0; idx < (size_t)CLASS_NUM; ++idx)
+    {
+        flushHit(idx);
+
+        CacheAllocClass &c = g_class[idx];
+
+        Stat &s  = stats[idx];
+        s.size   = (size_t)1 << (idx + MIN_SHIFT);
+        s.hit    = c.hit;
+        s.miss   = c.miss;
+
+        TC_LockT<TC_ThreadMutex> lock(c.mutex);
+        s.cached = c.free.size();
+    }
+}
+
+std::string TC_CacheAlloc::stat()
+{
+    std::vector<Stat> stats;
+
+    getStat(stats);
+
+    std::ostringstream os;
+
+    for (size_t i = 0; i < stats.size(); ++i)
+    {
+        if (stats[i].hit == 0 && stats[i].miss == 0)
+        {
+            continue;
+        }
+
+        os << "size:" << stats[i].size << " hit:" << stats[i].hit << " miss:" << stats[i].miss
+           << " cached:" << stats[i].cached << std::endl;
+    }
+
+    return os.str();
+}
+
+}
@@ -15,6 +15,7 @@
  */
 
 #include "util/tc_common.h"
+#include "util/tc_timeprovider.h"
 #include <signal.h>
 #include <sys/time.h>
 #include <string.h>
@@ -22,6 +23,134 @@
 
 namespace tars
 {
+
+namespace p
+{
+    /**
+     * 两位数字一起转换
+     */
+    static const char g_digits[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+    char *u64tochars(char *buf, uint64_t v)
+    {
+        char tmp[24];
+        char *p = tmp + sizeof(tmp);
+
+        while(v >= 100)
+        {
+            unsigned i = (unsigned)(v % 100) * 2;
+            v /= 100;
+            *--p = g_digits[i + 1];
+            *--p = g_digits[i];
+        }
+
+        if(v >= 10)
+        {
+            unsigned i = (unsigned)v * 2;
+            *--p = g_digits[i + 1];
+            *--p = g_digits[i];
+        }
+        else
+        {
+            *--p = (char)('0' + v);
+        }
+
+        size_t len = tmp + sizeof(tmp) - p;
+        memcpy(buf, p, len);
+        return buf + len;
+    }
+
+    static bool parseDigits(const char *s, size_t len, uint64_t max, uint64_t &v)
+    {
+        if(len == 0)
+        {
+            return false;
+        }
+
+        uint64_t limit = max / 10;
+        unsigned last  = (unsigned)(max % 10);
+
+        uint64_t r = 0;
+        for(size_t i = 0; i < len; ++i)
+        {
+            unsigned d = (unsigned char)s[i] - '0';
+            if(d > 9 || r > limit || (r == limit && d > last))
+            {
+                return false;
+            }
+            r = r * 10 + d;
+        }
+
+        v = r;
+        return true;
+    }
+
+    bool str2i64(const char *s, size_t len, int64_t &v)
+    {
+        bool neg = false;
+        if(len > 0 && (s[0] == '-' || s[0] == '+'))
+        {
+            neg = (s[0] == '-');
+            ++s;
+            --len;
+        }
+
+        uint64_t max = neg ? (uint64_t)numeric_limits<int64_t>::max() + 1 : (uint64_t)numeric_limits<int64_t>::max();
+
+        uint64_t u;
+        if(!parseDigits(s, len, max, u))
+        {
+            return false;
+        }
+
+        v = neg ? (int64_t)(0 - u) : (int64_t)u;
+        return true;
+    }
+
+    bool str2u64(const char *s, size_t len, uint64_t &v)
+    {
+        if(len > 0 && s[0] == '+')
+        {
+            ++s;
+            --len;
+        }
+
+        return parseDigits(s, len, numeric_limits<uint64_t>::max(), v);
+    }
+
+    bool str2double(const char *s, size_t len, double &v)
+    {
+        char buf[64];
+        if(len == 0 || len >= sizeof(buf))
+        {
+            return false;
+        }
+
+        memcpy(buf, s, len);
+        buf[len] = '\0';
+
+        char *end = NULL;
+        double d = strtod(buf, &end);
+        if(end != buf + len)
+        {
+            return false;
+        }
+
+        v = d;
+        return true;
+    }
+}
+
 template <>
 string TC_Common::tostr<bool>(const bool &t)
 {
@@ -51,49 +180,43 @@ string TC_Common::tostr<unsigned char>(const unsigned char &t)
 template <>
 string TC_Common::tostr<short>(const short &t)
 {
-    char buf[16];
-    snprintf(buf, 16, "%d", t);
-    return string(buf);
+    char buf[32];
+    return string(buf, tochars(buf, t) - buf);
 }
 
 template <>
 string TC_Common::tostr<unsigned short>(const unsigned short &t)
 {
-    char buf[16];
-    snprintf(buf, 16, "%u", t);
-    return string(buf);
+    char buf[32];
+    return string(buf, tochars(buf, t) - buf);
 }
 
 template <>
 string TC_Common::tostr<int>(const int &t)
 {
-    char buf[16];
-    snprintf(buf, 16, "%d", t);
-    return string(buf);
+    char buf[32];
+    return string(buf, tochars(buf, t) - buf);
 }
 
 template <>
 string TC_Common::tostr<unsigned int>(const unsigned int &t)
 {
-    char buf[16];
-    snprintf(buf, 16, "%u", t);
-    return string(buf);
+    char buf[32];
+    return string(buf, tochars(buf, t) - buf);
 }
 
 template <>
 string TC_Common::tostr<long>(const long &t)
 {
     char buf[32];
-    snprintf(buf, 32, "%ld", t);
-    return string(buf);
+    return string(buf, tochars(buf, t) - buf);
 }
 
 template <>
 string TC_Common::tostr<long long>(const long long &t)
 {
     char buf[32];
-    snprintf(buf, 32, "%lld", t);
-    return string(buf);
+    return string(buf, tochars(buf, t) - buf);
 }
 
 
@@ -101,8 +224,14 @@ template <>
 string TC_Common::tostr<unsigned long>(const unsigned long &t)
 {
     char buf[32];
-    snprintf(buf, 32, "%lu", t);
-    return string(buf);
+    return string(buf, tochars(buf, t) - buf);
+}
+
+template <>
+string TC_Common::tostr<unsigned long long>(const unsigned long long &t)
+{
+    char buf[32];
+    return string(buf, tochars(buf, t) - buf);
 }
 
 template <>
@@ -233,6 +362,38 @@ string TC_Common::trim(const string &sStr, const string &s, bool bChar)
     return trimright(trimleft(sStr, s, true), s, true);
 }
 
+TC_StringView TC_Common::trimView(const TC_StringView &sStr, const char *s)
+{
+    const char *b = sStr.data();
+    const char *e = b + sStr.length();
+
+    while(b < e && strchr(s, *b) != NULL && *b != '\0')
+    {
+        ++b;
+    }
+
+    while(e > b && strchr(s, *(e - 1)) != NULL && *(e - 1) != '\0')
+    {
+        --e;
+    }
+
+    return TC_StringView(b, e - b);
+}
+
+void TC_Common::trimInPlace(string &sStr, const char *s)
+{
+    TC_StringView v = trimView(sStr, s);
+
+    if(v.length() == sStr.length())
+    {
+        return;
+    }
+
+    size_t pos = v.data() - sStr.data();
+    sStr.erase(pos + v.length());
+    sStr.erase(0, pos);
+}
+
 string TC_Common::trimleft(const string &sStr, const string &s, bool bChar)
 {
     if(sStr.empty())
@@ -386,8 +547,34 @@ string TC_Common::tm2str(const struct tm &stTm, const string &sFormat)
 
 string TC_Common::tm2str(const time_t &t, const string &sFormat)
 {
+    //常用的格式不用localtime_r和strftime
+    int format = -1;
+    if (sFormat == "%Y%m%d%H%M%S")
+    {
+        format = TC_TimeProvider::TF_NUMBER;
+    }
+    else if (sFormat == "%Y-%m-%d %H:%M:%S")
+    {
+        format = TC_TimeProvider::TF_DATETIME;
+    }
+    else if (sFormat == "%Y%m%d")
+    {
+        format = TC_TimeProvider::TF_DATE;
+    }
+    else if (sFormat == "%Y%m%d%H%M")
+    {
+        format = TC_TimeProvider::TF_MINUTE;
+    }
+
+    if (format >= 0)
+    {
+        char buf[32];
+        size_t len = TC_TimeProvider::tm2str(t, format, buf);
+        return string(buf, len);
+    }
+
     struct tm tt;
-    localtime_r(&t, &tt);
+    TC_TimeProvider::localtime(t, tt);
 
     return tm2str(tt, sFormat);
 }
@@ -406,9 +593,9 @@ string TC_Common::now2GMTstr()
 
 string TC_Common::tm2GMTstr(const time_t &t)
 {
-    struct tm tt;
-    gmtime_r(&t, &tt);
-    return tm2str(tt, "%a, %d %b %Y %H:%M:%S GMT");
+    char buf[32];
+    size_t len = TC_TimeProvider::tm2str(t, TC_TimeProvider::TF_GMT, buf);
+    return string(buf, len);
 }
 
 string TC_Common::tm2GMTstr(const struct tm &stTm)
@@ -534,17 +721,91 @@ string TC_Common::replace(const string &sString, const string &sSrc, const strin
         return sString;
     }
 
-    string sBuf = sString;
+    string sBuf;
+    sBuf.reserve(sString.length());
 
-    string::size_type pos = 0;
+    replace(sString, sSrc, sDest, sBuf);
 
-    while( (pos = sBuf.find(sSrc, pos)) != string::npos)
+    return sBuf;
+}
+
+void TC_Common::replace(const TC_StringView &sString, const TC_StringView &sSrc, const TC_StringView &sDest, string &sOut)
+{
+    if(sSrc.empty())
     {
-        sBuf.replace(pos, sSrc.length(), sDest);
-        pos += sDest.length();
+        sOut.append(sString.data(), sString.length());
+        return;
     }
 
-    return sBuf;
+    const char *p   = sString.data();
+    const char *end = p + sString.length();
+
+    while((size_t)(end - p) >= sSrc.length())
+    {
+        const char *f = (const char*)memchr(p, sSrc[0], end - p - sSrc.length() + 1);
+        if(f == NULL)
+        {
+            break;
+        }
+
+        if(memcmp(f, sSrc.data(), sSrc.length()) == 0)
+        {
+            sOut.append(p, f - p);
+            sOut.append(sDest.data(), sDest.length());
+            p = f + sSrc.length();
+        }
+        else
+        {
+            sOut.append(p, f + 1 - p);
+            p = f + 1;
+        }
+    }
+
+    sOut.append(p, end - p);
+}
+
+size_t TC_Common::sepstr(const TC_StringView &sStr, const TC_StringView &sSep, TC_StringView *vt, size_t max, bool withEmpty)
+{
+    //分隔符的位图
+    unsigned char sep[32];
+    memset(sep, 0, sizeof(sep));
+    for(size_t i = 0; i < sSep.length(); ++i)
+    {
+        unsigned char c = sSep[i];
+        sep[c >> 3] |= (unsigned char)(1 << (c & 7));
+    }
+
+    size_t n = 0;
+
+    const char *b   = sStr.data();
+    const char *end = b + sStr.length();
+
+    while(true)
+    {
+        const char *e = b;
+        while(e < end && !(sep[(unsigned char)*e >> 3] & (1 << ((unsigned char)*e & 7))))
+        {
+            ++e;
+        }
+
+        if(withEmpty || e != b)
+        {
+            if(n < max)
+            {
+                vt[n] = TC_StringView(b, e - b);
+            }
+            ++n;
+        }
+
+        if(e == end)
+        {
+            break;
+        }
+
+        b = e + 1;
+    }
+
+    return n;
 }
 
 string TC_Common::replace(const string &sString, const map<string,string>& mSrcDest)
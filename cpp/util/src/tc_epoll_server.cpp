@@ -17,6 +17,7 @@
 #include "util/tc_epoll_server.h"
 #include "util/tc_clientsocket.h"
 #include "util/tc_common.h"
+#include "util/tc_eventfd.h"
 #include <iostream>
 #include <limits>
 #include <cassert>
@@ -42,11 +43,17 @@ TC_EpollServer::Handle::Handle()
 : _pEpollServer(NULL)
 , _handleGroup(NULL)
 , _iWaitTime(100)
+, _index(0)
+, _bWaiting(false)
 {
 }
 
 TC_EpollServer::Handle::~Handle()
 {
+    for (deque<tagRecvData*>::iterator it = _localQueue.begin(); it != _localQueue.end(); ++it)
+    {
+        delete *it;
+    }
 }
 
 void TC_EpollServer::Handle::handleClose(const tagRecvData &stRecvData)
@@ -58,6 +65,11 @@ void TC_EpollServer::Handle::sendResponse(uint32_t uid, const string &sSendBuffe
     _pEpollServer->send(uid, sSendBuffer, ip, port, fd);
 }
 
+void TC_EpollServer::Handle::sendResponse(uint32_t uid, const TC_SharedSlice &slice, const string &ip, int port, int fd)
+{
+    _pEpollServer->send(uid, slice, ip, port, fd);
+}
+
 void TC_EpollServer::Handle::close(uint32_t uid, int fd)
 {
     _pEpollServer->close(uid, fd);
@@ -125,6 +137,9 @@ void TC_EpollServer::Handle::setHandleGroup(TC_EpollServer::HandleGroupPtr& pHan
     TC_ThreadLock::Lock lock(*this);
 
     _handleGroup = pHandleGroup;
+
+    //设置完才放入组中
+    _index = pHandleGroup->handles.size();
 }
 
 TC_EpollServer::HandleGroupPtr& TC_EpollServer::Handle::getHandleGroup()
@@ -134,6 +149,21 @@ TC_EpollServer::HandleGroupPtr& TC_EpollServer::Handle::getHandleGroup()
 
 void TC_EpollServer::Handle::notifyFilter()
 {
+    if (_handleGroup->schedule != HANDLE_SCHED_QUEUE)
+    {
+        TC_ThreadLock::Lock lock(_localMonitor);
+
+        if (_bWaiting)
+        {
+            _bWaiting = false;
+            _handleGroup->idle.dec();
+        }
+
+        _localMonitor.notify();
+
+        return;
+    }
+
     TC_ThreadLock::Lock lock(_handleGroup->monitor);
 
     //如何做到不唤醒所有handle呢？
@@ -147,12 +177,169 @@ void TC_EpollServer::Handle::setWaitTime(uint32_t iWaitTime)
     _iWaitTime = iWaitTime;
 }
 
+void TC_EpollServer::Handle::pushRecvData(const recv_queue_type &vtRecvData, bool bPushBack)
+{
+    {
+        TC_ThreadLock::Lock lock(_localMonitor);
+
+        if (bPushBack)
+        {
+            _localQueue.insert(_localQueue.end(), vtRecvData.begin(), vtRecvData.end());
+        }
+        else
+        {
+            _localQueue.insert(_localQueue.begin(), vtRecvData.begin(), vtRecvData.end());
+        }
+
+        if (_bWaiting)
+        {
+            _bWaiting = false;
+            _handleGroup->idle.dec();
+
+            _localMonitor.notify();
+
+            return;
+        }
+    }
+
+    //本handle在忙, 唤醒一个等待中的handle来偷取.
+    //队列长度在放入前已经原子地加上, 等待方先登记idle再检查队列长度(见waitForRecvData),
+    //所以这里看不到idle时, 等待方一定能看到队列长度, 不会睡下去
+    if (_handleGroup->idle.get() <= 0)
+    {
+        return;
+    }
+
+    vector<HandlePtr> &handles = _handleGroup->handles;
+
+    for (size_t i = 1; i < handles.size(); ++i)
+    {
+        Handle *handle = handles[(_index + i) % handles.size()].get();
+
+        TC_ThreadLock::Lock lock(handle->_localMonitor);
+
+        if (handle->_bWaiting)
+        {
+            handle->_bWaiting = false;
+            _handleGroup->idle.dec();
+
+            handle->_localMonitor.notify();
+
+            break;
+        }
+    }
+}
+
+bool TC_EpollServer::Handle::popRecvData(tagRecvData* &recv)
+{
+    recv = NULL;
+
+    {
+        TC_ThreadLock::Lock lock(_localMonitor);
+
+        if (!_localQueue.empty())
+        {
+            recv = _localQueue.front();
+            _localQueue.pop_front();
+        }
+    }
+
+    //从其他handle的队列尾部偷取
+    vector<HandlePtr> &handles = _handleGroup->handles;
+
+    for (size_t i = 1; recv == NULL && i < handles.size(); ++i)
+    {
+        Handle *handle = handles[(_index + i) % handles.size()].get();
+
+        TC_ThreadLock::Lock lock(handle->_localMonitor);
+
+        if (!handle->_localQueue.empty())
+        {
+            recv = handle->_localQueue.back();
+            handle->_localQueue.pop_back();
+        }
+    }
+
+    if (recv == NULL)
+    {
+        return false;
+    }
+
+    recv->adapter->_iHandleQueueSize.dec();
+
+    return true;
+}
+
+void TC_EpollServer::Handle::waitForRecvData(uint32_t iWaitTime)
+{
+    TC_ThreadLock::Lock lock(_localMonitor);
+
+    //先登记为等待再检查队列, 和pushRecvData中先加队列长度再看idle配对,
+    //避免检查完队列、登记之前放入的数据没人唤醒
+    _bWaiting = true;
+    _handleGroup->idle.inc();
+
+    if (allAdapterIsEmpty() && allFilterIsEmpty())
+    {
+        _localMonitor.timedWait(iWaitTime);
+    }
+
+    //超时醒来或者不用等, 唤醒的一方已经清除了等待状态
+    if (_bWaiting)
+    {
+        _bWaiting = false;
+        _handleGroup->idle.dec();
+    }
+}
+
+void TC_EpollServer::Handle::processRecvData(tagRecvData *recv)
+{
+    //上报心跳
+    heartbeat();
+
+    //为了实现所有主逻辑的单线程化,在每次循环中给业务处理自有消息的机会
+    handleAsyncResponse();
+
+    tagRecvData& stRecvData = *recv;
+
+    int64_t now = TNOWMS;
+
+    //数据已超载 overload
+    if (stRecvData.isOverload)
+    {
+        handleOverload(stRecvData);
+    }
+    //关闭连接的通知消息
+    else if (stRecvData.isClosed)
+    {
+        handleClose(stRecvData);
+    }
+    //数据在队列中已经超时了
+    else if ( (now - stRecvData.recvTimeStamp) > (int64_t)stRecvData.adapter->getQueueTimeout())
+    {
+        handleTimeout(stRecvData);
+    }
+    else
+    {
+        handle(stRecvData);
+    }
+
+    handleCustomMessage(false);
+}
+
 void TC_EpollServer::Handle::handleImp()
 {
     startHandle();
 
+    const bool bLocalQueue = (_handleGroup->schedule != HANDLE_SCHED_QUEUE);
+
     while (!getEpollServer()->isTerminate())
     {
+        if (bLocalQueue)
+        {
+            waitForRecvData(_iWaitTime);
+        }
+        else
         {
             TC_ThreadLock::Lock lock(_handleGroup->monitor);
 
@@ -181,41 +368,14 @@ void TC_EpollServer::Handle::handleImp()
             try
             {
 
-                while (adapter->waitForRecvQueue(recv, 0))
+                while (bLocalQueue ? popRecvData(recv) : adapter->waitForRecvQueue(recv, 0))
                 {
-                    //上报心跳
-                    heartbeat();
-
-                    //为了实现所有主逻辑的单线程化,在每次循环中给业务处理自有消息的机会
-                    handleAsyncResponse();
-
-                    tagRecvData& stRecvData = *recv;
-
-                    int64_t now = TNOWMS;
-
-
-                    stRecvData.adapter = adapter;
-
-                    //数据已超载 overload
-                    if (stRecvData.isOverload)
-                    {
-                        handleOverload(stRecvData);
-                    }
-                    //关闭连接的通知消息
-                    else if (stRecvData.isClosed)
+                    if (!bLocalQueue)
                     {
-                        handleClose(stRecvData);
+                        recv->adapter = adapter;
                     }
-                    //数据在队列中已经超时了
-                    else if ( (now - stRecvData.recvTimeStamp) > (int64_t)adapter->getQueueTimeout())
-                    {
-                        handleTimeout(stRecvData);
-                    }
-                    else
-                    {
-                        handle(stRecvData);
-                    }
-                     handleCustomMessage(false);
+
+                    processRecvData(recv);
 
                     delete recv;
                     recv = NULL;
@@ -243,6 +403,12 @@ void TC_EpollServer::Handle::handleImp()
 
                 getEpollServer()->error("[Handle::handleImp] unknown error");
             }
+
+            //非共用队列模式下请求都在handle自己的队列中, 不用按adapter取
+            if (bLocalQueue)
+            {
+                break;
+            }
         }
     }
 
@@ -257,6 +423,8 @@ TC_EpollServer::BindAdapter::BindAdapter(TC_EpollServer *pEpollServer)
 , _pEpollServer(pEpollServer)
 , _handleGroup(NULL)
 , _pf(echo_protocol)
+, _spf(echo_slice_protocol)
+, _bSliceProtocol(false)
 , _hf(echo_header_filter)
 , _name("")
 , _handleGroupName("")
@@ -270,6 +438,8 @@ TC_EpollServer::BindAdapter::BindAdapter(TC_EpollServer *pEpollServer)
 , _iHeartBeatTime(0)
 , _protocolName("tars")
 , _iBackPacketBuffLimit(0)
+, _bReusePort(false)
+, _iHandleSchedule(HANDLE_SCHED_QUEUE)
 {
 }
 
@@ -327,6 +497,33 @@ bool TC_EpollServer::BindAdapter::isIpAllow(const string& ip) const
 
 void TC_EpollServer::BindAdapter::insertRecvQueue(const recv_queue::queue_type &vtRecvData, bool bPushBack)
 {
+    if (_handleGroup->schedule != HANDLE_SCHED_QUEUE)
+    {
+        vector<HandlePtr> &handles = _handleGroup->handles;
+
+        //同一批都是一个连接的
+        size_t index;
+        if (_handleGroup->schedule == HANDLE_SCHED_AFFINITY)
+        {
+            index = vtRecvData.front()->uid % handles.size();
+        }
+        else
+        {
+            index = (uint32_t)_handleGroup->next.inc() % handles.size();
+        }
+
+        for (recv_queue::queue_type::const_iterator it = vtRecvData.begin(); it != vtRecvData.end(); ++it)
+        {
+            (*it)->adapter = this;
+        }
+
+        _iHandleQueueSize.add(vtRecvData.size());
+
+        handles[index]->pushRecvData(vtRecvData, bPushBack);
+
+        return;
+    }
+
     {
         if (bPushBack)
         {
@@ -359,6 +556,11 @@ bool TC_EpollServer::BindAdapter::waitForRecvQueue(tagRecvData* &recv, uint32_t
 
 size_t TC_EpollServer::BindAdapter::getRecvBufferSize()
 {
+    if (_handleGroup && _handleGroup->schedule != HANDLE_SCHED_QUEUE)
+    {
+        return _iHandleQueueSize.get();
+    }
+
     return _rbuffer.size();
 }
 
@@ -376,6 +578,15 @@ int TC_EpollServer::BindAdapter::echo_protocol(string &r, string &o)
     return 1;
 }
 
+int TC_EpollServer::BindAdapter::echo_slice_protocol(const char *data, size_t len, size_t &pos, size_t &end)
+{
+    pos = 0;
+
+    end = len;
+
+    return 1;
+}
+
 int TC_EpollServer::BindAdapter::echo_header_filter(int i, string &o)
 {
     return 1;
@@ -427,7 +638,7 @@ void TC_EpollServer::BindAdapter::setQueueCapacity(int n)
 
 int TC_EpollServer::BindAdapter::isOverloadorDiscard()
 {
-    int iRecvBufferSize = _rbuffer.size();
+    int iRecvBufferSize = getRecvBufferSize();
 
     if(iRecvBufferSize <= (_iQueueCapacity / 2))//未过载
     {
@@ -568,6 +779,8 @@ void TC_EpollServer::BindAdapter::setProtocol(const TC_EpollServer::protocol_fun
 {
     _pf = pf;
 
+    _bSliceProtocol = false;
+
     _hf = hf;
 
     _iHeaderLen = iHeaderLen;
@@ -578,6 +791,27 @@ TC_EpollServer::protocol_functor& TC_EpollServer::BindAdapter::getProtocol()
     return _pf;
 }
 
+void TC_EpollServer::BindAdapter::setSliceProtocol(const TC_EpollServer::slice_protocol_functor &spf, int iHeaderLen, const TC_EpollServer::header_filter_functor &hf)
+{
+    _spf = spf;
+
+    _bSliceProtocol = true;
+
+    _hf = hf;
+
+    _iHeaderLen = iHeaderLen;
+}
+
+TC_EpollServer::slice_protocol_functor& TC_EpollServer::BindAdapter::getSliceProtocol()
+{
+    return _spf;
+}
+
+bool TC_EpollServer::BindAdapter::isSliceProtocol() const
+{
+    return _bSliceProtocol;
+}
+
 TC_EpollServer::header_filter_functor& TC_EpollServer::BindAdapter::getHeaderFilterFunctor()
 {
     return _hf;
@@ -598,6 +832,26 @@ size_t TC_EpollServer::BindAdapter::getBackPacketBuffLimit()
     return _iBackPacketBuffLimit;
 }
 
+void TC_EpollServer::BindAdapter::setReusePort(bool bReusePort)
+{
+    _bReusePort = bReusePort;
+}
+
+bool TC_EpollServer::BindAdapter::isReusePort() const
+{
+    return _bReusePort;
+}
+
+void TC_EpollServer::BindAdapter::setHandleSchedule(int iSchedule)
+{
+    _iHandleSchedule = iSchedule;
+}
+
+int TC_EpollServer::BindAdapter::getHandleSchedule() const
+{
+    return _iHandleSchedule;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // 服务连接
 TC_EpollServer::NetThread::Connection::Connection(TC_EpollServer::BindAdapter *pBindAdapter, int lfd, int timeout, int fd, const string& ip, uint16_t port)
@@ -612,7 +866,6 @@ TC_EpollServer::NetThread::Connection::Connection(TC_EpollServer::BindAdapter *p
 , _iMaxTemQueueSize(100)
 , _enType(EM_TCP)
 , _bEmptyConn(true)
-, _pRecvBuffer(NULL)
 , _nRecvBufferSize(DEFAULT_RECV_BUFFERSIZE)
 , _authInit(false)
 #if TARS_SSL
@@ -638,7 +891,6 @@ TC_EpollServer::NetThread::Connection::Connection(BindAdapter *pBindAdapter, int
 , _iMaxTemQueueSize(100)
 , _enType(EM_TCP)
 ,_bEmptyConn(false) /*udp is always false*/
-,_pRecvBuffer(NULL)
 ,_nRecvBufferSize(DEFAULT_RECV_BUFFERSIZE)
 ,_authInit(false)
 #if TARS_SSL
@@ -662,7 +914,6 @@ TC_EpollServer::NetThread::Connection::Connection(BindAdapter *pBindAdapter)
 , _iMaxTemQueueSize(100)
 , _enType(EM_TCP)
 ,_bEmptyConn(false) /*udp is always false*/
-,_pRecvBuffer(NULL)
 ,_nRecvBufferSize(DEFAULT_RECV_BUFFERSIZE)
 ,_authInit(false)
 #if TARS_SSL
@@ -674,13 +925,12 @@ TC_EpollServer::NetThread::Connection::Connection(BindAdapter *pBindAdapter)
 }
 TC_EpollServer::NetThread::Connection::~Connection()
 {
-    if(_pRecvBuffer)
+    clearSlices(_sendbuffer);
+
+    for(size_t i = 0; i < _pendingSend.size(); i++)
     {
-        delete _pRecvBuffer;
-        _pRecvBuffer = NULL;
+        delete _pendingSend[i];
     }
-    
-    clearSlices(_sendbuffer);
 
     if(_lfd != -1)
     {
@@ -759,102 +1009,202 @@ void TC_EpollServer::NetThread::Connection::insertRecvQueue(recv_queue::queue_ty
     }
 }
 
-int TC_EpollServer::NetThread::Connection::parseProtocol(recv_queue::queue_type &o)
+void TC_EpollServer::NetThread::Connection::pushRecvData(tagRecvData *recv, recv_queue::queue_type &o)
 {
-    try
+    recv->ip               = _ip;
+    recv->port             = _port;
+    recv->recvTimeUs       = TNOWUS;
+    recv->recvTimeStamp    = recv->recvTimeUs / 1000;
+    recv->uid              = getId();
+    recv->isOverload       = false;
+    recv->isClosed         = false;
+    recv->fd               = getfd();
+
+    //收到完整的包才算
+    this->_bEmptyConn = false;
+
+    //收到完整包
+    o.push_back(recv);
+
+    if((int) o.size() > _iMaxTemQueueSize)
+    {
+        insertRecvQueue(o);
+        o.clear();
+    }
+}
+
+int TC_EpollServer::NetThread::Connection::parseSliceProtocol(TC_SharedBuffer &rbuf, recv_queue::queue_type &o)
+{
+    //先找出所有完整的包, 再把它们一次取出, 避免小包引用住整个接收内存块
+    vector<pair<size_t, size_t> > packets;
+
+    size_t total = 0;
+
+    int ret = 0;
+
+    while (total < rbuf.ReadableSize())
     {
-        while (true)
+        size_t pos = 0;
+        size_t end = 0;
+
+        const size_t left = rbuf.ReadableSize() - total;
+
+        int b = _pBindAdapter->getSliceProtocol()(rbuf.ReadAddr() + total, left, pos, end);
+
+        if(b == TC_EpollServer::PACKET_LESS)
         {
-            //需要过滤首包包头
-            if(_iHeaderLen > 0)
-            {
-                if(_recvbuffer.length() >= (unsigned) _iHeaderLen)
-                {
-                    string header = _recvbuffer.substr(0, _iHeaderLen);
-                    _pBindAdapter->getHeaderFilterFunctor()((int)(TC_EpollServer::PACKET_FULL), header);
-                    _recvbuffer = _recvbuffer.substr(_iHeaderLen);
-                    _iHeaderLen = 0;
-                }
-                else
-                {
-                    _pBindAdapter->getHeaderFilterFunctor()((int)(TC_EpollServer::PACKET_LESS), _recvbuffer);
-                    _iHeaderLen -= _recvbuffer.length();
-                    _recvbuffer = "";
-                    break;
-                }
-            }
+            //包不完全
+            break;
+        }
+        else if(b == TC_EpollServer::PACKET_FULL && pos <= end && end > 0 && end <= left)
+        {
+            packets.push_back(make_pair(total + pos, end - pos));
 
-            std::string* rbuf = &_recvbuffer;
-#if TARS_SSL
-            // ssl connection
-            if (_pBindAdapter->getEndpoint().isSSL())
-            {
-                std::string out;
-                if (!_openssl->Read(_recvbuffer.data(), _recvbuffer.size(), out))
-                {
-                    _pBindAdapter->getEpollServer()->error("[TARS][SSL_read failed");
-                    return -1;
-                }
-                else
-                {
-                    if (!out.empty())
-                        this->send(out, "", 0);
+            total += end;
+        }
+        else
+        {
+            _pBindAdapter->getEpollServer()->error("recv [" + _ip + ":" + TC_Common::tostr(_port) + "],packet error.");
+            ret = -1;                       //协议解析错误
+            break;
+        }
+    }
 
-                    rbuf = _openssl->RecvBuffer();
-                }
+    TC_SharedSlice data = rbuf.Take(total);
 
-                _recvbuffer.clear();
-            }
-#endif
+    for (size_t i = 0; i < packets.size(); ++i)
+    {
+        TC_SharedSlice slice(data.block, data.data + packets[i].first, packets[i].second);
+
+        //鉴权成功(AUTH_SUCC == 0)后鉴权函数不再处理数据, 不必为它拷贝一份
+        if (_pBindAdapter->_authWrapper && !(_authInit && _authState == 0) &&
+            _pBindAdapter->_authWrapper(this, string(slice.data, slice.len)))
+            continue;
+
+        tagRecvData* recv = new tagRecvData();
+        recv->slice = slice;
+
+        pushRecvData(recv, o);
+    }
+
+    return ret < 0 ? ret : (int)o.size();
+}
+
+int TC_EpollServer::NetThread::Connection::parseStringProtocol(TC_SharedBuffer &rbuf, recv_queue::queue_type &o)
+{
+    //string协议解析器要求数据在string中, 只追加新收到的数据, 未解析完的数据留在_strbuffer
+    if (!rbuf.IsEmpty())
+    {
+        _strbuffer.append(rbuf.ReadAddr(), rbuf.ReadableSize());
+        rbuf.Clear();
+    }
+
+    if (_strbuffer.empty())
+    {
+        return o.size();
+    }
+
+    int ret = 0;
+
+    while (true)
+    {
+        string ro;
 
-            string ro;
+        int b = _pBindAdapter->getProtocol()(_strbuffer, ro);
 
-            int b = _pBindAdapter->getProtocol()(*rbuf, ro);
+        if(b == TC_EpollServer::PACKET_LESS)
+        {
+            //包不完全
+            break;
+        }
+        else if(b == TC_EpollServer::PACKET_FULL)
+        {
+            if (_pBindAdapter->_authWrapper &&
+                _pBindAdapter->_authWrapper(this, ro))
+                continue;
+
+            tagRecvData* recv = new tagRecvData();
+            recv->buffer.swap(ro);
+
+            pushRecvData(recv, o);
 
-            if(b == TC_EpollServer::PACKET_LESS)
+            if(_strbuffer.empty())
             {
-                //包不完全
                 break;
             }
-            else if(b == TC_EpollServer::PACKET_FULL)
+        }
+        else
+        {
+            _pBindAdapter->getEpollServer()->error("recv [" + _ip + ":" + TC_Common::tostr(_port) + "],packet error.");
+            ret = -1;                       //协议解析错误
+            break;
+        }
+    }
+
+    return ret < 0 ? ret : (int)o.size();
+}
+
+int TC_EpollServer::NetThread::Connection::parseProtocol(recv_queue::queue_type &o)
+{
+    try
+    {
+        //需要过滤首包包头
+        if(_iHeaderLen > 0)
+        {
+            if(_recvbuffer.ReadableSize() >= (size_t) _iHeaderLen)
             {
-                if (_pBindAdapter->_authWrapper &&
-                    _pBindAdapter->_authWrapper(this, ro))
-                    continue;
-
-                tagRecvData* recv = new tagRecvData();
-                recv->buffer           = ro;
-                recv->ip               = _ip;
-                recv->port             = _port;
-                recv->recvTimeStamp    = TNOWMS;
-                recv->uid              = getId();
-                recv->isOverload       = false;
-                recv->isClosed         = false;
-                recv->fd               = getfd();
-
-                //收到完整的包才算
-                this->_bEmptyConn = false;
-
-                //收到完整包
-                o.push_back(recv);
-
-                if((int) o.size() > _iMaxTemQueueSize)
+                string header(_recvbuffer.ReadAddr(), _iHeaderLen);
+                _pBindAdapter->getHeaderFilterFunctor()((int)(TC_EpollServer::PACKET_FULL), header);
+                _recvbuffer.Consume(_iHeaderLen);
+                _iHeaderLen = 0;
+            }
+            else
+            {
+                string header;
+                if (!_recvbuffer.IsEmpty())
                 {
-                    insertRecvQueue(o);
-                    o.clear();
+                    header.assign(_recvbuffer.ReadAddr(), _recvbuffer.ReadableSize());
                 }
+                _pBindAdapter->getHeaderFilterFunctor()((int)(TC_EpollServer::PACKET_LESS), header);
+                _iHeaderLen -= header.length();
+                _recvbuffer.Clear();
+                return o.size();
+            }
+        }
 
-                if(rbuf->empty())
-                {
-                    break;
-                }
+        TC_SharedBuffer* rbuf = &_recvbuffer;
+#if TARS_SSL
+        // ssl connection
+        if (_pBindAdapter->getEndpoint().isSSL())
+        {
+            std::string out;
+            if (!_openssl->Read(_recvbuffer.ReadAddr(), _recvbuffer.ReadableSize(), out))
+            {
+                _pBindAdapter->getEpollServer()->error("[TARS][SSL_read failed");
+                return -1;
             }
             else
             {
-                _pBindAdapter->getEpollServer()->error("recv [" + _ip + ":" + TC_Common::tostr(_port) + "],packet error.");
-                return -1;                      //协议解析错误
+                if (!out.empty())
+                    this->send(out, "", 0);
+
+                std::string* plain = _openssl->RecvBuffer();
+                _sslbuffer.PushData(plain->data(), plain->length());
+                plain->clear();
+
+                rbuf = &_sslbuffer;
             }
+
+            _recvbuffer.Clear();
+        }
+#endif
+
+        if (_pBindAdapter->isSliceProtocol())
+        {
+            return parseSliceProtocol(*rbuf, o);
         }
+
+        return parseStringProtocol(*rbuf, o);
     }
     catch(exception &ex)
     {
@@ -876,23 +1226,20 @@ int TC_EpollServer::NetThread::Connection::recv(recv_queue::queue_type &o)
 
     while(true)
     {
-        char buffer[32 * 1024];
         int iBytesReceived = 0;
 
+        //直接收到接收缓冲区中, 解析出的包引用其中的数据, 不再拷贝
         if(_lfd == -1)
         {
-            if(_pRecvBuffer)
-            {
-                iBytesReceived = _sock.recvfrom((void*)_pRecvBuffer,_nRecvBufferSize, _ip, _port, 0);
-            }
-            else
-            {
-                iBytesReceived = _sock.recvfrom((void*)buffer,sizeof(buffer), _ip, _port, 0);
-            }
+            _recvbuffer.AssureSpace(_nRecvBufferSize);
+
+            iBytesReceived = _sock.recvfrom((void*)_recvbuffer.WriteAddr(), _nRecvBufferSize, _ip, _port, 0);
         }
         else
         {
-            iBytesReceived = ::read(_sock.getfd(), (void*)buffer, sizeof(buffer));
+            _recvbuffer.AssureSpace(32 * 1024);
+
+            iBytesReceived = ::read(_sock.getfd(), (void*)_recvbuffer.WriteAddr(), _recvbuffer.WritableSize());
         }
 
         if (iBytesReceived < 0)
@@ -917,21 +1264,9 @@ int TC_EpollServer::NetThread::Connection::recv(recv_queue::queue_type &o)
         }
 
         //保存接收到数据
-        if(_lfd == -1)
-        {
-            if(_pRecvBuffer)
-            {
-                _recvbuffer.append(_pRecvBuffer, iBytesReceived);
-            }
-            else
-            {
-                _recvbuffer.append(buffer, iBytesReceived);
-            }
-        }
-        else
-        {
-            _recvbuffer.append(buffer, iBytesReceived);
-        }
+        const bool bFull = ((size_t)iBytesReceived == _recvbuffer.WritableSize());
+
+        _recvbuffer.Produce(iBytesReceived);
 
         //UDP协议
         if(_lfd == -1)
@@ -945,29 +1280,43 @@ int TC_EpollServer::NetThread::Connection::recv(recv_queue::queue_type &o)
                  //udp ip无权限
                 _pBindAdapter->getEpollServer()->debug("accept [" + _ip + ":" + TC_Common::tostr(_port) + "] [" + TC_Common::tostr(_lfd) + "] not allowed");
             }
-            _recvbuffer = "";
+            _recvbuffer.Clear();
+            _strbuffer.clear();
         }
         else
         {
-            //接收到数据不超过buffer,没有数据了(如果有数据,内核会再通知你)
-            if((size_t)iBytesReceived < sizeof(buffer))
+            //接收到数据没有填满buffer,没有数据了(如果有数据,内核会再通知你)
+            if(!bFull)
             {
                 break;
             }
-            //字符串太长时substr性能会急剧下降
-            if(_recvbuffer.length() > 8192)
+
+            //先解析已收到的包, 腾出缓冲区
+            if(parseProtocol(o) < 0)
             {
-                parseProtocol(o);
+                return -1;
             }
         }
     }
 
+    int ret = o.size();
+
     if(_lfd != -1)
     {
-        return parseProtocol(o);
+        ret = parseProtocol(o);
     }
 
-    return o.size();
+    //空闲连接不占用接收缓冲区
+    _recvbuffer.Shrink();
+    if (_strbuffer.empty())
+    {
+        string().swap(_strbuffer);
+    }
+#if TARS_SSL
+    _sslbuffer.Shrink();
+#endif
+
+    return ret;
 }
 
 int TC_EpollServer::NetThread::Connection::send(const string& buffer, const string &ip, uint16_t port, bool byEpollOut)
@@ -998,21 +1347,9 @@ int TC_EpollServer::NetThread::Connection::send(const string& buffer, const stri
     }
     else
     {
-        const size_t kChunkSize = 8 * 1024 * 1024;
         if (!_sendbuffer.empty()) 
         { 
-            TC_BufferPool* pool = _pBindAdapter->getEpollServer()->getNetThreadOfFd(_sock.getfd())->_bufferPool;
-            // avoid too big chunk
-            for (size_t chunk = 0; chunk * kChunkSize < buffer.size(); chunk ++)
-            {
-                size_t needs = std::min<size_t>(kChunkSize, buffer.size() - chunk * kChunkSize);
-
-                TC_Slice slice = pool->Allocate(needs);
-                ::memcpy(slice.data, buffer.data() + chunk * kChunkSize, needs);
-                slice.dataLen = needs;
-
-                _sendbuffer.push_back(slice);
-            }
+            appendSendBuffer(buffer.data(), buffer.size());
         } 
         else 
         { 
@@ -1024,29 +1361,102 @@ int TC_EpollServer::NetThread::Connection::send(const string& buffer, const stri
             } 
             else if (bytes < static_cast<int>(buffer.size())) 
             { 
-                const char* remainData = &buffer[bytes];
                 const size_t remainLen = buffer.size() - static_cast<size_t>(bytes);
-            
-                TC_BufferPool* pool = _pBindAdapter->getEpollServer()->getNetThreadOfFd(_sock.getfd())->_bufferPool;
-                // avoid too big chunk
-                for (size_t chunk = 0; chunk * kChunkSize < remainLen; chunk ++)
-                {
-                    size_t needs = std::min<size_t>(kChunkSize, remainLen - chunk * kChunkSize);
 
-                    TC_Slice slice = pool->Allocate(needs);
-                    ::memcpy(slice.data, remainData + chunk * kChunkSize, needs);
-                    slice.dataLen = needs;
+                appendSendBuffer(&buffer[bytes], remainLen);
+
+                _pBindAdapter->getEpollServer()->info("EAGAIN[" + _ip + ":" + TC_Common::tostr(_port) +
+                        ", to sent bytes " + TC_Common::tostr(remainLen) +
+                        ", total sent " + TC_Common::tostr(buffer.size()));
+            } 
+        } 
+    }
+
+    return checkSendBuffer();
+}
+
+int TC_EpollServer::NetThread::Connection::send(const std::vector<tagSendData*>& vSend)
+{
+    if (!_sendbuffer.empty())
+    {
+        //前面的还没发完, 直接排在后面, 等EPOLLOUT
+        for (size_t i = 0; i < vSend.size(); ++ i)
+        {
+            appendSendBuffer(vSend[i]->data(), vSend[i]->length());
+        }
+
+        return checkSendBuffer();
+    }
+
+    std::vector<iovec> vecs;
+    vecs.reserve(vSend.size());
+
+    size_t total = 0;
+    for (size_t i = 0; i < vSend.size(); ++ i)
+    {
+        if (vSend[i]->length() == 0)
+            continue;
+
+        iovec ivc;
+        ivc.iov_base = const_cast<char*>(vSend[i]->data());
+        ivc.iov_len = vSend[i]->length();
+        total += ivc.iov_len;
+
+        vecs.push_back(ivc);
+    }
+
+    int bytes = sendv(vecs);
+    if (bytes == -1)
+    {
+        _pBindAdapter->getEpollServer()->debug("send [" + _ip + ":" + TC_Common::tostr(_port) + "] close connection by peer.");
+        return -1;
+    }
+
+    if (bytes < static_cast<int>(total))
+    {
+        //没发完的部分放入发送buffer
+        size_t skip = static_cast<size_t>(bytes);
+        for (size_t i = 0; i < vSend.size(); ++ i)
+        {
+            size_t len = vSend[i]->length();
+            if (skip >= len)
+            {
+                skip -= len;
+                continue;
+            }
+
+            appendSendBuffer(vSend[i]->data() + skip, len - skip);
+            skip = 0;
+        }
 
-                    _sendbuffer.push_back(slice);
-                }
-                // end
-                _pBindAdapter->getEpollServer()->info("EAGAIN[" + _ip + ":" + TC_Common::tostr(_port) +
-                        ", to sent bytes " + TC_Common::tostr(remainLen) +
-                        ", total sent " + TC_Common::tostr(buffer.size()));
-            } 
-        } 
+        _pBindAdapter->getEpollServer()->info("EAGAIN[" + _ip + ":" + TC_Common::tostr(_port) +
+                ", to sent bytes " + TC_Common::tostr(total - bytes) +
+                ", total sent " + TC_Common::tostr(total));
+    }
+
+    return checkSendBuffer();
+}
+
+void TC_EpollServer::NetThread::Connection::appendSendBuffer(const char* data, size_t len)
+{
+    const size_t kChunkSize = 8 * 1024 * 1024;
+
+    TC_BufferPool* pool = _pBindAdapter->getEpollServer()->getNetThreadOfConn(_uid, _sock.getfd())->_bufferPool;
+    // avoid too big chunk
+    for (size_t chunk = 0; chunk * kChunkSize < len; chunk ++)
+    {
+        size_t needs = std::min<size_t>(kChunkSize, len - chunk * kChunkSize);
+
+        TC_Slice slice = pool->Allocate(needs);
+        ::memcpy(slice.data, data + chunk * kChunkSize, needs);
+        slice.dataLen = needs;
+
+        _sendbuffer.push_back(slice);
     }
+}
 
+int TC_EpollServer::NetThread::Connection::checkSendBuffer()
+{
     size_t toSendBytes = 0;
     for (std::vector<TC_Slice>::const_iterator it(_sendbuffer.begin()); it != _sendbuffer.end(); ++ it)
     {
@@ -1085,28 +1495,46 @@ int TC_EpollServer::NetThread::Connection::send()
 }
 
 int TC_EpollServer::NetThread::Connection::send(const std::vector<TC_Slice>& slices)
+{
+    // convert to iovec array
+    std::vector<iovec> vecs;
+    vecs.reserve(slices.size());
+
+    for (size_t i = 0; i < slices.size(); ++ i)
+    {
+        assert (slices[i].dataLen > 0);
+
+        iovec ivc;
+        ivc.iov_base = slices[i].data;
+        ivc.iov_len = slices[i].dataLen;
+
+        vecs.push_back(ivc);
+    }
+
+    return sendv(vecs);
+}
+
+int TC_EpollServer::NetThread::Connection::sendv(const std::vector<iovec>& buffers)
 {
     const int kIOVecCount = std::max<int>(sysconf(_SC_IOV_MAX), 16); // be care of IOV_MAX
 
+    if (static_cast<int>(buffers.size()) <= kIOVecCount)
+    {
+        //绝大多数情况一次writev
+        return buffers.empty() ? 0 : tcpWriteV(buffers);
+    }
+
     size_t alreadySentVecs = 0;
     size_t alreadySentBytes = 0;
-    while (alreadySentVecs < slices.size())
+    while (alreadySentVecs < buffers.size())
     {
-        const size_t vc = std::min<int>(slices.size() - alreadySentVecs, kIOVecCount);
+        const size_t vc = std::min<int>(buffers.size() - alreadySentVecs, kIOVecCount);
 
-        // convert to iovec array
-        std::vector<iovec> vecs;
+        std::vector<iovec> vecs(buffers.begin() + alreadySentVecs, buffers.begin() + alreadySentVecs + vc);
         size_t expectSent = 0;
-        for (size_t i = alreadySentVecs; i < alreadySentVecs + vc; ++ i)
+        for (size_t i = 0; i < vc; ++ i)
         {
-            assert (slices[i].dataLen > 0);
-
-            iovec ivc;
-            ivc.iov_base = slices[i].data;
-            ivc.iov_len = slices[i].dataLen;
-            expectSent += slices[i].dataLen;
-
-            vecs.push_back(ivc);
+            expectSent += vecs[i].iov_len;
         }
 
         int bytes = tcpWriteV(vecs);
@@ -1203,7 +1631,7 @@ void TC_EpollServer::NetThread::Connection::adjustSlices(std::vector<TC_Slice>&
     }
 
     // free to pool
-    TC_BufferPool* pool = _pBindAdapter->getEpollServer()->getNetThreadOfFd(_sock.getfd())->_bufferPool;
+    TC_BufferPool* pool = _pBindAdapter->getEpollServer()->getNetThreadOfConn(_uid, _sock.getfd())->_bufferPool;
     assert (pool);
     for (size_t i = 0; i < skippedVecs; ++ i)
     {
@@ -1215,16 +1643,10 @@ void TC_EpollServer::NetThread::Connection::adjustSlices(std::vector<TC_Slice>&
 
 bool TC_EpollServer::NetThread::Connection::setRecvBuffer(size_t nSize)
 {
-    //only udp type needs to malloc
-    if(_lfd == -1 && !_pRecvBuffer)
+    //only udp type needs to set
+    if(_lfd == -1)
     {
         _nRecvBufferSize = nSize;
-
-        _pRecvBuffer = new char[_nRecvBufferSize];
-        if(!_pRecvBuffer)
-        {
-            throw TC_Exception("adapter '" + _pBindAdapter->getName() + "' malloc udp receive buffer fail");
-        }
     }
     return true;
 }
@@ -1262,6 +1684,8 @@ void TC_EpollServer::NetThread::ConnectionList::init(uint32_t size, uint32_t iIn
 
     _iConnectionMagic   = ((((uint32_t)_lastTimeoutTime) << 26) & (0xFFFFFFFF << 26)) + ((iIndex << 22) & (0xFFFFFFFF << 22));//((uint32_t)_lastTimeoutTime) << 20;
 
+    _wheel.init(_total, _lastTimeoutTime);
+
     //free从1开始分配, 这个值为uid, 0保留为管道用, epollwait根据0判断是否是管道消息
     for(uint32_t i = 1; i <= _total; i++)
     {
@@ -1308,28 +1732,48 @@ void TC_EpollServer::NetThread::ConnectionList::add(Connection *cPtr, time_t iTi
 
     assert(magi == _iConnectionMagic && uid > 0 && uid <= _total && !_vConn[uid].first);
 
-    _vConn[uid] = make_pair(cPtr, _tl.insert(make_pair(iTimeOutStamp, uid)));
+    _vConn[uid] = make_pair(cPtr, iTimeOutStamp);
+
+    //udp的监听端口, 不做超时处理
+    if(cPtr->getListenfd() != -1)
+    {
+        _wheel.add(uid, getCheckTime(uid));
+    }
 }
 
 void TC_EpollServer::NetThread::ConnectionList::refresh(uint32_t uid, time_t iTimeOutStamp)
 {
-    TC_ThreadLock::Lock lock(*this);
-
+    //只在本网络线程中修改自己连接的超时时间点, 不需要加锁,
+    //时间轮中的定时项到期时再按新的时间点重新挂入
     uint32_t magi = uid & (0xFFFFFFFF << 22);
     uid           = uid & (0x7FFFFFFF >> 9);
 
     assert(magi == _iConnectionMagic && uid > 0 && uid <= _total && _vConn[uid].first);
 
-    if(iTimeOutStamp - _vConn[uid].first->_iLastRefreshTime < 1)
-    {
-        return;
-    }
     _vConn[uid].first->_iLastRefreshTime = iTimeOutStamp;
 
-    //删除超时链表
-    _tl.erase(_vConn[uid].second);
+    _vConn[uid].second = iTimeOutStamp;
+}
+
+time_t TC_EpollServer::NetThread::ConnectionList::getCheckTime(uint32_t uid)
+{
+    Connection *cPtr = _vConn[uid].first;
+
+    time_t iTimeout = _vConn[uid].second;
+
+    //空连接需要提前检查
+    if(_pEpollServer->IsEmptyConnCheck() && cPtr->IsEmptyConn())
+    {
+        //获取空连接的超时时间点
+        time_t iEmptyTimeout = (iTimeout - cPtr->getTimeout()) + (_pEpollServer->getEmptyConnTimeout()/1000);
+
+        if(iEmptyTimeout < iTimeout)
+        {
+            return iEmptyTimeout;
+        }
+    }
 
-    _vConn[uid].second = _tl.insert(make_pair(iTimeOutStamp, uid));
+    return iTimeout;
 }
 
 void TC_EpollServer::NetThread::ConnectionList::checkTimeout(time_t iCurTime)
@@ -1344,70 +1788,29 @@ void TC_EpollServer::NetThread::ConnectionList::checkTimeout(time_t iCurTime)
 
     TC_ThreadLock::Lock lock(*this);
 
-    multimap<time_t, uint32_t>::iterator it = _tl.begin();
+    _expired.clear();
 
-    while(it != _tl.end())
-    {
-        //已经检查到当前时间点了, 后续不用在检查了
-        if(it->first > iCurTime)
-        {
-            break;
-        }
+    _wheel.expire(iCurTime, _expired);
 
-        uint32_t uid = it->second;
+    for(size_t i = 0; i < _expired.size(); ++i)
+    {
+        uint32_t uid = _expired[i];
 
-        ++it;
+        time_t iCheckTime = getCheckTime(uid);
 
-        //udp的监听端口, 不做处理
-        if(_vConn[uid].first->getListenfd() == -1)
+        //期间有数据收发, 超时时间点已经后移, 重新挂入
+        if(iCheckTime > iCurTime)
         {
+            _wheel.add(uid, iCheckTime);
             continue;
         }
 
-        //超时关闭
+        //超时关闭(包括空连接超时)
         _pEpollServer->delConnection(_vConn[uid].first, false,EM_SERVER_TIMEOUT_CLOSE);
 
         //从链表中删除
         _del(uid);
     }
-
-
-    if(_pEpollServer->IsEmptyConnCheck())
-    {
-        it = _tl.begin();
-        while(it != _tl.end())
-        {
-            uint32_t uid = it->second;
-
-            //遍历所有的空连接
-            if(_vConn[uid].first->IsEmptyConn())
-            {
-                //获取空连接的超时时间点
-                time_t iEmptyTimeout = (it->first - _vConn[uid].first->getTimeout()) + (_pEpollServer->getEmptyConnTimeout()/1000);
-
-                 //已经检查到当前时间点了, 后续不用在检查了
-                if(iEmptyTimeout > iCurTime)
-                {
-                    break;
-                }
-
-                //udp的监听端口, 不做处理
-                if(_vConn[uid].first->getListenfd() == -1)
-                {
-                    ++it;
-                    continue;
-                }
-
-                //超时关闭
-                _pEpollServer->delConnection(_vConn[uid].first, false,EM_SERVER_TIMEOUT_CLOSE);
-
-                //从链表中删除
-                _del(uid);
-            }
-
-            ++it;
-        }
-    }
 }
 
 vector<TC_EpollServer::ConnStatus> TC_EpollServer::NetThread::ConnectionList::getConnStatus(int lfd)
@@ -1452,7 +1855,7 @@ void TC_EpollServer::NetThread::ConnectionList::_del(uint32_t uid)
 {
     assert(uid > 0 && uid <= _total && _vConn[uid].first);
 
-    _tl.erase(_vConn[uid].second);
+    _wheel.del(uid);
 
     delete _vConn[uid].first;
 
@@ -1471,13 +1874,78 @@ size_t TC_EpollServer::NetThread::ConnectionList::size()
 }
 
 //////////////////////////////NetThread//////////////////////////////////
+/**
+ * 发送记录的缓存, 避免每个响应都new/delete:
+ * 业务线程先从本线程的缓存取, 取空了再从全局整批(SEND_DATA_BATCH个)拿;
+ * 网络线程用完的记录攒够一批, 整批还回全局
+ */
+enum
+{
+    SEND_DATA_BATCH     = 64,
+    SEND_DATA_MAX_BATCH = 1024,
+    SEND_DATA_MAX_CAP   = 64 * 1024
+};
+
+static TC_ThreadMutex                                   g_sendDataMutex;
+static vector<TC_EpollServer::tagSendData*>             g_sendDataBatch;
+static __thread TC_EpollServer::tagSendData             *t_sendDataCache = NULL;
+
+static TC_EpollServer::tagSendData *allocSendData()
+{
+    if (t_sendDataCache == NULL)
+    {
+        TC_LockT<TC_ThreadMutex> lock(g_sendDataMutex);
+
+        if (!g_sendDataBatch.empty())
+        {
+            t_sendDataCache = g_sendDataBatch.back();
+            g_sendDataBatch.pop_back();
+        }
+    }
+
+    if (t_sendDataCache == NULL)
+    {
+        return new TC_EpollServer::tagSendData();
+    }
+
+    TC_EpollServer::tagSendData *send = t_sendDataCache;
+
+    t_sendDataCache = send->next;
+
+    return send;
+}
+
+static void releaseSendData(TC_EpollServer::tagSendData *batch)
+{
+    {
+        TC_LockT<TC_ThreadMutex> lock(g_sendDataMutex);
+
+        if (g_sendDataBatch.size() < SEND_DATA_MAX_BATCH)
+        {
+            g_sendDataBatch.push_back(batch);
+            return;
+        }
+    }
+
+    //缓存够多了, 直接释放
+    while (batch != NULL)
+    {
+        TC_EpollServer::tagSendData *next = batch->next;
+        delete batch;
+        batch = next;
+    }
+}
+
 TC_EpollServer::NetThread::NetThread(TC_EpollServer *epollServer)
 : _epollServer(epollServer)
 , _listSize(0)
 , _bTerminate(false)
 , _createEpoll(false)
 , _handleStarted(false)
+, _notified(0)
 , _list(this)
+, _freeSend(NULL)
+, _freeSendSize(0)
 , _hasUdp(false)
 , _bEmptyConnAttackCheck(false)
 , _iEmptyCheckTimeout(MIN_EMPTY_CONN_TIMEOUT)
@@ -1486,7 +1954,11 @@ TC_EpollServer::NetThread::NetThread(TC_EpollServer *epollServer)
 {
     _shutdown.createSocket();
 
-    _notify.createSocket();
+    _notify = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_notify < 0)
+    {
+        throw TC_Exception("[TC_EpollServer::NetThread] create eventfd error", errno);
+    }
 }
 
 TC_EpollServer::NetThread::~NetThread()
@@ -1501,6 +1973,21 @@ TC_EpollServer::NetThread::~NetThread()
     }
     _listeners.clear();
 
+    tagSendData *send;
+    while ((send = _sbuffer.pop()) != NULL)
+    {
+        delete send;
+    }
+
+    while (_freeSend != NULL)
+    {
+        send = _freeSend->next;
+        delete _freeSend;
+        _freeSend = send;
+    }
+
+    ::close(_notify);
+
     delete _bufferPool;
 }
 
@@ -1566,7 +2053,23 @@ int  TC_EpollServer::NetThread::bind(BindAdapterPtr &lsPtr)
 
     TC_Socket& s = lsPtr->getSocket();
 
-    bind(ep, s);
+    bind(ep, s, lsPtr->isReusePort());
+
+    _listeners[s.getfd()] = lsPtr;
+
+    return s.getfd();
+}
+
+int  TC_EpollServer::NetThread::bindReusePort(BindAdapterPtr &lsPtr)
+{
+    const TC_Endpoint &ep = lsPtr->getEndpoint();
+
+    //监听fd由本网络线程管理, 析构时关闭
+    TC_Socket s;
+
+    s.setOwner(false);
+
+    bind(ep, s, true);
 
     _listeners[s.getfd()] = lsPtr;
 
@@ -1589,7 +2092,7 @@ TC_EpollServer::BindAdapterPtr TC_EpollServer::NetThread::getBindAdapter(const s
     return NULL;
 }
 
-void TC_EpollServer::NetThread::bind(const TC_Endpoint &ep, TC_Socket &s)
+void TC_EpollServer::NetThread::bind(const TC_Endpoint &ep, TC_Socket &s, bool bReusePort)
 {
     int type = ep.isUnixLocal()?AF_LOCAL:AF_INET;
 
@@ -1602,6 +2105,12 @@ void TC_EpollServer::NetThread::bind(const TC_Endpoint &ep, TC_Socket &s)
         s.createSocket(SOCK_DGRAM, type);
     }
 
+    //SO_REUSEPORT必须在bind之前设置
+    if(bReusePort)
+    {
+        s.setReusePort();
+    }
+
     if(ep.isUnixLocal())
     {
         s.bind(ep.getHost().c_str());
@@ -1638,7 +2147,7 @@ void TC_EpollServer::NetThread::createEpoll(uint32_t iIndex)
         _epoller.create(10240);
 
         _epoller.add(_shutdown.getfd(), H64(ET_CLOSE), EPOLLIN);
-        _epoller.add(_notify.getfd(), H64(ET_NOTIFY), EPOLLIN);
+        _epoller.add(_notify, H64(ET_NOTIFY), EPOLLIN);
 
         size_t maxAllConn   = 0;
 
@@ -1663,11 +2172,9 @@ void TC_EpollServer::NetThread::createEpoll(uint32_t iIndex)
             ++it;
         }
 
-        if(maxAllConn == 0)
-        {
-            //当网络线程中listeners没有监听socket时，使用adapter中设置的最大连接数
-            maxAllConn = _listSize;
-        }
+        //其他网络线程accept后转交过来的连接, 使用adapter中设置的最大连接数
+        //(没有监听socket的网络线程, 只有这部分连接)
+        maxAllConn += _listSize;
 
         if(maxAllConn >= (1 << 22))
         {
@@ -1708,9 +2215,6 @@ void TC_EpollServer::NetThread::terminate()
 {
     _bTerminate = true;
 
-    //通知队列醒过来
-    _sbuffer.notifyT();
-
     //通知epoll响应, 关闭连接
     _epoller.mod(_shutdown.getfd(), H64(ET_CLOSE), EPOLLOUT);
 }
@@ -1774,13 +2278,21 @@ bool TC_EpollServer::NetThread::accept(int fd)
 
         int timeout = _listeners[fd]->getEndpoint().getTimeout()/1000;
 
-        Connection *cPtr = new Connection(_listeners[fd].get(), fd, (timeout < 2 ? 2 : timeout), cs.getfd(), ip, port);
+        //SO_REUSEPORT模式下各网络线程的监听fd不同, 连接统一记录adapter的监听fd
+        Connection *cPtr = new Connection(_listeners[fd].get(), _listeners[fd]->getSocket().getfd(), (timeout < 2 ? 2 : timeout), cs.getfd(), ip, port);
 
         //过滤连接首个数据包包头
         cPtr->setHeaderFilterLen(_listeners[fd]->getHeaderFilterLen());
 
-        //addTcpConnection(cPtr);
-        _epollServer->addConnection(cPtr, cs.getfd(), TCP_CONNECTION);
+        if(_listeners[fd]->isReusePort())
+        {
+            //本线程accept的连接由本线程管理, 不再转交
+            addTcpConnection(cPtr);
+        }
+        else
+        {
+            _epollServer->addConnection(cPtr, cs.getfd(), TCP_CONNECTION);
+        }
 
         return true;
     }
@@ -1881,7 +2393,8 @@ void TC_EpollServer::NetThread::delConnection(TC_EpollServer::NetThread::Connect
         recv->port       = cPtr->getPort();
         recv->isClosed   = true;
         recv->isOverload = false;
-        recv->recvTimeStamp = TNOWMS;
+        recv->recvTimeUs    = TNOWUS;
+        recv->recvTimeStamp = recv->recvTimeUs / 1000;
         recv->fd         = cPtr->getfd();
         recv->closeType = (int)closeType;
 
@@ -1923,16 +2436,15 @@ int  TC_EpollServer::NetThread::recvBuffer(TC_EpollServer::NetThread::Connection
 
 void TC_EpollServer::NetThread::close(uint32_t uid)
 {
-    tagSendData* send = new tagSendData();
+    tagSendData* send = allocSendData();
 
     send->uid = uid;
 
     send->cmd = 'c';
 
-    _sbuffer.push_back(send);
+    send->buffer.clear();
 
-    //通知epoll响应, 关闭连接
-    _epoller.mod(_notify.getfd(), H64(ET_NOTIFY), EPOLLOUT);
+    pushSendData(send);
 }
 
 void TC_EpollServer::NetThread::send(uint32_t uid, const string &s, const string &ip, uint16_t port)
@@ -1942,43 +2454,128 @@ void TC_EpollServer::NetThread::send(uint32_t uid, const string &s, const string
         return;
     }
 
-    tagSendData* send = new tagSendData();
+    tagSendData* send = allocSendData();
+
+    send->uid = uid;
+
+    send->cmd = 's';
+
+    send->buffer.assign(s);
+
+    send->ip.assign(ip);
+
+    send->port = port;
+
+    pushSendData(send);
+}
+
+void TC_EpollServer::NetThread::send(uint32_t uid, const TC_SharedSlice &slice, const string &ip, uint16_t port)
+{
+    if(_bTerminate)
+    {
+        return;
+    }
+
+    tagSendData* send = allocSendData();
 
     send->uid = uid;
 
     send->cmd = 's';
 
-    send->buffer = s;
+    send->buffer.clear();
 
-    send->ip = ip;
+    send->slice = slice;
+
+    send->ip.assign(ip);
 
     send->port = port;
 
-    _sbuffer.push_back(send);
+    pushSendData(send);
+}
+
+void TC_EpollServer::NetThread::pushSendData(tagSendData *send)
+{
+    _sbuffer.push(send);
+
+    //网络线程还没处理上次的通知就不用再通知了, 一批响应只唤醒一次
+    if(__sync_lock_test_and_set(&_notified, 1) == 0)
+    {
+        eventfd_write(_notify, 1);
+    }
+}
+
+void TC_EpollServer::NetThread::freeSendData(tagSendData *send)
+{
+    //太大的buffer不缓存
+    if(send->buffer.capacity() > SEND_DATA_MAX_CAP)
+    {
+        string().swap(send->buffer);
+    }
+
+    //释放引用的内存块
+    send->slice = TC_SharedSlice();
+
+    send->next = _freeSend;
+    _freeSend = send;
+
+    if(++_freeSendSize >= SEND_DATA_BATCH)
+    {
+        releaseSendData(_freeSend);
+
+        _freeSend     = NULL;
+        _freeSendSize = 0;
+    }
+}
+
+bool TC_EpollServer::NetThread::flushSendData(Connection *cPtr)
+{
+    if(cPtr->_pendingSend.empty())
+    {
+        return true;
+    }
+
+    int ret = cPtr->send(cPtr->_pendingSend);
+
+    for(size_t i = 0; i < cPtr->_pendingSend.size(); i++)
+    {
+        freeSendData(cPtr->_pendingSend[i]);
+    }
+
+    cPtr->_pendingSend.clear();
+
+    if(ret < 0)
+    {
+        delConnection(cPtr,true,(ret==-1)?EM_CLIENT_CLOSE:EM_SERVER_CLOSE);
+
+        return false;
+    }
 
-    //通知epoll响应, 有数据要发送
-    _epoller.mod(_notify.getfd(), H64(ET_NOTIFY), EPOLLOUT);
+    return true;
 }
 
 void TC_EpollServer::NetThread::processPipe()
 {
-    send_queue::queue_type deSendData;
+    eventfd_t value;
 
-    _sbuffer.swap(deSendData);
+    eventfd_read(_notify, &value);
 
-    send_queue::queue_type::iterator it = deSendData.begin();
+    //先清通知标记再取队列, 之后放入的会重新通知
+    __sync_lock_release(&_notified);
 
-    send_queue::queue_type::iterator itEnd = deSendData.end();
+    __sync_synchronize();
 
-    while(it != itEnd)
+    tagSendData *send;
+
+    while((send = _sbuffer.pop()) != NULL)
     {
-        switch((*it)->cmd)
+        switch(send->cmd)
         {
         case 'c':
             {
-                Connection *cPtr = getConnectionPtr((*it)->uid);
+                Connection *cPtr = getConnectionPtr(send->uid);
 
-                if(cPtr)
+                //先把之前的响应发出去再关闭
+                if(cPtr && flushSendData(cPtr))
                 {
                     if(cPtr->setClose())
                     {
@@ -1989,35 +2586,66 @@ void TC_EpollServer::NetThread::processPipe()
             }
         case 's':
             {
-                Connection *cPtr = getConnectionPtr((*it)->uid);
+                Connection *cPtr = getConnectionPtr(send->uid);
 
-                if(cPtr)
+                if(!cPtr)
                 {
-#if TARS_SSL
-                    if (cPtr->getBindAdapter()->getEndpoint().isSSL() && cPtr->_openssl->IsHandshaked())
-                    {
-                        std::string out = cPtr->_openssl->Write((*it)->buffer.data(), (*it)->buffer.size());
-                        if (cPtr->_openssl->HasError())
-                            break; // should not happen
-    
-                        (*it)->buffer = out;
-                    }
-#endif
-                    int ret = sendBuffer(cPtr, (*it)->buffer, (*it)->ip, (*it)->port);
+                    break;
+                }
 
-                    if(ret < 0)
+                if(cPtr->getType() == Connection::EM_UDP)
+                {
+                    if(!send->slice.empty())
                     {
-                        delConnection(cPtr,true,(ret==-1)?EM_CLIENT_CLOSE:EM_SERVER_CLOSE);
+                        send->buffer.assign(send->slice.data, send->slice.len);
                     }
+                    sendBuffer(cPtr, send->buffer, send->ip, send->port);
+                    break;
+                }
+
+#if TARS_SSL
+                if (cPtr->getBindAdapter()->getEndpoint().isSSL() && cPtr->_openssl->IsHandshaked())
+                {
+                    std::string out = cPtr->_openssl->Write(send->data(), send->length());
+                    if (cPtr->_openssl->HasError())
+                        break; // should not happen
+
+                    send->buffer.swap(out);
+                    send->slice = TC_SharedSlice();
+                }
+#endif
+                //同一个连接本轮的响应攒起来, 最后一次writev发出去
+                if(cPtr->_pendingSend.empty())
+                {
+                    _pendingConn.push_back(send->uid);
                 }
+
+                cPtr->_pendingSend.push_back(send);
+
+                send = NULL;
                 break;
             }
         default:
             assert(false);
         }
-        delete (*it);
-        ++it;
+
+        if(send != NULL)
+        {
+            freeSendData(send);
+        }
     }
+
+    for(size_t i = 0; i < _pendingConn.size(); i++)
+    {
+        Connection *cPtr = getConnectionPtr(_pendingConn[i]);
+
+        if(cPtr)
+        {
+            flushSendData(cPtr);
+        }
+    }
+
+    _pendingConn.clear();
 }
 
 void TC_EpollServer::NetThread::processNet(const epoll_event &ev)
@@ -2234,12 +2862,30 @@ int  TC_EpollServer::bind(TC_EpollServer::BindAdapterPtr &lsPtr)
 {
     int iRet = 0;
 
+    if(lsPtr->isReusePort())
+    {
+        const TC_Endpoint &ep = lsPtr->getEndpoint();
+
+        //只有tcp(非unix local)且指定了端口、多网络线程时才有意义, 否则退回单线程accept的方式
+        if(!ep.isTcp() || ep.isUnixLocal() || ep.getPort() == 0 || _netThreads.size() <= 1)
+        {
+            debug("bind adapter '" + lsPtr->getName() + "' reuseport ignored, use single acceptor.");
+
+            lsPtr->setReusePort(false);
+        }
+    }
+
     for(size_t i = 0; i < _netThreads.size(); ++i)
     {
         if(i == 0)
         {
             iRet = _netThreads[i]->bind(lsPtr);
         }
+        else if(lsPtr->isReusePort())
+        {
+            //每个网络线程各自监听, 各自accept
+            _netThreads[i]->bindReusePort(lsPtr);
+        }
         else
         {
             //当网络线程中listeners没有监听socket时，list使用adapter中设置的最大连接数作为初始化
@@ -2300,6 +2946,14 @@ void TC_EpollServer::stopThread()
         }
         vector<TC_EpollServer::HandlePtr>& hds = it->second->handles;
 
+        if (it->second->schedule != HANDLE_SCHED_QUEUE)
+        {
+            for (uint32_t i = 0; i < hds.size(); ++i)
+            {
+                hds[i]->notifyFilter();
+            }
+        }
+
         for (uint32_t i = 0; i < hds.size(); ++i)
         {
             if (hds[i]->isAlive())
@@ -2339,18 +2993,25 @@ TC_EpollServer::BindAdapterPtr TC_EpollServer::getBindAdapter(const string &sNam
 }
 void TC_EpollServer::close(unsigned int uid, int fd)
 {
-    TC_EpollServer::NetThread* netThread = getNetThreadOfFd(fd);
+    TC_EpollServer::NetThread* netThread = getNetThreadOfConn(uid, fd);
 
     netThread->close(uid);
 }
 
 void TC_EpollServer::send(unsigned int uid, const string &s, const string &ip, uint16_t port, int fd)
 {
-    TC_EpollServer::NetThread* netThread = getNetThreadOfFd(fd);
+    TC_EpollServer::NetThread* netThread = getNetThreadOfConn(uid, fd);
 
     netThread->send(uid, s, ip, port);
 }
 
+void TC_EpollServer::send(unsigned int uid, const TC_SharedSlice &slice, const string &ip, uint16_t port, int fd)
+{
+    TC_EpollServer::NetThread* netThread = getNetThreadOfConn(uid, fd);
+
+    netThread->send(uid, slice, ip, port);
+}
+
 void TC_EpollServer::debug(const string &s)
 {
     if(_pLocalLogger)
@@ -2399,6 +3060,13 @@ map<int, TC_EpollServer::BindAdapterPtr> TC_EpollServer::getListenSocketInfo()
 
         while(it != tmp.end())
         {
+            //SO_REUSEPORT模式下其他网络线程的监听socket, 不重复列出adapter
+            if(it->first != it->second->getSocket().getfd())
+            {
+                ++it;
+                continue;
+            }
+
             mListen.insert(map<int, TC_EpollServer::BindAdapterPtr>::value_type(it->first, it->second));
             ++it;
         }
@@ -29,6 +29,321 @@ namespace tars
     const string TarsLogByHour::FORMAT = "%Y%m%d%H";
     const string TarsLogByMinute::FORMAT = "%Y%m%d%H%M";
 
+    size_t TC_LoggerRoll::_defaultRingSize = 65536;
+    int TC_LoggerRoll::_defaultOverflow = TC_LoggerRoll::OVERFLOW_SYNC;
+
+    /**
+     * 写日志线程的序号, 用来找到线程在每个TC_LoggerRoll上的缓冲区;
+     * 线程退出时序号归还, 给新的线程复用(连同缓冲区一起), 全局对象不释放
+     */
+    struct LoggerThreadIndex
+    {
+        TC_ThreadMutex      mutex;
+        std::vector<int>    free;
+        int                 next;
+
+        LoggerThreadIndex() : next(0) {}
+    };
+
+    static LoggerThreadIndex *  g_index = NULL;
+    static pthread_once_t       g_indexOnce = PTHREAD_ONCE_INIT;
+    static pthread_key_t        g_indexKey;
+
+    /**
+     * -1: 还没有分配, -2: 超过了MAX_RING_THREAD
+     */
+    static __thread int         t_ringIndex = -1;
+
+    /**
+     * 是否是写日志线程
+     */
+    static __thread bool        t_loggerThread = false;
+
+    static void indexThreadExit(void *)
+    {
+        if (t_ringIndex >= 0)
+        {
+            TC_LockT<TC_ThreadMutex> lock(g_index->mutex);
+            g_index->free.push_back(t_ringIndex);
+        }
+
+        t_ringIndex = -1;
+    }
+
+    static void indexInit()
+    {
+        g_index = new LoggerThreadIndex();
+
+        pthread_key_create(&g_indexKey, indexThreadExit);
+    }
+
+    static int ringIndex()
+    {
+        if (t_ringIndex != -1)
+        {
+            return t_ringIndex;
+        }
+
+        pthread_once(&g_indexOnce, indexInit);
+
+        {
+            TC_LockT<TC_ThreadMutex> lock(g_index->mutex);
+
+            if (!g_index->free.empty())
+            {
+                t_ringIndex = g_index->free.back();
+                g_index->free.pop_back();
+            }
+            else if (g_index->next < TC_LoggerRoll::MAX_RING_THREAD)
+            {
+                t_ringIndex = g_index->next++;
+            }
+            else
+            {
+                t_ringIndex = -2;
+            }
+        }
+
+        if (t_ringIndex >= 0)
+        {
+            pthread_setspecific(g_indexKey, (void*)1);
+        }
+
+        return t_ringIndex;
+    }
+
+    /**
+     * 记录头: 长度 + 染色标记
+     */
+    static const size_t     RING_HEAD   = 8;
+    static const uint32_t   RING_WRAP   = 0xffffffff;
+    static const uint32_t   RING_RECORD = 0x80000000;
+
+    static inline size_t ringAlign(size_t len)
+    {
+        return (len + 7) & ~((size_t)7);
+    }
+
+//////////////////////////////////////////////////////////////////
+//
+    const char *TC_LoggerHead::timeStr(time_t t)
+    {
+        static __thread time_t  t_last = -1;
+        static __thread char    t_str[32];
+
+        if (t != t_last)
+        {
+            TC_TimeProvider::tm2str(t, TC_TimeProvider::TF_DATETIME, t_str);
+            t_last = t;
+        }
+
+        return t_str;
+    }
+
+    const char *TC_LoggerHead::tidStr()
+    {
+        static __thread char    t_tid[24] = "";
+
+        if (t_tid[0] == '\0')
+        {
+            snprintf(t_tid, sizeof(t_tid), "%ld", syscall(SYS_gettid));
+        }
+
+        return t_tid;
+    }
+
+    /**
+     * 线程缓存的stringstream, 嵌套写日志时(正在使用)临时new一个
+     */
+    static __thread std::stringstream * t_stream = NULL;
+    static __thread bool                t_streamUsed = false;
+
+    static pthread_once_t       g_streamOnce = PTHREAD_ONCE_INIT;
+    static pthread_key_t        g_streamKey;
+
+    static void streamThreadExit(void *p)
+    {
+        delete (std::stringstream*)p;
+
+        t_stream = NULL;
+    }
+
+    static void streamInit()
+    {
+        pthread_key_create(&g_streamKey, streamThreadExit);
+    }
+
+    std::stringstream *TC_LoggerHead::allocStream()
+    {
+        if (t_streamUsed)
+        {
+            return new std::stringstream();
+        }
+
+        if (t_stream == NULL)
+        {
+            pthread_once(&g_streamOnce, streamInit);
+
+            t_stream = new std::stringstream();
+
+            pthread_setspecific(g_streamKey, t_stream);
+        }
+
+        t_streamUsed = true;
+
+        return t_stream;
+    }
+
+    void TC_LoggerHead::freeStream(std::stringstream *ss)
+    {
+        if (ss != t_stream)
+        {
+            delete ss;
+            return;
+        }
+
+        //恢复成新构造时的状态
+        ss->str("");
+        ss->clear();
+        ss->flags(std::ios_base::skipws | std::ios_base::dec);
+        ss->fill(' ');
+        ss->width(0);
+        ss->precision(6);
+
+        t_streamUsed = false;
+    }
+
+//////////////////////////////////////////////////////////////////
+//
+    TC_LoggerRing::TC_LoggerRing(size_t size) : _size(16), _head(0), _tail(0)
+    {
+        while (_size < size)
+        {
+            _size <<= 1;
+        }
+
+        _buf = new char[_size];
+    }
+
+    TC_LoggerRing::~TC_LoggerRing()
+    {
+        delete[] _buf;
+    }
+
+    bool TC_LoggerRing::push(int dyeing, const char *data, size_t len, bool record)
+    {
+        size_t need = RING_HEAD + ringAlign(len);
+        size_t head = _head;
+        size_t tail = _tail;
+
+        __sync_synchronize();
+
+        size_t pos  = head & (_size - 1);
+        size_t left = _size - pos;
+
+        //尾部放不下, 写回绕标记从头开始
+        size_t total = (left < need) ? left + need : need;
+
+        if (_size - (head - tail) < total)
+        {
+            return false;
+        }
+
+        if (left < need)
+        {
+            *(uint32_t*)(_buf + pos) = RING_WRAP;
+            head += left;
+            pos   = 0;
+        }
+
+        *(uint32_t*)(_buf + pos)     = record ? ((uint32_t)len | RING_RECORD) : (uint32_t)len;
+        *(int32_t*)(_buf + pos + 4)  = dyeing;
+        memcpy(_buf + pos + RING_HEAD, data, len);
+
+        __sync_synchronize();
+
+        _head = head + need;
+
+        return true;
+    }
+
+    size_t TC_LoggerRing::pop(deque<pair<int, string> > &ds)
+    {
+        size_t head = _head;
+        size_t tail = _tail;
+        size_t n    = 0;
+
+        __sync_synchronize();
+
+        while (tail != head)
+        {
+            size_t   pos = tail & (_size - 1);
+            uint32_t len = *(uint32_t*)(_buf + pos);
+
+            if (len == RING_WRAP)
+            {
+                tail += _size - pos;
+                continue;
+            }
+
+            if (len & RING_RECORD)
+            {
+                //二进制记录在这里格式化
+                len &= ~RING_RECORD;
+                ds.push_back(make_pair(*(int32_t*)(_buf + pos + 4), string()));
+                LoggerRecord::format(_buf + pos + RING_HEAD, len, ds.back().second);
+            }
+            else
+            {
+                ds.push_back(make_pair(*(int32_t*)(_buf + pos + 4), string(_buf + pos + RING_HEAD, len)));
+            }
+
+            tail += RING_HEAD + ringAlign(len);
+            ++n;
+        }
+
+        __sync_synchronize();
+
+        _tail = tail;
+
+        return n;
+    }
+
+//////////////////////////////////////////////////////////////////
+//
+    TC_LoggerRoll::TC_LoggerRoll()
+    : _ringNum(0)
+    , _ringSize(_defaultRingSize)
+    , _overflow(_defaultOverflow)
+    , _dropCount(0)
+    , _blockCount(0)
+    , _syncCount(0)
+    , _dropReported(0)
+    , _pThreadGroup(NULL)
+    {
+        for (size_t i = 0; i < (size_t)(MAX_RING_THREAD / RING_CHUNK); ++i)
+        {
+            _rings[i] = NULL;
+        }
+    }
+
+    TC_LoggerRoll::~TC_LoggerRoll()
+    {
+        for (size_t i = 0; i < (size_t)(MAX_RING_THREAD / RING_CHUNK); ++i)
+        {
+            if (_rings[i] != NULL)
+            {
+                for (size_t j = 0; j < (size_t)RING_CHUNK; ++j)
+                {
+                    delete _rings[i][j];
+                }
+
+                delete[] _rings[i];
+            }
+        }
+    }
+
+
     void TC_LoggerRoll::setupThread(TC_LoggerThreadGroup *pThreadGroup)
     {
         assert(pThreadGroup != NULL);
@@ -63,6 +378,56 @@ namespace tars
     }
 
     void TC_LoggerRoll::write(const pair<int, string> &buffer)
+    {
+        write(buffer.second.data(), buffer.second.length());
+    }
+
+    void TC_LoggerRoll::write(const char *buffer, size_t len)
+    {
+        int dyeing = dyeingId();
+
+        if (_pThreadGroup)
+        {
+            if (pushRing(dyeing, buffer, len))
+            {
+                return;
+            }
+
+            if (t_loggerThread || _ringSize == 0 || ringIndex() < 0)
+            {
+                //没有缓冲区的线程都走队列, 顺序不会乱; 写日志线程自己写日志不能在这里写文件
+                _buffer.push_back(make_pair(dyeing, string(buffer, len)));
+            }
+            else
+            {
+                //先把缓冲区中的写掉, 保证这个线程的日志顺序
+                __sync_fetch_and_add(&_syncCount, 1);
+                flush(dyeing, buffer, len);
+            }
+        }
+        else
+        {
+            //同步记录日志
+            deque<pair<int, string> > ds;
+            ds.push_back(make_pair(dyeing, string(buffer, len)));
+            roll(ds);
+        }
+    }
+
+    void TC_LoggerRoll::writeRecord(const char *record, size_t len)
+    {
+        if (_pThreadGroup && pushRing(dyeingId(), record, len, true))
+        {
+            return;
+        }
+
+        //同步写或者缓冲区写不下, 在当前线程格式化
+        string s;
+        LoggerRecord::format(record, len, s);
+        write(s.data(), s.length());
+    }
+
+    int TC_LoggerRoll::dyeingId()
     {
         pthread_t ThreadID = 0;
         if (_bDyeingFlag)
@@ -77,33 +442,190 @@ namespace tars
             }
         }
 
-        if (_pThreadGroup)
+        return ThreadID;
+    }
+
+    TC_LoggerRing *TC_LoggerRoll::getRing()
+    {
+        int idx = ringIndex();
+        if (idx < 0)
         {
-            _buffer.push_back(make_pair(ThreadID, buffer.second));
+            return NULL;
         }
-        else
+
+        TC_LoggerRing * volatile *chunk = _rings[idx / RING_CHUNK];
+
+        if (chunk != NULL && chunk[idx % RING_CHUNK] != NULL)
         {
-            //同步记录日志
-            deque<pair<int, string> > ds;
-            ds.push_back(make_pair(ThreadID, buffer.second));
-            roll(ds);
+            return chunk[idx % RING_CHUNK];
+        }
+
+        TC_LockT<TC_ThreadMutex> lock(_ringMutex);
+
+        if (_ringSize == 0)
+        {
+            return NULL;
+        }
+
+        chunk = _rings[idx / RING_CHUNK];
+        if (chunk == NULL)
+        {
+            TC_LoggerRing * volatile *p = new TC_LoggerRing * volatile[RING_CHUNK];
+            for (size_t i = 0; i < (size_t)RING_CHUNK; ++i)
+            {
+                p[i] = NULL;
+            }
+
+            __sync_synchronize();
+            _rings[idx / RING_CHUNK] = chunk = p;
+        }
+
+        if (chunk[idx % RING_CHUNK] == NULL)
+        {
+            TC_LoggerRing *ring = new TC_LoggerRing(_ringSize);
+
+            __sync_synchronize();
+            chunk[idx % RING_CHUNK] = ring;
+
+            if ((size_t)idx >= _ringNum)
+            {
+                _ringNum = idx + 1;
+            }
         }
+
+        return chunk[idx % RING_CHUNK];
+    }
+
+    bool TC_LoggerRoll::pushRing(int dyeing, const char *buffer, size_t len, bool record)
+    {
+        if (_ringSize == 0)
+        {
+            return false;
+        }
+
+        TC_LoggerRing *ring = getRing();
+
+        //太大的不放缓冲区, 保证一条至少能放进空的缓冲区;
+        //setRing只影响之后创建的缓冲区, 要按这个线程已有缓冲区的大小判断
+        if (ring == NULL || len + 16 > ring->capacity() / 2)
+        {
+            return false;
+        }
+
+        while (!ring->push(dyeing, buffer, len, record))
+        {
+            TC_LoggerThreadGroup *group = _pThreadGroup;
+
+            //写日志线程自己写日志不能等待, 也不丢弃
+            if (t_loggerThread || group == NULL)
+            {
+                return false;
+            }
+
+            if (_overflow == OVERFLOW_DROP)
+            {
+                __sync_fetch_and_add(&_dropCount, 1);
+                group->wakeup();
+                return true;
+            }
+            else if (_overflow == OVERFLOW_BLOCK)
+            {
+                __sync_fetch_and_add(&_blockCount, 1);
+                group->wakeup();
+                usleep(1000);
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        //超过一半, 不等100ms的定时, 提前唤醒写日志线程
+        if (ring->used() > ring->capacity() / 2)
+        {
+            TC_LoggerThreadGroup *group = _pThreadGroup;
+            if (group)
+            {
+                group->wakeup();
+            }
+        }
+
+        return true;
     }
 
     void TC_LoggerRoll::flush()
     {
+        flush(0, NULL, 0);
+    }
+
+    void TC_LoggerRoll::flush(int dyeing, const char *buffer, size_t len)
+    {
+        //多个写日志线程同时flush同一个roll时, 保证写入文件的顺序和取出的顺序一致
+        TC_LockT<TC_ThreadMutex> lock(_flushMutex);
+
+        deque<pair<int, string> > ds;
+
+        size_t num = _ringNum;
+        for (size_t i = 0; i < num; ++i)
+        {
+            TC_LoggerRing * volatile *chunk = _rings[i / RING_CHUNK];
+            if (chunk == NULL)
+            {
+                //整块都没有分配
+                i = (i / RING_CHUNK + 1) * RING_CHUNK - 1;
+                continue;
+            }
+
+            TC_LoggerRing *ring = chunk[i % RING_CHUNK];
+            if (ring != NULL)
+            {
+                ring->pop(ds);
+            }
+        }
+
         TC_ThreadQueue<pair<int, string> >::queue_type qt;
         _buffer.swap(qt);
 
         if (!qt.empty())
         {
-            roll(qt);
+            ds.insert(ds.end(), qt.begin(), qt.end());
+        }
+
+        size_t drop = _dropCount;
+        if (drop > _dropReported)
+        {
+            ds.push_back(make_pair(0, "[TC_LoggerRoll] buffer full, " + TC_Common::tostr(drop - _dropReported) + " log lines dropped\n"));
+            _dropReported = drop;
+        }
+
+        if (buffer != NULL)
+        {
+            ds.push_back(make_pair(dyeing, string(buffer, len)));
+        }
+
+        if (!ds.empty())
+        {
+            roll(ds);
         }
     }
 
+    void TC_LoggerRoll::setRing(size_t ringSize, int overflow)
+    {
+        TC_LockT<TC_ThreadMutex> lock(_ringMutex);
+
+        _ringSize = ringSize;
+        _overflow = overflow;
+    }
+
+    void TC_LoggerRoll::setDefaultRing(size_t ringSize, int overflow)
+    {
+        _defaultRingSize = ringSize;
+        _defaultOverflow = overflow;
+    }
+
 //////////////////////////////////////////////////////////////////
 //
-    TC_LoggerThreadGroup::TC_LoggerThreadGroup() : _bTerminate(false)
+    TC_LoggerThreadGroup::TC_LoggerThreadGroup() : _bTerminate(false), _notified(0)
     {
     }
 
@@ -172,20 +694,331 @@ namespace tars
         }
     }
 
+    void TC_LoggerThreadGroup::wakeup()
+    {
+        //已经唤醒过还没有处理的, 不再加锁
+        if (__sync_lock_test_and_set(&_notified, 1) == 0)
+        {
+            Lock lock(*this);
+            notifyAll();
+        }
+    }
+
     void TC_LoggerThreadGroup::run()
     {
+        t_loggerThread = true;
+
         while (!_bTerminate)
         {
-            //100ms
+            //100ms, 或者有缓冲区过半时被唤醒
             {
                 Lock lock(*this);
-                timedWait(100);
+                if (_notified == 0)
+                {
+                    timedWait(100);
+                }
             }
 
+            __sync_lock_release(&_notified);
+
             flush();
         }
     }
 
+//////////////////////////////////////////////////////////////////////////////////
+
+    LoggerRecord::LoggerRecord(const char *header, const char *fmt, TC_LoggerRoll *roll, bool bCopy)
+    : _roll(header != NULL ? roll : NULL)
+    , _data(_inline)
+    , _len(0)
+    , _cap(INLINE_SIZE)
+    {
+        if (_roll)
+        {
+            uint16_t hlen = strlen(header) & ~FMT_COPIED;
+            uint16_t flag = hlen;
+
+            //拷贝时连同结尾的0, 格式化时可以直接当C字符串用
+            uint32_t flen = 0;
+            if (bCopy && fmt != NULL)
+            {
+                flag |= FMT_COPIED;
+                flen  = strlen(fmt) + 1;
+            }
+
+            size_t n = sizeof(hlen) + hlen + ((flag & FMT_COPIED) ? sizeof(flen) + flen : sizeof(fmt));
+
+            char *p = reserve(n);
+            memcpy(p, &flag, sizeof(flag));
+            memcpy(p + sizeof(hlen), header, hlen);
+
+            if (flag & FMT_COPIED)
+            {
+                memcpy(p + sizeof(hlen) + hlen, &flen, sizeof(flen));
+                memcpy(p + sizeof(hlen) + hlen + sizeof(flen), fmt, flen);
+            }
+            else
+            {
+                memcpy(p + sizeof(hlen) + hlen, &fmt, sizeof(fmt));
+            }
+
+            _len += n;
+        }
+    }
+
+    LoggerRecord::~LoggerRecord()
+    {
+        if (_roll)
+        {
+            _roll->writeRecord(_data, _len);
+        }
+
+        if (_data != _inline)
+        {
+            delete[] _data;
+        }
+    }
+
+    void LoggerRecord::grow(size_t len)
+    {
+        size_t cap = _cap * 2;
+        if (cap < len)
+        {
+            cap = len;
+        }
+
+        char *p = new char[cap];
+        memcpy(p, _data, _len);
+
+        if (_data != _inline)
+        {
+            delete[] _data;
+        }
+
+        _data = p;
+        _cap  = cap;
+    }
+
+    LoggerRecord& LoggerRecord::appendInt(int64_t t)
+    {
+        if (_roll)
+        {
+            char *p = reserve(1 + sizeof(t));
+            p[0] = ARG_INT;
+            memcpy(p + 1, &t, sizeof(t));
+            _len += 1 + sizeof(t);
+        }
+        return *this;
+    }
+
+    LoggerRecord& LoggerRecord::appendUInt(uint64_t t)
+    {
+        if (_roll)
+        {
+            char *p = reserve(1 + sizeof(t));
+            p[0] = ARG_UINT;
+            memcpy(p + 1, &t, sizeof(t));
+            _len += 1 + sizeof(t);
+        }
+        return *this;
+    }
+
+    LoggerRecord& LoggerRecord::appendDouble(double t)
+    {
+        if (_roll)
+        {
+            char *p = reserve(1 + sizeof(t));
+            p[0] = ARG_DOUBLE;
+            memcpy(p + 1, &t, sizeof(t));
+            _len += 1 + sizeof(t);
+        }
+        return *this;
+    }
+
+    LoggerRecord& LoggerRecord::appendString(const char *t, size_t len)
+    {
+        if (_roll)
+        {
+            uint32_t n = len;
+            char *p = reserve(1 + sizeof(n) + len);
+            p[0] = ARG_STRING;
+            memcpy(p + 1, &n, sizeof(n));
+            memcpy(p + 1 + sizeof(n), t, len);
+            _len += 1 + sizeof(n) + len;
+        }
+        return *this;
+    }
+
+    LoggerRecord& LoggerRecord::operator << (const void *t)
+    {
+        if (_roll)
+        {
+            char *p = reserve(1 + sizeof(t));
+            p[0] = ARG_POINTER;
+            memcpy(p + 1, &t, sizeof(t));
+            _len += 1 + sizeof(t);
+        }
+        return *this;
+    }
+
+    LoggerRecord& LoggerRecord::operator << (char t)
+    {
+        if (_roll)
+        {
+            char *p = reserve(2);
+            p[0] = ARG_CHAR;
+            p[1] = t;
+            _len += 2;
+        }
+        return *this;
+    }
+
+    /**
+     * 格式化pos处的一个参数, 返回下一个参数的位置; 数据不对时返回len
+     */
+    static size_t formatArg(const char *data, size_t len, size_t pos, string &out)
+    {
+        char buf[64];
+
+        switch (data[pos])
+        {
+            case LoggerRecord::ARG_INT:
+            {
+                int64_t t;
+                memcpy(&t, data + pos + 1, sizeof(t));
+                out.append(buf, snprintf(buf, sizeof(buf), "%lld", (long long)t));
+                return pos + 1 + sizeof(t);
+            }
+            case LoggerRecord::ARG_UINT:
+            {
+                uint64_t t;
+                memcpy(&t, data + pos + 1, sizeof(t));
+                out.append(buf, snprintf(buf, sizeof(buf), "%llu", (unsigned long long)t));
+                return pos + 1 + sizeof(t);
+            }
+            case LoggerRecord::ARG_DOUBLE:
+            {
+                //和ostream缺省的格式一样
+                double t;
+                memcpy(&t, data + pos + 1, sizeof(t));
+                out.append(buf, snprintf(buf, sizeof(buf), "%g", t));
+                return pos + 1 + sizeof(t);
+            }
+            case LoggerRecord::ARG_CHAR:
+            {
+                out += data[pos + 1];
+                return pos + 2;
+            }
+            case LoggerRecord::ARG_STRING:
+            {
+                uint32_t n;
+                memcpy(&n, data + pos + 1, sizeof(n));
+                out.append(data + pos + 1 + sizeof(n), n);
+                return pos + 1 + sizeof(n) + n;
+            }
+            case LoggerRecord::ARG_POINTER:
+            {
+                const void *t;
+                memcpy(&t, data + pos + 1, sizeof(t));
+                if (t == NULL)
+                {
+                    out += '0';
+                }
+                else
+                {
+                    out.append(buf, snprintf(buf, sizeof(buf), "%p", t));
+                }
+                return pos + 1 + sizeof(t);
+            }
+        }
+
+        return len;
+    }
+
+    void LoggerRecord::format(const char *data, size_t len, string &out)
+    {
+        uint16_t    hlen;
+        const char *fmt;
+
+        if (len < sizeof(hlen))
+        {
+            return;
+        }
+
+        memcpy(&hlen, data, sizeof(hlen));
+
+        bool bCopied = (hlen & FMT_COPIED);
+        hlen &= ~FMT_COPIED;
+
+        size_t pos = sizeof(hlen) + hlen;
+        if (bCopied)
+        {
+            uint32_t flen;
+            if (pos + sizeof(flen) > len)
+            {
+                return;
+            }
+
+            memcpy(&flen, data + pos, sizeof(flen));
+            pos += sizeof(flen);
+
+            if (flen == 0 || pos + flen > len || data[pos + flen - 1] != '\0')
+            {
+                return;
+            }
+
+            fmt  = data + pos;
+            pos += flen;
+        }
+        else
+        {
+            if (pos + sizeof(fmt) > len)
+            {
+                return;
+            }
+
+            memcpy(&fmt, data + pos, sizeof(fmt));
+            pos += sizeof(fmt);
+        }
+
+        out.append(data + sizeof(hlen), hlen);
+
+        const char *f = fmt ? fmt : "";
+        while (*f)
+        {
+            const char *b = strstr(f, "{}");
+            if (b == NULL)
+            {
+                out.append(f);
+                break;
+            }
+
+            out.append(f, b - f);
+
+            if (pos < len)
+            {
+                pos = formatArg(data, len, pos, out);
+            }
+            else
+            {
+                out.append("{}");
+            }
+
+            f = b + 2;
+        }
+
+        //多出来的参数接在后面
+        while (pos < len)
+        {
+            pos = formatArg(data, len, pos, out);
+        }
+
+        if (out.empty() || out[out.length() - 1] != '\n')
+        {
+            out += '\n';
+        }
+    }
+
 //////////////////////////////////////////////////////////////////////////////////
 
     LoggerBuffer::LoggerBuffer() : _buffer(NULL), _buffer_len(0)
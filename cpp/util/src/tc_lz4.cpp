@@ -0,0 +1,258 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+
+#include "util/tc_lz4.h"
+#include <string.h>
+#include <stdint.h>
+
+namespace tars
+{
+
+/**
+ * LZ4 block格式的约束: 最短匹配4字节, 最后5字节必须是字面量, 最后一个匹配从距结尾12字节之前开始
+ */
+static const size_t MIN_MATCH     = 4;
+static const size_t LAST_LITERALS = 5;
+static const size_t MF_LIMIT      = 12;
+static const size_t MAX_OFFSET    = 65535;
+static const int    HASH_LOG      = 12;
+
+static inline uint32_t read32(const char *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t hash32(uint32_t v)
+{
+    return (v * 2654435761U) >> (32 - HASH_LOG);
+}
+
+/**
+ * 长度超过15的部分, 每个字节255, 最后一个字节<255
+ */
+static inline char *writeLength(char *op, size_t len)
+{
+    while (len >= 255)
+    {
+        *op++ = (char)255;
+        len  -= 255;
+    }
+    *op++ = (char)len;
+    return op;
+}
+
+static inline char *writeLiterals(char *op, const char *src, size_t litLen, size_t matchCode)
+{
+    char *token = op++;
+
+    if (litLen >= 15)
+    {
+        *token = (char)(15 << 4);
+        op = writeLength(op, litLen - 15);
+    }
+    else
+    {
+        *token = (char)(litLen << 4);
+    }
+
+    *token |= (char)matchCode;
+
+    memcpy(op, src, litLen);
+
+    return op + litLen;
+}
+
+bool TC_LZ4::compress(const char *src, size_t length, string& buffer)
+{
+    size_t start = buffer.length();
+    buffer.resize(start + compressBound(length));
+
+    char *out = &buffer[0] + start;
+    char *op  = out;
+
+    size_t anchor = 0;
+
+    if (length > MF_LIMIT)
+    {
+        //位置+1, 0表示空
+        uint32_t table[1 << HASH_LOG];
+        memset(table, 0, sizeof(table));
+
+        size_t ip    = 0;
+        size_t limit = length - MF_LIMIT;
+
+        while (ip <= limit)
+        {
+            uint32_t v   = read32(src + ip);
+            uint32_t h   = hash32(v);
+            size_t   ref = table[h];
+
+            table[h] = ip + 1;
+
+            if (ref == 0 || ip - (ref - 1) > MAX_OFFSET || read32(src + ref - 1) != v)
+            {
+                ++ip;
+                continue;
+            }
+
+            --ref;
+
+            //向后扩展匹配
+            size_t ml  = MIN_MATCH;
+            size_t end = length - LAST_LITERALS;
+            while (ip + ml < end && src[ref + ml] == src[ip + ml])
+            {
+                ++ml;
+            }
+
+            size_t litLen    = ip - anchor;
+            size_t matchLen  = ml - MIN_MATCH;
+            size_t offset    = ip - ref;
+
+            op = writeLiterals(op, src + anchor, litLen, matchLen >= 15 ? 15 : matchLen);
+
+            *op++ = (char)(offset & 0xff);
+            *op++ = (char)(offset >> 8);
+
+            if (matchLen >= 15)
+            {
+                op = writeLength(op, matchLen - 15);
+            }
+
+            ip    += ml;
+            anchor = ip;
+        }
+    }
+
+    //剩下的都是字面量
+    op = writeLiterals(op, src + anchor, length - anchor, 0);
+
+    buffer.resize(start + (op - out));
+
+    return true;
+}
+
+bool TC_LZ4::uncompress(const char *src, size_t length, size_t rawLength, string& buffer)
+{
+    size_t start = buffer.length();
+    buffer.resize(start + rawLength);
+
+    char *out = &buffer[0] + start;
+    size_t ip = 0;
+    size_t op = 0;
+
+    while (ip < length)
+    {
+        unsigned char token = src[ip++];
+
+        //字面量
+        size_t litLen = token >> 4;
+        if (litLen == 15)
+        {
+            unsigned char c;
+            do
+            {
+                if (ip >= length)
+                {
+                    goto error;
+                }
+                c = src[ip++];
+                litLen += c;
+            }
+            while (c == 255);
+        }
+
+        if (litLen > length - ip || litLen > rawLength - op)
+        {
+            goto error;
+        }
+
+        memcpy(out + op, src + ip, litLen);
+        ip += litLen;
+        op += litLen;
+
+        //最后一个序列只有字面量
+        if (ip == length)
+        {
+            break;
+        }
+
+        //匹配
+        if (length - ip < 2)
+        {
+            goto error;
+        }
+
+        size_t offset = (unsigned char)src[ip] | ((size_t)(unsigned char)src[ip + 1] << 8);
+        ip += 2;
+
+        if (offset == 0 || offset > op)
+        {
+            goto error;
+        }
+
+        size_t matchLen = token & 0x0f;
+        if (matchLen == 15)
+        {
+            unsigned char c;
+            do
+            {
+                if (ip >= length)
+                {
+                    goto error;
+                }
+                c = src[ip++];
+                matchLen += c;
+            }
+            while (c == 255);
+        }
+        matchLen += MIN_MATCH;
+
+        if (matchLen > rawLength - op)
+        {
+            goto error;
+        }
+
+        //可能重叠, 按字节复制
+        char *d = out + op;
+        const char *s = d - offset;
+        if (offset >= matchLen)
+        {
+            memcpy(d, s, matchLen);
+        }
+        else
+        {
+            for (size_t i = 0; i < matchLen; ++i)
+            {
+                d[i] = s[i];
+            }
+        }
+        op += matchLen;
+    }
+
+    if (op == rawLength)
+    {
+        return true;
+    }
+
+error:
+    buffer.resize(start);
+    return false;
+}
+
+}
@@ -15,6 +15,7 @@
  */
 
 #include "util/tc_mysql.h"
+#include "util/tc_common.h"
 #include "errmsg.h"
 #include <sstream>
 #include <string.h>
@@ -126,6 +127,22 @@ string TC_Mysql::escapeString(const string& sFrom)
     return sTo;
 }
 
+void TC_Mysql::escapeString(const char *sFrom, size_t iLen, string &sTo)
+{
+    if(!_bConnected)
+    {
+        connect();
+    }
+
+    size_t iPos = sTo.length();
+
+    sTo.resize(iPos + iLen * 2 + 1);
+
+    unsigned long n = mysql_real_escape_string(_pstMql, &sTo[iPos], sFrom, iLen);
+
+    sTo.resize(iPos + n);
+}
+
 MYSQL *TC_Mysql::getMysql(void)
 {
     return _pstMql;
@@ -293,6 +310,89 @@ void TC_Mysql::execute(const string& sSql)
     }
 }
 
+namespace
+{
+    /**
+     * LOAD DATA LOCAL INFILE的数据源, 从内存读
+     */
+    struct LocalInfile
+    {
+        const char  *data;
+        size_t      len;
+        size_t      pos;
+    };
+
+    int localInfileInit(void **ptr, const char *filename, void *userdata)
+    {
+        LocalInfile *infile = (LocalInfile*)userdata;
+        infile->pos = 0;
+        *ptr = infile;
+        return 0;
+    }
+
+    int localInfileRead(void *ptr, char *buf, unsigned int buf_len)
+    {
+        LocalInfile *infile = (LocalInfile*)ptr;
+
+        size_t n = infile->len - infile->pos;
+        if(n > buf_len)
+        {
+            n = buf_len;
+        }
+
+        memcpy(buf, infile->data + infile->pos, n);
+        infile->pos += n;
+
+        return (int)n;
+    }
+
+    void localInfileEnd(void *ptr)
+    {
+    }
+
+    int localInfileError(void *ptr, char *error_msg, unsigned int error_msg_len)
+    {
+        snprintf(error_msg, error_msg_len, "[TC_Mysql::loadData]: read memory error");
+        return CR_UNKNOWN_ERROR;
+    }
+}
+
+void TC_Mysql::loadData(const string& sSql, const char *data, size_t len)
+{
+    if(!_bConnected)
+    {
+        connect();
+    }
+
+    _sLastSql = sSql;
+
+    LocalInfile infile = {data, len, 0};
+
+    mysql_set_local_infile_handler(_pstMql, localInfileInit, localInfileRead, localInfileEnd, localInfileError, &infile);
+
+    int iRet = mysql_real_query(_pstMql, sSql.c_str(), sSql.length());
+    if(iRet != 0)
+    {
+        /**
+        自动重新连接, 新连接要重新设置数据源
+        */
+        int iErrno = mysql_errno(_pstMql);
+        if (iErrno == 2013 || iErrno == 2006)
+        {
+            connect();
+            mysql_set_local_infile_handler(_pstMql, localInfileInit, localInfileRead, localInfileEnd, localInfileError, &infile);
+            iRet = mysql_real_query(_pstMql, sSql.c_str(), sSql.length());
+        }
+    }
+
+    mysql_set_local_infile_default(_pstMql);
+
+    if (iRet != 0)
+    {
+        throw TC_Mysql_Exception("[TC_Mysql::loadData]: mysql_query: [ " + sSql + " ] :" + string(mysql_error(_pstMql)));
+    }
+}
+
 TC_Mysql::MysqlData TC_Mysql::queryRecord(const string& sSql)
 {
     MysqlData   data;
@@ -495,5 +595,197 @@ TC_Mysql::MysqlRecord TC_Mysql::MysqlData::operator[](size_t i)
     return MysqlRecord(_data[i]);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TC_MysqlBulk::TC_MysqlBulk(TC_Mysql *pMysql, BulkMode eMode, size_t iMaxRows, size_t iMaxPacket)
+: _pMysql(pMysql)
+, _eMode(eMode)
+, _iMaxRows(iMaxRows > 0 ? iMaxRows : 1)
+, _iMaxPacket(iMaxPacket)
+, _iRows(0)
+, _iFields(0)
+, _iTotal(0)
+, _iRowBegin(0)
+{
+}
+
+TC_MysqlBulk::BulkMode TC_MysqlBulk::toMode(const string &sMode)
+{
+    return sMode == "loaddata" ? BM_LOAD_DATA : BM_INSERT;
+}
+
+void TC_MysqlBulk::begin(const string &sTable, const string &sColumns, bool bIgnore)
+{
+    if(_eMode == BM_LOAD_DATA)
+    {
+        //文件名只是占位, 数据从内存读
+        _sHead = "load data local infile 'tars_bulk.tsv' ";
+        _sHead += (bIgnore ? "ignore into table " : "into table ");
+        _sHead += sTable;
+        if(!_pMysql->getDBConf()._charset.empty())
+        {
+            _sHead += " character set ";
+            _sHead += _pMysql->getDBConf()._charset;
+        }
+        _sHead += " fields terminated by '\\t' escaped by '\\\\' lines terminated by '\\n' (";
+        _sHead += sColumns;
+        _sHead += ")";
+    }
+    else
+    {
+        _sHead = (bIgnore ? "insert ignore into " : "insert into ");
+        _sHead += sTable;
+        _sHead += " (";
+        _sHead += sColumns;
+        _sHead += ") values ";
+    }
+
+    _iTotal = 0;
+
+    reset();
 }
 
+void TC_MysqlBulk::reset()
+{
+    if(_eMode == BM_LOAD_DATA)
+    {
+        _buffer.clear();
+    }
+    else
+    {
+        _buffer = _sHead;
+    }
+
+    _iRows     = 0;
+    _iFields   = 0;
+    _iRowBegin = _buffer.length();
+}
+
+void TC_MysqlBulk::addSep()
+{
+    if(_eMode == BM_LOAD_DATA)
+    {
+        if(_iFields != 0)
+        {
+            _buffer += '\t';
+        }
+    }
+    else
+    {
+        _buffer += (_iFields != 0 ? "," : (_iRows != 0 ? ",(" : "("));
+    }
+
+    ++_iFields;
+}
+
+void TC_MysqlBulk::addStr(const char *str, size_t len)
+{
+    addSep();
+
+    if(_eMode == BM_LOAD_DATA)
+    {
+        //TSV转义, 和语句里的escaped by一致, 没有特殊字符的片段整段追加
+        size_t iBegin = 0;
+        for(size_t i = 0; i < len; ++i)
+        {
+            char c = 0;
+            switch(str[i])
+            {
+                case '\\': c = '\\'; break;
+                case '\t': c = 't'; break;
+                case '\n': c = 'n'; break;
+                case '\r': c = 'r'; break;
+                case '\0': c = '0'; break;
+                default: continue;
+            }
+
+            _buffer.append(str + iBegin, i - iBegin);
+            _buffer += '\\';
+            _buffer += c;
+            iBegin = i + 1;
+        }
+        _buffer.append(str + iBegin, len - iBegin);
+    }
+    else
+    {
+        _buffer += '\'';
+        _pMysql->escapeString(str, len, _buffer);
+        _buffer += '\'';
+    }
+}
+
+void TC_MysqlBulk::addInt(int64_t i)
+{
+    addSep();
+
+    char buf[32];
+    _buffer.append(buf, TC_Common::tochars(buf, i) - buf);
+}
+
+void TC_MysqlBulk::addNull()
+{
+    addSep();
+
+    _buffer += (_eMode == BM_LOAD_DATA ? "\\N" : "NULL");
+}
+
+size_t TC_MysqlBulk::endRow()
+{
+    _buffer += (_eMode == BM_LOAD_DATA ? '\n' : ')');
+
+    _iFields = 0;
+
+    size_t n = 0;
+
+    if(_iRows != 0 && _buffer.length() > _iMaxPacket)
+    {
+        //先写入之前的行, 这一行留到下一条语句, insert方式去掉行前的逗号
+        string sRow = _buffer.substr(_eMode == BM_LOAD_DATA ? _iRowBegin : _iRowBegin + 1);
+        _buffer.resize(_iRowBegin);
+
+        n += flush();
+
+        _buffer += sRow;
+    }
+
+    ++_iRows;
+    _iRowBegin = _buffer.length();
+
+    if(_iRows >= _iMaxRows || _buffer.length() >= _iMaxPacket)
+    {
+        n += flush();
+    }
+
+    return n;
+}
+
+void TC_MysqlBulk::write()
+{
+    if(_eMode == BM_LOAD_DATA)
+    {
+        _pMysql->loadData(_sHead, _buffer.c_str(), _buffer.length());
+    }
+    else
+    {
+        _pMysql->execute(_buffer);
+    }
+}
+
+size_t TC_MysqlBulk::flush()
+{
+    if(_iRows == 0)
+    {
+        return 0;
+    }
+
+    write();
+
+    size_t n = _iRows;
+
+    _iTotal += n;
+
+    reset();
+
+    return n;
+}
+
+}
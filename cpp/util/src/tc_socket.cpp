@@ -481,6 +481,19 @@ void TC_Socket::setKeepAlive()
     }
 }
 
+void TC_Socket::setReusePort()
+{
+#ifdef SO_REUSEPORT
+    int flag = 1;
+    if(setSockOpt(SO_REUSEPORT, (char*)&flag, int(sizeof(int)), SOL_SOCKET) == -1)
+    {
+        throw TC_Socket_Exception("[TC_Socket::setReusePort] error", errno);
+    }
+#else
+    throw TC_Socket_Exception("[TC_Socket::setReusePort] SO_REUSEPORT not supported");
+#endif
+}
+
 void TC_Socket::setSendBufferSize(int sz)
 {
     if(setSockOpt(SO_SNDBUF, (char*)&sz, int(sizeof(int)), SOL_SOCKET) == -1)
@@ -15,10 +15,257 @@
  */
 
 #include "util/tc_timeprovider.h"
+#include <stdint.h>
 
 namespace tars
 {
 
+/**
+ * 当天的日期, 本地时间和GMT各一份, 范围是[begin, end)
+ */
+struct TimeDayCache
+{
+    time_t      localBegin;
+    time_t      localEnd;
+    time_t      localBase;      //当天0点, 夏令时切换的那天范围只有一秒
+    struct tm   local;
+
+    time_t      gmtBegin;
+    struct tm   gmt;
+};
+
+/**
+ * 写的时候g_daySeq为奇数, 读的时候前后g_daySeq一致才有效
+ */
+static volatile uint32_t    g_daySeq = 0;
+static TimeDayCache         g_day;
+
+static const char *g_weekDays[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+static const char *g_months[]   = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+#define TC_MS_1(p) "." p "0", "." p "1", "." p "2", "." p "3", "." p "4", "." p "5", "." p "6", "." p "7", "." p "8", "." p "9"
+#define TC_MS_2(p) TC_MS_1(p "0"), TC_MS_1(p "1"), TC_MS_1(p "2"), TC_MS_1(p "3"), TC_MS_1(p "4"), \
+                   TC_MS_1(p "5"), TC_MS_1(p "6"), TC_MS_1(p "7"), TC_MS_1(p "8"), TC_MS_1(p "9")
+
+static const char g_msStr[1000][5] =
+{
+    TC_MS_2("0"), TC_MS_2("1"), TC_MS_2("2"), TC_MS_2("3"), TC_MS_2("4"),
+    TC_MS_2("5"), TC_MS_2("6"), TC_MS_2("7"), TC_MS_2("8"), TC_MS_2("9")
+};
+
+#undef TC_MS_1
+#undef TC_MS_2
+
+/**
+ * x86上读和读、写和写不会乱序, seqlock只需要阻止编译器重排
+ */
+#if defined(__i386__) || defined(__x86_64__)
+#define TC_SEQ_BARRIER() __asm__ __volatile__("" ::: "memory")
+#else
+#define TC_SEQ_BARRIER() __sync_synchronize()
+#endif
+
+static bool readDay(TimeDayCache &dc)
+{
+    for (int i = 0; i < 16; ++i)
+    {
+        uint32_t seq = g_daySeq;
+        if (seq & 1)
+        {
+            continue;
+        }
+
+        TC_SEQ_BARRIER();
+        dc = g_day;
+        TC_SEQ_BARRIER();
+
+        if (seq == g_daySeq)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void makeDay(time_t t, TimeDayCache &dc)
+{
+    localtime_r(&t, &dc.local);
+
+    time_t sod      = dc.local.tm_hour * 3600 + dc.local.tm_min * 60 + dc.local.tm_sec;
+    dc.localBase    = t - sod;
+    dc.localBegin   = dc.localBase;
+    dc.localEnd     = dc.localBase + 86400;
+
+    //当天有夏令时的切换, 不缓存
+    struct tm b, e;
+    time_t last = dc.localEnd - 1;
+    localtime_r(&dc.localBegin, &b);
+    localtime_r(&last, &e);
+    if (b.tm_gmtoff != dc.local.tm_gmtoff || e.tm_gmtoff != dc.local.tm_gmtoff)
+    {
+        dc.localBegin   = t;
+        dc.localEnd     = t + 1;
+    }
+
+    gmtime_r(&t, &dc.gmt);
+    dc.gmtBegin = t - (dc.gmt.tm_hour * 3600 + dc.gmt.tm_min * 60 + dc.gmt.tm_sec);
+}
+
+static void publishDay(const TimeDayCache &dc)
+{
+    uint32_t seq = g_daySeq;
+    if (!(seq & 1) && __sync_bool_compare_and_swap(&g_daySeq, seq, seq + 1))
+    {
+        g_day = dc;
+        TC_SEQ_BARRIER();
+        g_daySeq = seq + 2;
+    }
+}
+
+/**
+ * 当前时间所在的一天不在缓存里时重新计算并更新缓存, 只由时间线程调用
+ */
+static void refreshDay(time_t t)
+{
+    TimeDayCache dc;
+    if (readDay(dc) && t >= dc.localBegin && t < dc.localEnd && t >= dc.gmtBegin && t < dc.gmtBegin + 86400)
+    {
+        return;
+    }
+
+    makeDay(t, dc);
+    publishDay(dc);
+}
+
+/**
+ * 取包含t的那一天; 不在缓存中的时间(历史时间等)只在本线程算一次localtime_r/gmtime_r, 不替换缓存,
+ * 缓存只在为空时(时间线程没有启动)初始化一次, 之后由时间线程跨天时更新
+ */
+static void getDay(time_t t, bool gmt, TimeDayCache &dc)
+{
+    if (readDay(dc))
+    {
+        if (gmt ? (t >= dc.gmtBegin && t < dc.gmtBegin + 86400) : (t >= dc.localBegin && t < dc.localEnd))
+        {
+            return;
+        }
+    }
+
+    if (g_daySeq == 0)
+    {
+        makeDay(t, dc);
+        publishDay(dc);
+        return;
+    }
+
+    if (gmt)
+    {
+        gmtime_r(&t, &dc.gmt);
+        dc.gmtBegin = t - (dc.gmt.tm_hour * 3600 + dc.gmt.tm_min * 60 + dc.gmt.tm_sec);
+    }
+    else
+    {
+        localtime_r(&t, &dc.local);
+        dc.localBase = t - (dc.local.tm_hour * 3600 + dc.local.tm_min * 60 + dc.local.tm_sec);
+    }
+}
+
+static inline char *put2(char *p, int v)
+{
+    p[0] = '0' + v / 10;
+    p[1] = '0' + v % 10;
+    return p + 2;
+}
+
+static inline char *put4(char *p, int v)
+{
+    p[0] = '0' + v / 1000 % 10;
+    p[1] = '0' + v / 100 % 10;
+    p[2] = '0' + v / 10 % 10;
+    p[3] = '0' + v % 10;
+    return p + 4;
+}
+
+size_t TC_TimeProvider::tm2str(time_t t, int format, char *buf)
+{
+    TimeDayCache dc;
+    getDay(t, format == TF_GMT, dc);
+
+    char *p = buf;
+
+    if (format == TF_GMT)
+    {
+        int sod = (int)(t - dc.gmtBegin);
+
+        memcpy(p, g_weekDays[dc.gmt.tm_wday], 3);
+        p += 3;
+        *p++ = ',';
+        *p++ = ' ';
+        p = put2(p, dc.gmt.tm_mday);
+        *p++ = ' ';
+        memcpy(p, g_months[dc.gmt.tm_mon], 3);
+        p += 3;
+        *p++ = ' ';
+        p = put4(p, dc.gmt.tm_year + 1900);
+        *p++ = ' ';
+        p = put2(p, sod / 3600);
+        *p++ = ':';
+        p = put2(p, sod / 60 % 60);
+        *p++ = ':';
+        p = put2(p, sod % 60);
+        memcpy(p, " GMT", 4);
+        p += 4;
+    }
+    else
+    {
+        int sod = (int)(t - dc.localBase);
+        bool dt = (format == TF_DATETIME);
+
+        p = put4(p, dc.local.tm_year + 1900);
+        if (dt) *p++ = '-';
+        p = put2(p, dc.local.tm_mon + 1);
+        if (dt) *p++ = '-';
+        p = put2(p, dc.local.tm_mday);
+
+        if (format != TF_DATE)
+        {
+            if (dt) *p++ = ' ';
+            p = put2(p, sod / 3600);
+            if (dt) *p++ = ':';
+            p = put2(p, sod / 60 % 60);
+
+            if (format != TF_MINUTE)
+            {
+                if (dt) *p++ = ':';
+                p = put2(p, sod % 60);
+            }
+        }
+    }
+
+    *p = '\0';
+
+    return p - buf;
+}
+
+void TC_TimeProvider::localtime(time_t t, struct tm &tt)
+{
+    TimeDayCache dc;
+    getDay(t, false, dc);
+
+    int sod = (int)(t - dc.localBase);
+
+    tt          = dc.local;
+    tt.tm_hour  = sod / 3600;
+    tt.tm_min   = sod / 60 % 60;
+    tt.tm_sec   = sod % 60;
+}
+
+const char *TC_TimeProvider::msStr(int ms)
+{
+    return g_msStr[ms];
+}
+
 TC_ThreadLock TC_TimeProvider::g_tl;
 TC_TimeProviderPtr TC_TimeProvider::g_tp = NULL;
 
@@ -71,6 +318,13 @@ int64_t TC_TimeProvider::getNowMs()
     return tv.tv_sec * (int64_t)1000 + tv.tv_usec/1000;
 }
 
+int64_t TC_TimeProvider::getNowUs()
+{
+    struct timeval tv;
+    getNow(&tv);
+    return tv.tv_sec * (int64_t)1000000 + tv.tv_usec;
+}
+
 void TC_TimeProvider::run()
 {
     while(!_terminate)
@@ -83,6 +337,9 @@ void TC_TimeProvider::run()
 
         _buf_idx = !_buf_idx;
 
+        //跨天时提前算好缓存的日期
+        refreshDay(tt.tv_sec);
+
         TC_ThreadLock::Lock lock(g_tl);
 
         g_tl.timedWait(800); //修改800时 需对应修改addTimeOffset中offset判读值
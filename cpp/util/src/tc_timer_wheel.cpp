@@ -0,0 +1,245 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+
+#include "util/tc_timer_wheel.h"
+#include <cassert>
+
+namespace tars
+{
+
+TC_TimerWheel::TC_TimerWheel()
+: _size(0)
+, _count(0)
+, _current(0)
+{
+}
+
+void TC_TimerWheel::init(uint32_t size, int64_t now)
+{
+    _size    = size;
+    _count   = 0;
+    _current = now;
+
+    Node node;
+    node.prev   = 0;
+    node.next   = 0;
+    node.expire = 0;
+
+    _nodes.assign(_size + 1 + SLOT_NUM, node);
+
+    for (uint32_t slot = 0; slot < SLOT_NUM; ++slot)
+    {
+        uint32_t h = head(slot);
+
+        _nodes[h].prev = h;
+        _nodes[h].next = h;
+    }
+}
+
+void TC_TimerWheel::add(uint32_t id, int64_t expire)
+{
+    assert(id > 0 && id <= _size);
+
+    if (exist(id))
+    {
+        unlink(id);
+    }
+
+    _nodes[id].expire = expire;
+
+    place(id);
+}
+
+void TC_TimerWheel::del(uint32_t id)
+{
+    assert(id > 0 && id <= _size);
+
+    if (exist(id))
+    {
+        unlink(id);
+    }
+}
+
+void TC_TimerWheel::place(uint32_t id)
+{
+    int64_t expire = _nodes[id].expire;
+    int64_t delta  = expire - _current;
+
+    uint32_t slot;
+
+    if (delta < 0)
+    {
+        //已经过期的, 放在当前刻度, 下次推进时取出
+        slot = (uint32_t)(_current & (ROOT_SIZE - 1));
+    }
+    else if (delta < ROOT_SIZE)
+    {
+        slot = (uint32_t)(expire & (ROOT_SIZE - 1));
+    }
+    else
+    {
+        //超出最上层范围的, 先放在最上层最远的槽, 转到时再重新分散
+        const int64_t maxDelta = ((int64_t)1 << (ROOT_BITS + LEVEL_NUM * LEVEL_BITS)) - 1;
+        if (delta > maxDelta)
+        {
+            expire = _current + maxDelta;
+            delta  = maxDelta;
+        }
+
+        uint32_t level = 1;
+        while (level < LEVEL_NUM && delta >= ((int64_t)1 << (ROOT_BITS + level * LEVEL_BITS)))
+        {
+            ++level;
+        }
+
+        uint32_t shift = ROOT_BITS + (level - 1) * LEVEL_BITS;
+
+        slot = ROOT_SIZE + (level - 1) * LEVEL_SIZE + (uint32_t)((expire >> shift) & (LEVEL_SIZE - 1));
+    }
+
+    //挂到槽的尾部
+    uint32_t h = head(slot);
+
+    _nodes[id].next = h;
+    _nodes[id].prev = _nodes[h].prev;
+
+    _nodes[_nodes[h].prev].next = id;
+    _nodes[h].prev = id;
+
+    ++_count;
+}
+
+void TC_TimerWheel::unlink(uint32_t id)
+{
+    Node &node = _nodes[id];
+
+    _nodes[node.prev].next = node.next;
+    _nodes[node.next].prev = node.prev;
+
+    node.prev = 0;
+    node.next = 0;
+
+    --_count;
+}
+
+void TC_TimerWheel::cascade(uint32_t slot)
+{
+    //先把整个槽摘下来再逐个重新挂入, 避免挂回同一个槽
+    uint32_t h  = head(slot);
+    uint32_t id = _nodes[h].next;
+
+    _nodes[h].prev = h;
+    _nodes[h].next = h;
+
+    while (id != h)
+    {
+        uint32_t next = _nodes[id].next;
+
+        _nodes[id].prev = 0;
+        _nodes[id].next = 0;
+        --_count;
+
+        place(id);
+
+        id = next;
+    }
+}
+
+void TC_TimerWheel::expire(int64_t now, std::vector<uint32_t> &ids)
+{
+    //时间跳变超过第二层一圈, 逐个刻度推进不划算, 全部重新分散
+    if (now - _current >= ((int64_t)1 << (ROOT_BITS + LEVEL_BITS)))
+    {
+        std::vector<uint32_t> all;
+        all.reserve(_count);
+
+        for (uint32_t slot = 0; slot < SLOT_NUM; ++slot)
+        {
+            uint32_t h = head(slot);
+
+            while (_nodes[h].next != h)
+            {
+                uint32_t id = _nodes[h].next;
+
+                unlink(id);
+
+                all.push_back(id);
+            }
+        }
+
+        _current = now + 1;
+
+        for (size_t i = 0; i < all.size(); ++i)
+        {
+            if (_nodes[all[i]].expire <= now)
+            {
+                ids.push_back(all[i]);
+            }
+            else
+            {
+                place(all[i]);
+            }
+        }
+
+        return;
+    }
+
+    while (_current <= now)
+    {
+        uint32_t index = (uint32_t)(_current & (ROOT_SIZE - 1));
+
+        //第一层转完一圈, 逐层把上一层的槽分散下来
+        if (index == 0)
+        {
+            for (uint32_t level = 1; level <= LEVEL_NUM; ++level)
+            {
+                uint32_t shift = ROOT_BITS + (level - 1) * LEVEL_BITS;
+                uint32_t idx   = (uint32_t)((_current >> shift) & (LEVEL_SIZE - 1));
+
+                cascade(ROOT_SIZE + (level - 1) * LEVEL_SIZE + idx);
+
+                if (idx != 0)
+                {
+                    break;
+                }
+            }
+        }
+
+        //取出当前刻度的槽
+        uint32_t h  = head(index);
+        uint32_t id = _nodes[h].next;
+
+        _nodes[h].prev = h;
+        _nodes[h].next = h;
+
+        while (id != h)
+        {
+            uint32_t next = _nodes[id].next;
+
+            _nodes[id].prev = 0;
+            _nodes[id].next = 0;
+            --_count;
+
+            ids.push_back(id);
+
+            id = next;
+        }
+
+        ++_current;
+    }
+}
+
+}